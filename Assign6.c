@@ -8,6 +8,7 @@
 //FreeRTOS headers
 #include <FreeRTOS.h>
 #include <task.h>
+#include <queue.h>
 #include <semphr.h>
 
 //C Headers
@@ -28,60 +29,234 @@
 #include "hardware/spi.h"
 #include "hardware/adc.h"
 #include "hardware/uart.h"
-
-// I2C reserves some addresses for special purposes. We exclude these from the scan.
-// These are any addresses of the form 000 0xxx or 111 1xxx
-#define HDC1080TEMPREG 0x00
-#define HDC1080HUMREG 0x01
-#define HDC1080CONFIGREG 0x02
-#define HDC1080ADDRESS 0x40
-#define HDC1080SN1 0xFB
-#define HDC1080SN2 0xFC
-#define HDC1080SN3 0xFD
-#define HDC1080DEVICEIDREG 0xFE
-#define HDC1080DEVICEID 0xFF
-#define I2C_PORT i2c1
-
-//define 7-segment led pins
-#define SevenSegCC1 11  //right number
-#define SevenSegCC2 10  //left number
-
-#define SevenSegA 26    //Top bar
-#define SevenSegB 27    //Top right
-#define SevenSegC 29    //bottom right
-#define SevenSegD 18    //bottom bar
-#define SevenSegE 25    //bottom left
-#define SevenSegF 7     //Top Left
-#define SevenSegG 28    //Middle
-#define SevenSegDP 24   //decimal points
-
-//Function prototypes
-int readConfigReg();
-int readMFID();
-int readSN1();
-int readSN2();
-int readSN3();
-int readTemperature();
-int readHumidity();
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+
+#include "hdc1080.h"
+#include "i2c_async.h"
+#include "alarm_wait.h"
+#include "display.h"
+#include "sample_cell.h"
+#include "history.h"
+#include "flash_log.h"
+#include "telemetry.h"
+#include "console.h"
+#include "spsc_ring.h"
+#include "runtime_stats.h"
+#include "event_trace.h"
+#include "rtos_static.h"
+#include "adaptive_rate.h"
+#include "sample_filter.h"
+#include "runtime_config.h"
+#include "jitter_histogram.h"
+#include "spi_display.h"
+#include "psychro.h"
+
+//Defaults for the settings that can be changed over USB, see
+//runtime_config.h. Settings saved in flash replace them at boot.
+
+//HDC1080 resolution. Lower resolution converts faster.
+#define TEMPRESOLUTION HDC1080RES14BIT
+#define HUMRESOLUTION HDC1080RES14BIT
+
+//Each reading averages SAMPLEOVERSAMPLE back to back conversions,
+//then goes through the channel's filter (see sample_filter.h). Both
+//are on raw codes, ahead of conversion, so published values keep
+//their fraction of a degree.
+#define SAMPLEOVERSAMPLE 4
+#define TEMPFILTER {SAMPLEFILTERMEDIAN, 3, 0}
+#define HUMFILTER {SAMPLEFILTERMEDIAN, 3, 0}
+
+//What the display shows, how long it shows humidity before
+//switching to temperature, and in which units. Sampling runs on its
+//own schedule per channel, see adaptive_rate.h.
+#define DISPLAYMODE RUNTIMECONFIGDISPLAYCYCLE
+#define DISPLAYDWELLMS 5000
+#define DISPLAYFAHRENHEIT 1
+
+//The MAX7219 chain on SPI (spi_display.h) shows temperature and
+//humidity together, half the digits each, with one decimal place or
+//two when the fields are 6 digits or wider
+#define CHAINFIELDDIGITS (SPIDISPLAYDIGITS / 2)
+#define CHAINDECIMALS (CHAINFIELDDIGITS >= 6 ? 2 : 1)
+
+//Output format. 1 sends packed, checksummed frames of TELEMETRYBATCH
+//samples (see telemetry.h, decode with tools/telemetry_decode.c),
+//0 prints text.
+#define TELEMETRYBINARY 0
+#define TELEMETRYBATCH 4
+_Static_assert(TELEMETRYMAXFRAME <= CONSOLEMESSAGEMAX, "a telemetry frame fits one console message");
+
+//Task stacks in words, as multiples of the port minimum so the same
+//code runs under the POSIX port in the host simulation. Each is sized
+//from its deepest path with about a third spare; check them against
+//stack_free_words in the stats report after a change.
+//  readHDC1080Task  consolePrintf: message + vsnprintf, ~1 KB; the
+//                   scan's per sensor buffers in readScanned are less
+//  flashLogTask     flashLogAppend page program, the page buffer in
+//                   runtimeConfigSave, or consolePrintf
+//  reportTask       snapshot, line and chunk buffers + the TaskStatus_t
+//                   array in runtimeStatsCollect, ~2.2 KB
+//  commandTask      command parser copies and replies, ~1.2 KB
+#define READSTACKWORDS (3 * configMINIMAL_STACK_SIZE)
+#define FLASHLOGSTACKWORDS (3 * configMINIMAL_STACK_SIZE)
+#define REPORTSTACKWORDS (6 * configMINIMAL_STACK_SIZE)
+#define COMMANDSTACKWORDS (4 * configMINIMAL_STACK_SIZE)
+
+//How often the command task checks USB for input, and the longest
+//the report task sleeps on the sample cell before it looks for a
+//request. Besides the settings commands in
+//runtime_config.h, "stats" (or "s") prints the runtime stats,
+//"trace" (or "t") dumps the event trace (decode with
+//tools/trace_to_chrome.c), "jitter" (or "j") prints how late
+//readings start against their schedule (jitter_histogram.h),
+//"now" (or "n") the latest sample, from the sample cell, "watch"
+//(or "w") turns on or off a line per sample from the report task,
+//woken by the cell on each publish,
+//"sensors" the latest reading of each sensor the scan reads, and
+//"history minute|hour [count]" the newest minute or hour rollups
+//(history.h), the last hour or day by default.
+#define COMMANDPOLLMS 50
+#define REPORTPOLLMS 100
+
+//How long to wait before looking for the sensor again when the probe
+//finds none
+#define PROBERETRYMS 1000
+
+//Most HDC1080s the probe looks for, one on the controller or one per
+//channel of the TCA9548As on it. With more than one found every
+//reading scans them all (hdc1080Scan); the first drives the display,
+//history and log.
+#define SENSORSMAX 8
+
+//Sensor bus speed, also used to bring the controller back after bus
+//recovery
+#define I2CBAUDRATE (100 * 1000)
+
+//Queue numbers shown in the event trace
+#define FLASHLOGQUEUENUMBER 1
+
+//Samples in flight from acquisition on core 0 to display and
+//telemetry on core 1, a power of 2
+#define SAMPLERINGLEN 8
+
+//Samples waiting for the flash log task. The reading task never
+//blocks on it; if the log falls this far behind samples are dropped.
+#define FLASHLOGQUEUELEN 16
+
+//Slack the flash log task needs before the next reading to erase a
+//sector. The erase holds off interrupts and parks core 1; the W25Q16
+//takes 45 ms typical, this leaves room for a slow one.
+#define FLASHERASEUS 100000
+
+//Longest a settings save waits for that slack. Past it the save goes
+//ahead anyway, which can hold up one reading by the erase time.
+#define FLASHSAVEWAITMS 5000
 
 //Task Prototypes
 void readHDC1080Task();
-void segLEDLeft();
-void segLEDRight();
+void core1Main();
+void flashLogTask();
+void reportTask();
+void commandTask();
+void consoleWait();
+bool flashSlack();
+bool configSaveRequest();
+void configSave();
+bool sleepUntil(uint64_t dueUs);
+void sendToCore1(const SampleRecord_t *record);
+void commandReply(const char *text);
+void commandNow();
+void commandHistory(const char *args);
+void configDefaults(RuntimeConfig_t *config);
+bool readOversampled(int count, bool temperature, bool humidity, HDC1080Sample_t *sample);
+bool readScanned(int count, HDC1080Sample_t *sample);
+void commandSensors();
+void printCenti(const char *label, int32_t centi);
+void outputSample(TelemetryEncoder_t *telemetry, const RuntimeConfig_t *config, const SampleRecord_t *record);
+int displayValue(const RuntimeConfig_t *config, const SampleRecord_t *record, bool showTemperature);
+void chainShow(const RuntimeConfig_t *config, const SampleRecord_t *record);
+
+//Task stacks and control blocks, see rtos_static.h
+RTOSTASK(readHDC1080Task, READSTACKWORDS);
+RTOSTASK(flashLogTask, FLASHLOGSTACKWORDS);
+RTOSTASK(reportTask, REPORTSTACKWORDS);
+RTOSTASK(commandTask, COMMANDSTACKWORDS);
+
+//The reading task, woken when settings are applied, and when the
+//latest command started, to report how long settings took to apply.
+//Written by commandTask and read by readHDC1080Task in critical
+//sections: 64 bits are two stores on the M0+.
+TaskHandle_t readTaskHandle;
+uint64_t configAppliedUs;
+
+//How late each scheduled reading started, written by readHDC1080Task
+JitterHistogram_t scheduleJitter;
+
+//Latest humidity and temp values for tasks on core 0, written by
+//readHDC1080Task, read by the now command and waited on by
+//reportTask. watchSamples is set by the watch command.
+SampleCell_t latestSample;
+volatile bool watchSamples;
+
+//Every sample, from readHDC1080Task to core 1
+SampleRecord_t sampleRingSlots[SAMPLERINGLEN];
+SpscRing_t sampleRing;
+
+//Recent samples and minute/hour rollups, written by readHDC1080Task
+History_t sampleHistory;
+
+//Samples on their way to flash, and the log itself. The save command
+//is queued here too, so every flash erase and program is done by
+//flashLogTask and the two never wait on each other's multicore lockout.
+typedef struct {
+    uint32_t timeSec;
+    int32_t centiC;
+    int32_t centiRH;
+    bool saveConfig;            //save the applied settings, not a sample
+} FlashLogEntry_t;
+
+QueueHandle_t flashLogQueue;
+RTOSQUEUE(flashLogQueue, FLASHLOGQUEUELEN, sizeof(FlashLogEntry_t));
+FlashLog_t sampleLog;
+uint32_t flashLogDropped;
+
+//When the reading task next reads, for the flash log task to keep
+//erases out of its way. Written by readHDC1080Task in a critical
+//section: 64 bits are two stores on the M0+.
+uint64_t readNextDueUs;
+
+//The MAX7219 chain, driven from core 1
+SpiDisplay_t chainDisplay;
+
+//Interrupt driven I2C transport used by the HDC1080 driver
+I2CAsyncBus_t hdc1080Bus;
+
+//The HDC1080s on I2C_PORT, found by the probe in readHDC1080Task.
+//sensorCount is set once, before the first reading.
+HDC1080Bus_t sensorBus;
+HDC1080_t sensors[SENSORSMAX];
+int sensorCount;
+
+//Latest reading of every sensor and how long a scan of them all took,
+//written by readScanned in a critical section and read by the sensors
+//command
+HDC1080Sample_t sensorSamples[SENSORSMAX];
+uint32_t sensorScanUs;
 
-//Define Queue variable to hold humidity and temp values
-QueueHandle_t tempHumqueue;
+int main() {
 
-//Define semaphore for 7segLEDs
-SemaphoreHandle_t ledSem;
+    RuntimeConfig_t config;
 
-int main() {
     // Enable UART so we can print status output
   stdio_init_all();
-  while (!tud_cdc_connected()) { sleep_ms(100);  }    
-    
+
+    //output goes through the console task, so sampling starts
+    //whether or not a host is attached
+    consoleInit();
+
     // This example will use I2C1 on the default SDA and SCL pins
-    i2c_init(I2C_PORT, 100 * 1000);
+    i2c_init(I2C_PORT, I2CBAUDRATE);
     gpio_set_function(PICO_DEFAULT_I2C_SDA_PIN, GPIO_FUNC_I2C);
     gpio_set_function(PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C);
     gpio_pull_up(PICO_DEFAULT_I2C_SDA_PIN);
@@ -90,18 +265,52 @@ int main() {
     // Make the I2C pins available to picotool
     bi_decl(bi_2pins_with_func(PICO_DEFAULT_I2C_SDA_PIN, PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C));
 
-    //initialize Semaphores
-    vSemaphoreCreateBinary(ledSem);
+    //move sensor transfers off the CPU, the reading task sleeps
+    //on a notification while the controller works
+    i2cAsyncRp2040Init(&hdc1080Bus, I2C_PORT);
+    hdc1080BusInit(&sensorBus, I2C_PORT, &hdc1080Bus);
 
-    //initialize Queues
-    tempHumqueue = xQueueCreate(2, sizeof(int));
+    //a transfer that hangs frees the bus by clocking SCL on these pins
+    hdc1080BusSetRecovery(&sensorBus, PICO_DEFAULT_I2C_SDA_PIN, PICO_DEFAULT_I2C_SCL_PIN, I2CBAUDRATE);
+
+    //start the PIO/DMA display refresh
+    displayInit();
+
+    //initialize the sample cell and the ring to core 1
+    sampleCellInit(&latestSample);
+    spscRingInit(&sampleRing, sampleRingSlots, sizeof(SampleRecord_t), SAMPLERINGLEN);
+    historyInit(&sampleHistory);
+    jitterHistogramInit(&scheduleJitter);
+
+    //settings saved in flash, or the defaults, before any task runs
+    if(!runtimeConfigLoad(&runtimeConfigRp2040Storage, &config)){
+        configDefaults(&config);
+    }
+    runtimeConfigInit(&config);
+
+    //find the end of the flash log before anything is sampled
+    if(!flashLogInit(&sampleLog, &flashLogRp2040Storage)){
+        consolePrintf("Flash log init failed\n");
+    }
+    flashLogQueue = RTOSCREATEQUEUE(flashLogQueue, FLASHLOGQUEUELEN, sizeof(FlashLogEntry_t));
+    vQueueSetQueueNumber(flashLogQueue, FLASHLOGQUEUENUMBER);
     
     //initialize task to read from HDC1080
-    xTaskCreate(readHDC1080Task, "readHDC1080Task", 256, NULL, 1, NULL);
+    RTOSCREATETASK(readHDC1080Task, READSTACKWORDS, 1);
 
-    //initialize tasks to display on 7 seg leds
-    xTaskCreate(segLEDLeft, "segLEDLeft", 128, NULL, 1, NULL);
-    xTaskCreate(segLEDRight, "segLEDRight", 128, NULL, 1, NULL);
+    //initialize task to write samples to flash, below the others so
+    //erases only run when nothing else is ready
+    RTOSCREATETASK(flashLogTask, FLASHLOGSTACKWORDS, 0);
+
+    //initialize task to report runtime stats and the trace on request
+    RTOSCREATETASK(reportTask, REPORTSTACKWORDS, 1);
+
+    //initialize task to run commands from USB
+    RTOSCREATETASK(commandTask, COMMANDSTACKWORDS, 1);
+
+    //display and USB output run on core 1, outside FreeRTOS, so
+    //neither can add latency to sampling
+    multicore_launch_core1(core1Main);
 
     //start scheduler
     vTaskStartScheduler();
@@ -110,753 +319,947 @@ int main() {
 }
 
 //This is the main task that reads the data from the HDC1080
-//and sends the data to a queue to display on 7-segment LEDs
+//and passes each sample to core 1 for display and output
 void readHDC1080Task() {
 
     //Initialize variables
-    int configStat;
-    int mfID;
-    int serialNum1;
-    int serialNum2;
-    int serialNum3;
-    int temperatureInC;
-    int temperatureInF;
-    int humidity;
-    int clearQueue;
-
-    //Get Device ID values and print out on intial execution
-    configStat = readConfigReg();
-    mfID = readMFID();
-    serialNum1 = readSN1();
-    serialNum2 = readSN2();
-    serialNum3 = readSN3();
-
-
-    printf("Configuration Register = 0x%X\n", configStat);
-    printf("Manufacturer ID = 0x%X\n", mfID);
-    printf("Serial Number = %X-%X-%X\n", serialNum1, serialNum2, serialNum3);
+    const HDC1080Identity_t *identity;
+    uint64_t startUs = time_us_64();
+    uint64_t probeUs;
+    HDC1080Sample_t sample;
+    SampleRecord_t record;
+    uint64_t timestampUs;
+    FlashLogEntry_t entry;
+    uint32_t sampleSequence = 0;
+    RuntimeConfig_t config;
+    RuntimeConfig_t previous;
+    uint32_t configGeneration = 0;
+    bool setupAll = true;
+    AdaptiveRate_t temperatureRate;
+    AdaptiveRate_t humidityRate;
+    SampleFilter_t temperatureFilter;
+    SampleFilter_t humidityFilter;
+    bool readTemperature;
+    bool readHumidity;
+    uint64_t readStartUs;
+    uint64_t dueUs = 0;
+    bool scheduled = false;
+    uint32_t missed;
+    uint64_t nowUs;
+    uint64_t appliedUs;
+    int oversample;
+    int i;
+
+    readTaskHandle = xTaskGetCurrentTaskHandle();
+
+    //Find the sensors and check and cache their identities. The reads
+    //run back to back, so sampling starts within a few ms of boot.
+    while((sensorCount = hdc1080Probe(&sensorBus, sensors, SENSORSMAX)) == 0){
+        consolePrintf("No HDC1080 found, retrying\n");
+        vTaskDelay(pdMS_TO_TICKS(PROBERETRYMS));
+    }
+    probeUs = time_us_64() - startUs;
+
+    for(i = 0; i < sensorCount; i++){
+        identity = &sensors[i].identity;
+        consolePrintf("HDC1080 %d serial %04X-%04X-%04X, manufacturer 0x%04X, device 0x%04X, config 0x%04X, mux 0x%02X channel %u\n",
+                      i, identity->serial[0], identity->serial[1], identity->serial[2],
+                      identity->manufacturerId, identity->deviceId, sensors[i].config, sensors[i].muxAddress,
+                      sensors[i].muxChannel);
+    }
+    consolePrintf("%d HDC1080 found in %lu us\n", sensorCount, (unsigned long)probeUs);
+
+    //Both channels convert on one trigger. With one sensor
+    //readOversampled drops to split mode for a read of one channel
+    //alone; more are always scanned in combined mode.
+    for(i = 0; i < sensorCount; i++){
+        if(!hdc1080SetAcquisitionMode(&sensors[i], true)){
+            consolePrintf("Failed to set HDC1080 %d acquisition mode\n", i);
+        }
+    }
+
+    memset(&sample, 0, sizeof(sample));
+    memset(&config, 0, sizeof(config));
 
     while(true){
-        
-        //Get current Temperature in C
-        temperatureInC = readTemperature();
 
-        //Convert Temperature in C to F
-        temperatureInF = (temperatureInC * 1.8) + 32;
+        //Take up settings applied over USB, redoing only the parts
+        //that changed so the other channel keeps its rate and filter
+        if(setupAll || runtimeConfigGeneration() != configGeneration){
+            previous = config;
+            configGeneration = runtimeConfigRead(&config);
+            nowUs = time_us_64();
+
+            if(setupAll || config.temperatureResolution != previous.temperatureResolution ||
+               config.humidityResolution != previous.humidityResolution){
+                for(i = 0; i < sensorCount; i++){
+                    if(!hdc1080SetResolution(&sensors[i], (HDC1080Resolution_t)config.temperatureResolution,
+                                             (HDC1080Resolution_t)config.humidityResolution)){
+                        consolePrintf("Failed to set HDC1080 %d resolution\n", i);
+                    }
+                }
+            }
+            if(setupAll || memcmp(&config.temperatureRate, &previous.temperatureRate, sizeof(config.temperatureRate)) != 0){
+                adaptiveRateInit(&temperatureRate, &config.temperatureRate, nowUs);
+            }
+            if(setupAll || memcmp(&config.humidityRate, &previous.humidityRate, sizeof(config.humidityRate)) != 0){
+                adaptiveRateInit(&humidityRate, &config.humidityRate, nowUs);
+            }
+            if(setupAll || memcmp(&config.temperatureFilter, &previous.temperatureFilter, sizeof(config.temperatureFilter)) != 0){
+                if(!sampleFilterInit(&temperatureFilter, &config.temperatureFilter)){
+                    consolePrintf("Bad temperature filter config, not filtering\n");
+                }
+            }
+            if(setupAll || memcmp(&config.humidityFilter, &previous.humidityFilter, sizeof(config.humidityFilter)) != 0){
+                if(!sampleFilterInit(&humidityFilter, &config.humidityFilter)){
+                    consolePrintf("Bad humidity filter config, not filtering\n");
+                }
+            }
 
-        //Get current Humidity
-        humidity = readHumidity();
+            taskENTER_CRITICAL();
+            appliedUs = configAppliedUs;
+            taskEXIT_CRITICAL();
+            if(!setupAll && appliedUs != 0){
+                consolePrintf("Settings generation %lu applied in %lu us\n", (unsigned long)configGeneration,
+                              (unsigned long)(time_us_64() - appliedUs));
+            }
+            setupAll = false;
+        }
 
-        printf("Temperature in C: %d\n", temperatureInC);
-        printf("Temperature in F: %d\n", temperatureInF);
-        printf("Humidity %d\n", humidity);
+        //Read whichever channels are due, and the other one too if it
+        //is nearly due so they share the wake up. The sample is
+        //stamped with the start of the read, on the schedule's clock.
+        readStartUs = time_us_64();
+        readTemperature = adaptiveRateDue(&temperatureRate, readStartUs);
+        readHumidity = adaptiveRateDue(&humidityRate, readStartUs);
+        if(adaptiveRateWaitUs(&temperatureRate, readStartUs) <= ADAPTIVERATECOALESCEMS * 1000 &&
+           adaptiveRateWaitUs(&humidityRate, readStartUs) <= ADAPTIVERATECOALESCEMS * 1000){
+            readTemperature = true;
+            readHumidity = true;
+        }
 
-        //Send humidity data to queue and delay for 5 seconds
-        xQueueSend(tempHumqueue, &humidity, 0);
-        vTaskDelay(5000/portTICK_PERIOD_MS);
-        
-        //Clear Queue
-        xQueueReceive(tempHumqueue, &clearQueue, 0);
+        //a scan reads both channels of every sensor
+        if(sensorCount > 1 && (readTemperature || readHumidity)){
+            readTemperature = true;
+            readHumidity = true;
+        }
 
-        //send temperature data in F and delay for 5 seconds
-        xQueueSend(tempHumqueue, &temperatureInF, 0);
-        vTaskDelay(5000/portTICK_PERIOD_MS);
+        if(readTemperature || readHumidity){
+            if(scheduled){
+                taskENTER_CRITICAL();
+                jitterHistogramRecord(&scheduleJitter, dueUs, readStartUs);
+                taskEXIT_CRITICAL();
+            }
+            missed = 0;
+
+            //the first reading is a single conversion so output starts
+            //right after the probe, the filter smooths it in after
+            oversample = sampleSequence == 0 ? 1 : config.oversample;
+            if(sensorCount > 1 ? readScanned(oversample, &sample) :
+               readOversampled(oversample, readTemperature, readHumidity, &sample)){
+                if(readTemperature){
+                    sample.rawTemperature = sampleFilterAdd(&temperatureFilter, sample.rawTemperature);
+                }
+                if(readHumidity){
+                    sample.rawHumidity = sampleFilterAdd(&humidityFilter, sample.rawHumidity);
+                }
+                hdc1080ConvertSample(&sample);
+
+                //dew point, absolute humidity and heat index from the
+                //latest reading of each channel
+                if((sample.flags & (HDC1080VALIDTEMPERATURE | HDC1080VALIDHUMIDITY)) ==
+                   (HDC1080VALIDTEMPERATURE | HDC1080VALIDHUMIDITY)){
+                    psychroCompute(sample.centiC, sample.centiRH, &record.derived);
+                }
+                else{
+                    psychroClear(&record.derived);
+                }
+
+                //the next slots are set from the end of the read, so a
+                //read that overran drops those it passed
+                nowUs = time_us_64();
+                if(readTemperature){
+                    missed += adaptiveRateUpdate(&temperatureRate, sample.centiC, nowUs);
+                }
+                if(readHumidity){
+                    missed += adaptiveRateUpdate(&humidityRate, sample.centiRH, nowUs);
+                }
+
+                //Send the sample to core 1, publish it and keep it in history
+                timestampUs = readStartUs;
+
+                record.sample = sample;
+                record.timestampUs = timestampUs;
+                record.sequence = ++sampleSequence;
+                sendToCore1(&record);
+                if(record.sequence == 1){
+                    consolePrintf("First sample %lu us after start\n", (unsigned long)(time_us_64() - startUs));
+                }
+
+                sampleCellPublish(&latestSample, &sample, &record.derived, timestampUs);
+                eventTraceRecord(EVENTTRACESAMPLEPUBLISH, 0, (uint16_t)record.sequence);
+                historyAdd(&sampleHistory, timestampUs, sample.centiC, sample.centiRH);
+
+                //hand it to the flash log without waiting
+                entry.timeSec = (uint32_t)(timestampUs / 1000000);
+                entry.centiC = sample.centiC;
+                entry.centiRH = sample.centiRH;
+                if(xQueueSend(flashLogQueue, &entry, 0) != pdTRUE){
+                    flashLogDropped++;
+                }
+            }
+            else{
+                //Publish the failure so the display shows dashes rather
+                //than a stale reading. It stays out of the filters,
+                //history and flash log.
+                nowUs = time_us_64();
+                if(readTemperature){
+                    sample.flags &= ~HDC1080VALIDTEMPERATURE;
+                    missed += adaptiveRateSkip(&temperatureRate, nowUs);
+                }
+                if(readHumidity){
+                    sample.flags &= ~HDC1080VALIDHUMIDITY;
+                    missed += adaptiveRateSkip(&humidityRate, nowUs);
+                }
+
+                record.sample = sample;
+                psychroClear(&record.derived);
+                record.timestampUs = readStartUs;
+                record.sequence = ++sampleSequence;
+                sendToCore1(&record);
+                sampleCellPublish(&latestSample, &sample, &record.derived, record.timestampUs);
+
+                consolePrintf("HDC1080 read failed, %lu timeouts %lu recoveries %lu restores\n",
+                              (unsigned long)sensorBus.stats.timeouts, (unsigned long)sensorBus.stats.recoveries,
+                              (unsigned long)sensorBus.stats.restores);
+            }
+
+            if(missed != 0){
+                taskENTER_CRITICAL();
+                jitterHistogramMissed(&scheduleJitter, missed);
+                taskEXIT_CRITICAL();
+            }
+        }
 
-        //clear Queue
-        xQueueReceive(tempHumqueue, &clearQueue, 0);
+        //sleep until the next channel is due, or new settings are
+        //applied. The slot is the grid time itself, not an offset
+        //from now, so the schedule holds however long the board runs.
+        dueUs = temperatureRate.dueUs < humidityRate.dueUs ? temperatureRate.dueUs : humidityRate.dueUs;
+        taskENTER_CRITICAL();
+        readNextDueUs = dueUs;
+        taskEXIT_CRITICAL();
+        scheduled = sleepUntil(dueUs);
 
     }
 }
 
+//Sleep until dueUs on the 64 bit timer. A one shot hardware alarm
+//gives the task notification at dueUs (alarm_wait.h), so the wake is
+//not rounded to the 10 ms tick and nothing spins waiting for it.
+//Returns false if a notification (new settings) ended the sleep early.
+bool sleepUntil(uint64_t dueUs)
+{
+    return alarmWaitUntil(dueUs, 0);
+}
 
-//Function to read a return the Configuration Register Status
-//Value will be printed once at the beginning of the
-//readHDC1080Task  task
-int readConfigReg(){
+//Hand a record to core 1 and wake it. The ring only fills if core 1
+//has fallen SAMPLERINGLEN samples behind; the record is then dropped,
+//counted in sampleRing.dropped for the stats report, and said on the
+//console.
+void sendToCore1(const SampleRecord_t *record)
+{
+    if(spscRingPush(&sampleRing, record)){
+        eventTraceRecord(EVENTTRACERINGPUSH, 0, (uint16_t)record->sequence);
+    }
+    else{
+        consolePrintf("Sample %lu dropped, core 1 is behind, %lu dropped\n", (unsigned long)record->sequence,
+                      (unsigned long)sampleRing.dropped);
+    }
+    __sev();
+}
 
-    uint8_t cfReg[2];    
-    uint8_t cfRegVal = HDC1080CONFIGREG;
+//Read the channels asked for count times and average the raw codes,
+//rounding. The channel not read keeps its value in sample.
+bool readOversampled(int count, bool temperature, bool humidity, HDC1080Sample_t *sample)
+{
+    uint32_t sumTemperature = 0;
+    uint32_t sumHumidity = 0;
+    uint8_t retried = 0;
+    int i;
+
+    //both channels due, or coalesced, is one trigger and one 4 byte
+    //read; one alone needs split mode. The mode is only written when
+    //it changes, which the coalescing keeps rare.
+    if(!hdc1080SetAcquisitionMode(&sensors[0], temperature && humidity)){
+        return false;
+    }
 
-    int ret;
+    for(i = 0; i < count; i++){
+        if(!hdc1080ReadChannels(&sensors[0], temperature, humidity, sample)){
+            return false;
+        }
+        sumTemperature += sample->rawTemperature;
+        sumHumidity += sample->rawHumidity;
+        retried |= sample->flags & HDC1080RETRIED;
+    }
 
-      //write blocking for Configuration Register
-      ret = i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &cfRegVal, 1, false);
-      vTaskDelay(100/portTICK_PERIOD_MS);
+    sample->rawTemperature = (uint16_t)((sumTemperature + count / 2) / count);
+    sample->rawHumidity = (uint16_t)((sumHumidity + count / 2) / count);
+    sample->flags |= retried;
+    return true;
+}
 
-      //read blocking. Read Configuration Register
-      ret = i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, cfReg, 2, false);
-      int fullcfReg = cfReg[0]<<8|cfReg[1];
+//Read both channels of every sensor count times, each time with one
+//hdc1080Scan so their conversions overlap, and average each sensor's
+//raw codes, rounding. Every sensor's reading goes to sensorSamples
+//for the sensors command and the first one's raw codes to sample.
+//Returns false if the first sensor failed.
+bool readScanned(int count, HDC1080Sample_t *sample)
+{
+    const uint8_t bothValid = HDC1080VALIDTEMPERATURE | HDC1080VALIDHUMIDITY;
+    HDC1080Sample_t scanned[SENSORSMAX];
+    uint32_t sumTemperature[SENSORSMAX];
+    uint32_t sumHumidity[SENSORSMAX];
+    bool good[SENSORSMAX];
+    bool ok[SENSORSMAX];
+    uint32_t faults = sensorBus.stats.retries + sensorBus.stats.recoveries;
+    uint64_t startUs = time_us_64();
+    uint32_t scanUs;
+    int i;
+    int n;
+
+    memset(scanned, 0, sizeof(scanned));
+    for(i = 0; i < sensorCount; i++){
+        sumTemperature[i] = 0;
+        sumHumidity[i] = 0;
+        good[i] = true;
+    }
 
-      return fullcfReg;
+    for(n = 0; n < count; n++){
+        hdc1080Scan(sensors, sensorCount, scanned, ok);
+        for(i = 0; i < sensorCount; i++){
+            good[i] = good[i] && ok[i];
+            sumTemperature[i] += scanned[i].rawTemperature;
+            sumHumidity[i] += scanned[i].rawHumidity;
+        }
+    }
+    scanUs = (uint32_t)((time_us_64() - startUs) / count);
+
+    for(i = 0; i < sensorCount; i++){
+        if(good[i]){
+            scanned[i].rawTemperature = (uint16_t)((sumTemperature[i] + count / 2) / count);
+            scanned[i].rawHumidity = (uint16_t)((sumHumidity[i] + count / 2) / count);
+            scanned[i].flags |= bothValid;
+            hdc1080ConvertSample(&scanned[i]);
+        }
+        else{
+            scanned[i].flags &= ~bothValid;
+        }
+    }
 
-}
+    taskENTER_CRITICAL();
+    memcpy(sensorSamples, scanned, sensorCount * sizeof(scanned[0]));
+    sensorScanUs = scanUs;
+    taskEXIT_CRITICAL();
+
+    if(!good[0]){
+        return false;
+    }
 
-//Function to read and return the Manufacturing ID
-//Value will be printed once at the beginning of the
-//readHDC1080Task  task
-int readMFID(){
+    sample->rawTemperature = scanned[0].rawTemperature;
+    sample->rawHumidity = scanned[0].rawHumidity;
+    sample->flags |= bothValid;
+    if(sensorBus.stats.retries + sensorBus.stats.recoveries != faults){
+        sample->flags |= HDC1080RETRIED;
+    }
+    else{
+        sample->flags &= ~HDC1080RETRIED;
+    }
+    return true;
+}
 
-    	uint8_t manufactID[2];
-      uint8_t mfVal = HDC1080DEVICEIDREG;
-      int ret;
+//Print hundredths as a decimal, e.g. -5 as -0.05
+void printCenti(const char *label, int32_t centi)
+{
+    int32_t magnitude = centi < 0 ? -centi : centi;
 
-      //write blocking for MF ID
-      ret = i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &mfVal, 1, false);
-      vTaskDelay(100/portTICK_PERIOD_MS);
+    printf("%s%s%d.%02d\n", label, centi < 0 ? "-" : "", (int)(magnitude / 100), (int)(magnitude % 100));
+}
 
-      //read blocking. Return Full Manufacturing ID
-      ret = i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, manufactID, 2, false);
-      int fullMfID = manufactID[0]<<8|manufactID[1];
+//Write one sample to USB, as text or through the telemetry encoder
+void outputSample(TelemetryEncoder_t *telemetry, const RuntimeConfig_t *config, const SampleRecord_t *record)
+{
+    const uint8_t bothValid = HDC1080VALIDTEMPERATURE | HDC1080VALIDHUMIDITY;
+    TelemetryRecord_t telemetryRecord;
+    size_t frameLength;
+    size_t i;
 
-      return fullMfID;
+    if(!tud_cdc_connected()){
+        return;
+    }
 
+    if(config->output == RUNTIMECONFIGOUTPUTBINARY){
+        //frames carry only good readings, a failed one shows on the
+        //host as a gap in the sequence numbers
+        if((record->sample.flags & bothValid) != bothValid){
+            return;
+        }
+        telemetryRecord.sequence = record->sequence;
+        telemetryRecord.timeMs = (uint32_t)(record->timestampUs / 1000);
+        telemetryRecord.rawTemperature = record->sample.rawTemperature;
+        telemetryRecord.rawHumidity = record->sample.rawHumidity;
+        frameLength = telemetryEncode(telemetry, &telemetryRecord);
+        for(i = 0; i < frameLength; i++){
+            putchar_raw(telemetry->frame[i]);
+        }
+    }
+    else{
+        if(record->sample.flags & HDC1080VALIDTEMPERATURE){
+            printCenti("Temperature in C: ", record->sample.centiC);
+            printCenti("Temperature in F: ", record->sample.centiF);
+        }
+        else{
+            printf("Temperature: no reading\n");
+        }
+        if(record->sample.flags & HDC1080VALIDHUMIDITY){
+            printCenti("Humidity ", record->sample.centiRH);
+        }
+        else{
+            printf("Humidity: no reading\n");
+        }
+        if(record->derived.centiDewPointC != PSYCHRONOVALUE){
+            printCenti("Dew point in C: ", record->derived.centiDewPointC);
+        }
+        if(record->derived.centiAbsHumidity != PSYCHRONOVALUE){
+            printCenti("Absolute humidity g/m3: ", record->derived.centiAbsHumidity);
+            printCenti("Heat index in F: ", record->derived.centiHeatIndexF);
+        }
+    }
+    stdio_flush();
 }
 
-//Function to read and return the 1st block of the Serial Number
-//Value will be printed once at the beginning of the
-//readHDC1080Task  task
-int readSN1(){
+//Pick the value the display shows for a sample, dashes for a channel
+//whose last read failed
+int displayValue(const RuntimeConfig_t *config, const SampleRecord_t *record, bool showTemperature)
+{
+    if(!(record->sample.flags & (showTemperature ? HDC1080VALIDTEMPERATURE : HDC1080VALIDHUMIDITY))){
+        return DISPLAYNOVALUE;
+    }
+    if(!showTemperature){
+        return record->sample.humidity;
+    }
+    return config->fahrenheit ? record->sample.temperatureInF : record->sample.temperatureInC;
+}
 
-      uint8_t sn1[2];
-      uint8_t sn1RegVal = HDC1080SN1;
-      int ret;
+//Core 1 runs the display and USB output without FreeRTOS. It sleeps
+//in WFE until core 0 signals a new sample, console message or new
+//settings, or the display dwell time is up. In cycle mode the display
+//switches between humidity and temperature every dwell, otherwise it
+//stays on one, always showing the latest sample. The PIO state
+//machine and DMA keep the digits multiplexed.
+//Temperature in the left half of the MAX7219 chain and humidity in
+//the right. A channel whose read failed shows dashes.
+void chainShow(const RuntimeConfig_t *config, const SampleRecord_t *record)
+{
+    const HDC1080Sample_t *sample = &record->sample;
+    uint8_t segments[SPIDISPLAYDIGITS];
+    int32_t temperature = config->fahrenheit ? sample->centiF : sample->centiC;
+
+    spiDisplayFormat(segments, CHAINFIELDDIGITS,
+                     (sample->flags & HDC1080VALIDTEMPERATURE) ? temperature : SPIDISPLAYNOVALUE, CHAINDECIMALS);
+    spiDisplayFormat(segments + CHAINFIELDDIGITS, SPIDISPLAYDIGITS - CHAINFIELDDIGITS,
+                     (sample->flags & HDC1080VALIDHUMIDITY) ? sample->centiRH : SPIDISPLAYNOVALUE, CHAINDECIMALS);
+    spiDisplaySet(&chainDisplay, segments);
+}
 
-      //write blocking for sn1 register
-      ret = i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &sn1RegVal, 1, false);
-      vTaskDelay(100/portTICK_PERIOD_MS);
+void core1Main()
+{
+    SampleRecord_t record;
+    TelemetryEncoder_t telemetry;
+    RuntimeConfig_t config;
+    uint8_t chainDashes[SPIDISPLAYDIGITS];
+    uint32_t configGeneration;
+    uint8_t previousOutput;
+    absolute_time_t dwellEnd = at_the_end_of_time;
+    size_t frameLength;
+    size_t i;
+    bool haveSample = false;
+    bool showTemperature = false;
+
+    //flash writes on core 0 park this core while XIP is off
+    multicore_lockout_victim_init();
+
+    //set up here so the chain's DMA interrupt is taken on this core
+    spiDisplayRp2040Init(&chainDisplay, spi1, SPIDISPLAYSCKPIN, SPIDISPLAYMOSIPIN, SPIDISPLAYCSPIN,
+                         SPIDISPLAYBAUDRATE);
+
+    //dashes until the first sample, as on the 7 segment display
+    spiDisplayFormat(chainDashes, SPIDISPLAYDIGITS, SPIDISPLAYNOVALUE, 0);
+    spiDisplaySet(&chainDisplay, chainDashes);
+
+    telemetryEncoderInit(&telemetry, TELEMETRYBATCH);
+    configGeneration = runtimeConfigRead(&config);
 
-      //read blocking for sn1
-      ret = i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, sn1, 2, false);
-      int fullSN1 = sn1[0]<<8|sn1[1];
-      
-      return fullSN1;
-}
+    while(true){
 
-//Function to read and return the 2nd block of the Serial Number
-//Value will be printed once at the beginning of the
-//readHDC1080Task  task
-int readSN2(){
+        //new settings take effect between samples
+        if(runtimeConfigGeneration() != configGeneration){
+            previousOutput = config.output;
+            configGeneration = runtimeConfigRead(&config);
+
+            //leaving binary, send the part batch so no sample is lost
+            if(previousOutput == RUNTIMECONFIGOUTPUTBINARY && config.output != RUNTIMECONFIGOUTPUTBINARY){
+                frameLength = telemetryFlush(&telemetry);
+                if(tud_cdc_connected()){
+                    for(i = 0; i < frameLength; i++){
+                        putchar_raw(telemetry.frame[i]);
+                    }
+                    stdio_flush();
+                }
+            }
 
-      uint8_t sn2[2];
-      uint8_t sn2RegVal = HDC1080SN2;
-      int ret;
+            //start the display over in the new mode
+            if(haveSample){
+                showTemperature = config.display == RUNTIMECONFIGDISPLAYTEMPERATURE;
+                dwellEnd = config.display == RUNTIMECONFIGDISPLAYCYCLE ? make_timeout_time_ms(config.dwellMs)
+                                                                       : at_the_end_of_time;
+                displayShow(displayValue(&config, &record, showTemperature));
+                chainShow(&config, &record);
+            }
+        }
 
-      //write blocking for sn1 register
-      ret = i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &sn2RegVal, 1, false);
-      vTaskDelay(100/portTICK_PERIOD_MS);
+        while(spscRingPop(&sampleRing, &record)){
+            eventTraceRecord(EVENTTRACERINGPOP, 1, (uint16_t)record.sequence);
+
+            //first sample starts the display, cycling from humidity
+            //or on the one value, later ones update whichever value
+            //is showing without restarting the dwell, as samples may
+            //come faster than it
+            if(!haveSample){
+                haveSample = true;
+                showTemperature = config.display == RUNTIMECONFIGDISPLAYTEMPERATURE;
+                if(config.display == RUNTIMECONFIGDISPLAYCYCLE){
+                    dwellEnd = make_timeout_time_ms(config.dwellMs);
+                }
+            }
+            displayShow(displayValue(&config, &record, showTemperature));
+            chainShow(&config, &record);
 
-      //read blocking for sn1
-      ret = i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, sn2, 2, false);
-      int fullSN2 = sn2[0]<<8|sn2[1];
-      
-      return fullSN2;
-}
+            outputSample(&telemetry, &config, &record);
+        }
 
-//Function to read and return the 3rd block of the Serial Number
-//Value will be printed once at the beginning of the
-//readHDC1080Task  task
-int readSN3(){
+        consoleService();
 
-      uint8_t sn3[2];
-      uint8_t sn3RegVal = HDC1080SN3;
-      int ret;
+        //send the chain whatever changed, once the last update is out;
+        //its completion interrupt wakes this loop
+        spiDisplayService(&chainDisplay);
 
-      //write blocking for sn1 register
-      ret = i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &sn3RegVal, 1, false);
-      vTaskDelay(100/portTICK_PERIOD_MS);
+        if(haveSample && time_reached(dwellEnd)){
+            //dwell time up, switch to the other value
+            showTemperature = !showTemperature;
+            displayShow(displayValue(&config, &record, showTemperature));
+            dwellEnd = delayed_by_ms(dwellEnd, config.dwellMs);
+        }
 
-      //read blocking for sn1
-      ret = i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, sn3, 2, false);
-      int fullSN3 = sn3[0]<<8|sn3[1];
-      
-      return fullSN3;
+        best_effort_wfe_or_timeout(dwellEnd);
+    }
 }
 
-//This function reads the current temperature from the HDC1080.
-//This function is called once every 10 seconds
-int readTemperature(){
-
-  uint8_t temperatue[2];
-  uint8_t tempRegVal = HDC1080TEMPREG;
-  int ret;
-  int fullTemperatureC;
-  int fullTemperatureF;
+//This task owns the flash log. It stages queued samples, programs a
+//page when the stage fills, and erases the next sector ahead of need.
+//Samples are queued just before the reading task sleeps, so the erase
+//goes in the slack after a reading, and only if the next one is far
+//enough off that it cannot be held up. Otherwise it waits for the
+//next sample; flashLogAppend only erases itself if the log reaches a
+//sector that never got a gap. It also saves the settings for the save
+//command, so it is the only task that writes flash.
+void flashLogTask()
+{
+    FlashLogEntry_t entry;
 
-    //write block for temperature
-      ret = i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &tempRegVal, 1, false);
-      vTaskDelay(100/portTICK_PERIOD_MS);
+    while(true){
 
-      //read block for temperature
-      ret = i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, temperatue, 2, false);
-      int fullTemperature = temperatue[0]<<8|temperatue[1];
+        if(xQueueReceive(flashLogQueue, &entry, portMAX_DELAY) == pdTRUE){
+            if(entry.saveConfig){
+                configSave();
+            }
+            else if(!flashLogAppend(&sampleLog, entry.timeSec, entry.centiC, entry.centiRH)){
+                consolePrintf("Flash log write failed\n");
+            }
+        }
 
-      float actualTempC = (fullTemperature / 65536.0) * 165 - 40;
+        //nothing else queued, get the spare sector ready
+        if(uxQueueMessagesWaiting(flashLogQueue) == 0 && flashSlack()){
+            flashLogService(&sampleLog);
+        }
+    }
+}
 
-      fullTemperatureC = round(actualTempC);
+//True if a sector erase fits before the next reading is due
+bool flashSlack()
+{
+    uint64_t nextReadUs;
 
-      return fullTemperatureC;
+    taskENTER_CRITICAL();
+    nextReadUs = readNextDueUs;
+    taskEXIT_CRITICAL();
 
+    return time_us_64() + FLASHERASEUS <= nextReadUs;
 }
 
-//This function reads the current humidity from the HDC1080
-//This function is called once every 10 seconds
-int readHumidity(){
-
-      uint8_t humidty[2];
-      uint8_t humRegVal = HDC1080HUMREG;
- 
-      int ret;
-      int rndHumidity;
+//The save command's hand over to flashLogTask, called by the parser
+//on commandTask. It never waits for the flash.
+bool configSaveRequest()
+{
+    FlashLogEntry_t entry;
 
-      //write block for humidity
-      ret = i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &humRegVal, 1, false);
-      vTaskDelay(100/portTICK_PERIOD_MS);
+    memset(&entry, 0, sizeof(entry));
+    entry.saveConfig = true;
 
-      //read block for humidity
-      ret = i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, humidty, 2, false);
-      int fullHumidity = humidty[0]<<8|humidty[1];
+    return xQueueSend(flashLogQueue, &entry, 0) == pdTRUE;
+}
 
-      float actualHumidity = (fullHumidity / 65536.0)*100.0;
+//Save the applied settings from flashLogTask. The sector erase waits
+//for slack before the next reading, as the log's own erases do, for
+//up to FLASHSAVEWAITMS.
+void configSave()
+{
+    RuntimeConfig_t config;
+    TickType_t start = xTaskGetTickCount();
 
-      rndHumidity = round(actualHumidity);      
+    while(!flashSlack() && xTaskGetTickCount() - start < pdMS_TO_TICKS(FLASHSAVEWAITMS)){
+        vTaskDelay(1);
+    }
 
-      return rndHumidity;
+    runtimeConfigRead(&config);
+    commandReply(runtimeConfigSave(&runtimeConfigRp2040Storage, &config) ? "ok saved" : "err save failed");
+}
 
+//Wait for a free console slot, so a long report is paced to USB
+//rather than dropped
+void consoleWait()
+{
+    while(consoleFree() == 0){
+        vTaskDelay(1);
+    }
 }
 
-//This function controls numbers displayed on the left number
-//of the 7 segment LED. segLEDLeft and segLED right share
-//the ledSem semaphore to alternate blinking sides
-//quickly so there is no flashing.
-void segLEDLeft()
+//This task prints the runtime stats or the schedule jitter, or dumps
+//the event trace, when the command task passes on a request. A stats
+//snapshot covers the time since the previous one. Tracing goes on
+//while the rings are copied out; a dump holds what was recorded when
+//it was asked for.
+void reportTask()
 {
-    const uint LED_PIN = PICO_DEFAULT_LED_PIN;
-    // initialize digital pin LED_BUILTIN as an output.
-    gpio_init(SevenSegA);   //top bar
-    gpio_init(SevenSegB);   //top right
-    gpio_init(SevenSegC);   //bottom right?
-    gpio_init(SevenSegD);   //bottom bar
-    gpio_init(SevenSegE);   //bottom left
-    gpio_init(SevenSegF);   //Top Left
-    gpio_init(SevenSegG);   //Middle
-    gpio_init(SevenSegDP);  //decimal points
-
-    gpio_init(SevenSegCC1);
-    gpio_init(SevenSegCC2);
-
-    gpio_set_dir(SevenSegA, GPIO_OUT);  //top bar
-    gpio_set_dir(SevenSegB, GPIO_OUT);  //top right
-    gpio_set_dir(SevenSegC, GPIO_OUT);  //bottom right?
-    gpio_set_dir(SevenSegD, GPIO_OUT);  //bottom bar
-    gpio_set_dir(SevenSegE, GPIO_OUT);  //bottom left
-    gpio_set_dir(SevenSegF, GPIO_OUT);  //Top Left
-    gpio_set_dir(SevenSegG, GPIO_OUT);  //Middle
-    gpio_set_dir(SevenSegDP, GPIO_OUT); //Decimal points
-
-    gpio_set_dir(SevenSegCC1, GPIO_OUT);
-    gpio_set_dir(SevenSegCC2, GPIO_OUT);
-
-    gpio_init(LED_PIN);
-    gpio_set_dir(LED_PIN, GPIO_OUT);
-
-    int leftNum;
+    RuntimeStatsSnapshot_t snapshot;
+    JitterHistogram_t jitter;
+    SampleRecord_t record;
+    char line[CONSOLEMESSAGEMAX];
+    uint8_t chunk[CONSOLEMESSAGEMAX];
+    EventTraceDump_t dump;
+    uint32_t lastSequence = 0;
+    int length;
+    int core;
+    int i;
+
+    if(!sampleCellSubscribe(&latestSample)){
+        consolePrintf("Report task could not subscribe to samples\n");
+    }
 
     while(true){
-        
-        //initialize counter variable
-        int i;
-
-        //peek at current value in the queue and get the left
-        //side by dividing by 10
-        if(xQueuePeek(tempHumqueue, &leftNum, 0)){
-            leftNum = leftNum / 10;
-        }
 
-        //switch case for which segments to light up on the left
-        //side of the 7 segment led to display leftNum.
-        //In each case, this
-        //function will take and release the shared semaphore.
-        switch(leftNum){
-
-        //Case 0
-        case 0 :
-            for (i = 0; i < 15; i++){
-                xSemaphoreTake(ledSem, 1);
-                
-                gpio_put(SevenSegCC1, 0);   //right multiplex
-                gpio_put(SevenSegCC2, 1);   //left multiplex
-                gpio_put(SevenSegA, 1);    //top bar   
-                gpio_put(SevenSegB, 1);    //top right  
-                gpio_put(SevenSegC, 1);    //bottom right
-                gpio_put(SevenSegD, 1);    //bottom bar
-                gpio_put(SevenSegE, 1);    //bottom left
-                gpio_put(SevenSegF, 1);    //Top Left
-                gpio_put(SevenSegG, 0);    //Middle              
-                
-                xSemaphoreGive(ledSem);
-                
-                vTaskDelay(1/portTICK_PERIOD_MS);
+        //Sleep until the next sample is published, or REPORTPOLLMS to
+        //look for a request; watch prints each sample as it arrives
+        if(sampleCellWait(&latestSample, lastSequence, &record, pdMS_TO_TICKS(REPORTPOLLMS))){
+            lastSequence = record.sequence;
+            if(watchSamples){
+                consoleWait();
+                consolePrintf("watch sequence=%lu flags=%u centi_c=%ld centi_rh=%ld\n",
+                              (unsigned long)record.sequence, record.sample.flags, (long)record.sample.centiC,
+                              (long)record.sample.centiRH);
             }
-            break;
-
-        //case 1
-        case 1 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 0);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 0);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 0);    //Middle             
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 2
-        case 2 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 0);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 1);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                            
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
         }
-        break;
-
-        //case 3
-        case 3 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle               
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 4
-        case 4 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 0);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 0);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle              
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 5
-        case 5 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 0);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                 
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 6
-        case 6 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 0);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 1);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 7
-        case 7 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 0);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 0);    //Middle               
-            
-            xSemaphoreGive(ledSem);
-
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 8
-        case 8 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 1);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                
-            
-            xSemaphoreGive(ledSem);
-
-            vTaskDelay(1/portTICK_PERIOD_MS);
+
+        if(runtimeStatsTakeRequest()){
+            runtimeStatsCollect(&snapshot);
+            snapshot.sampleRingDropped = sampleRing.dropped;
+            snapshot.flashLogDropped = flashLogDropped + sampleLog.dropped;
+            snapshot.consoleDropped = consoleDropped();
+            for(i = 0; runtimeStatsFormat(&snapshot, i, line, sizeof(line)) > 0; i++){
+                consoleWait();
+                consolePrintf("%s", line);
+            }
         }
-        break;
-
-        //case 9
-        case 9 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 0);   //right multiplex
-            gpio_put(SevenSegCC2, 1);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                
-            
-            xSemaphoreGive(ledSem);
-
-            vTaskDelay(1/portTICK_PERIOD_MS);
+
+        if(jitterHistogramTakeRequest()){
+            taskENTER_CRITICAL();
+            jitter = scheduleJitter;
+            taskEXIT_CRITICAL();
+            for(i = 0; jitterHistogramFormat(&jitter, i, line, sizeof(line)) > 0; i++){
+                consoleWait();
+                consolePrintf("%s", line);
+            }
         }
-        break;
+
+        if(eventTraceTakeRequest()){
+            eventTraceDumpBegin(&dump);
+            for(core = 0; core < 2; core++){
+                while((length = eventTraceDumpChunk(&dump, core, chunk, sizeof(chunk))) > 0){
+                    consoleWait();
+                    consoleWrite(chunk, length);
+                }
+            }
         }
     }
 }
 
-//This function controls numbers displayed on the right number
-//of the 7 segment LED. segLEDLeft and segLED right share
-//the ledSem semaphore to alternate blinking sides
-//quickly so there is no flashing.
-void segLEDRight()
+//Compiled in settings, used when none are saved in flash and by the
+//defaults command
+void configDefaults(RuntimeConfig_t *config)
 {
-    const uint LED_PIN = PICO_DEFAULT_LED_PIN;
-    // initialize digital pin LED_BUILTIN as an output.
-    gpio_init(SevenSegA);   //top bar
-    gpio_init(SevenSegB);   //top right
-    gpio_init(SevenSegC);   //bottom right?
-    gpio_init(SevenSegD);   //bottom bar
-    gpio_init(SevenSegE);   //bottom left
-    gpio_init(SevenSegF);   //Top Left
-    gpio_init(SevenSegG);   //Middle
-    gpio_init(SevenSegDP);  //decimal points
-
-    gpio_init(SevenSegCC1);
-    gpio_init(SevenSegCC2);
-
-    gpio_set_dir(SevenSegA, GPIO_OUT);  //top bar
-    gpio_set_dir(SevenSegB, GPIO_OUT);  //top right
-    gpio_set_dir(SevenSegC, GPIO_OUT);  //bottom right?
-    gpio_set_dir(SevenSegD, GPIO_OUT);  //bottom bar
-    gpio_set_dir(SevenSegE, GPIO_OUT);  //bottom left
-    gpio_set_dir(SevenSegF, GPIO_OUT);  //Top Left
-    gpio_set_dir(SevenSegG, GPIO_OUT);  //Middle
-    gpio_set_dir(SevenSegDP, GPIO_OUT); //Decimal points
-
-    gpio_set_dir(SevenSegCC1, GPIO_OUT);
-    gpio_set_dir(SevenSegCC2, GPIO_OUT);
-
-    gpio_init(LED_PIN);
-    gpio_set_dir(LED_PIN, GPIO_OUT);
-
-    int rightNum;
+    const AdaptiveRateConfig_t temperatureRate = ADAPTIVERATETEMPERATURE;
+    const AdaptiveRateConfig_t humidityRate = ADAPTIVERATEHUMIDITY;
+    const SampleFilterConfig_t temperatureFilter = TEMPFILTER;
+    const SampleFilterConfig_t humidityFilter = HUMFILTER;
+
+    memset(config, 0, sizeof(*config));
+    config->temperatureRate = temperatureRate;
+    config->humidityRate = humidityRate;
+    config->temperatureFilter = temperatureFilter;
+    config->humidityFilter = humidityFilter;
+    config->dwellMs = DISPLAYDWELLMS;
+    config->temperatureResolution = TEMPRESOLUTION;
+    config->humidityResolution = HUMRESOLUTION;
+    config->oversample = SAMPLEOVERSAMPLE;
+    config->output = TELEMETRYBINARY ? RUNTIMECONFIGOUTPUTBINARY : RUNTIMECONFIGOUTPUTTEXT;
+    config->display = DISPLAYMODE;
+    config->fahrenheit = DISPLAYFAHRENHEIT;
+}
 
-    while(true){
+//One line of a command's answer, through the console like any
+//other output
+void commandReply(const char *text)
+{
+    consoleWait();
+    consolePrintf("%s\n", text);
+}
 
-        //initialize variables for counter
-        int i;
-        
-        //peek at number in the queue and get the right digit by
-        //perfoming a mod on the number in the queue
-        if(xQueuePeek(tempHumqueue, &rightNum, 0)){
-            rightNum = rightNum % 10;
-        }
-        
-        //Switch case to determine which segments of the right digit
-        //on the 7 segment led to light up based on rightNum. 
-        //In each case, this
-        //function will take and release the shared semaphore.
-        switch(rightNum){
-        //Case 0
-        case 0 :
-        for (i = 0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 1);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 0);    //Middle              
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 1
-        case 1 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 0);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 0);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 0);    //Middle              
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 2
-        case 2 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 0);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 1);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle             
-            
-            xSemaphoreGive(ledSem);
-           
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 3
-        case 3 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle  
-                               
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 4
-        case 4 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 0);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 0);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle  
-                          
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 5
-        case 5 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-            
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 0);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                 
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 6
-        case 6 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 0);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 1);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                
-            
-            xSemaphoreGive(ledSem);
-            
-            vTaskDelay(1/portTICK_PERIOD_MS);
-        }
-        break;
-
-        //case 7
-        case 7 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 0);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 0);    //Top Left
-            gpio_put(SevenSegG, 0);    //Middle               
-            
-            xSemaphoreGive(ledSem);
-
-            vTaskDelay(1/portTICK_PERIOD_MS);
+//Answer the now command from the sample cell, without waiting on the
+//reading task
+void commandNow()
+{
+    SampleRecord_t record;
+    char reply[RUNTIMECONFIGREPLYMAX];
+
+    if(!sampleCellRead(&latestSample, &record)){
+        commandReply("err no sample yet");
+        return;
+    }
+
+    snprintf(reply, sizeof(reply), "sequence=%lu age_ms=%lu flags=%u", (unsigned long)record.sequence,
+             (unsigned long)((time_us_64() - record.timestampUs) / 1000), record.sample.flags);
+    commandReply(reply);
+    snprintf(reply, sizeof(reply), "centi_c=%ld centi_rh=%ld", (long)record.sample.centiC,
+             (long)record.sample.centiRH);
+    commandReply(reply);
+    snprintf(reply, sizeof(reply), "centi_dew_c=%ld", (long)record.derived.centiDewPointC);
+    commandReply(reply);
+    commandReply("ok");
+}
+
+//Answer the sensors command with the latest reading of each sensor
+//the scan reads, then how long the scan took:
+//
+//  sensor=<n> mux=0x<address> channel=<n> flags=<n>
+//  centi_c=<n> centi_rh=<n>
+//  scan_us=<n>
+void commandSensors()
+{
+    HDC1080Sample_t samples[SENSORSMAX];
+    char reply[RUNTIMECONFIGREPLYMAX];
+    uint32_t scanUs;
+    int count = sensorCount;
+    int i;
+
+    if(count < 2){
+        commandReply("err no scan, one sensor");
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    memcpy(samples, sensorSamples, count * sizeof(samples[0]));
+    scanUs = sensorScanUs;
+    taskEXIT_CRITICAL();
+    if(scanUs == 0){
+        commandReply("err no sample yet");
+        return;
+    }
+
+    for(i = 0; i < count; i++){
+        snprintf(reply, sizeof(reply), "sensor=%d mux=0x%02X channel=%u flags=%u", i, sensors[i].muxAddress,
+                 sensors[i].muxChannel, samples[i].flags);
+        commandReply(reply);
+        snprintf(reply, sizeof(reply), "centi_c=%ld centi_rh=%ld", (long)samples[i].centiC,
+                 (long)samples[i].centiRH);
+        commandReply(reply);
+    }
+    snprintf(reply, sizeof(reply), "scan_us=%lu", (unsigned long)scanUs);
+    commandReply(reply);
+    commandReply("ok");
+}
+
+//Answer "history minute|hour [count]", oldest first, one line per
+//bucket with the min, mean and max of each channel:
+//
+//  bucket start_s=<n> count=<n> c=<min>/<mean>/<max> rh=<min>/<mean>/<max>
+//
+//The reading task adds to the history, so each bucket is copied in a
+//critical section, found by its start time so a rollover part way
+//through does not shift the rest.
+void commandHistory(const char *args)
+{
+    HistoryBucket_t bucket;
+    HistoryResolution_t resolution;
+    char unit[8];
+    char reply[128];
+    unsigned long count = 0;
+    uint32_t periodSec;
+    uint32_t newestSec;
+    int32_t meanC;
+    int32_t meanRH;
+    bool found;
+    unsigned long i;
+
+    if(sscanf(args, "%7s %lu", unit, &count) < 1){
+        commandReply("err history needs minute or hour");
+        return;
+    }
+    if(strcmp(unit, "minute") == 0){
+        resolution = HISTORYMINUTE;
+        periodSec = 60;
+        count = count != 0 ? count : 60;
+    }
+    else if(strcmp(unit, "hour") == 0){
+        resolution = HISTORYHOUR;
+        periodSec = 3600;
+        count = count != 0 ? count : 24;
+    }
+    else{
+        commandReply("err history needs minute or hour");
+        return;
+    }
+    if(count > (resolution == HISTORYHOUR ? HISTORYHOURS : HISTORYMINUTES)){
+        commandReply("err history count past the ring");
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    found = historyQuery(&sampleHistory, resolution, &bucket, 1) == 1;
+    taskEXIT_CRITICAL();
+    if(!found){
+        commandReply("err no history yet");
+        return;
+    }
+    newestSec = bucket.startSec;
+
+    for(i = count; i > 0; i--){
+        if(newestSec < (i - 1) * periodSec){
+            continue;
         }
-        break;
-
-        //case 8
-        case 8 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 1);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                
-            
-            xSemaphoreGive(ledSem);
-
-            vTaskDelay(1/portTICK_PERIOD_MS);
+        taskENTER_CRITICAL();
+        found = historyBucketAt(&sampleHistory, resolution, newestSec - (uint32_t)(i - 1) * periodSec, &bucket);
+        taskEXIT_CRITICAL();
+        if(!found){
+            continue;
         }
-        break;
-
-        //case 9
-        case 9 :
-        for(i=0; i < 15; i++){
-            xSemaphoreTake(ledSem, 1);
-
-            gpio_put(SevenSegCC1, 1);   //right multiplex
-            gpio_put(SevenSegCC2, 0);   //left multiplex
-            gpio_put(SevenSegA, 1);    //top bar   
-            gpio_put(SevenSegB, 1);    //top right  
-            gpio_put(SevenSegC, 1);    //bottom right
-            gpio_put(SevenSegD, 1);    //bottom bar
-            gpio_put(SevenSegE, 0);    //bottom left
-            gpio_put(SevenSegF, 1);    //Top Left
-            gpio_put(SevenSegG, 1);    //Middle                
-            
-            xSemaphoreGive(ledSem);
-
-            vTaskDelay(1/portTICK_PERIOD_MS);
+
+        if(historyMean(&bucket, &meanC, &meanRH)){
+            snprintf(reply, sizeof(reply), "bucket start_s=%lu count=%lu c=%d/%ld/%d rh=%u/%ld/%u",
+                     (unsigned long)bucket.startSec, (unsigned long)bucket.count, bucket.minC, (long)meanC,
+                     bucket.maxC, bucket.minRH, (long)meanRH, bucket.maxRH);
         }
-        break;
+        else{
+            snprintf(reply, sizeof(reply), "bucket start_s=%lu count=0", (unsigned long)bucket.startSec);
         }
+        commandReply(reply);
     }
+    commandReply("ok");
 }
 
+//This task collects command lines from USB and runs them. Settings
+//changes are checked and staged by the parser; when one is applied
+//the reading task and core 1 are woken to take it up rather than
+//waiting out their sleep.
+void commandTask()
+{
+    RuntimeConfigParser_t parser;
+    RuntimeConfig_t defaults;
+    char line[RUNTIMECONFIGLINEMAX];
+    int length = 0;
+    bool overlong = false;
+    int c;
+
+    configDefaults(&defaults);
+    runtimeConfigParserInit(&parser, &defaults, &runtimeConfigRp2040Storage);
+    parser.save = configSaveRequest;
 
+    while(true){
 
+        vTaskDelay(COMMANDPOLLMS/portTICK_PERIOD_MS);
+
+        while((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT){
+
+            if(c != '\n' && c != '\r'){
+                //keep the start of an overlong line, it is refused
+                //as a whole when it ends
+                if(length < (int)sizeof(line) - 1){
+                    line[length++] = (char)c;
+                }
+                else{
+                    overlong = true;
+                }
+                continue;
+            }
+            line[length] = '\0';
+
+            if(overlong){
+                commandReply("err line too long");
+            }
+            else if(strcmp(line, "stats") == 0 || strcmp(line, "s") == 0){
+                runtimeStatsRequest();
+            }
+            else if(strcmp(line, "trace") == 0 || strcmp(line, "t") == 0){
+                eventTraceRequest();
+            }
+            else if(strcmp(line, "jitter") == 0 || strcmp(line, "j") == 0){
+                jitterHistogramRequest();
+            }
+            else if(strcmp(line, "now") == 0 || strcmp(line, "n") == 0){
+                commandNow();
+            }
+            else if(strcmp(line, "watch") == 0 || strcmp(line, "w") == 0){
+                watchSamples = !watchSamples;
+                commandReply(watchSamples ? "ok watching" : "ok");
+            }
+            else if(strcmp(line, "sensors") == 0){
+                commandSensors();
+            }
+            else if(strncmp(line, "history", 7) == 0 && (line[7] == '\0' || line[7] == ' ')){
+                commandHistory(line + 7);
+            }
+            else{
+                //stamped ahead of the command, so it is in place
+                //before the reading task can see a new generation
+                taskENTER_CRITICAL();
+                configAppliedUs = time_us_64();
+                taskEXIT_CRITICAL();
+                if(runtimeConfigCommand(&parser, line, commandReply)){
+                    xTaskNotifyGive(readTaskHandle);
+                    __sev();
+                }
+            }
+            length = 0;
+            overlong = false;
+        }
+    }
+}
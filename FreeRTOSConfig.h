@@ -17,7 +17,7 @@
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
 #define configUSE_TASK_NOTIFICATIONS            1
-#define configTASK_NOTIFICATION_ARRAY_ENTRIES   3
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   4
 #define configUSE_MUTEXES                       1
 #define configUSE_RECURSIVE_MUTEXES             0
 #define configUSE_COUNTING_SEMAPHORES           0
@@ -30,9 +30,18 @@
 #define configSTACK_DEPTH_TYPE                  uint16_t
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
 
-/* Memory allocation related definitions. */
+/* Memory allocation related definitions. ASSIGN6STATIC is set by the
+   CMake option of the same name, see rtos_static.h. */
+#ifndef ASSIGN6STATIC
+#define ASSIGN6STATIC                           0
+#endif
+#if ASSIGN6STATIC
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+#else
 #define configSUPPORT_STATIC_ALLOCATION         0
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
+#endif
 #define configAPPLICATION_ALLOCATED_HEAP        1
 
 /* Hook function related definitions. */
@@ -43,8 +52,8 @@
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
-#define configUSE_TRACE_FACILITY                0
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
 /* Co-routine related definitions. */
@@ -70,7 +79,7 @@
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
-#define INCLUDE_uxTaskGetStackHighWaterMark     0
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
@@ -79,6 +88,25 @@
 #define INCLUDE_xTaskGetHandle                  0
 #define INCLUDE_xTaskResumeFromISR              1
 
-/* A header file that defines trace macro can be included here. */
+/* Run time stats from the 1 MHz hardware timer and per task context
+ * switch counts, see runtime_stats.c. The timer is always running.
+ * Context switches and queue/semaphore operations also go to the
+ * event trace, see event_trace.c. */
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+#include "event_trace.h"
+uint32_t runtimeStatsCounter( void );
+void runtimeStatsSwitchedIn( uint32_t taskNumber );
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        runtimeStatsCounter()
+#define traceTASK_SWITCHED_IN()                                                                     \
+    do {                                                                                            \
+        runtimeStatsSwitchedIn( pxCurrentTCB->uxTCBNumber );                                        \
+        eventTraceRecord( EVENTTRACETASKSWITCH, 0, ( uint16_t ) pxCurrentTCB->uxTCBNumber );        \
+    } while( 0 )
+#define traceQUEUE_SEND( pxQueue )              eventTraceRecord( EVENTTRACEQUEUESEND, ( pxQueue )->ucQueueType, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceQUEUE_RECEIVE( pxQueue )           eventTraceRecord( EVENTTRACEQUEUERECEIVE, ( pxQueue )->ucQueueType, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceQUEUE_PEEK( pxQueue )              eventTraceRecord( EVENTTRACEQUEUEPEEK, ( pxQueue )->ucQueueType, ( uint16_t ) ( pxQueue )->uxQueueNumber )
 
 #endif /* FREERTOS_CONFIG_H */
\ No newline at end of file
@@ -0,0 +1,88 @@
+//Adaptive sample rate, see adaptive_rate.h
+//Timestamps are uint64_t microseconds from boot, so unlike the 32 bit
+//millisecond tick there is no wrap to guard against.
+
+#include <stdlib.h>
+
+#include "adaptive_rate.h"
+
+void adaptiveRateInit(AdaptiveRate_t *rate, const AdaptiveRateConfig_t *config, uint64_t nowUs){
+
+    rate->config = *config;
+    rate->periodMs = config->minPeriodMs;
+    rate->dueUs = nowUs;
+    rate->lastUs = nowUs;
+    rate->lastValue = 0;
+    rate->haveLast = false;
+}
+
+bool adaptiveRateDue(const AdaptiveRate_t *rate, uint64_t nowUs){
+
+    return nowUs >= rate->dueUs;
+}
+
+uint64_t adaptiveRateWaitUs(const AdaptiveRate_t *rate, uint64_t nowUs){
+
+    return rate->dueUs > nowUs ? rate->dueUs - nowUs : 0;
+}
+
+//Move dueUs on one period, then past any slots nowUs has already
+//passed. Returns the slots passed over.
+static uint32_t advance(AdaptiveRate_t *rate, uint64_t nowUs){
+
+    uint64_t periodUs = (uint64_t)rate->periodMs * 1000;
+    uint64_t missed = 0;
+
+    rate->dueUs += periodUs;
+
+    if(nowUs > rate->dueUs && periodUs > 0){
+        missed = (nowUs - rate->dueUs + periodUs - 1) / periodUs;
+        rate->dueUs += missed * periodUs;
+    }
+    else if(nowUs > rate->dueUs){
+        rate->dueUs = nowUs;
+    }
+
+    return missed > UINT32_MAX ? UINT32_MAX : (uint32_t)missed;
+}
+
+uint32_t adaptiveRateUpdate(AdaptiveRate_t *rate, int32_t value, uint64_t nowUs){
+
+    const AdaptiveRateConfig_t *config = &rate->config;
+    uint64_t elapsedUs = nowUs - rate->lastUs;
+    int32_t change = abs(value - rate->lastValue);
+    int64_t perMin;
+
+    if(!rate->haveLast){
+        //nothing to compare with yet, stay fast
+        rate->periodMs = config->minPeriodMs;
+    }
+    else{
+        if(elapsedUs == 0){
+            elapsedUs = 1;
+        }
+        perMin = (int64_t)change * 60000000 / (int64_t)elapsedUs;
+
+        if(change > config->deadband && perMin >= config->thresholdPerMin){
+            rate->periodMs = config->minPeriodMs;
+        }
+        else{
+            //by at least 1 ms, or a 1 ms period would never grow
+            rate->periodMs += rate->periodMs > 1 ? rate->periodMs / 2 : 1;
+            if(rate->periodMs > config->maxPeriodMs || rate->periodMs < config->minPeriodMs){
+                rate->periodMs = config->maxPeriodMs;
+            }
+        }
+    }
+
+    rate->lastValue = value;
+    rate->lastUs = nowUs;
+    rate->haveLast = true;
+
+    return advance(rate, nowUs);
+}
+
+uint32_t adaptiveRateSkip(AdaptiveRate_t *rate, uint64_t nowUs){
+
+    return advance(rate, nowUs);
+}
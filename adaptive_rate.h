@@ -0,0 +1,75 @@
+//Adaptive sample rate
+//One scheduler per channel. After each reading the rate of change
+//since the previous one decides the next interval: past the threshold
+//the channel drops straight to its fastest period so a transient is
+//followed closely, otherwise the period grows by half again each time
+//up to the slowest period, the floor rate while readings are stable.
+//A config with minPeriodMs == maxPeriodMs samples at a fixed rate.
+//
+//Readings are due on an absolute grid: the next one is a period after
+//the slot just taken, not after the time it was read, so however long
+//a read takes the schedule does not drift. A reading so late that
+//later slots have already passed drops them rather than running them
+//back to back.
+//
+//The grid is kept in 64 bit microseconds, the time_us_64 clock, so
+//slots land exactly on it and it does not wrap in the life of the
+//board. Periods are set in milliseconds.
+//
+//Pure logic on timestamps passed in, so it runs unchanged on the
+//host (tools/adaptive_replay.c, tools/schedule_drift.c).
+
+#ifndef ADAPTIVE_RATE_H
+#define ADAPTIVE_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t minPeriodMs;       //fastest, while the signal is moving
+    uint32_t maxPeriodMs;       //slowest, while it is stable
+    int32_t thresholdPerMin;    //change per minute that counts as moving
+    int32_t deadband;           //changes this small are noise
+} AdaptiveRateConfig_t;
+
+//Settings for the HDC1080 channels in hundredths, shared by the
+//firmware and the replay tool. Temperature follows anything past
+//0.5 C/min, humidity past 2 %RH/min; both settle at one reading
+//every 30 s, a third of the reads of the old fixed 10 s schedule. The
+//cost is the start of a transient that begins while a channel is
+//settled, which is only seen at its next reading; tools/adaptive_replay.c
+//prints the reads against the error for a range of floors. A trend
+//slower than one deadband per minPeriodMs settles at the period where
+//its change per reading clears the deadband.
+#define ADAPTIVERATETEMPERATURE {1000, 30000, 50, 5}
+#define ADAPTIVERATEHUMIDITY {1000, 30000, 200, 20}
+
+//When one channel is read, the other is read with it if it is due
+//within this long, saving a second wake up and transfer
+#define ADAPTIVERATECOALESCEMS 2000
+
+typedef struct {
+    AdaptiveRateConfig_t config;
+    uint32_t periodMs;
+    uint64_t dueUs;             //slot on the grid, nextDueUs += periodUs
+    uint64_t lastUs;
+    int32_t lastValue;
+    bool haveLast;
+} AdaptiveRate_t;
+
+//Starts at the fastest period, the first reading is due at nowUs
+void adaptiveRateInit(AdaptiveRate_t *rate, const AdaptiveRateConfig_t *config, uint64_t nowUs);
+
+bool adaptiveRateDue(const AdaptiveRate_t *rate, uint64_t nowUs);
+
+//Microseconds until the next reading is due, 0 if it already is
+uint64_t adaptiveRateWaitUs(const AdaptiveRate_t *rate, uint64_t nowUs);
+
+//Record a reading taken at nowUs and schedule the next one. Returns
+//how many slots were dropped because nowUs was already past them.
+uint32_t adaptiveRateUpdate(AdaptiveRate_t *rate, int32_t value, uint64_t nowUs);
+
+//The reading due failed. Try again in the next slot at the same rate.
+uint32_t adaptiveRateSkip(AdaptiveRate_t *rate, uint64_t nowUs);
+
+#endif
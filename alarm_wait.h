@@ -0,0 +1,30 @@
+//Timed waits off the tick
+//The FreeRTOS tick is 10 ms, too coarse for a 250 us poll or a
+//6.5 ms conversion. These block the calling task on a direct-to-task
+//notification that a one shot hardware alarm gives at the time asked
+//for, so the wake is not rounded to the tick and the CPU is free while
+//waiting. The RP2040 backend uses the SDK's default alarm pool; the
+//host backend in sim/ blocks whole ticks and sleeps the thread for the
+//rest.
+
+#ifndef ALARM_WAIT_H
+#define ALARM_WAIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+//Notification slot for waits nothing else should end. Slot 1 belongs
+//to the I2C transport and slot 2 to the sample cell.
+#define ALARMWAITNOTIFYINDEX 3
+
+//Block the calling task until dueUs on the 64 bit timer, woken on
+//notification index. A notification given to index by anything else
+//ends the wait early and cancels the alarm. Returns true if the wait
+//ran to dueUs, false if it was ended early. A time already past
+//returns true straight away.
+bool alarmWaitUntil(uint64_t dueUs, UBaseType_t index);
+
+#endif
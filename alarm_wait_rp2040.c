@@ -0,0 +1,61 @@
+//Timed waits off the tick, RP2040 backend
+//Each wait takes a one shot alarm from the SDK's default alarm pool,
+//which fires on core 0 where the tasks run. The alarm interrupt gives
+//the waiting task's notification.
+
+#include "pico/stdlib.h"
+
+#include "alarm_wait.h"
+
+typedef struct {
+    TaskHandle_t task;
+    UBaseType_t index;
+} AlarmWaiter_t;
+
+static int64_t alarmFired(alarm_id_t id, void *userData){
+
+    AlarmWaiter_t *waiter = userData;
+    BaseType_t woken = pdFALSE;
+
+    (void)id;
+    vTaskNotifyGiveIndexedFromISR(waiter->task, waiter->index, &woken);
+    portYIELD_FROM_ISR(woken);
+
+    return 0;
+}
+
+bool alarmWaitUntil(uint64_t dueUs, UBaseType_t index){
+
+    const uint64_t tickUs = portTICK_PERIOD_MS * 1000;
+    AlarmWaiter_t waiter = {xTaskGetCurrentTaskHandle(), index};
+    uint64_t nowUs = time_us_64();
+    TickType_t ticks;
+    alarm_id_t id;
+
+    if(nowUs >= dueUs){
+        return true;
+    }
+
+    //the tick bound only matters if the alarm is lost, or there was
+    //no free one, when the wait falls back to the tick
+    ticks = (TickType_t)((dueUs - nowUs) / tickUs) + 2;
+    id = add_alarm_at(from_us_since_boot(dueUs), alarmFired, &waiter, false);
+    if(id == 0){
+        return true;
+    }
+    if(id < 0){
+        return ulTaskNotifyTakeIndexed(index, pdTRUE, ticks - 1) == 0;
+    }
+
+    ulTaskNotifyTakeIndexed(index, pdTRUE, ticks);
+
+    //The alarm runs on this core, so if it can no longer be cancelled
+    //it has given already; take that too in case it came after the
+    //wake, or it would end the next wait at once. waiter is on this
+    //stack, so the alarm must be gone before returning either way.
+    if(!cancel_alarm(id)){
+        ulTaskNotifyTakeIndexed(index, pdTRUE, 0);
+    }
+
+    return time_us_64() >= dueUs;
+}
@@ -0,0 +1,649 @@
+//Benchmarks for the driver, conversion, display, publish, history
+//and flash log paths
+//Builds as its own executable, on the board (ASSIGN6BENCH in
+//CMakeLists.txt) and in the host simulation (sim/CMakeLists.txt),
+//timing with the 64 bit microsecond timer. Every benchmark collects
+//BENCHRUNS timings and prints one line:
+//
+//  bench <name> runs <n> median <x> p99 <y> <unit>
+//
+//so results from two commits can be diffed line by line. Fast
+//operations are timed in batches of BENCHBATCH calls and reported in
+//ns per call, since one call is well under the timer resolution.
+
+//FreeRTOS headers
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+//C Headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Pico Headers
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+
+#include "hdc1080.h"
+#include "i2c_async.h"
+#include "conversion.h"
+#include "psychro.h"
+#include "display_frame.h"
+#include "spi_display.h"
+#include "sample_cell.h"
+#include "spsc_ring.h"
+#include "sample_filter.h"
+#include "history.h"
+#include "rtos_static.h"
+
+#ifdef ASSIGN6SIM
+#include "spi_display_sim.h"
+#include "flash_log.h"
+#include "flash_file_sim.h"
+#else
+#include "hardware/clocks.h"
+#endif
+
+#define BENCHRUNS 101
+#define BENCHSENSORRUNS 51
+#define BENCHBASELINERUNS 11      //200 ms each
+#define BENCHBATCH 1000
+#define BENCHSCANMAX 8
+#define BENCHSTACKWORDS (2 * configMINIMAL_STACK_SIZE)
+#define BENCHFLASHIMAGE "assign6_bench_flash.img"
+
+void benchTask();
+RTOSTASK(benchTask, BENCHSTACKWORDS);
+
+I2CAsyncBus_t benchAsyncBus;
+HDC1080Bus_t benchSensorBus;
+HDC1080_t benchSensor;
+HDC1080_t benchScanSensors[BENCHSCANMAX];
+SpiDisplay_t benchChain;
+
+#ifdef ASSIGN6SIM
+SpiDisplaySim_t benchChainSim;
+#endif
+
+//Results are kept here so the compiler cannot drop the work
+volatile int32_t benchSink;
+
+static uint32_t timings[BENCHRUNS];
+
+static int compareTimings(const void *a, const void *b){
+
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, int runs, const char *unit){
+
+    qsort(timings, runs, sizeof(timings[0]), compareTimings);
+
+    printf("bench %-24s runs %4d median %8lu p99 %8lu %s\n", name, runs,
+           (unsigned long)timings[runs / 2], (unsigned long)timings[(runs * 99) / 100], unit);
+}
+
+//End to end sample latency through the driver, one conversion each
+
+static void benchSensorPaths(void){
+
+    HDC1080Sample_t sample;
+    uint64_t startUs;
+    int i;
+
+    //startup probe: mux scan, identity and serial reads
+    for(i = 0; i < BENCHSENSORRUNS; i++){
+        startUs = time_us_64();
+        benchSink = hdc1080Probe(&benchSensorBus, &benchSensor, 1);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+    }
+    report("hdc1080Probe", BENCHSENSORRUNS, "us");
+
+    hdc1080SetAcquisitionMode(&benchSensor, false);
+    for(i = 0; i < BENCHSENSORRUNS; i++){
+        startUs = time_us_64();
+        benchSink = readTemperature(&benchSensor);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+    }
+    report("readTemperature", BENCHSENSORRUNS, "us");
+
+    for(i = 0; i < BENCHSENSORRUNS; i++){
+        startUs = time_us_64();
+        benchSink = readHumidity(&benchSensor);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+    }
+    report("readHumidity", BENCHSENSORRUNS, "us");
+
+    hdc1080SetAcquisitionMode(&benchSensor, true);
+    for(i = 0; i < BENCHSENSORRUNS; i++){
+        startUs = time_us_64();
+        hdc1080ReadSample(&benchSensor, &sample);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+        benchSink = sample.centiC;
+    }
+    report("hdc1080ReadSample", BENCHSENSORRUNS, "us");
+}
+
+//One channel as the read task did before combined mode and the
+//resolution aware wait: pointer write, a fixed 100 ms, 2 byte read
+static int baselineChannel(uint8_t reg){
+
+    uint8_t data[2];
+
+    i2c_write_blocking(I2C_PORT, HDC1080ADDRESS, &reg, 1, false);
+    vTaskDelay(100/portTICK_PERIOD_MS);
+    i2c_read_blocking(I2C_PORT, HDC1080ADDRESS, data, 2, false);
+
+    return data[0]<<8|data[1];
+}
+
+//Split, then combined acquisition at one temperature/humidity
+//resolution in bits
+static void benchSampleLatencyAt(const char *resolution, HDC1080Resolution_t temperature,
+                                 HDC1080Resolution_t humidity){
+
+    HDC1080Sample_t sample;
+    uint64_t startUs;
+    char name[32];
+    int i;
+
+    hdc1080SetAcquisitionMode(&benchSensor, false);
+    hdc1080SetResolution(&benchSensor, temperature, humidity);
+    for(i = 0; i < BENCHSENSORRUNS; i++){
+        startUs = time_us_64();
+        hdc1080ReadChannels(&benchSensor, true, true, &sample);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+        benchSink = sample.centiC;
+    }
+    snprintf(name, sizeof(name), "sample split %s", resolution);
+    report(name, BENCHSENSORRUNS, "us");
+
+    hdc1080SetAcquisitionMode(&benchSensor, true);
+    for(i = 0; i < BENCHSENSORRUNS; i++){
+        startUs = time_us_64();
+        hdc1080ReadSample(&benchSensor, &sample);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+        benchSink = sample.centiC;
+    }
+    snprintf(name, sizeof(name), "sample combined %s", resolution);
+    report(name, BENCHSENSORRUNS, "us");
+}
+
+//Latency of one temperature and humidity reading: the old fixed wait
+//read, then split and combined acquisition at each resolution, so the gain from each change can be read off on
+//its own
+static void benchSampleLatency(void){
+
+    uint64_t startUs;
+    int i;
+
+    hdc1080SetAcquisitionMode(&benchSensor, false);
+    hdc1080SetResolution(&benchSensor, HDC1080RES14BIT, HDC1080RES14BIT);
+    for(i = 0; i < BENCHBASELINERUNS; i++){
+        startUs = time_us_64();
+        benchSink = baselineChannel(HDC1080TEMPREG);
+        benchSink = baselineChannel(HDC1080HUMREG);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+    }
+    report("sample fixed 100 ms", BENCHBASELINERUNS, "us");
+
+    benchSampleLatencyAt("14/14", HDC1080RES14BIT, HDC1080RES14BIT);
+    benchSampleLatencyAt("11/11", HDC1080RES11BIT, HDC1080RES11BIT);
+    benchSampleLatencyAt("11/8", HDC1080RES11BIT, HDC1080RES8BIT);
+
+    hdc1080SetResolution(&benchSensor, HDC1080RES14BIT, HDC1080RES14BIT);
+}
+
+//Scan time against the number of sensors: hdc1080Scan of the first n
+//found, then the same n read one after another. In the host
+//simulation ASSIGN6SIMSENSORS sets how many there are.
+static void benchScan(void){
+
+    HDC1080Sample_t samples[BENCHSCANMAX];
+    bool ok[BENCHSCANMAX];
+    uint64_t startUs;
+    char name[32];
+    int found;
+    int n;
+    int i;
+    int j;
+
+    memset(samples, 0, sizeof(samples));
+    found = hdc1080Probe(&benchSensorBus, benchScanSensors, BENCHSCANMAX);
+    for(i = 0; i < found; i++){
+        hdc1080SetAcquisitionMode(&benchScanSensors[i], true);
+    }
+
+    for(n = 1; n <= found; n++){
+        for(i = 0; i < BENCHSENSORRUNS; i++){
+            startUs = time_us_64();
+            benchSink = hdc1080Scan(benchScanSensors, n, samples, ok);
+            timings[i] = (uint32_t)(time_us_64() - startUs);
+        }
+        snprintf(name, sizeof(name), "scan %d sensors", n);
+        report(name, BENCHSENSORRUNS, "us");
+
+        for(i = 0; i < BENCHSENSORRUNS; i++){
+            startUs = time_us_64();
+            for(j = 0; j < n; j++){
+                hdc1080ReadSample(&benchScanSensors[j], &samples[j]);
+            }
+            timings[i] = (uint32_t)(time_us_64() - startUs);
+            benchSink = samples[0].centiC;
+        }
+        snprintf(name, sizeof(name), "sequential %d sensors", n);
+        report(name, BENCHSENSORRUNS, "us");
+    }
+}
+
+//Raw code to engineering units, codes walked over all 65536.
+//tools/conversion_check.c checks every one against the formulas.
+
+static void benchConversion(void){
+
+    uint64_t startUs;
+    uint16_t raw = 0;
+    int32_t sum;
+    int i;
+    int j;
+
+    for(i = 0; i < BENCHRUNS; i++){
+        sum = 0;
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            sum += convRawToCentiC(raw);
+            sum += convRawToCentiRH(raw);
+            raw += 40503;
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = sum;
+    }
+    report("convRawToCentiC+RH", BENCHRUNS, "ns");
+
+#ifndef ASSIGN6SIM
+    //the same runs in clk_sys cycles per pair of codes
+    for(i = 0; i < BENCHRUNS; i++){
+        timings[i] = (uint32_t)((uint64_t)timings[i] * (clock_get_hz(clk_sys) / 1000) / 1000000);
+    }
+    report("convRawToCentiC+RH", BENCHRUNS, "cycles");
+#endif
+
+    for(i = 0; i < BENCHRUNS; i++){
+        HDC1080Sample_t sample;
+
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            sample.rawTemperature = raw;
+            sample.rawHumidity = raw ^ 0x5555;
+            hdc1080ConvertSample(&sample);
+            raw += 40503;
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = sample.centiF;
+    }
+    report("hdc1080ConvertSample", BENCHRUNS, "ns");
+
+#ifndef ASSIGN6SIM
+    //the same runs in clk_sys cycles per sample
+    for(i = 0; i < BENCHRUNS; i++){
+        timings[i] = (uint32_t)((uint64_t)timings[i] * (clock_get_hz(clk_sys) / 1000) / 1000000);
+    }
+    report("hdc1080ConvertSample", BENCHRUNS, "cycles");
+#endif
+}
+
+//Derived metrics, inputs walked across the sensor range
+
+static void benchPsychro(void){
+
+    PsychroMetrics_t metrics;
+    uint64_t startUs;
+    int32_t centiC = -4000;
+    int32_t centiRH = 1;
+    int i;
+    int j;
+
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            psychroCompute(centiC, centiRH, &metrics);
+            centiC = centiC >= 12500 ? -4000 : centiC + 7;
+            centiRH = centiRH >= 10000 ? 1 : centiRH + 13;
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = metrics.centiDewPointC;
+    }
+    report("psychroCompute", BENCHRUNS, "ns");
+
+#ifndef ASSIGN6SIM
+    //the same runs in clk_sys cycles per sample
+    for(i = 0; i < BENCHRUNS; i++){
+        timings[i] = (uint32_t)((uint64_t)timings[i] * (clock_get_hz(clk_sys) / 1000) / 1000000);
+    }
+    report("psychroCompute", BENCHRUNS, "cycles");
+#endif
+}
+
+//Sample filters, cost per code added
+
+static void benchFilter(const char *name, SampleFilterType_t type, uint8_t window, uint8_t shift){
+
+    SampleFilterConfig_t config = {type, window, shift};
+    SampleFilter_t filter;
+    uint64_t startUs;
+    uint16_t raw = 25000;
+    int32_t sum;
+    int i;
+    int j;
+
+    sampleFilterInit(&filter, &config);
+    for(i = 0; i < BENCHRUNS; i++){
+        sum = 0;
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            sum += sampleFilterAdd(&filter, raw);
+            raw = (uint16_t)(25000 + (j & 63));
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = sum;
+    }
+    report(name, BENCHRUNS, "ns");
+}
+
+static void benchFilters(void){
+
+    benchFilter("sampleFilter average16", SAMPLEFILTERAVERAGE, 16, 0);
+    benchFilter("sampleFilter ema4", SAMPLEFILTEREMA, 0, 4);
+    benchFilter("sampleFilter median3", SAMPLEFILTERMEDIAN, 3, 0);
+    benchFilter("sampleFilter median9", SAMPLEFILTERMEDIAN, 9, 0);
+}
+
+//Segment encoding and frame build for the two digit display
+
+static void benchDisplay(void){
+
+    DisplayFrame_t frame;
+    uint64_t startUs;
+    int value = -9;
+    int changed;
+    int i;
+    int j;
+
+    memset(&frame, 0, sizeof(frame));
+
+    for(i = 0; i < BENCHRUNS; i++){
+        changed = 0;
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            changed += displayEncode(value, &frame);
+            value = value == 99 ? -9 : value + 1;
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = changed;
+    }
+    report("displayEncode", BENCHRUNS, "ns");
+
+    for(i = 0; i < BENCHRUNS; i++){
+        changed = 0;
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            changed += displayEncode(42, &frame);
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = changed;
+    }
+    report("displayEncode unchanged", BENCHRUNS, "ns");
+}
+
+//MAX7219 chain updates, from a value to the last frame latched. On
+//the board the CPU is free while the frames shift out; the time is
+//what it takes for a change to reach the chain.
+
+static void benchChainUpdate(const char *name, int32_t first, int32_t second){
+
+    uint8_t segments[SPIDISPLAYDIGITS];
+    uint64_t startUs;
+    int changed;
+    int i;
+    int j;
+
+    for(i = 0; i < BENCHRUNS; i++){
+        changed = 0;
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            spiDisplayFormat(segments, SPIDISPLAYDIGITS / 2, j & 1 ? second : first, 1);
+            spiDisplayFormat(segments + SPIDISPLAYDIGITS / 2, SPIDISPLAYDIGITS / 2, j & 1 ? second : first, 1);
+            changed += spiDisplaySet(&benchChain, segments);
+            spiDisplayService(&benchChain);
+            while(benchChain.busy){}
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = changed;
+    }
+    report(name, BENCHRUNS, "ns");
+}
+
+static void benchChainDisplay(void){
+
+    //first update sends the control registers and every digit
+    benchChainUpdate("spiDisplay unchanged", 2250, 2250);
+    benchChainUpdate("spiDisplay 1 digit", 2250, 2260);
+    benchChainUpdate("spiDisplay all digits", 11110, 22220);
+}
+
+//Publishing a sample and reading it back
+
+static SampleCell_t benchCell;
+static SampleRecord_t benchRingSlots[8];
+static SpscRing_t benchRing;
+RTOSQUEUE(benchQueue, 1, sizeof(SampleRecord_t));
+
+static void benchPublish(void){
+
+    HDC1080Sample_t sample;
+    SampleRecord_t record;
+    QueueHandle_t queue;
+    uint64_t startUs;
+    int i;
+    int j;
+
+    memset(&sample, 0, sizeof(sample));
+    psychroClear(&record.derived);
+    sampleCellInit(&benchCell);
+    spscRingInit(&benchRing, benchRingSlots, sizeof(SampleRecord_t), 8);
+    queue = RTOSCREATEQUEUE(benchQueue, 1, sizeof(SampleRecord_t));
+
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            sampleCellPublish(&benchCell, &sample, &record.derived, j);
+            sampleCellRead(&benchCell, &record);
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = record.sequence;
+    }
+    report("sampleCell publish+read", BENCHRUNS, "ns");
+
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            spscRingPush(&benchRing, &record);
+            spscRingPop(&benchRing, &record);
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = record.sequence;
+    }
+    report("spscRing push+pop", BENCHRUNS, "ns");
+
+    //the length 1 queue the display used to be fed through
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            xQueueOverwrite(queue, &record);
+            xQueuePeek(queue, &record, 0);
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+        benchSink = record.sequence;
+    }
+    report("xQueue overwrite+peek", BENCHRUNS, "ns");
+}
+
+//History insert, and the 24 hour query the history command makes
+
+static History_t benchHistory;
+static HistoryBucket_t benchBuckets[24];
+
+static void benchHistoryPaths(void){
+
+    uint64_t startUs;
+    uint64_t timeUs = 0;
+    int i;
+    int j;
+
+    historyInit(&benchHistory);
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            //a sample a second, so the run crosses minute and hour
+            //rollovers as the reading task does
+            timeUs += 1000000;
+            historyAdd(&benchHistory, timeUs, 2000 + j % 50, 4000 + j % 70);
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+    }
+    report("historyAdd", BENCHRUNS, "ns");
+
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            benchSink = historyQuery(&benchHistory, HISTORYHOUR, benchBuckets, 24);
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+    }
+    report("historyQuery 24 hours", BENCHRUNS, "ns");
+}
+
+#ifdef ASSIGN6SIM
+//Flash log append and mount, on a file image (sim/flash_file_sim.c)
+//made for the run and removed after. Not run on the board, where it
+//would overwrite the sample log and wear the chip;
+//tools/flash_log_check.c counts the programs and erases behind these.
+
+static FlashFileSim_t benchFlash;
+static FlashLog_t benchLog;
+
+static void benchFlashLog(void){
+
+    uint64_t startUs;
+    uint32_t timeSec = 0;
+    int i;
+    int j;
+
+    remove(BENCHFLASHIMAGE);
+    if(!flashFileSimOpen(&benchFlash, BENCHFLASHIMAGE) || !flashLogInit(&benchLog, &benchFlash.storage)){
+        printf("bench flash image %s could not be made\n", BENCHFLASHIMAGE);
+        return;
+    }
+
+    //a sample a second, with the spare erased as the log task does
+    //once its queue is empty; the erases are timed with the appends
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        for(j = 0; j < BENCHBATCH; j++){
+            flashLogAppend(&benchLog, ++timeSec, 2000 + j % 50, 4000 + j % 70);
+            if(benchLog.staged == 0){
+                flashLogService(&benchLog);
+            }
+        }
+        timings[i] = (uint32_t)((time_us_64() - startUs) * 1000 / BENCHBATCH);
+    }
+    report("flashLogAppend", BENCHRUNS, "ns");
+
+    //boot: find the head and the newest record on a log that has
+    //wrapped, then the reads it took
+    for(i = 0; i < BENCHRUNS; i++){
+        startUs = time_us_64();
+        flashLogInit(&benchLog, &benchFlash.storage);
+        timings[i] = (uint32_t)(time_us_64() - startUs);
+    }
+    report("flashLogInit", BENCHRUNS, "us");
+
+    for(i = 0; i < BENCHRUNS; i++){
+        timings[i] = benchLog.recoveryReads;
+    }
+    report("flashLogInit", BENCHRUNS, "reads");
+
+    flashFileSimClose(&benchFlash);
+    remove(BENCHFLASHIMAGE);
+}
+#endif
+
+int main() {
+
+    stdio_init_all();
+
+    i2c_init(I2C_PORT, 100 * 1000);
+    gpio_set_function(PICO_DEFAULT_I2C_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(PICO_DEFAULT_I2C_SDA_PIN);
+    gpio_pull_up(PICO_DEFAULT_I2C_SCL_PIN);
+
+    i2cAsyncRp2040Init(&benchAsyncBus, I2C_PORT);
+    hdc1080BusInit(&benchSensorBus, I2C_PORT, &benchAsyncBus);
+    hdc1080Init(&benchSensor, &benchSensorBus, HDC1080NOMUX, 0);
+
+#ifdef ASSIGN6SIM
+    spiDisplaySimInit(&benchChain, &benchChainSim);
+#else
+    spiDisplayRp2040Init(&benchChain, spi1, SPIDISPLAYSCKPIN, SPIDISPLAYMOSIPIN, SPIDISPLAYCSPIN,
+                         SPIDISPLAYBAUDRATE);
+#endif
+
+    RTOSCREATETASK(benchTask, BENCHSTACKWORDS, 1);
+
+    vTaskStartScheduler();
+
+  while(1){};
+}
+
+//Run everything once, then idle. On the board the results wait for
+//a host so none are lost.
+void benchTask()
+{
+    while(!tud_cdc_connected()){
+        vTaskDelay(100/portTICK_PERIOD_MS);
+    }
+
+    printf("bench start\n");
+    benchSensorPaths();
+    benchSampleLatency();
+    benchScan();
+    benchConversion();
+    benchPsychro();
+    benchFilters();
+    benchDisplay();
+    benchChainDisplay();
+    benchPublish();
+    benchHistoryPaths();
+#ifdef ASSIGN6SIM
+    benchFlashLog();
+#endif
+    printf("bench done\n");
+    stdio_flush();
+
+#ifdef ASSIGN6SIM
+    //the simulation is run from scripts, let them see the end
+    exit(0);
+#endif
+
+    while(true){
+        vTaskDelay(portMAX_DELAY);
+    }
+}
@@ -0,0 +1,143 @@
+//Non-blocking console output
+//Each message carries a kind ahead of its payload so core 1 knows
+//whether stdio may translate it.
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "tusb.h"
+
+#include "console.h"
+#include "spsc_ring.h"
+#include "event_trace.h"
+
+#define CONSOLETEXT 0
+#define CONSOLERAW 1
+
+typedef struct {
+    uint8_t kind;
+    uint8_t length;
+    uint8_t data[CONSOLEMESSAGEMAX];
+} ConsoleMessage_t;
+
+static ConsoleMessage_t consoleSlots[CONSOLESLOTS];
+static SpscRing_t consoleRing;
+static uint32_t reported;
+
+void consoleInit(void){
+
+    spscRingInit(&consoleRing, consoleSlots, sizeof(ConsoleMessage_t), CONSOLESLOTS);
+    reported = 0;
+}
+
+//The ring has one producer, so pushes from several tasks are
+//serialised with the scheduler suspended. Nothing here blocks.
+static bool send(const ConsoleMessage_t *message){
+
+    bool sent;
+
+    vTaskSuspendAll();
+    sent = spscRingPush(&consoleRing, message);
+    xTaskResumeAll();
+
+    eventTraceRecord(EVENTTRACECONSOLE, message->kind, message->length);
+
+    //wake core 1
+    __sev();
+
+    return sent;
+}
+
+bool consolePrintf(const char *format, ...){
+
+    ConsoleMessage_t message;
+    va_list args;
+    int length;
+
+    va_start(args, format);
+    length = vsnprintf((char *)message.data, sizeof(message.data), format, args);
+    va_end(args);
+
+    if(length < 0){
+        return false;
+    }
+    if(length >= CONSOLEMESSAGEMAX){
+        length = CONSOLEMESSAGEMAX - 1;     //truncated
+    }
+
+    message.kind = CONSOLETEXT;
+    message.length = (uint8_t)length;
+
+    return send(&message);
+}
+
+bool consoleWrite(const void *data, size_t length){
+
+    ConsoleMessage_t message;
+
+    //counted with the producers serialised, as send counts a full ring
+    if(length > CONSOLEMESSAGEMAX){
+        vTaskSuspendAll();
+        consoleRing.dropped++;
+        xTaskResumeAll();
+        return false;
+    }
+
+    message.kind = CONSOLERAW;
+    message.length = (uint8_t)length;
+    memcpy(message.data, data, length);
+
+    return send(&message);
+}
+
+int consoleFree(void){
+
+    return CONSOLESLOTS - (int)spscRingCount(&consoleRing);
+}
+
+uint32_t consoleDropped(void){
+
+    return consoleRing.dropped;
+}
+
+int consoleService(void){
+
+    ConsoleMessage_t message;
+    uint32_t now;
+    int count = 0;
+    int i;
+
+    while(spscRingPop(&consoleRing, &message)){
+        count++;
+
+        if(!tud_cdc_connected()){
+            continue;
+        }
+
+        if(message.kind == CONSOLERAW){
+            for(i = 0; i < message.length; i++){
+                putchar_raw(message.data[i]);
+            }
+        }
+        else{
+            fwrite(message.data, 1, message.length, stdout);
+        }
+        stdio_flush();
+
+        //say what was lost since the last report; in binary mode the
+        //host decoder skips the line and resyncs
+        now = consoleRing.dropped;
+        if(now != reported){
+            printf("console: %lu messages dropped\n", (unsigned long)(now - reported));
+            reported = now;
+        }
+    }
+
+    return count;
+}
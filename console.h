@@ -0,0 +1,42 @@
+//Non-blocking console output
+//Tasks on core 0 hand text lines and binary frames to core 1 through
+//an SPSC ring and never wait on USB. If the ring is full the message
+//is dropped and counted; core 1 reports the count with the next
+//message it writes.
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//Messages in flight between the cores, a power of 2
+#define CONSOLESLOTS 8
+
+//Longest single message, text or binary
+#define CONSOLEMESSAGEMAX 224
+
+//Call before any other console function, and before the scheduler
+//starts if messages are queued from main
+void consoleInit(void);
+
+//printf to the console. Returns false if the line was dropped.
+bool consolePrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+//Bytes sent as is, without newline translation
+bool consoleWrite(const void *data, size_t length);
+
+//Slots free right now. A task sending a burst can wait for room
+//rather than have messages dropped.
+int consoleFree(void);
+
+//Messages dropped since boot
+uint32_t consoleDropped(void);
+
+//Core 1 side. Writes every queued message to USB CDC and returns
+//how many there were. Output is discarded while no host is connected
+//so the ring never backs up into the producers.
+int consoleService(void);
+
+#endif
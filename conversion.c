@@ -0,0 +1,44 @@
+//Fixed point conversion of HDC1080 raw codes
+//Every product below fits in an int32_t: the largest is
+//65535 * 29700 = 1946389500.
+
+#include "conversion.h"
+
+//Divide by 2^16 rounding half away from zero
+static inline int32_t roundShift16(int32_t v){
+
+    if(v >= 0){
+        return (v + 0x8000) >> 16;
+    }
+    return -((-v + 0x8000) >> 16);
+}
+
+int32_t convRawToCentiC(uint16_t raw){
+
+    return roundShift16((int32_t)raw * (CONVTEMPCSCALE * 100) - (CONVTEMPOFFSET * 100 << 16));
+}
+
+int32_t convRawToCentiF(uint16_t raw){
+
+    return roundShift16((int32_t)raw * (CONVTEMPFSCALE * 100) - (CONVTEMPOFFSET * 100 << 16));
+}
+
+int32_t convRawToCentiRH(uint16_t raw){
+
+    return roundShift16((int32_t)raw * (CONVHUMSCALE * 100));
+}
+
+int convRawToC(uint16_t raw){
+
+    return roundShift16((int32_t)raw * CONVTEMPCSCALE - (CONVTEMPOFFSET << 16));
+}
+
+int convRawToF(uint16_t raw){
+
+    return roundShift16((int32_t)raw * CONVTEMPFSCALE - (CONVTEMPOFFSET << 16));
+}
+
+int convRawToRH(uint16_t raw){
+
+    return roundShift16((int32_t)raw * CONVHUMSCALE);
+}
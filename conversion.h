@@ -0,0 +1,31 @@
+//Fixed point conversion of HDC1080 raw codes
+//The Cortex-M0+ has no FPU, so the datasheet formulas are evaluated
+//in 32 bit integers with the scale factors folded into constants.
+//Results are rounded half away from zero, the same as round() on the
+//exact value, for every one of the 65536 raw codes
+//(tools/conversion_check.c checks them all).
+
+#ifndef CONVERSION_H
+#define CONVERSION_H
+
+#include <stdint.h>
+
+//Temperature C = raw * 165 / 2^16 - 40
+//Temperature F = raw * 297 / 2^16 - 40
+//Humidity %RH  = raw * 100 / 2^16
+#define CONVTEMPCSCALE 165
+#define CONVTEMPFSCALE 297
+#define CONVHUMSCALE 100
+#define CONVTEMPOFFSET 40
+
+//Hundredths of a degree / percent
+int32_t convRawToCentiC(uint16_t raw);
+int32_t convRawToCentiF(uint16_t raw);
+int32_t convRawToCentiRH(uint16_t raw);
+
+//Whole degrees / percent
+int convRawToC(uint16_t raw);
+int convRawToF(uint16_t raw);
+int convRawToRH(uint16_t raw);
+
+#endif
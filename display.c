@@ -0,0 +1,79 @@
+//7 segment display engine
+//Data DMA channel: frame buffer -> PIO TX FIFO, paced by the state
+//machine's DREQ, DISPLAYDIGITS words per pass. When it finishes it
+//chains to the control channel, which writes the frame buffer address
+//back into the data channel's read address trigger register and so
+//restarts it. The pair loops with no interrupts.
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+
+#include "display.h"
+#include "sevenseg.pio.h"
+
+//Frame buffer read by DMA, and the address the control channel
+//reloads into the data channel on each pass
+static DisplayFrame_t frame;
+static const uint32_t *frameAddress = frame.word;
+
+void displayInit(void){
+
+    PIO pio = pio0;
+    uint sm = pio_claim_unused_sm(pio, true);
+    uint offset = pio_add_program(pio, &sevenseg_program);
+    int dataChan = dma_claim_unused_channel(true);
+    int ctrlChan = dma_claim_unused_channel(true);
+    pio_sm_config c = sevenseg_program_get_default_config(offset);
+    dma_channel_config dc;
+    float div;
+    uint pin;
+
+    //show dashes until the first value arrives
+    displayEncode(DISPLAYNOVALUE, &frame);
+
+    //hand just the display pins to the PIO, everything else in the
+    //range stays with its current function
+    for(pin = DISPLAYPINBASE; pin < DISPLAYPINBASE + DISPLAYPINCOUNT; pin++){
+        if(DISPLAYPINMASK & (1u << pin)){
+            pio_gpio_init(pio, pin);
+        }
+    }
+    pio_sm_set_pindirs_with_mask(pio, sm, DISPLAYPINMASK, DISPLAYPINMASK);
+
+    sm_config_set_out_pins(&c, DISPLAYPINBASE, DISPLAYPINCOUNT);
+    sm_config_set_out_shift(&c, true, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+
+    div = (float)clock_get_hz(clk_sys) * DISPLAYDIGITUS / 1000000 / DISPLAYHOLDCYCLES;
+    sm_config_set_clkdiv(&c, div);
+
+    pio_sm_init(pio, sm, offset, &c);
+
+    //data channel, restarted by the control channel
+    dc = dma_channel_get_default_config(dataChan);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, pio_get_dreq(pio, sm, true));
+    channel_config_set_chain_to(&dc, ctrlChan);
+    dma_channel_configure(dataChan, &dc, &pio->txf[sm], frame.word, DISPLAYDIGITS, false);
+
+    //control channel, one word into the data channel's trigger register
+    dc = dma_channel_get_default_config(ctrlChan);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dc, false);
+    channel_config_set_write_increment(&dc, false);
+    dma_channel_configure(ctrlChan, &dc, &dma_hw->ch[dataChan].al3_read_addr_trig, &frameAddress, 1, false);
+
+    pio_sm_set_enabled(pio, sm, true);
+    dma_channel_start(ctrlChan);
+}
+
+bool displayShow(int value){
+
+    //word writes are atomic, the worst case is one refresh pass with
+    //one old and one new digit
+    return displayEncode(value, &frame);
+}
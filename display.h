@@ -0,0 +1,27 @@
+//7 segment display engine
+//A PIO state machine multiplexes the digits and a pair of chained DMA
+//channels stream the frame buffer to it forever, so refreshing the
+//display costs no CPU time. The CPU only touches the frame buffer when
+//the value shown changes.
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdbool.h>
+
+#include "display_frame.h"
+
+//How long each digit is lit in us. Two digits at 1 ms each refresh at
+//500 Hz, well clear of visible flicker.
+#define DISPLAYDIGITUS 1000
+
+//Number of cycles the PIO program holds each digit (see sevenseg.pio)
+#define DISPLAYHOLDCYCLES (32 * 32 + 3)
+
+//Claim the PIO state machine and DMA channels and start refreshing
+void displayInit(void);
+
+//Show value. Returns true if the frame buffer had to be updated.
+bool displayShow(int value);
+
+#endif
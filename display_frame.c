@@ -0,0 +1,88 @@
+//7 segment frame encoding
+//Segment patterns come from one digit table and the pin masks for each
+//digit are derived from it at compile time, replacing the per digit switch
+//cases that used to live in segLEDLeft and segLEDRight.
+
+#include "display_frame.h"
+
+#define DIGIT0 (SEGA | SEGB | SEGC | SEGD | SEGE | SEGF)
+#define DIGIT1 (SEGB | SEGC)
+#define DIGIT2 (SEGA | SEGB | SEGD | SEGE | SEGG)
+#define DIGIT3 (SEGA | SEGB | SEGC | SEGD | SEGG)
+#define DIGIT4 (SEGB | SEGC | SEGF | SEGG)
+#define DIGIT5 (SEGA | SEGC | SEGD | SEGF | SEGG)
+#define DIGIT6 (SEGA | SEGC | SEGD | SEGE | SEGF | SEGG)
+#define DIGIT7 (SEGA | SEGB | SEGC)
+#define DIGIT8 (SEGA | SEGB | SEGC | SEGD | SEGE | SEGF | SEGG)
+#define DIGIT9 (SEGA | SEGB | SEGC | SEGD | SEGF | SEGG)
+
+const uint8_t displayDigitSegments[10] = {
+    DIGIT0, DIGIT1, DIGIT2, DIGIT3, DIGIT4,
+    DIGIT5, DIGIT6, DIGIT7, DIGIT8, DIGIT9,
+};
+
+//Pin for each segment bit, in bit order
+static const uint8_t segmentPins[8] = {
+    SevenSegA, SevenSegB, SevenSegC, SevenSegD,
+    SevenSegE, SevenSegF, SevenSegG, SevenSegDP,
+};
+
+//Common cathode select for each digit. The selected digit's pin is
+//driven high, the same as the old gpio_put(SevenSegCC2, 1) for left.
+static const uint32_t digitSelect[DISPLAYDIGITS] = {
+    1u << SevenSegCC2,      //left
+    1u << SevenSegCC1,      //right
+};
+
+//Pin masks for 0 - 9, built from the digit table at compile time
+#define DIGITPINS(d) SEGPINS(DIGIT##d)
+static const uint32_t digitPins[10] = {
+    DIGITPINS(0), DIGITPINS(1), DIGITPINS(2), DIGITPINS(3), DIGITPINS(4),
+    DIGITPINS(5), DIGITPINS(6), DIGITPINS(7), DIGITPINS(8), DIGITPINS(9),
+};
+
+uint8_t displayDecodeSegments(uint32_t word){
+
+    uint32_t pins = word << DISPLAYPINBASE;
+    uint8_t segments = 0;
+    int i;
+
+    for(i = 0; i < 8; i++){
+        if(pins & (1u << segmentPins[i])){
+            segments |= 1 << i;
+        }
+    }
+
+    return segments;
+}
+
+bool displayEncode(int value, DisplayFrame_t *frame){
+
+    uint32_t pins[DISPLAYDIGITS];
+    bool changed = false;
+    int i;
+
+    if(value > 99 || value < -9){
+        pins[0] = SEGPINS(SEGDASH);
+        pins[1] = SEGPINS(SEGDASH);
+    }
+    else if(value < 0){
+        pins[0] = SEGPINS(SEGDASH);
+        pins[1] = digitPins[-value];
+    }
+    else{
+        pins[0] = digitPins[value / 10];
+        pins[1] = digitPins[value % 10];
+    }
+
+    for(i = 0; i < DISPLAYDIGITS; i++){
+        uint32_t word = (pins[i] | digitSelect[i]) >> DISPLAYPINBASE;
+
+        if(frame->word[i] != word){
+            frame->word[i] = word;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
@@ -0,0 +1,78 @@
+//7 segment frame encoding
+//Turns a number into the GPIO pin image for each multiplexed digit.
+//Pure C with no hardware access so it can be built and checked on the
+//host; display.c streams the frames to the pins.
+
+#ifndef DISPLAY_FRAME_H
+#define DISPLAY_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//define 7-segment led pins
+#define SevenSegCC1 11  //right number
+#define SevenSegCC2 10  //left number
+
+#define SevenSegA 26    //Top bar
+#define SevenSegB 27    //Top right
+#define SevenSegC 29    //bottom right
+#define SevenSegD 18    //bottom bar
+#define SevenSegE 25    //bottom left
+#define SevenSegF 7     //Top Left
+#define SevenSegG 28    //Middle
+#define SevenSegDP 24   //decimal points
+
+//Every display pin, lowest first. The PIO drives the contiguous range
+//DISPLAYPINBASE .. DISPLAYPINBASE + DISPLAYPINCOUNT - 1 and a frame
+//word is the pin image shifted down by DISPLAYPINBASE.
+#define DISPLAYPINMASK ((1u << SevenSegA) | (1u << SevenSegB) | (1u << SevenSegC) | \
+                        (1u << SevenSegD) | (1u << SevenSegE) | (1u << SevenSegF) | \
+                        (1u << SevenSegG) | (1u << SevenSegDP) | \
+                        (1u << SevenSegCC1) | (1u << SevenSegCC2))
+#define DISPLAYPINBASE 7
+#define DISPLAYPINCOUNT 23
+
+//Digits in multiplex order, left then right
+#define DISPLAYDIGITS 2
+
+//Segment bits, independent of wiring
+#define SEGA 0x01
+#define SEGB 0x02
+#define SEGC 0x04
+#define SEGD 0x08
+#define SEGE 0x10
+#define SEGF 0x20
+#define SEGG 0x40
+#define SEGDP 0x80
+
+//Segment pattern shown for out of range values
+#define SEGDASH SEGG
+#define SEGBLANK 0x00
+
+//GPIO mask for a set of segment bits. Folds to a constant when s is
+//a constant.
+#define SEGPINS(s) ((((s) & SEGA) ? 1u << SevenSegA : 0) | \
+                    (((s) & SEGB) ? 1u << SevenSegB : 0) | \
+                    (((s) & SEGC) ? 1u << SevenSegC : 0) | \
+                    (((s) & SEGD) ? 1u << SevenSegD : 0) | \
+                    (((s) & SEGE) ? 1u << SevenSegE : 0) | \
+                    (((s) & SEGF) ? 1u << SevenSegF : 0) | \
+                    (((s) & SEGG) ? 1u << SevenSegG : 0) | \
+                    (((s) & SEGDP) ? 1u << SevenSegDP : 0))
+
+typedef struct {
+    uint32_t word[DISPLAYDIGITS];
+} DisplayFrame_t;
+
+//Segment bits for 0 - 9
+extern const uint8_t displayDigitSegments[10];
+
+//Encode value for the two digit display. -9 to 99 are shown, anything
+//else shows "--". Returns true if frame changed.
+#define DISPLAYNOVALUE 100          //shows "--", for a reading that failed
+bool displayEncode(int value, DisplayFrame_t *frame);
+
+//Recover the segment bits of digit from a frame word
+uint8_t displayDecodeSegments(uint32_t word);
+
+#endif
@@ -0,0 +1,150 @@
+//Event trace
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "event_trace.h"
+#include "telemetry.h"
+
+_Static_assert(sizeof(EventTrace_t) == 8, "event size");
+
+//head is claimed before a slot is written and done moved up after, so
+//a dump on the other core reads only slots up to done, and knows one
+//it copied was overwritten meanwhile if head has passed it by a ring
+typedef struct {
+    EventTrace_t events[EVENTTRACELEN];
+    volatile uint32_t head;     //events claimed since boot
+    volatile uint32_t done;     //events written since boot
+} EventTraceRing_t;
+
+static EventTraceRing_t rings[2];
+static volatile bool enabled = true;
+static volatile bool requested;
+
+void eventTraceRecord(uint8_t type, uint8_t arg8, uint16_t arg16){
+
+    EventTraceRing_t *ring;
+    EventTrace_t *event;
+    uint32_t index;
+    uint32_t irq;
+
+    if(!enabled){
+        return;
+    }
+
+    //each core has its own ring, so only interrupts on this core
+    //can race for the slot; the whole slot is written before one
+    //can come in and take the next
+    ring = &rings[get_core_num()];
+    irq = save_and_disable_interrupts();
+    index = ring->head;
+    ring->head = index + 1;
+    __dmb();
+
+    event = &ring->events[index & (EVENTTRACELEN - 1)];
+    event->timeUs = time_us_32();
+    event->type = type;
+    event->arg8 = arg8;
+    event->arg16 = arg16;
+
+    __dmb();
+    ring->done = index + 1;
+    restore_interrupts(irq);
+}
+
+void eventTraceRequest(void){
+
+    requested = true;
+}
+
+bool eventTraceTakeRequest(void){
+
+    if(!requested){
+        return false;
+    }
+
+    requested = false;
+
+    return true;
+}
+
+void eventTraceEnable(bool enable){
+
+    enabled = enable;
+}
+
+void eventTraceDumpBegin(EventTraceDump_t *dump){
+
+    uint32_t end;
+    int core;
+
+    for(core = 0; core < 2; core++){
+        end = rings[core].done;
+        dump->end[core] = end;
+        dump->next[core] = end > EVENTTRACELEN ? end - EVENTTRACELEN : 0;
+    }
+    dump->lost = 0;
+}
+
+int eventTraceDumpChunk(EventTraceDump_t *dump, int core, uint8_t *buf, int len){
+
+    EventTraceRing_t *ring = &rings[core];
+    EventTrace_t events[EVENTTRACECHUNKEVENTS];
+    uint32_t end = dump->end[core];
+    uint32_t first;
+    uint32_t count;
+    uint32_t oldest;
+    uint32_t head;
+    uint32_t i;
+    uint16_t crc;
+    int length;
+
+    while(dump->next[core] < end){
+        first = dump->next[core];
+        count = end - first;
+        if(count > EVENTTRACECHUNKEVENTS){
+            count = EVENTTRACECHUNKEVENTS;
+        }
+
+        for(i = 0; i < count; i++){
+            events[i] = ring->events[(first + i) & (EVENTTRACELEN - 1)];
+        }
+
+        //recording goes on during the dump: anything a ring or more
+        //behind head may have been written over while it was copied
+        __dmb();
+        head = ring->head;
+        oldest = head > EVENTTRACELEN ? head - EVENTTRACELEN : 0;
+        if(oldest > first){
+            i = oldest - first < count ? oldest - first : count;
+            dump->lost += i;
+            dump->next[core] = first + i;
+            continue;
+        }
+
+        length = EVENTTRACECHUNKHEADER + (int)count * (int)sizeof(EventTrace_t) + 2;
+        if(length > len){
+            return 0;
+        }
+
+        buf[0] = EVENTTRACESYNC0;
+        buf[1] = EVENTTRACESYNC1;
+        buf[2] = (uint8_t)core;
+        buf[3] = (uint8_t)count;
+        memcpy(&buf[4], &first, 4);
+
+        //the RP2040 and the host are both little endian
+        memcpy(&buf[EVENTTRACECHUNKHEADER], events, count * sizeof(EventTrace_t));
+
+        crc = telemetryCrc16(&buf[2], length - 4);
+        buf[length - 2] = (uint8_t)crc;
+        buf[length - 1] = (uint8_t)(crc >> 8);
+
+        dump->next[core] = first + count;
+        return length;
+    }
+
+    return 0;
+}
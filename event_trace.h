@@ -0,0 +1,81 @@
+//Event trace
+//A fixed ring of 8 byte timestamped events per core, cheap enough to
+//leave on: recording one is a timer read and an 8 byte store with
+//interrupts held off. Events come from the driver, the sample path
+//and the FreeRTOS trace macros in FreeRTOSConfig.h. The rings are
+//dumped as framed binary chunks on the console, with recording
+//carrying on, and turned into Chrome / Perfetto trace JSON on the
+//host by tools/trace_to_chrome.c. tools/trace_stress.c dumps one ring
+//while another thread records into it.
+//
+//No FreeRTOS includes here, FreeRTOSConfig.h includes this file.
+//
+//Dump chunk, little endian:
+//  sync      2  0xA5 0x5B
+//  core      1
+//  count     1  events in this chunk
+//  first     4  index of the first event since boot, for gap checks
+//  events    count * 8
+//  crc       2  CRC-16/CCITT over core..events, as telemetry.c
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Events per core, a power of 2
+#define EVENTTRACELEN 512
+
+//Event types
+#define EVENTTRACETASKSWITCH 1      //arg16 task number switched in
+#define EVENTTRACEI2CSTART 2        //arg8 address, arg16 length, bit 15 set for a read
+#define EVENTTRACEI2CEND 3          //arg8 address, arg16 result
+#define EVENTTRACEQUEUESEND 4       //arg8 queue type, arg16 queue number
+#define EVENTTRACEQUEUERECEIVE 5
+#define EVENTTRACEQUEUEPEEK 6
+#define EVENTTRACESAMPLEPUBLISH 7   //arg16 low bits of the sample sequence
+#define EVENTTRACESAMPLEREAD 8
+#define EVENTTRACERINGPUSH 9
+#define EVENTTRACERINGPOP 10
+#define EVENTTRACECONSOLE 11        //arg16 message length
+#define EVENTTRACEI2CRECOVER 12     //arg8 1 if the lines were freed
+
+#define EVENTTRACESYNC0 0xA5
+#define EVENTTRACESYNC1 0x5B
+#define EVENTTRACECHUNKHEADER 8
+#define EVENTTRACECHUNKEVENTS 25
+
+typedef struct {
+    uint32_t timeUs;
+    uint8_t type;
+    uint8_t arg8;
+    uint16_t arg16;
+} EventTrace_t;
+
+void eventTraceRecord(uint8_t type, uint8_t arg8, uint16_t arg16);
+
+//Stop or restart recording
+void eventTraceEnable(bool enable);
+
+//Where a dump has got to in each core's ring. It covers the events
+//recorded up to eventTraceDumpBegin; later ones go to the next dump.
+typedef struct {
+    uint32_t next[2];
+    uint32_t end[2];
+    uint32_t lost;              //overwritten before they were copied
+} EventTraceDump_t;
+
+void eventTraceDumpBegin(EventTraceDump_t *dump);
+
+//Build the next dump chunk of core's ring into buf, oldest events
+//first. Events overwritten since the dump began are skipped, leaving a
+//gap in the chunk indices. Returns its length, 0 once the ring is done.
+int eventTraceDumpChunk(EventTraceDump_t *dump, int core, uint8_t *buf, int len);
+
+//Ask for a dump. Safe from core 1 or an interrupt; the report task
+//picks it up.
+void eventTraceRequest(void);
+bool eventTraceTakeRequest(void);
+
+#endif
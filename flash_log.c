@@ -0,0 +1,318 @@
+//Flash backed sample log
+//Sector layout: page 0 holds the header, pages 1-15 hold 16 records
+//each. An erased page reads 0xFF, so the first page whose first word
+//is 0xFFFFFFFF is where the next page will be programmed.
+
+#include <string.h>
+
+#include "flash_log.h"
+
+_Static_assert(sizeof(FlashLogRecord_t) == FLASHLOGRECORDSIZE, "record size");
+
+static uint8_t crc8(const uint8_t *data, size_t len){
+
+    uint8_t crc = 0xFF;
+    size_t i;
+    int bit;
+
+    for(i = 0; i < len; i++){
+        crc ^= data[i];
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static uint32_t headerCrc(const FlashLogHeader_t *header){
+
+    return header->magic ^ header->sectorSequence ^ ~header->eraseCount;
+}
+
+static uint32_t sectorOffset(int sector){
+
+    return (uint32_t)sector * FLASHLOGSECTORSIZE;
+}
+
+static bool readHeader(FlashLog_t *log, int sector, FlashLogHeader_t *header){
+
+    log->recoveryReads++;
+    if(!log->storage->read(log->storage->ctx, sectorOffset(sector), header, sizeof(*header))){
+        return false;
+    }
+
+    return header->magic == FLASHLOGMAGIC && header->crc == headerCrc(header);
+}
+
+//Erase sector, carrying its erase count forward into RAM
+static bool eraseSector(FlashLog_t *log, int sector, uint32_t *eraseCount){
+
+    FlashLogHeader_t header;
+
+    *eraseCount = readHeader(log, sector, &header) ? header.eraseCount + 1 : 1;
+
+    if(!log->storage->erase(log->storage->ctx, sectorOffset(sector))){
+        log->errors++;
+        return false;
+    }
+
+    log->sectorsErased++;
+
+    return true;
+}
+
+//Write the header that makes an erased sector the head
+static bool openSector(FlashLog_t *log, int sector, uint32_t eraseCount){
+
+    uint8_t page[FLASHLOGPAGESIZE];
+    FlashLogHeader_t header;
+
+    header.magic = FLASHLOGMAGIC;
+    header.sectorSequence = ++log->sectorSequence;
+    header.eraseCount = eraseCount;
+    header.crc = headerCrc(&header);
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &header, sizeof(header));
+
+    if(!log->storage->program(log->storage->ctx, sectorOffset(sector), page, sizeof(page))){
+        log->errors++;
+        return false;
+    }
+
+    log->sector = sector;
+    log->page = 1;
+
+    return true;
+}
+
+static bool pageErased(FlashLog_t *log, int sector, int page){
+
+    uint32_t word;
+
+    log->recoveryReads++;
+    if(!log->storage->read(log->storage->ctx, sectorOffset(sector) + page * FLASHLOGPAGESIZE, &word, sizeof(word))){
+        return false;
+    }
+
+    return word == 0xFFFFFFFF;
+}
+
+static bool sectorErased(FlashLog_t *log, int sector){
+
+    int page;
+
+    for(page = 0; page < FLASHLOGPAGESPERSECTOR; page++){
+        if(!pageErased(log, sector, page)){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Sequence of the newest record on flash. Right after the head moved
+//to a new sector, or when its last page failed, that is further back
+//than the head's last page, so it is found the way a reader would.
+static void recoverRecordSequence(FlashLog_t *log){
+
+    FlashLogRecord_t newest;
+
+    log->recordSequence = flashLogReadRecent(log, &newest, 1) == 1 ? newest.sequence : 0;
+}
+
+bool flashLogInit(FlashLog_t *log, const FlashLogStorage_t *storage){
+
+    FlashLogHeader_t header;
+    uint32_t eraseCount;
+    uint32_t headEraseCount = 0;
+    int head = -1;
+    int next;
+    int sector;
+    int page;
+
+    memset(log, 0, sizeof(*log));
+    log->storage = storage;
+
+    //the head is the sector with the newest header
+    for(sector = 0; sector < FLASHLOGSECTORS; sector++){
+        if(readHeader(log, sector, &header) && (head < 0 || header.sectorSequence > log->sectorSequence)){
+            head = sector;
+            log->sectorSequence = header.sectorSequence;
+            headEraseCount = header.eraseCount;
+        }
+    }
+
+    if(head < 0){
+        //empty or foreign region, start a new log in sector 0
+        if(!eraseSector(log, 0, &eraseCount) || !openSector(log, 0, eraseCount)){
+            return false;
+        }
+        log->spareErased = false;
+        return true;
+    }
+
+    //first erased page in the head sector
+    log->sector = head;
+    log->page = FLASHLOGPAGESPERSECTOR;
+    for(page = 1; page < FLASHLOGPAGESPERSECTOR; page++){
+        if(pageErased(log, head, page)){
+            log->page = page;
+            break;
+        }
+    }
+
+    recoverRecordSequence(log);
+
+    //An erased spare has lost its header and the erase count in it.
+    //Sectors are used in turn from sector 0, so it has been erased as
+    //often as the head, or once more when it starts the next lap.
+    next = (head + 1) % FLASHLOGSECTORS;
+    log->spareErased = sectorErased(log, next);
+    log->spareEraseCount = headEraseCount + (next == 0 ? 1 : 0);
+
+    return true;
+}
+
+//The staged records could not be written, make room for the next ones
+static bool dropStage(FlashLog_t *log){
+
+    log->dropped += log->staged;
+    log->staged = 0;
+
+    return false;
+}
+
+static bool programStage(FlashLog_t *log){
+
+    uint8_t page[FLASHLOGPAGESIZE];
+    bool programmed;
+
+    //head sector full, move on to the spare
+    if(log->page == FLASHLOGPAGESPERSECTOR){
+        int next = (log->sector + 1) % FLASHLOGSECTORS;
+        uint32_t eraseCount = log->spareEraseCount;
+
+        if(!log->spareErased){
+            //the service task fell behind, erase inline
+            if(!eraseSector(log, next, &eraseCount)){
+                return dropStage(log);
+            }
+        }
+
+        //a header that failed may be half written, erase it again
+        //before the next try
+        log->spareErased = false;
+        if(!openSector(log, next, eraseCount)){
+            log->spareEraseCount = eraseCount;
+            return dropStage(log);
+        }
+    }
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, log->stage, log->staged * FLASHLOGRECORDSIZE);
+
+    programmed = log->storage->program(log->storage->ctx, sectorOffset(log->sector) + log->page * FLASHLOGPAGESIZE,
+                                       page, sizeof(page));
+
+    //a failed page may be partly programmed, so it is passed over
+    //either way
+    log->page++;
+    if(!programmed){
+        log->errors++;
+        return dropStage(log);
+    }
+
+    log->pagesProgrammed++;
+    log->staged = 0;
+
+    return true;
+}
+
+bool flashLogAppend(FlashLog_t *log, uint32_t timeSec, int32_t centiC, int32_t centiRH){
+
+    FlashLogRecord_t *record = &log->stage[log->staged];
+
+    memset(record, 0, sizeof(*record));
+    record->timeSec = timeSec;
+    record->sequence = ++log->recordSequence;
+    record->centiC = (int16_t)centiC;
+    record->centiRH = (uint16_t)centiRH;
+    record->crc = crc8((const uint8_t *)record, FLASHLOGRECORDSIZE - 1);
+
+    log->staged++;
+    log->appended++;
+
+    if(log->staged == FLASHLOGRECORDSPERPAGE){
+        return programStage(log);
+    }
+
+    return true;
+}
+
+bool flashLogFlush(FlashLog_t *log){
+
+    if(log->staged == 0){
+        return true;
+    }
+
+    return programStage(log);
+}
+
+bool flashLogService(FlashLog_t *log){
+
+    int next = (log->sector + 1) % FLASHLOGSECTORS;
+
+    if(log->spareErased){
+        return false;
+    }
+
+    //the erase count is carried in the header written on open
+    if(!eraseSector(log, next, &log->spareEraseCount)){
+        return false;
+    }
+
+    log->spareErased = true;
+
+    return true;
+}
+
+int flashLogReadRecent(FlashLog_t *log, FlashLogRecord_t *out, int count){
+
+    FlashLogRecord_t records[FLASHLOGRECORDSPERPAGE];
+    FlashLogHeader_t header;
+    int sector = log->sector;
+    int page = log->page - 1;
+    int sectorsSeen = 0;
+    int found = 0;
+    int i;
+
+    while(found < count && sectorsSeen < FLASHLOGSECTORS){
+        if(page < 1){
+            sector = (sector + FLASHLOGSECTORS - 1) % FLASHLOGSECTORS;
+            sectorsSeen++;
+            if(!readHeader(log, sector, &header) || header.sectorSequence >= log->sectorSequence){
+                break;
+            }
+            page = FLASHLOGPAGESPERSECTOR - 1;
+            continue;
+        }
+
+        if(!log->storage->read(log->storage->ctx, sectorOffset(sector) + page * FLASHLOGPAGESIZE,
+                               records, sizeof(records))){
+            break;
+        }
+
+        for(i = FLASHLOGRECORDSPERPAGE - 1; i >= 0 && found < count; i--){
+            if(records[i].crc == crc8((const uint8_t *)&records[i], FLASHLOGRECORDSIZE - 1) &&
+               records[i].sequence != 0xFFFFFFFF){
+                out[found++] = records[i];
+            }
+        }
+
+        page--;
+    }
+
+    return found;
+}
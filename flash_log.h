@@ -0,0 +1,106 @@
+//Flash backed sample log
+//Log structured ring of sectors in a reserved region of flash. Samples
+//are staged in RAM and programmed a full page at a time, sectors are
+//used in turn so wear is spread evenly, and the write head is found at
+//boot from the sector headers and one word per page rather than by
+//reading every record. The next sector is erased ahead of time by
+//flashLogService, so appends never wait on an erase.
+//Storage is reached through FlashLogStorage_t; flash_log_rp2040.c is
+//the on-board QSPI flash and sim/flash_file_sim.c a file on Linux.
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FLASHLOGPAGESIZE 256
+#define FLASHLOGSECTORSIZE 4096
+#define FLASHLOGPAGESPERSECTOR (FLASHLOGSECTORSIZE / FLASHLOGPAGESIZE)
+#define FLASHLOGRECORDSIZE 16
+#define FLASHLOGRECORDSPERPAGE (FLASHLOGPAGESIZE / FLASHLOGRECORDSIZE)
+
+//Number of sectors in the reserved region, 256 KB
+#define FLASHLOGSECTORS 64
+
+#define FLASHLOGMAGIC 0x474F4C48    //"HLOG"
+
+//Storage operations. Offsets are from the start of the region.
+//program is always whole, erased pages; erase is one whole sector.
+typedef struct {
+    bool (*read)(void *ctx, uint32_t offset, void *dst, size_t len);
+    bool (*program)(void *ctx, uint32_t offset, const void *src, size_t len);
+    bool (*erase)(void *ctx, uint32_t offset);
+    void *ctx;
+} FlashLogStorage_t;
+
+//One record as stored. crc covers the first 15 bytes.
+typedef struct {
+    uint32_t timeSec;
+    uint32_t sequence;
+    int16_t centiC;
+    uint16_t centiRH;
+    uint8_t flags;
+    uint8_t reserved[2];
+    uint8_t crc;
+} FlashLogRecord_t;
+
+//First page of every sector
+typedef struct {
+    uint32_t magic;
+    uint32_t sectorSequence;    //increases each time a sector is opened
+    uint32_t eraseCount;
+    uint32_t crc;
+} FlashLogHeader_t;
+
+typedef struct {
+    const FlashLogStorage_t *storage;
+
+    //Write head
+    int sector;
+    int page;
+    uint32_t sectorSequence;
+    uint32_t recordSequence;
+
+    //Sector after the head, erased ahead of use
+    bool spareErased;
+    uint32_t spareEraseCount;
+
+    //RAM staging for the page being filled
+    FlashLogRecord_t stage[FLASHLOGRECORDSPERPAGE];
+    int staged;
+
+    //Statistics
+    uint32_t appended;
+    uint32_t pagesProgrammed;
+    uint32_t sectorsErased;
+    uint32_t recoveryReads;
+    uint32_t errors;
+    uint32_t dropped;           //staged records lost to a failed write
+} FlashLog_t;
+
+//On-board flash, defined in flash_log_rp2040.c
+extern const FlashLogStorage_t flashLogRp2040Storage;
+
+//Find the write head, formatting the region if it holds no log.
+bool flashLogInit(FlashLog_t *log, const FlashLogStorage_t *storage);
+
+//Stage one sample. Programs a page when the stage fills; erases only
+//if the service has not got the next sector ready. Returns false if
+//the page could not be written; its records are dropped and counted,
+//and the page is passed over.
+bool flashLogAppend(FlashLog_t *log, uint32_t timeSec, int32_t centiC, int32_t centiRH);
+
+//Program a partly filled stage, padding the page. Used before reset.
+bool flashLogFlush(FlashLog_t *log);
+
+//Background work: erase the sector after the head if needed. Call from
+//a low priority task, when nothing needs the CPU or flash for as long
+//as an erase takes. Returns true if it erased.
+bool flashLogService(FlashLog_t *log);
+
+//Copy up to count of the newest records on flash, newest first.
+int flashLogReadRecent(FlashLog_t *log, FlashLogRecord_t *out, int count);
+
+#endif
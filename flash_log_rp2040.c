@@ -0,0 +1,80 @@
+//RP2040 storage for the flash log and the saved settings
+//The log sits in the last FLASHLOGSECTORS sectors of the QSPI flash,
+//the settings (runtime_config.h) in the sector below it. ctx points to
+//the flash offset of the region.
+//Reads go through the XIP window. Programming and erasing take the
+//flash out of XIP mode, so interrupts are held off for the duration;
+//a sector erase is tens of ms, which is why flashLogService erases
+//from its own low priority task ahead of need, in the slack between
+//readings. Core 1 also runs from flash, so it is parked with the
+//multicore lockout for the same time.
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+
+#include "flash_log.h"
+#include "runtime_config.h"
+
+#define FLASHLOGREGIONOFFSET (PICO_FLASH_SIZE_BYTES - FLASHLOGSECTORS * FLASHLOGSECTORSIZE)
+#define CONFIGREGIONOFFSET (FLASHLOGREGIONOFFSET - FLASHLOGSECTORSIZE)
+
+static const uint32_t logRegion = FLASHLOGREGIONOFFSET;
+static const uint32_t configRegion = CONFIGREGIONOFFSET;
+
+_Static_assert(FLASHLOGPAGESIZE == FLASH_PAGE_SIZE, "log page is one flash page");
+_Static_assert(FLASHLOGSECTORSIZE == FLASH_SECTOR_SIZE, "log sector is one flash sector");
+
+static bool rp2040Read(void *ctx, uint32_t offset, void *dst, size_t len){
+
+    uint32_t region = *(const uint32_t *)ctx;
+
+    memcpy(dst, (const void *)(XIP_BASE + region + offset), len);
+
+    return true;
+}
+
+static bool rp2040Program(void *ctx, uint32_t offset, const void *src, size_t len){
+
+    uint32_t region = *(const uint32_t *)ctx;
+    uint32_t irq;
+
+    multicore_lockout_start_blocking();
+    irq = save_and_disable_interrupts();
+    flash_range_program(region + offset, (const uint8_t *)src, len);
+    restore_interrupts(irq);
+    multicore_lockout_end_blocking();
+
+    return true;
+}
+
+static bool rp2040Erase(void *ctx, uint32_t offset){
+
+    uint32_t region = *(const uint32_t *)ctx;
+    uint32_t irq;
+
+    multicore_lockout_start_blocking();
+    irq = save_and_disable_interrupts();
+    flash_range_erase(region + offset, FLASHLOGSECTORSIZE);
+    restore_interrupts(irq);
+    multicore_lockout_end_blocking();
+
+    return true;
+}
+
+const FlashLogStorage_t flashLogRp2040Storage = {
+    .read = rp2040Read,
+    .program = rp2040Program,
+    .erase = rp2040Erase,
+    .ctx = (void *)&logRegion,
+};
+
+const FlashLogStorage_t runtimeConfigRp2040Storage = {
+    .read = rp2040Read,
+    .program = rp2040Program,
+    .erase = rp2040Erase,
+    .ctx = (void *)&configRegion,
+};
@@ -0,0 +1,749 @@
+//Justin Harris
+//HDC1080 driver
+//Register reads used by readHDC1080Task. Split out of Assign6.c so
+//the driver can be shared and run against the simulated sensor.
+//Every function takes the device handle of the sensor to talk to, so
+//any number of sensors can be driven across both controllers and
+//behind TCA9548A multiplexers.
+
+//FreeRTOS headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+//Pico Headers
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+#include <string.h>
+
+#include "hdc1080.h"
+#include "i2c_async.h"
+#include "alarm_wait.h"
+#include "conversion.h"
+#include "event_trace.h"
+
+void hdc1080BusInit(HDC1080Bus_t *bus, i2c_inst_t *i2c, I2CAsyncBus_t *async){
+
+      bus->i2c = i2c;
+      bus->async = async;
+      bus->activeMux = HDC1080NOMUX;
+      bus->activeMask = 0;
+      bus->sdaPin = 0;
+      bus->sclPin = 0;
+      bus->baudrate = 0;
+      memset(&bus->stats, 0, sizeof(bus->stats));
+}
+
+void hdc1080BusSetRecovery(HDC1080Bus_t *bus, uint32_t sdaPin, uint32_t sclPin, uint32_t baudrate){
+
+      bus->sdaPin = sdaPin;
+      bus->sclPin = sclPin;
+      bus->baudrate = baudrate;
+}
+
+void hdc1080Init(HDC1080_t *dev, HDC1080Bus_t *bus, uint8_t muxAddress, uint8_t muxChannel){
+
+      dev->bus = bus;
+      dev->address = HDC1080ADDRESS;
+      dev->muxAddress = muxAddress;
+      dev->muxChannel = muxChannel;
+      dev->config = HDC1080CONFIGDEFAULT;
+      dev->conversionStartUs = 0;
+      dev->converting = false;
+      dev->identity.valid = false;
+      dev->restore = false;
+      dev->recoveriesSeen = bus->stats.recoveries;
+}
+
+//Block for us on a hardware alarm rather than the tick, so a wait
+//shorter than a tick neither spins nor stretches to a whole one
+static void pauseUs(uint32_t us){
+
+      uint64_t dueUs = time_us_64() + us;
+
+      while(!alarmWaitUntil(dueUs, ALARMWAITNOTIFYINDEX)){
+      }
+}
+
+//One transfer to addr: txLen bytes written, then rxLen bytes read
+//after a repeated start. Either length may be zero. Bounded by
+//HDC1080XFERTIMEOUTUS on both transports; the async one sleeps on a
+//notification instead of spinning on the bus. Returns the bytes
+//transferred (rx if any, else tx) or an I2CASYNC error code; a short
+//transfer counts as a NACK.
+static int transfer(HDC1080Bus_t *bus, uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen){
+
+      size_t expected = rxLen > 0 ? rxLen : txLen;
+      int ret;
+
+      eventTraceRecord(EVENTTRACEI2CSTART, addr, (uint16_t)(rxLen > 0 ? rxLen | 0x8000 : txLen));
+
+      if(bus->async != NULL){
+          I2CAsyncXfer_t xfer = {
+              .address = addr,
+              .txBuf = tx,
+              .txLen = txLen,
+              .rxBuf = rx,
+              .rxLen = rxLen,
+          };
+          //whole ticks and one more, a wait of n ticks can end up to
+          //a tick early
+          ret = i2cAsyncTransfer(bus->async, &xfer, HDC1080XFERTIMEOUTUS / (portTICK_PERIOD_MS * 1000) + 2);
+      }
+      else{
+          uint64_t startUs = time_us_64();
+
+          ret = (int)txLen;
+          if(txLen > 0){
+              ret = i2c_write_timeout_us(bus->i2c, addr, tx, txLen, rxLen > 0, HDC1080XFERTIMEOUTUS);
+          }
+          if(ret == (int)txLen && rxLen > 0){
+              uint64_t elapsed = time_us_64() - startUs;
+
+              ret = elapsed >= HDC1080XFERTIMEOUTUS ? PICO_ERROR_TIMEOUT :
+                    i2c_read_timeout_us(bus->i2c, addr, rx, rxLen, false, HDC1080XFERTIMEOUTUS - (uint32_t)elapsed);
+          }
+          if(ret == PICO_ERROR_TIMEOUT){
+              ret = I2CASYNCTIMEOUT;
+          }
+      }
+
+      if(ret >= 0 && ret != (int)expected){
+          ret = I2CASYNCERROR;
+      }
+
+      eventTraceRecord(EVENTTRACEI2CEND, addr, (uint16_t)ret);
+
+      return ret;
+}
+
+//Count a failed transfer. NACKs are expected while probing or polling
+//a conversion, so only the ones that end a retry or a poll count.
+static void countFailure(HDC1080Bus_t *bus, int ret){
+
+      switch(ret){
+      case I2CASYNCTIMEOUT :
+          bus->stats.timeouts++;
+          break;
+      case I2CASYNCBUSERROR :
+          bus->stats.busErrors++;
+          break;
+      default :
+          bus->stats.nacks++;
+          break;
+      }
+}
+
+//Free a hung bus and reset the controller. Any mux may have lost its
+//selection with the bus, so the next transfer selects again, and every
+//sensor on the bus is restored before its next read.
+static void recoverBus(HDC1080Bus_t *bus){
+
+      bool released;
+
+      if(bus->baudrate == 0){
+          return;
+      }
+
+      released = i2cRp2040Recover(bus->i2c, bus->sdaPin, bus->sclPin, bus->baudrate);
+      eventTraceRecord(EVENTTRACEI2CRECOVER, released, 0);
+
+      bus->stats.recoveries++;
+      if(!released){
+          bus->stats.stuck++;
+      }
+      bus->activeMux = HDC1080NOMUX;
+      bus->activeMask = 0;
+}
+
+//transfer with retries. A NACK is retried as it is, the sensor may be
+//busy; a timeout or bus error recovers the bus first.
+static int transferRetry(HDC1080Bus_t *bus, uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen){
+
+      uint32_t backoffUs = HDC1080BACKOFFUS;
+      int attempt;
+      int ret;
+
+      for(attempt = 1; ; attempt++){
+          ret = transfer(bus, addr, tx, txLen, rx, rxLen);
+          if(ret >= 0){
+              return ret;
+          }
+
+          countFailure(bus, ret);
+          if(attempt == HDC1080XFERATTEMPTS){
+              return ret;
+          }
+
+          bus->stats.retries++;
+          if(ret != I2CASYNCERROR){
+              recoverBus(bus);
+          }
+
+          pauseUs(backoffUs);
+          backoffUs *= 2;
+          if(backoffUs > HDC1080BACKOFFMAXUS){
+              backoffUs = HDC1080BACKOFFMAXUS;
+          }
+      }
+}
+
+//Route the bus to dev. Every HDC1080 answers on 0x40, so sensors on
+//the same controller sit on different mux channels. Only one mux on a
+//controller may have a channel open at a time; the open mux and mask
+//are cached so back to back transfers to one sensor cost nothing.
+static bool selectDevice(HDC1080_t *dev){
+
+      HDC1080Bus_t *bus = dev->bus;
+      uint8_t mask = 1 << dev->muxChannel;
+      uint8_t none = 0;
+
+      if(dev->muxAddress == HDC1080NOMUX){
+          if(bus->activeMux != HDC1080NOMUX){
+              if(transferRetry(bus, bus->activeMux, &none, 1, NULL, 0) != 1){
+                  return false;
+              }
+              bus->activeMux = HDC1080NOMUX;
+          }
+          return true;
+      }
+
+      if(bus->activeMux == dev->muxAddress && bus->activeMask == mask){
+          return true;
+      }
+
+      if(bus->activeMux != HDC1080NOMUX && bus->activeMux != dev->muxAddress){
+          if(transferRetry(bus, bus->activeMux, &none, 1, NULL, 0) != 1){
+              return false;
+          }
+      }
+
+      if(transferRetry(bus, dev->muxAddress, &mask, 1, NULL, 0) != 1){
+          bus->activeMux = HDC1080NOMUX;
+          return false;
+      }
+
+      bus->activeMux = dev->muxAddress;
+      bus->activeMask = mask;
+
+      return true;
+}
+
+//Write to dev with retries. A write that still fails leaves the
+//sensor in an unknown state, so it is restored before the next read.
+static int busWrite(HDC1080_t *dev, const uint8_t *src, size_t len){
+
+      int ret;
+
+      if(!selectDevice(dev)){
+          dev->restore = true;
+          return I2CASYNCERROR;
+      }
+
+      ret = transferRetry(dev->bus, dev->address, src, len, NULL, 0);
+      if(ret != (int)len){
+          dev->restore = true;
+      }
+      return ret;
+}
+
+//One read attempt, for polling a conversion the sensor NACKs until done
+static int busRead(HDC1080_t *dev, uint8_t *dst, size_t len){
+
+      if(!selectDevice(dev)){
+          return I2CASYNCERROR;
+      }
+
+      return transfer(dev->bus, dev->address, NULL, 0, dst, len);
+}
+
+//Fill in the engineering units of sample from its raw codes
+void hdc1080ConvertSample(HDC1080Sample_t *sample){
+
+      sample->centiC = convRawToCentiC(sample->rawTemperature);
+      sample->centiF = convRawToCentiF(sample->rawTemperature);
+      sample->centiRH = convRawToCentiRH(sample->rawHumidity);
+      sample->temperatureInC = convRawToC(sample->rawTemperature);
+      sample->temperatureInF = convRawToF(sample->rawTemperature);
+      sample->humidity = convRawToRH(sample->rawHumidity);
+}
+
+//Function to read and return the Configuration Register, which is
+//also cached in dev->config. -1 if the read failed.
+int readConfigReg(HDC1080_t *dev){
+
+    uint8_t cfReg[2];
+    uint8_t cfRegVal = HDC1080CONFIGREG;
+
+    int ret;
+
+      //write blocking for Configuration Register
+      ret = busWrite(dev, &cfRegVal, 1);
+      if(ret != 1){
+          return -1;
+      }
+
+      //read blocking. Read Configuration Register
+      ret = busRead(dev, cfReg, 2);
+      if(ret != 2){
+          dev->restore = true;
+          return -1;
+      }
+      int fullcfReg = cfReg[0]<<8|cfReg[1];
+      dev->config = fullcfReg;
+
+      return fullcfReg;
+
+}
+
+//Function to write the Configuration Register.
+//The pointer byte is followed by the MSB then LSB of the new value.
+bool writeConfigReg(HDC1080_t *dev, uint16_t config){
+
+      uint8_t cfReg[3] = {HDC1080CONFIGREG, config >> 8, config & 0xFF};
+      int ret;
+
+      ret = busWrite(dev, cfReg, 3);
+      if(ret != 3){
+          return false;
+      }
+
+      dev->config = config & ~HDC1080CONFIGRST;
+
+      return true;
+}
+
+//Read one of the registers that need no conversion time: pointer
+//write, then the two bytes back after a repeated start, in one
+//transfer
+static bool readRegister(HDC1080_t *dev, uint8_t reg, uint16_t *value){
+
+      uint8_t data[2];
+
+      if(!selectDevice(dev)){
+          return false;
+      }
+
+      if(transferRetry(dev->bus, dev->address, &reg, 1, data, sizeof(data)) != sizeof(data)){
+          return false;
+      }
+      *value = data[0] << 8 | data[1];
+      return true;
+}
+
+bool hdc1080ReadIdentity(HDC1080_t *dev){
+
+      HDC1080Identity_t *id = &dev->identity;
+      uint16_t config;
+
+      id->valid = false;
+
+      //anything else at 0x40 stops here, before the serial reads
+      if(!readRegister(dev, HDC1080MFIDREG, &id->manufacturerId) ||
+         !readRegister(dev, HDC1080DEVICEIDREG, &id->deviceId) ||
+         id->manufacturerId != HDC1080MFID || id->deviceId != HDC1080DEVICEID){
+          return false;
+      }
+
+      if(!readRegister(dev, HDC1080SN1, &id->serial[0]) ||
+         !readRegister(dev, HDC1080SN2, &id->serial[1]) ||
+         !readRegister(dev, HDC1080SN3, &id->serial[2]) ||
+         !readRegister(dev, HDC1080CONFIGREG, &config)){
+          return false;
+      }
+
+      dev->config = config;
+      id->valid = true;
+      return true;
+}
+
+//One try for the probe, where a NACK is the usual answer. A hung bus
+//is still recovered so the probe can find what is behind it.
+static int probeTransfer(HDC1080Bus_t *bus, uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen){
+
+      int ret = transfer(bus, addr, tx, txLen, rx, rxLen);
+
+      if(ret < 0 && ret != I2CASYNCERROR){
+          countFailure(bus, ret);
+          recoverBus(bus);
+      }
+      return ret;
+}
+
+//One try at the manufacturer ID, so an empty channel costs a single
+//NACK rather than the retries
+static bool answers(HDC1080_t *dev){
+
+      uint8_t reg = HDC1080MFIDREG;
+      uint8_t data[2];
+
+      return selectDevice(dev) && probeTransfer(dev->bus, dev->address, &reg, 1, data, sizeof(data)) == sizeof(data);
+}
+
+int hdc1080Probe(HDC1080Bus_t *bus, HDC1080_t *devs, int max){
+
+      uint8_t muxes = 0;
+      uint8_t none = 0;
+      int found = 0;
+      int mux;
+      int channel;
+
+      if(max <= 0){
+          return 0;
+      }
+
+      //Close every mux first. One left open from before a reset would
+      //make a sensor behind it look direct. An absent mux NACKs, so
+      //these get one attempt each.
+      for(mux = 0; mux < 8; mux++){
+          if(probeTransfer(bus, HDC1080MUXBASEADDRESS + mux, &none, 1, NULL, 0) == 1){
+              muxes |= 1 << mux;
+          }
+      }
+      bus->activeMux = HDC1080NOMUX;
+      bus->activeMask = 0;
+
+      //A sensor directly on the controller answers whatever the muxes
+      //do, so nothing behind them can share its address
+      hdc1080Init(&devs[0], bus, HDC1080NOMUX, 0);
+      if(answers(&devs[0]) && hdc1080ReadIdentity(&devs[0])){
+          return 1;
+      }
+
+      for(mux = 0; mux < 8 && found < max; mux++){
+          if(!(muxes & (1 << mux))){
+              continue;
+          }
+          for(channel = 0; channel < 8 && found < max; channel++){
+              hdc1080Init(&devs[found], bus, HDC1080MUXBASEADDRESS + mux, channel);
+              if(answers(&devs[found]) && hdc1080ReadIdentity(&devs[found])){
+                  found++;
+              }
+          }
+      }
+
+      return found;
+}
+
+uint32_t hdc1080ConversionTimeUs(HDC1080_t *dev, uint8_t reg){
+
+      uint32_t tempUs = (dev->config & HDC1080CONFIGTRES) ? HDC1080TEMP11BITUS : HDC1080TEMP14BITUS;
+      uint32_t humUs;
+
+      switch((dev->config & HDC1080CONFIGHRES) >> 8){
+      case HDC1080RES11BIT :
+          humUs = HDC1080HUM11BITUS;
+          break;
+      case HDC1080RES8BIT :
+          humUs = HDC1080HUM8BITUS;
+          break;
+      default :
+          humUs = HDC1080HUM14BITUS;
+          break;
+      }
+
+      if(reg == HDC1080HUMREG){
+          return humUs;
+      }
+      if(dev->config & HDC1080CONFIGMODE){
+          return tempUs + humUs;
+      }
+      return tempUs;
+}
+
+//Wait for a conversion started at startUs and read the result.
+//The task blocks for the remaining time and wakes on an alarm, so the
+//read lands as soon as data is ready without spinning the CPU.
+//If the sensor still NACKs, poll until HDC1080POLLTIMEOUTUS, blocked
+//between polls the same way. A read that hangs rather than NACKs ends
+//the poll and recovers the bus.
+static int readConversion(HDC1080_t *dev, uint64_t startUs, uint32_t conversionUs, uint8_t *data, size_t len){
+
+      uint64_t elapsed;
+      int ret;
+
+      elapsed = time_us_64() - startUs;
+      if(elapsed < conversionUs){
+          pauseUs(conversionUs - (uint32_t)elapsed);
+      }
+
+      while(true){
+          ret = busRead(dev, data, len);
+          if(ret == (int)len){
+              return ret;
+          }
+          if(ret != I2CASYNCERROR || time_us_64() - startUs > HDC1080POLLTIMEOUTUS){
+              countFailure(dev->bus, ret);
+              if(ret != I2CASYNCERROR){
+                  recoverBus(dev->bus);
+              }
+              dev->restore = true;
+              return ret;
+          }
+          pauseUs(HDC1080POLLUS);
+      }
+}
+
+//Bring dev back after a failed transfer or a bus recovery, which may
+//have come from the sensor resetting: check it is still the sensor it
+//was and put its configuration back. Called before each read.
+static bool deviceReady(HDC1080_t *dev){
+
+      HDC1080Bus_t *bus = dev->bus;
+      uint16_t config = dev->config;
+
+      if(!dev->restore && dev->recoveriesSeen == bus->stats.recoveries){
+          return true;
+      }
+
+      dev->converting = false;
+      if(!hdc1080ReadIdentity(dev)){
+          dev->config = config;
+          dev->restore = true;
+          return false;
+      }
+      if(dev->config != config && !writeConfigReg(dev, config)){
+          dev->config = config;
+          return false;
+      }
+
+      bus->stats.restores++;
+      dev->restore = false;
+      dev->recoveriesSeen = bus->stats.recoveries;
+      return true;
+}
+
+static uint32_t faultCount(const HDC1080Bus_t *bus){
+
+      return bus->stats.retries + bus->stats.recoveries;
+}
+
+//Trigger a single channel conversion and read back the raw code.
+//Used for temperature and humidity when not in combined mode.
+static bool readRawChannel(HDC1080_t *dev, uint8_t reg, uint16_t *raw){
+
+      uint8_t data[2] = {0, 0};
+
+      //write block for the channel register starts the conversion
+      if(busWrite(dev, &reg, 1) != 1){
+          return false;
+      }
+      uint64_t startUs = time_us_64();
+
+      //read block for the result
+      if(readConversion(dev, startUs, hdc1080ConversionTimeUs(dev, reg), data, 2) != 2){
+          return false;
+      }
+
+      *raw = data[0]<<8|data[1];
+      return true;
+}
+
+//This function reads the current temperature from the HDC1080.
+//This function is called once every 10 seconds
+int readTemperature(HDC1080_t *dev){
+
+      uint16_t raw;
+
+      if(!deviceReady(dev) || !readRawChannel(dev, HDC1080TEMPREG, &raw)){
+          return HDC1080NOREADING;
+      }
+      return convRawToC(raw);
+
+}
+
+//This function reads the current humidity from the HDC1080
+//This function is called once every 10 seconds
+int readHumidity(HDC1080_t *dev){
+
+      uint16_t raw;
+
+      if(!deviceReady(dev) || !readRawChannel(dev, HDC1080HUMREG, &raw)){
+          return HDC1080NOREADING;
+      }
+      return convRawToRH(raw);
+
+}
+
+//Set or clear the MODE bit in the configuration register.
+//The other configuration bits are preserved. Works from the cached
+//dev->config, as hdc1080SetResolution does, and skips the write if
+//the sensor is already in that mode, so it is cheap to call per read.
+bool hdc1080SetAcquisitionMode(HDC1080_t *dev, bool combined){
+
+      uint16_t config = dev->config;
+
+      if(combined){
+          config |= HDC1080CONFIGMODE;
+      }
+      else{
+          config &= ~HDC1080CONFIGMODE;
+      }
+
+      //the reset bit self clears, never write it back
+      config &= ~HDC1080CONFIGRST;
+
+      if(config == dev->config){
+          return true;
+      }
+
+      return writeConfigReg(dev, config);
+}
+
+//Start a combined conversion on dev without waiting for it.
+//Requires the MODE bit to be set.
+bool hdc1080TriggerSample(HDC1080_t *dev){
+
+      uint8_t tempRegVal = HDC1080TEMPREG;
+
+      //pointer write to the temperature register starts both conversions
+      if(!deviceReady(dev) || busWrite(dev, &tempRegVal, 1) != 1){
+          dev->converting = false;
+          return false;
+      }
+
+      dev->conversionStartUs = time_us_64();
+      dev->converting = true;
+
+      return true;
+}
+
+//Wait for the conversion started by hdc1080TriggerSample to finish
+//and read temperature and humidity back in one 4 byte read.
+bool hdc1080CollectSample(HDC1080_t *dev, HDC1080Sample_t *sample){
+
+      uint8_t data[4];
+      int ret;
+
+      sample->flags &= ~(HDC1080VALIDTEMPERATURE | HDC1080VALIDHUMIDITY);
+      if(!dev->converting){
+          return false;
+      }
+      dev->converting = false;
+
+      //one read returns temperature followed by humidity
+      ret = readConversion(dev, dev->conversionStartUs, hdc1080ConversionTimeUs(dev, HDC1080TEMPREG), data, 4);
+      if(ret != 4){
+          return false;
+      }
+
+      sample->rawTemperature = data[0]<<8|data[1];
+      sample->rawHumidity = data[2]<<8|data[3];
+      sample->flags |= HDC1080VALIDTEMPERATURE | HDC1080VALIDHUMIDITY;
+      hdc1080ConvertSample(sample);
+
+      return true;
+}
+
+//Read both channels into sample.
+//In combined mode this is one pointer write, one conversion wait and
+//one 4 byte read (temperature MSB/LSB then humidity MSB/LSB).
+//Otherwise it falls back to a temperature read and a humidity read.
+bool hdc1080ReadSample(HDC1080_t *dev, HDC1080Sample_t *sample){
+
+      uint32_t faults = faultCount(dev->bus);
+      bool ok;
+
+      if(!(dev->config & HDC1080CONFIGMODE)){
+          return hdc1080ReadChannels(dev, true, true, sample);
+      }
+
+      //the trigger failing leaves converting clear, so collect fails
+      //too and clears both flags
+      hdc1080TriggerSample(dev);
+      ok = hdc1080CollectSample(dev, sample);
+
+      if(faultCount(dev->bus) != faults){
+          sample->flags |= HDC1080RETRIED;
+      }
+      else{
+          sample->flags &= ~HDC1080RETRIED;
+      }
+      return ok;
+}
+
+//Read only the channels asked for, leaving the other raw code in
+//sample as it was, then convert. Needs the MODE bit clear to convert
+//one channel alone; in combined mode both are always read.
+bool hdc1080ReadChannels(HDC1080_t *dev, bool temperature, bool humidity, HDC1080Sample_t *sample){
+
+      uint32_t faults = faultCount(dev->bus);
+      uint8_t wanted = (temperature ? HDC1080VALIDTEMPERATURE : 0) | (humidity ? HDC1080VALIDHUMIDITY : 0);
+      uint16_t raw;
+      bool ok;
+
+      if(dev->config & HDC1080CONFIGMODE){
+          return hdc1080ReadSample(dev, sample);
+      }
+
+      //a channel is only marked good once its read has come back
+      sample->flags &= ~wanted;
+      ok = deviceReady(dev);
+
+      if(ok && temperature){
+          ok = readRawChannel(dev, HDC1080TEMPREG, &raw);
+          if(ok){
+              sample->rawTemperature = raw;
+              sample->flags |= HDC1080VALIDTEMPERATURE;
+          }
+      }
+      if(ok && humidity){
+          ok = readRawChannel(dev, HDC1080HUMREG, &raw);
+          if(ok){
+              sample->rawHumidity = raw;
+              sample->flags |= HDC1080VALIDHUMIDITY;
+          }
+      }
+
+      if(faultCount(dev->bus) != faults){
+          sample->flags |= HDC1080RETRIED;
+      }
+      else{
+          sample->flags &= ~HDC1080RETRIED;
+      }
+
+      hdc1080ConvertSample(sample);
+      return ok;
+}
+
+//Sample every sensor in devs. All conversions are triggered first and
+//collected in the same order, so each sensor converts while the others
+//are being triggered or read. The scan costs roughly one conversion
+//time plus two transfers per sensor instead of one conversion each.
+//ok[i] is set for each sensor that returned data. Returns the count.
+int hdc1080Scan(HDC1080_t *devs, int count, HDC1080Sample_t *samples, bool *ok){
+
+      int i;
+      int good = 0;
+
+      for(i = 0; i < count; i++){
+          hdc1080TriggerSample(&devs[i]);
+      }
+
+      for(i = 0; i < count; i++){
+          ok[i] = hdc1080CollectSample(&devs[i], &samples[i]);
+          if(ok[i]){
+              good++;
+          }
+      }
+
+      return good;
+}
+
+//Set the temperature and humidity resolution.
+//Other configuration bits are preserved.
+bool hdc1080SetResolution(HDC1080_t *dev, HDC1080Resolution_t temperature, HDC1080Resolution_t humidity){
+
+      uint16_t config = dev->config & ~(HDC1080CONFIGTRES | HDC1080CONFIGHRES);
+
+      if(temperature == HDC1080RES8BIT){
+          return false;
+      }
+
+      if(temperature == HDC1080RES11BIT){
+          config |= HDC1080CONFIGTRES;
+      }
+      config |= (uint16_t)humidity << 8;
+
+      return writeConfigReg(dev, config);
+}
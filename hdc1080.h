@@ -0,0 +1,213 @@
+//HDC1080 Temperature / Humidity sensor driver
+//Register map and driver functions shared by the tasks in Assign6.c
+
+#ifndef HDC1080_H
+#define HDC1080_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "hardware/i2c.h"
+
+#include "i2c_async.h"
+
+#define HDC1080TEMPREG 0x00
+#define HDC1080HUMREG 0x01
+#define HDC1080CONFIGREG 0x02
+#define HDC1080ADDRESS 0x40
+#define HDC1080SN1 0xFB
+#define HDC1080SN2 0xFC
+#define HDC1080SN3 0xFD
+#define HDC1080MFIDREG 0xFE
+#define HDC1080DEVICEIDREG 0xFF
+#define I2C_PORT i2c1
+
+//Configuration register bits
+#define HDC1080CONFIGRST 0x8000     //software reset
+#define HDC1080CONFIGHEAT 0x2000    //heater enable
+#define HDC1080CONFIGMODE 0x1000    //0 = single channel, 1 = temperature and humidity in sequence
+#define HDC1080CONFIGTRES 0x0400    //temperature resolution, 0 = 14 bit, 1 = 11 bit
+#define HDC1080CONFIGHRES 0x0300    //humidity resolution, 00 = 14 bit, 01 = 11 bit, 10 = 8 bit
+#define HDC1080CONFIGDEFAULT 0x1000 //power on value
+
+//Identity register values of every HDC1080
+#define HDC1080MFID 0x5449          //Texas Instruments
+#define HDC1080DEVICEID 0x1050
+
+//Conversion times from the datasheet in microseconds
+#define HDC1080TEMP14BITUS 6350
+#define HDC1080TEMP11BITUS 3650
+#define HDC1080HUM14BITUS 6500
+#define HDC1080HUM11BITUS 3850
+#define HDC1080HUM8BITUS 2500
+
+//While a conversion is running the sensor NACKs reads. After the
+//expected conversion time the driver retries every POLL us until
+//the data is ready or TIMEOUT us have passed.
+#define HDC1080POLLUS 250
+#define HDC1080POLLTIMEOUTUS 20000
+
+//Every transfer is abandoned as hung if it has not finished within
+//XFERTIMEOUT us; a 4 byte read at 100 kHz takes about 0.5 ms. The
+//asynchronous transport waits in whole ticks, so there the bound is
+//rounded up to a tick and one more (10 - 20 ms at 100 Hz). A failed
+//transfer is tried ATTEMPTS times in all, BACKOFF us before the first
+//retry, doubling up to BACKOFFMAX. A timeout or bus error runs bus
+//recovery before the retry. Worst case for one transfer is ATTEMPTS
+//timeouts plus the backoffs and two recoveries: about 20 ms blocking,
+//65 ms asynchronous.
+#define HDC1080XFERTIMEOUTUS 5000
+#define HDC1080XFERATTEMPTS 3
+#define HDC1080BACKOFFUS 500
+#define HDC1080BACKOFFMAXUS 4000
+
+//Returned by readTemperature and readHumidity when the read failed
+#define HDC1080NOREADING INT_MIN
+
+//Sample flags. A channel's flag is clear when its last read failed.
+#define HDC1080VALIDTEMPERATURE 0x01
+#define HDC1080VALIDHUMIDITY 0x02
+#define HDC1080RETRIED 0x04         //the read needed a retry or bus recovery
+
+typedef enum {
+    HDC1080RES14BIT,
+    HDC1080RES11BIT,
+    HDC1080RES8BIT      //humidity only
+} HDC1080Resolution_t;
+
+//TCA9548A style 8 channel I2C multiplexer. Addresses 0x70 - 0x77.
+#define HDC1080MUXBASEADDRESS 0x70
+#define HDC1080NOMUX 0
+
+typedef struct {
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t busErrors;
+    uint32_t retries;
+    uint32_t recoveries;        //9 clock sequences and controller resets
+    uint32_t stuck;             //recoveries that left a line held low
+    uint32_t restores;          //sensors checked and reconfigured after a fault
+} HDC1080BusStats_t;
+
+//One I2C controller (i2c0 or i2c1) and the multiplexer channel that
+//is currently open on it
+typedef struct {
+    i2c_inst_t *i2c;
+    I2CAsyncBus_t *async;       //NULL for the pico SDK blocking calls
+    uint8_t activeMux;
+    uint8_t activeMask;
+
+    //Pins and speed for bus recovery, baudrate 0 for none
+    uint32_t sdaPin;
+    uint32_t sclPin;
+    uint32_t baudrate;
+
+    HDC1080BusStats_t stats;
+} HDC1080Bus_t;
+
+//Identity read from a sensor when it is probed. serial holds SN1 -
+//SN3 as read; the serial ID is their top 41 bits.
+typedef struct {
+    uint16_t manufacturerId;
+    uint16_t deviceId;
+    uint16_t serial[3];
+    bool valid;
+} HDC1080Identity_t;
+
+//One sensor. muxAddress is HDC1080NOMUX when the sensor sits directly
+//on the controller, otherwise the mux address and channel 0 - 7.
+//After a failed transfer or a bus recovery the sensor may have been
+//reset, so the next read first checks its identity and writes config
+//back (restore).
+typedef struct {
+    HDC1080Bus_t *bus;
+    uint8_t address;
+    uint8_t muxAddress;
+    uint8_t muxChannel;
+    uint16_t config;
+    uint64_t conversionStartUs;
+    bool converting;
+    HDC1080Identity_t identity;
+    bool restore;
+    uint32_t recoveriesSeen;    //bus recoveries when last known good
+} HDC1080_t;
+
+//One reading of both channels. The raw codes are kept so later
+//stages can work from the full 16 bit value.
+//Converted values are in hundredths (centi) and whole units.
+typedef struct {
+    uint16_t rawTemperature;
+    uint16_t rawHumidity;
+    int32_t centiC;
+    int32_t centiF;
+    int32_t centiRH;
+    int temperatureInC;
+    int temperatureInF;
+    int humidity;
+    uint8_t flags;
+} HDC1080Sample_t;
+
+void hdc1080BusInit(HDC1080Bus_t *bus, i2c_inst_t *i2c, I2CAsyncBus_t *async);
+
+//Let the driver free a hung bus: clock SCL until SDA is released,
+//then reset the controller at baudrate. Without this a hung transfer
+//is only retried.
+void hdc1080BusSetRecovery(HDC1080Bus_t *bus, uint32_t sdaPin, uint32_t sclPin, uint32_t baudrate);
+void hdc1080Init(HDC1080_t *dev, HDC1080Bus_t *bus, uint8_t muxAddress, uint8_t muxChannel);
+
+//Register access. readConfigReg returns -1 if the read failed.
+int readConfigReg(HDC1080_t *dev);
+bool writeConfigReg(HDC1080_t *dev, uint16_t config);
+
+//Read the identity and configuration registers into dev->identity and
+//dev->config, one pointer write + repeated start read each, back to
+//back. Returns false if the device does not answer or is not an
+//HDC1080.
+bool hdc1080ReadIdentity(HDC1080_t *dev);
+
+//Find the HDC1080s on bus: one directly on the controller, otherwise
+//one per channel of any TCA9548A at 0x70 - 0x77. Each one found is
+//initialized in devs with its identity read. Returns how many were
+//found, at most max.
+int hdc1080Probe(HDC1080Bus_t *bus, HDC1080_t *devs, int max);
+
+//Single channel reads, one conversion and one bus transaction each.
+//HDC1080NOREADING if the read failed.
+int readTemperature(HDC1080_t *dev);
+int readHumidity(HDC1080_t *dev);
+
+//Acquisition mode. When combined is true one pointer write to the
+//temperature register converts both channels and hdc1080ReadSample
+//reads all 4 bytes back in one transfer. Only writes the configuration
+//register when the mode changes.
+bool hdc1080SetAcquisitionMode(HDC1080_t *dev, bool combined);
+bool hdc1080ReadSample(HDC1080_t *dev, HDC1080Sample_t *sample);
+
+//Read one or both channels, for channels sampled at different rates.
+//The channel not read keeps its previous value and flag in sample.
+//The flag of each channel read is set or cleared by how it went.
+bool hdc1080ReadChannels(HDC1080_t *dev, bool temperature, bool humidity, HDC1080Sample_t *sample);
+
+//Split form of hdc1080ReadSample for combined mode, so conversions on
+//several sensors can overlap
+bool hdc1080TriggerSample(HDC1080_t *dev);
+bool hdc1080CollectSample(HDC1080_t *dev, HDC1080Sample_t *sample);
+
+//Trigger every sensor, then collect every sensor
+int hdc1080Scan(HDC1080_t *devs, int count, HDC1080Sample_t *samples, bool *ok);
+
+//Resolution. Sets the TRES/HRES bits; reads then wait only as long as
+//the conversion takes at that resolution. 8 bit is not valid for
+//temperature and returns false.
+bool hdc1080SetResolution(HDC1080_t *dev, HDC1080Resolution_t temperature, HDC1080Resolution_t humidity);
+
+//Fill in the converted fields of sample from its raw codes using
+//the fixed point kernels in conversion.c
+void hdc1080ConvertSample(HDC1080Sample_t *sample);
+
+//Expected conversion time in us for a pointer write to reg with the
+//current configuration
+uint32_t hdc1080ConversionTimeUs(HDC1080_t *dev, uint8_t reg);
+
+#endif
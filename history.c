@@ -0,0 +1,192 @@
+//In RAM sample history
+//Rollups keep a running min/max/sum/count for the current period and
+//advance to a fresh bucket when a sample lands in a later period. A
+//gap longer than the ring just clears it, so the work per insert is
+//bounded by the ring length and O(1) amortised.
+
+#include <string.h>
+
+#include "history.h"
+
+_Static_assert(sizeof(History_t) <= HISTORYMAXBYTES, "History_t larger than HISTORYMAXBYTES");
+
+static void bucketReset(HistoryBucket_t *bucket, uint32_t startSec){
+
+    bucket->startSec = startSec;
+    bucket->count = 0;
+    bucket->sumC = 0;
+    bucket->sumRH = 0;
+}
+
+static void rollupInit(HistoryRollup_t *rollup, HistoryBucket_t *buckets, int len, uint32_t periodSec){
+
+    rollup->periodSec = periodSec;
+    rollup->len = len;
+    rollup->head = 0;
+    rollup->filled = 0;
+    rollup->buckets = buckets;
+}
+
+static void rollupAdd(HistoryRollup_t *rollup, uint32_t timeSec, int16_t centiC, uint16_t centiRH){
+
+    uint32_t start = timeSec - timeSec % rollup->periodSec;
+    HistoryBucket_t *bucket = &rollup->buckets[rollup->head];
+
+    if(rollup->filled == 0){
+        bucketReset(bucket, start);
+        rollup->filled = 1;
+    }
+    else if(start > bucket->startSec){
+        uint32_t steps = (start - bucket->startSec) / rollup->periodSec;
+        uint32_t i;
+
+        if(steps > (uint32_t)rollup->len){
+            steps = rollup->len;
+        }
+
+        //one empty bucket for each skipped period, the last is current
+        for(i = 1; i <= steps; i++){
+            rollup->head = (rollup->head + 1) % rollup->len;
+            bucketReset(&rollup->buckets[rollup->head], start - (steps - i) * rollup->periodSec);
+        }
+
+        rollup->filled += steps;
+        if(rollup->filled > rollup->len){
+            rollup->filled = rollup->len;
+        }
+        bucket = &rollup->buckets[rollup->head];
+    }
+
+    if(bucket->count == 0){
+        bucket->minC = centiC;
+        bucket->maxC = centiC;
+        bucket->minRH = centiRH;
+        bucket->maxRH = centiRH;
+    }
+    else{
+        if(centiC < bucket->minC){
+            bucket->minC = centiC;
+        }
+        if(centiC > bucket->maxC){
+            bucket->maxC = centiC;
+        }
+        if(centiRH < bucket->minRH){
+            bucket->minRH = centiRH;
+        }
+        if(centiRH > bucket->maxRH){
+            bucket->maxRH = centiRH;
+        }
+    }
+
+    bucket->sumC += centiC;
+    bucket->sumRH += centiRH;
+    bucket->count++;
+}
+
+static int rollupCopy(const HistoryRollup_t *rollup, HistoryBucket_t *out, int count){
+
+    int i;
+    int first;
+
+    if(count > rollup->filled){
+        count = rollup->filled;
+    }
+
+    first = rollup->head - count + 1 + rollup->len;
+    for(i = 0; i < count; i++){
+        out[i] = rollup->buckets[(first + i) % rollup->len];
+    }
+
+    return count;
+}
+
+void historyInit(History_t *history){
+
+    memset(history, 0, sizeof(*history));
+
+    rollupInit(&history->minutes, history->minuteBuckets, HISTORYMINUTES, 60);
+    rollupInit(&history->hours, history->hourBuckets, HISTORYHOURS, 3600);
+}
+
+void historyAdd(History_t *history, uint64_t timestampUs, int32_t centiC, int32_t centiRH){
+
+    uint32_t timeSec = (uint32_t)(timestampUs / 1000000);
+    HistorySample_t *sample = &history->raw[history->rawHead];
+
+    sample->timeSec = timeSec;
+    sample->centiC = (int16_t)centiC;
+    sample->centiRH = (uint16_t)centiRH;
+
+    history->rawHead = (history->rawHead + 1) % HISTORYRAWLEN;
+    if(history->rawCount < HISTORYRAWLEN){
+        history->rawCount++;
+    }
+
+    rollupAdd(&history->minutes, timeSec, (int16_t)centiC, (uint16_t)centiRH);
+    rollupAdd(&history->hours, timeSec, (int16_t)centiC, (uint16_t)centiRH);
+
+    history->inserts++;
+}
+
+int historyRecent(const History_t *history, HistorySample_t *out, int count){
+
+    int i;
+    int first;
+
+    if(count > history->rawCount){
+        count = history->rawCount;
+    }
+
+    first = history->rawHead - count + HISTORYRAWLEN;
+    for(i = 0; i < count; i++){
+        out[i] = history->raw[(first + i) % HISTORYRAWLEN];
+    }
+
+    return count;
+}
+
+int historyQuery(const History_t *history, HistoryResolution_t resolution, HistoryBucket_t *out, int count){
+
+    if(resolution == HISTORYHOUR){
+        return rollupCopy(&history->hours, out, count);
+    }
+    return rollupCopy(&history->minutes, out, count);
+}
+
+bool historyBucketAt(const History_t *history, HistoryResolution_t resolution, uint32_t startSec,
+                     HistoryBucket_t *out){
+
+    const HistoryRollup_t *rollup = resolution == HISTORYHOUR ? &history->hours : &history->minutes;
+    uint32_t newest = rollup->buckets[rollup->head].startSec;
+    uint32_t age;
+
+    if(rollup->filled == 0 || startSec > newest || startSec % rollup->periodSec != 0){
+        return false;
+    }
+
+    age = (newest - startSec) / rollup->periodSec;
+    if(age >= (uint32_t)rollup->filled){
+        return false;
+    }
+
+    *out = rollup->buckets[(rollup->head - (int)age + rollup->len) % rollup->len];
+
+    return true;
+}
+
+bool historyMean(const HistoryBucket_t *bucket, int32_t *centiC, int32_t *centiRH){
+
+    if(bucket->count == 0){
+        return false;
+    }
+
+    if(bucket->sumC >= 0){
+        *centiC = (int32_t)((bucket->sumC + bucket->count / 2) / bucket->count);
+    }
+    else{
+        *centiC = -(int32_t)((-bucket->sumC + bucket->count / 2) / bucket->count);
+    }
+    *centiRH = (int32_t)((bucket->sumRH + bucket->count / 2) / bucket->count);
+
+    return true;
+}
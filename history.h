@@ -0,0 +1,92 @@
+//In RAM sample history
+//A ring of recent raw samples plus min/max/mean rollups per minute and
+//per hour. Every insert is O(1) and every size is fixed at compile
+//time, so the whole store is one static object next to the FreeRTOS
+//heap. Range queries read the rollup rings directly instead of
+//rescanning raw samples.
+//Not locked: add and query from the same task, or guard externally.
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Ring sizes
+#define HISTORYRAWLEN 256       //most recent samples
+#define HISTORYMINUTES 120      //2 hours of minute rollups
+#define HISTORYHOURS 168        //7 days of hour rollups
+
+//Upper bound for sizeof(History_t), checked at compile time
+#define HISTORYMAXBYTES (16 * 1024)
+
+typedef enum {
+    HISTORYMINUTE,
+    HISTORYHOUR
+} HistoryResolution_t;
+
+//One raw sample, seconds since boot and hundredths of C / %RH
+typedef struct {
+    uint32_t timeSec;
+    int16_t centiC;
+    uint16_t centiRH;
+} HistorySample_t;
+
+//One minute or hour. count is 0 for periods with no samples. The
+//count and sums are wide enough for an hour at a 1 ms sample period.
+typedef struct {
+    uint32_t startSec;
+    uint32_t count;
+    int16_t minC;
+    int16_t maxC;
+    uint16_t minRH;
+    uint16_t maxRH;
+    int64_t sumC;
+    uint64_t sumRH;
+} HistoryBucket_t;
+
+typedef struct {
+    uint32_t periodSec;
+    int len;
+    int head;               //index of the current (newest) bucket
+    int filled;
+    HistoryBucket_t *buckets;
+} HistoryRollup_t;
+
+typedef struct {
+    HistorySample_t raw[HISTORYRAWLEN];
+    int rawHead;
+    int rawCount;
+
+    HistoryBucket_t minuteBuckets[HISTORYMINUTES];
+    HistoryBucket_t hourBuckets[HISTORYHOURS];
+    HistoryRollup_t minutes;
+    HistoryRollup_t hours;
+
+    uint32_t inserts;
+} History_t;
+
+void historyInit(History_t *history);
+
+//Add one sample. Samples must arrive in time order.
+void historyAdd(History_t *history, uint64_t timestampUs, int32_t centiC, int32_t centiRH);
+
+//Copy up to count of the most recent raw samples, oldest first.
+//Returns the number copied.
+int historyRecent(const History_t *history, HistorySample_t *out, int count);
+
+//Copy up to count of the most recent minute or hour buckets, oldest
+//first, including the one still filling. Returns the number copied.
+int historyQuery(const History_t *history, HistoryResolution_t resolution, HistoryBucket_t *out, int count);
+
+//Copy the minute or hour bucket that starts at startSec, a multiple
+//of the period. O(1) from the newest bucket's start. Returns false if
+//that period has left the ring or not begun.
+bool historyBucketAt(const History_t *history, HistoryResolution_t resolution, uint32_t startSec,
+                     HistoryBucket_t *out);
+
+//Mean of a bucket in hundredths, rounded half away from zero.
+//Returns false for an empty bucket.
+bool historyMean(const HistoryBucket_t *bucket, int32_t *centiC, int32_t *centiRH);
+
+#endif
@@ -0,0 +1,96 @@
+//Asynchronous I2C transport
+//Backend independent part: start, completion and the task side wait.
+
+#include "i2c_async.h"
+
+static int finish(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer, int result, uint64_t nowUs){
+
+    xfer->result = result;
+    xfer->endUs = nowUs;
+
+    bus->busyUs += nowUs - xfer->startUs;
+    if(result < 0){
+        bus->errors++;
+    }
+    bus->active = NULL;
+
+    return result;
+}
+
+bool i2cAsyncStart(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer){
+
+    if(bus->active != NULL){
+        return false;
+    }
+
+    xfer->result = I2CASYNCTIMEOUT;
+    xfer->waiter = xTaskGetCurrentTaskHandle();
+    xfer->txIndex = 0;
+    xfer->cmdIndex = 0;
+    xfer->rxIndex = 0;
+    xfer->aborted = false;
+    xfer->busError = false;
+
+    //drop any completion left over from an earlier timed out transfer
+    xTaskNotifyStateClearIndexed(NULL, I2CASYNCNOTIFYINDEX);
+    ulTaskNotifyTakeIndexed(I2CASYNCNOTIFYINDEX, pdTRUE, 0);
+
+    bus->active = xfer;
+    bus->transfers++;
+
+    if(!bus->ops->start(bus, xfer)){
+        bus->active = NULL;
+        bus->errors++;
+        return false;
+    }
+
+    return true;
+}
+
+int i2cAsyncWait(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer, TickType_t timeout){
+
+    if(ulTaskNotifyTakeIndexed(I2CASYNCNOTIFYINDEX, pdTRUE, timeout) == 0){
+        if(bus->ops->abort != NULL){
+            bus->ops->abort(bus);
+        }
+        bus->active = NULL;
+        bus->errors++;
+        return I2CASYNCTIMEOUT;
+    }
+
+    return xfer->result;
+}
+
+int i2cAsyncTransfer(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer, TickType_t timeout){
+
+    xfer->timeoutUs = timeout == portMAX_DELAY ? 0 : timeout * portTICK_PERIOD_MS * 1000;
+    if(!i2cAsyncStart(bus, xfer)){
+        return I2CASYNCERROR;
+    }
+
+    return i2cAsyncWait(bus, xfer, timeout);
+}
+
+void i2cAsyncComplete(I2CAsyncBus_t *bus, int result, uint64_t nowUs){
+
+    I2CAsyncXfer_t *xfer = bus->active;
+
+    if(xfer == NULL){
+        return;
+    }
+
+    finish(bus, xfer, result, nowUs);
+    xTaskNotifyGiveIndexed(xfer->waiter, I2CASYNCNOTIFYINDEX);
+}
+
+void i2cAsyncCompleteFromISR(I2CAsyncBus_t *bus, int result, uint64_t nowUs, BaseType_t *woken){
+
+    I2CAsyncXfer_t *xfer = bus->active;
+
+    if(xfer == NULL){
+        return;
+    }
+
+    finish(bus, xfer, result, nowUs);
+    vTaskNotifyGiveIndexedFromISR(xfer->waiter, I2CASYNCNOTIFYINDEX, woken);
+}
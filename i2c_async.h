@@ -0,0 +1,99 @@
+//Asynchronous I2C transport
+//A transfer is started on a bus and the calling task blocks on a
+//direct-to-task notification until the backend reports completion,
+//so the CPU is free while bytes move. Backends provide the start
+//function; the RP2040 backend is interrupt driven and the host
+//backend in sim/ completes against the simulated sensor.
+
+#ifndef I2C_ASYNC_H
+#define I2C_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+//Notification slot used for transfer completion. Slot 0 is left for
+//application use (configTASK_NOTIFICATION_ARRAY_ENTRIES is 4).
+#define I2CASYNCNOTIFYINDEX 1
+
+//Result codes. ERROR and TIMEOUT match the pico SDK blocking calls.
+//ERROR is a NACK; BUSERROR is lost arbitration, another controller or
+//a line held low by a target.
+#define I2CASYNCERROR -1
+#define I2CASYNCTIMEOUT -2
+#define I2CASYNCBUSERROR -3
+
+//One transfer: txLen bytes written, then rxLen bytes read after a
+//repeated start. Either length may be zero.
+typedef struct {
+    uint8_t address;
+    const uint8_t *txBuf;
+    size_t txLen;
+    uint8_t *rxBuf;
+    size_t rxLen;
+
+    //Filled in by the transport. timeoutUs is the wait's bound, 0 for
+    //none, for backends that model bus time.
+    volatile int result;
+    uint32_t timeoutUs;
+    TaskHandle_t waiter;
+    uint64_t startUs;
+    uint64_t endUs;
+
+    //Backend progress
+    size_t txIndex;
+    size_t cmdIndex;
+    size_t rxIndex;
+    bool aborted;
+    bool busError;
+} I2CAsyncXfer_t;
+
+typedef struct I2CAsyncBus I2CAsyncBus_t;
+
+typedef struct {
+    //Begin xfer on the bus. Returns false if it could not be started.
+    bool (*start)(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer);
+    //Stop a transfer that timed out. Optional.
+    void (*abort)(I2CAsyncBus_t *bus);
+} I2CAsyncOps_t;
+
+struct I2CAsyncBus {
+    const I2CAsyncOps_t *ops;
+    void *ctx;
+    I2CAsyncXfer_t *volatile active;
+
+    //Statistics
+    uint32_t transfers;
+    uint32_t errors;
+    uint64_t busyUs;
+};
+
+//Start xfer and return without waiting
+bool i2cAsyncStart(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer);
+
+//Block the calling task until xfer completes or timeout ticks pass.
+//Returns bytes transferred (rx if any, else tx) or an error code.
+int i2cAsyncWait(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer, TickType_t timeout);
+
+//Start and wait in one call
+int i2cAsyncTransfer(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer, TickType_t timeout);
+
+//Called by backends when the active transfer finishes
+void i2cAsyncComplete(I2CAsyncBus_t *bus, int result, uint64_t nowUs);
+void i2cAsyncCompleteFromISR(I2CAsyncBus_t *bus, int result, uint64_t nowUs, BaseType_t *woken);
+
+//RP2040 interrupt driven backend on i2c0 or i2c1 (i2c_async_rp2040.c).
+//i2c_init must already have been called for the port.
+struct i2c_inst;
+void i2cAsyncRp2040Init(I2CAsyncBus_t *bus, struct i2c_inst *i2c);
+
+//Free a bus held by a target and reset the controller: up to 9 SCL
+//clocks until SDA is released, a STOP, then i2c_init at baudrate.
+//Works with or without the async backend. Returns false if SDA or
+//SCL is still low.
+bool i2cRp2040Recover(struct i2c_inst *i2c, uint32_t sdaPin, uint32_t sclPin, uint32_t baudrate);
+
+#endif
@@ -0,0 +1,246 @@
+//Asynchronous I2C transport, RP2040 backend
+//The controller FIFOs are fed from the I2C interrupt: TX_EMPTY queues
+//write bytes and read commands, RX_FULL drains received bytes, and
+//STOP_DET ends the transfer and notifies the waiting task.
+//Bus recovery for a target holding SDA low is here too.
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/gpio.h"
+
+#include "i2c_async.h"
+
+//FIFO depth of the DW_apb_i2c block on the RP2040
+#define I2CFIFODEPTH 16
+
+//Bus recovery clocks at 100 kHz. A target may stretch each clock for
+//up to STRETCH us before it counts as stuck.
+#define I2CRECOVERHALFUS 5
+#define I2CRECOVERSTRETCHUS 1000
+
+static I2CAsyncBus_t *irqBus[2];
+
+//Queue as many write bytes and read commands as fit in the TX FIFO.
+//The first read after a write gets a repeated start and the last
+//command of the transfer issues the stop.
+static void fillTxFifo(i2c_hw_t *hw, I2CAsyncXfer_t *xfer){
+
+    size_t total = xfer->txLen + xfer->rxLen;
+
+    while(xfer->cmdIndex < total && hw->txflr < I2CFIFODEPTH){
+        uint32_t cmd = 0;
+
+        if(xfer->cmdIndex < xfer->txLen){
+            cmd = xfer->txBuf[xfer->cmdIndex];
+        }
+        else{
+            cmd = I2C_IC_DATA_CMD_CMD_BITS;
+            if(xfer->cmdIndex == xfer->txLen && xfer->txLen > 0){
+                cmd |= I2C_IC_DATA_CMD_RESTART_BITS;
+            }
+        }
+        if(xfer->cmdIndex == total - 1){
+            cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+        }
+
+        hw->data_cmd = cmd;
+        xfer->cmdIndex++;
+    }
+
+    if(xfer->cmdIndex == total){
+        hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+    }
+}
+
+static void handleIrq(I2CAsyncBus_t *bus){
+
+    i2c_hw_t *hw = i2c_get_hw((i2c_inst_t *)bus->ctx);
+    I2CAsyncXfer_t *xfer = bus->active;
+    uint32_t status = hw->intr_stat;
+    BaseType_t woken = pdFALSE;
+
+    if(xfer == NULL){
+        hw->intr_mask = 0;
+        return;
+    }
+
+    if(status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS){
+        //NACK or arbitration loss. The controller flushes the FIFO and
+        //still generates a stop, which finishes the transfer below.
+        //The source has to be read before the abort is cleared.
+        xfer->busError = (hw->tx_abrt_source & I2C_IC_TX_ABRT_SOURCE_ARB_LOST_BITS) != 0;
+        (void)hw->clr_tx_abrt;
+        xfer->aborted = true;
+        hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+    }
+
+    if(status & I2C_IC_INTR_STAT_R_RX_FULL_BITS){
+        while(hw->rxflr > 0 && xfer->rxIndex < xfer->rxLen){
+            xfer->rxBuf[xfer->rxIndex++] = (uint8_t)hw->data_cmd;
+        }
+    }
+
+    if(status & I2C_IC_INTR_STAT_R_TX_EMPTY_BITS){
+        fillTxFifo(hw, xfer);
+    }
+
+    if(status & I2C_IC_INTR_STAT_R_STOP_DET_BITS){
+        int result;
+
+        (void)hw->clr_stop_det;
+        hw->intr_mask = 0;
+
+        if(xfer->aborted){
+            result = xfer->busError ? I2CASYNCBUSERROR : I2CASYNCERROR;
+        }
+        else if(xfer->rxLen > 0){
+            result = (int)xfer->rxIndex;
+        }
+        else{
+            result = (int)xfer->txLen;
+        }
+
+        i2cAsyncCompleteFromISR(bus, result, time_us_64(), &woken);
+    }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+static void i2c0Irq(void){
+
+    handleIrq(irqBus[0]);
+}
+
+static void i2c1Irq(void){
+
+    handleIrq(irqBus[1]);
+}
+
+static bool rp2040Start(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer){
+
+    i2c_hw_t *hw = i2c_get_hw((i2c_inst_t *)bus->ctx);
+
+    if(xfer->txLen + xfer->rxLen == 0){
+        return false;
+    }
+
+    xfer->startUs = time_us_64();
+
+    //target address can only change while the block is disabled
+    hw->enable = 0;
+    hw->tar = xfer->address;
+    hw->enable = 1;
+
+    (void)hw->clr_intr;
+    hw->rx_tl = 0;
+    hw->tx_tl = 0;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_TX_EMPTY_BITS |
+                    I2C_IC_INTR_MASK_M_RX_FULL_BITS |
+                    I2C_IC_INTR_MASK_M_TX_ABRT_BITS |
+                    I2C_IC_INTR_MASK_M_STOP_DET_BITS;
+
+    return true;
+}
+
+static void rp2040Abort(I2CAsyncBus_t *bus){
+
+    i2c_hw_t *hw = i2c_get_hw((i2c_inst_t *)bus->ctx);
+
+    hw->intr_mask = 0;
+    hw->enable = 0;
+    hw->enable = 1;
+}
+
+static const I2CAsyncOps_t rp2040Ops = {
+    .start = rp2040Start,
+    .abort = rp2040Abort,
+};
+
+void i2cAsyncRp2040Init(I2CAsyncBus_t *bus, struct i2c_inst *i2c){
+
+    uint index = i2c_hw_index(i2c);
+    uint irq = index == 0 ? I2C0_IRQ : I2C1_IRQ;
+
+    bus->ops = &rp2040Ops;
+    bus->ctx = i2c;
+    bus->active = NULL;
+    bus->transfers = 0;
+    bus->errors = 0;
+    bus->busyUs = 0;
+
+    irqBus[index] = bus;
+
+    i2c_get_hw(i2c)->intr_mask = 0;
+    irq_set_exclusive_handler(irq, index == 0 ? i2c0Irq : i2c1Irq);
+    irq_set_enabled(irq, true);
+}
+
+//Drive a pin open drain: low with the output enabled, released to
+//the pull up with it disabled. The output value is always 0.
+static void openDrain(uint32_t pin, bool low){
+
+    gpio_set_dir(pin, low ? GPIO_OUT : GPIO_IN);
+    busy_wait_us_32(I2CRECOVERHALFUS);
+}
+
+//Release SCL and wait out any clock stretching
+static bool releaseClock(uint32_t sclPin){
+
+    uint64_t start = time_us_64();
+
+    openDrain(sclPin, false);
+    while(!gpio_get(sclPin)){
+        if(time_us_64() - start > I2CRECOVERSTRETCHUS){
+            return false;
+        }
+    }
+    return true;
+}
+
+//A target reset or interrupted part way through a read holds SDA low
+//while it waits for clocks to shift out the rest of its byte. Each
+//clock with SDA high reads as a NACK, so at most 9 finish the byte
+//and the target lets go; the STOP after puts every target back to
+//idle. The controller is reset on the way out either way.
+bool i2cRp2040Recover(struct i2c_inst *i2c, uint32_t sdaPin, uint32_t sclPin, uint32_t baudrate){
+
+    bool clockOk = true;
+    bool released;
+    int clocks;
+
+    i2c_deinit(i2c);
+
+    gpio_init(sdaPin);
+    gpio_init(sclPin);
+    gpio_pull_up(sdaPin);
+    gpio_pull_up(sclPin);
+    gpio_put(sdaPin, 0);
+    gpio_put(sclPin, 0);
+    busy_wait_us_32(I2CRECOVERHALFUS);
+
+    for(clocks = 0; clocks < 9 && clockOk && !gpio_get(sdaPin); clocks++){
+        openDrain(sclPin, true);
+        clockOk = releaseClock(sclPin);
+    }
+
+    //STOP: SDA low then high while SCL is high
+    if(clockOk){
+        openDrain(sclPin, true);
+        openDrain(sdaPin, true);
+        clockOk = releaseClock(sclPin);
+        openDrain(sdaPin, false);
+    }
+
+    released = clockOk && gpio_get(sdaPin) && gpio_get(sclPin);
+
+    gpio_set_function(sdaPin, GPIO_FUNC_I2C);
+    gpio_set_function(sclPin, GPIO_FUNC_I2C);
+    i2c_init(i2c, baudrate);
+
+    //the block comes out of reset with its interrupts unmasked; the
+    //async backend unmasks what it needs when a transfer starts
+    i2c_get_hw(i2c)->intr_mask = 0;
+
+    return released;
+}
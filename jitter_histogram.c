@@ -0,0 +1,100 @@
+//Sampling jitter and drift, see jitter_histogram.h
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jitter_histogram.h"
+
+static volatile bool requested;
+
+void jitterHistogramInit(JitterHistogram_t *histogram){
+
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+void jitterHistogramRecord(JitterHistogram_t *histogram, uint64_t dueUs, uint64_t startUs){
+
+    int64_t lateUs = (int64_t)(startUs - dueUs);
+    int bucket = 0;
+
+    //early only happens when the clock is read before the slot, count
+    //it as on time
+    if(lateUs > 0){
+        while(bucket < JITTERBUCKETS - 1 && lateUs >= (int64_t)1 << bucket){
+            bucket++;
+        }
+    }
+    histogram->buckets[bucket]++;
+
+    if(histogram->samples == 0 || lateUs < histogram->minUs){
+        histogram->minUs = lateUs;
+    }
+    if(histogram->samples == 0 || lateUs > histogram->maxUs){
+        histogram->maxUs = lateUs;
+    }
+    histogram->sumUs += lateUs;
+    histogram->driftUs = lateUs;
+    histogram->samples++;
+}
+
+void jitterHistogramMissed(JitterHistogram_t *histogram, uint32_t slots){
+
+    histogram->missed += slots;
+}
+
+size_t jitterHistogramFormat(const JitterHistogram_t *histogram, int line, char *buf, size_t len){
+
+    int n = -1;
+    int bucket;
+
+    if(line == 0){
+        n = snprintf(buf, len,
+                     "jitter samples=%lu missed=%lu late_min_us=%lld late_mean_us=%lld late_max_us=%lld drift_us=%lld\n",
+                     (unsigned long)histogram->samples, (unsigned long)histogram->missed,
+                     (long long)histogram->minUs,
+                     (long long)(histogram->samples ? histogram->sumUs / histogram->samples : 0),
+                     (long long)histogram->maxUs, (long long)histogram->driftUs);
+    }
+    else{
+        //line n is the nth bucket in use, then the end marker
+        for(bucket = 0; bucket < JITTERBUCKETS; bucket++){
+            if(histogram->buckets[bucket] != 0 && --line == 0){
+                break;
+            }
+        }
+
+        if(bucket < JITTERBUCKETS){
+            n = snprintf(buf, len, "jitter_bucket below_us=%lu count=%lu\n",
+                         bucket < JITTERBUCKETS - 1 ? 1ul << bucket : 0ul,
+                         (unsigned long)histogram->buckets[bucket]);
+        }
+        else if(line == 1){
+            n = snprintf(buf, len, "jitter end\n");
+        }
+        else{
+            return 0;
+        }
+    }
+
+    if(n < 0){
+        return 0;
+    }
+
+    return (size_t)n < len ? (size_t)n : len - 1;
+}
+
+void jitterHistogramRequest(void){
+
+    requested = true;
+}
+
+bool jitterHistogramTakeRequest(void){
+
+    if(!requested){
+        return false;
+    }
+
+    requested = false;
+
+    return true;
+}
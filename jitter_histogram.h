@@ -0,0 +1,54 @@
+//Sampling jitter and drift
+//Each reading taken on the schedule records how late it started
+//against its slot on the 64 bit microsecond timer. Lateness goes into
+//power of 2 buckets, and the lateness of the newest reading is the
+//drift: with slots on an absolute grid it stays bounded however long
+//the firmware runs, where a relative delay would add every read's
+//duration to it. Printed as
+//
+//  jitter samples=<n> missed=<n> late_min_us=<n> late_mean_us=<n> late_max_us=<n> drift_us=<n>
+//  jitter_bucket below_us=<n> count=<n>      one per bucket in use
+//  jitter end
+//
+//Pure logic, so tools/schedule_drift.c runs it on the host. Not safe
+//to record and format at once; the firmware copies it in a critical
+//section.
+
+#ifndef JITTER_HISTOGRAM_H
+#define JITTER_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//Bucket i counts lateness below 2^i us, the last one everything
+//from 2^(JITTERBUCKETS - 2) us, about 0.5 s, up
+#define JITTERBUCKETS 21
+
+typedef struct {
+    uint32_t buckets[JITTERBUCKETS];
+    uint32_t samples;
+    uint32_t missed;            //slots dropped because a reading ran late
+    int64_t minUs;
+    int64_t maxUs;
+    int64_t sumUs;
+    int64_t driftUs;            //lateness of the newest reading
+} JitterHistogram_t;
+
+void jitterHistogramInit(JitterHistogram_t *histogram);
+
+//A reading due at dueUs started at startUs
+void jitterHistogramRecord(JitterHistogram_t *histogram, uint64_t dueUs, uint64_t startUs);
+
+//Slots the schedule skipped, see adaptiveRateMissed
+void jitterHistogramMissed(JitterHistogram_t *histogram, uint32_t slots);
+
+//Format line of the report into buf, as runtimeStatsFormat. Returns
+//the length, or 0 once past the last line.
+size_t jitterHistogramFormat(const JitterHistogram_t *histogram, int line, char *buf, size_t len);
+
+//Ask for a report. The report task picks it up.
+void jitterHistogramRequest(void);
+bool jitterHistogramTakeRequest(void);
+
+#endif
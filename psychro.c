@@ -0,0 +1,211 @@
+//Derived psychrometric metrics in fixed point, see psychro.h
+//Logs and exponents are Q24 (ln 10000 = 9.2 and exp 6 = 403 fit with
+//room to spare), polynomial arguments Q30. Products are formed in 64
+//bits and shifted back down.
+
+#include "psychro.h"
+
+#define Q24ONE (1 << 24)
+#define Q30ONE (1 << 30)
+#define LN2Q24 11629080                 //ln 2
+#define LN2Q30 744261118
+#define SQRT2Q30 1518500250             //sqrt 2
+#define LN10000Q24 154523870            //ln 10000, for RH as a fraction
+
+//Magnus b and c, and c in hundredths
+#define MAGNUSCENTIB 1762
+#define MAGNUSCENTIC 24312
+#define MAGNUSBQ24 (((int64_t)MAGNUSCENTIB << 24) / 100)
+
+//216.7 g K / m3 hPa * 6.112 hPa, times 10^4
+#define ABSHUMIDITYSCALE 13244704
+#define CENTIKELVIN 27315
+
+//Rothfusz regression coefficients times 10^8, heat index in F from T
+//in F and RH in %:
+//  HI = c0 + c1 T + c2 R + c3 T R + c4 T^2 + c5 R^2 + c6 T^2 R
+//     + c7 T R^2 + c8 T^2 R^2
+#define HIC0 -4237900000LL
+#define HIC1 204901523LL
+#define HIC2 1014333127LL
+#define HIC3 -22475541LL
+#define HIC4 -683783LL
+#define HIC5 -5481717LL
+#define HIC6 122874LL
+#define HIC7 85282LL
+#define HIC8 -199LL
+
+//Divide rounding half away from zero, den > 0
+static int64_t divRound(int64_t num, int64_t den){
+
+    if(num >= 0){
+        return (num + den / 2) / den;
+    }
+    return -((-num + den / 2) / den);
+}
+
+//a * b for Q30 a and b
+static inline int32_t mulQ30(int32_t a, int32_t b){
+
+    return (int32_t)(((int64_t)a * b + (1 << 29)) >> 30);
+}
+
+//ln n for n >= 1, Q24. n = 2^k m with m in [1/sqrt 2, sqrt 2), then
+//ln m = 2 atanh s, s = (m - 1) / (m + 1), |s| <= 0.172, so the series
+//to s^9 leaves under 1e-9.
+static int32_t lnQ24(uint32_t n){
+
+    int k = 31 - __builtin_clz(n);
+    int32_t m;
+    int32_t s;
+    int32_t s2;
+    int32_t poly;
+
+    //m = n / 2^k, Q30
+    m = k <= 30 ? (int32_t)(n << (30 - k)) : (int32_t)(n >> 1);
+    if(m > SQRT2Q30){
+        m = (int32_t)(((uint32_t)m + 1) >> 1);
+        k++;
+    }
+
+    s = (int32_t)divRound(((int64_t)m - Q30ONE) * Q30ONE, (int64_t)m + Q30ONE);
+    s2 = mulQ30(s, s);
+
+    poly = Q30ONE / 9;
+    poly = Q30ONE / 7 + mulQ30(s2, poly);
+    poly = Q30ONE / 5 + mulQ30(s2, poly);
+    poly = Q30ONE / 3 + mulQ30(s2, poly);
+    poly = Q30ONE + mulQ30(s2, poly);
+
+    //2 s poly, Q30 to Q24
+    return k * LN2Q24 + (int32_t)divRound(2 * (int64_t)mulQ30(s, poly), 1 << 6);
+}
+
+//exp x for Q24 x in about [-20, 20], Q24. x = k ln 2 + r with
+//|r| <= ln 2 / 2, and the Taylor series of exp r to r^6 leaves under
+//2e-7 relative.
+static int64_t expQ24(int32_t x){
+
+    int32_t k;
+    int32_t r;
+    int32_t poly;
+
+    k = (int32_t)divRound(x, LN2Q24);
+    r = (int32_t)((int64_t)x * (1 << 6) - (int64_t)k * LN2Q30);
+
+    poly = Q30ONE / 720;
+    poly = Q30ONE / 120 + mulQ30(r, poly);
+    poly = Q30ONE / 24 + mulQ30(r, poly);
+    poly = Q30ONE / 6 + mulQ30(r, poly);
+    poly = Q30ONE / 2 + mulQ30(r, poly);
+    poly = Q30ONE + mulQ30(r, poly);
+    poly = Q30ONE + mulQ30(r, poly);
+
+    //Q30 to Q24 times 2^k
+    if(k >= 6){
+        return (int64_t)poly << (k - 6);
+    }
+    return ((int64_t)poly + ((int64_t)1 << (5 - k))) >> (6 - k);
+}
+
+//Integer square root
+static uint32_t isqrt(uint64_t v){
+
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while(bit > v){
+        bit >>= 2;
+    }
+    while(bit != 0){
+        if(v >= root + bit){
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else{
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+//NWS heat index, hundredths of F in and out
+static int32_t heatIndex(int32_t t, int32_t r){
+
+    int64_t a;
+    int64_t b;
+    int64_t c;
+    int64_t hi;
+    int64_t simple;
+    int32_t fromNinetyFive;
+
+    //Steadman: 0.5 (T + 61 + 1.2 (T - 68) + 0.094 RH), kept as 2000
+    //times the hundredths so the test against 80 F is exact
+    simple = 1000LL * t + 6100000 + 1200LL * (t - 6800) + 94LL * r;
+    if(simple + 2000LL * t < 2000LL * 2 * 8000){
+        return (int32_t)divRound(simple, 2000);
+    }
+
+    //Rothfusz, grouped by powers of RH, times 10^8
+    a = HIC0 + HIC1 * t / 100 + HIC4 * t * t / 10000;
+    b = HIC2 + HIC3 * t / 100 + HIC6 * t * t / 10000;
+    c = HIC5 + HIC7 * t / 100 + HIC8 * t * t / 10000;
+    hi = a + b * r / 100 + c * r * r / 10000;
+
+    //dry: less ((13 - RH) / 4) sqrt((17 - |T - 95|) / 17)
+    if(r < 1300 && t > 8000 && t < 11200){
+        fromNinetyFive = t > 9500 ? t - 9500 : 9500 - t;
+        hi -= (int64_t)(1300 - r) * 250000 *
+              isqrt(((uint64_t)(1700 - fromNinetyFive) << 32) / 1700) >> 16;
+    }
+
+    //humid: more ((RH - 85) / 10) ((87 - T) / 5)
+    if(r > 8500 && t > 8000 && t < 8700){
+        hi += (int64_t)(r - 8500) * (8700 - t) * 200;
+    }
+
+    return (int32_t)divRound(hi, 1000000);
+}
+
+void psychroCompute(int32_t centiC, int32_t centiRH, PsychroMetrics_t *out){
+
+    int32_t magnus;
+    int32_t gamma;
+    int64_t vapour;
+    int32_t centiF;
+
+    if(centiRH < 0){
+        centiRH = 0;
+    }
+    else if(centiRH > 10000){
+        centiRH = 10000;
+    }
+
+    //b T / (c + T), T in hundredths
+    magnus = (int32_t)divRound((int64_t)MAGNUSCENTIB * centiC * Q24ONE, (int64_t)(MAGNUSCENTIC + centiC) * 100);
+
+    if(centiRH == 0){
+        out->centiDewPointC = PSYCHRONOVALUE;
+    }
+    else{
+        gamma = lnQ24((uint32_t)centiRH) - LN10000Q24 + magnus;
+        out->centiDewPointC = (int32_t)divRound((int64_t)MAGNUSCENTIC * gamma, MAGNUSBQ24 - gamma);
+    }
+
+    //e / 6.112 hPa, Q24
+    vapour = divRound(expQ24(magnus) * centiRH, 10000);
+    out->centiAbsHumidity = (int32_t)divRound(ABSHUMIDITYSCALE * vapour,
+                                              (int64_t)(CENTIKELVIN + centiC) << 24);
+
+    centiF = (int32_t)divRound((int64_t)centiC * 9, 5) + 3200;
+    out->centiHeatIndexF = heatIndex(centiF, centiRH);
+}
+
+void psychroClear(PsychroMetrics_t *out){
+
+    out->centiDewPointC = PSYCHRONOVALUE;
+    out->centiAbsHumidity = PSYCHRONOVALUE;
+    out->centiHeatIndexF = PSYCHRONOVALUE;
+}
@@ -0,0 +1,54 @@
+//Derived psychrometric metrics in fixed point
+//Dew point, absolute humidity and heat index from a temperature and
+//relative humidity in hundredths, for HVAC control on the board
+//rather than off it. The Cortex-M0+ has no FPU, so the log and exp
+//the formulas need are evaluated in Q24/Q30 integers: ln by range
+//reduction to [1/sqrt 2, sqrt 2) and an atanh series, exp by powers
+//of two and a degree 6 Taylor polynomial. No float, no libm.
+//
+//  dew point           Magnus over water, Sonntag 1990 constants:
+//                      g = ln(RH / 100) + b T / (c + T)
+//                      Td = c g / (b - g), b = 17.62, c = 243.12 C
+//  absolute humidity   AH = 216.7 e / (T + 273.15) g/m3, vapour
+//                      pressure e = RH / 100 * 6.112 exp(b T / (c + T))
+//                      hPa from the same Magnus fit
+//  heat index          NWS: Steadman's simple formula, or the
+//                      Rothfusz regression with its low and high
+//                      humidity adjustments once that averages 80 F
+//
+//Against the same formulas in double precision, over the whole sensor
+//range (-40 - 125 C, 0 - 100 %RH), results are within the bounds
+//below, checked by tools/psychro_check.c: the last digit only differs
+//where the exact value sits within a hair of half a hundredth. The
+//formulas themselves are fits: Magnus is within 0.1 % of saturation
+//pressure from -45 to 60 C and extrapolated outside it, and the heat
+//index regression is only meaningful from 80 to 112 F.
+//
+//Pure integer math, so it runs unchanged on the host.
+
+#ifndef PSYCHRO_H
+#define PSYCHRO_H
+
+#include <stdint.h>
+
+//Metric that cannot be derived: no valid reading, or a dew point at 0 %RH
+#define PSYCHRONOVALUE INT32_MIN
+
+//Worst case error against the double precision formulas, hundredths
+#define PSYCHRODEWPOINTBOUND 1          //0.01 C
+#define PSYCHROABSHUMIDITYBOUND 1       //0.01 g/m3
+#define PSYCHROHEATINDEXBOUND 1         //0.01 F
+
+typedef struct {
+    int32_t centiDewPointC;
+    int32_t centiAbsHumidity;           //g/m3
+    int32_t centiHeatIndexF;
+} PsychroMetrics_t;
+
+//Hundredths of a degree C and of a percent RH in, every metric out
+void psychroCompute(int32_t centiC, int32_t centiRH, PsychroMetrics_t *out);
+
+//Every metric PSYCHRONOVALUE, for a sample without both channels
+void psychroClear(PsychroMetrics_t *out);
+
+#endif
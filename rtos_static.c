@@ -0,0 +1,28 @@
+//Storage for the tasks the kernel creates itself. Only needed when
+//configSUPPORT_STATIC_ALLOCATION is set, see rtos_static.h.
+
+#include "rtos_static.h"
+
+#if configSUPPORT_STATIC_ALLOCATION
+
+RTOSTASK(idleTask, configMINIMAL_STACK_SIZE);
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *words){
+    *tcb = &idleTaskTcb;
+    *stack = idleTaskStack;
+    *words = configMINIMAL_STACK_SIZE;
+}
+
+#if configUSE_TIMERS
+
+RTOSTASK(timerTask, configTIMER_TASK_STACK_DEPTH);
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *words){
+    *tcb = &timerTaskTcb;
+    *stack = timerTaskStack;
+    *words = configTIMER_TASK_STACK_DEPTH;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+//Kernel object storage
+//With ASSIGN6STATIC (the CMake option, on by default) every task and
+//queue is built from storage reserved at compile time, so RAM use is
+//fixed at link time and nothing is allocated before the scheduler
+//starts. With it off the same calls fall back to the FreeRTOS heap.
+//
+//RTOSTASK and RTOSQUEUE reserve the storage at file scope, the create
+//macros use it:
+//
+//  RTOSTASK(sampleTask, SAMPLESTACKWORDS);
+//  RTOSCREATETASK(sampleTask, SAMPLESTACKWORDS, 1);
+//
+//The storage is named <task>Stack, <task>Tcb, <queue>Storage and
+//<queue>Buffer, which is how tools/ram_budget.py finds each task in
+//the link map.
+
+#ifndef RTOS_STATIC_H
+#define RTOS_STATIC_H
+
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+#if configSUPPORT_STATIC_ALLOCATION
+
+#define RTOSTASK(task, words) \
+    static StackType_t task##Stack[words]; \
+    static StaticTask_t task##Tcb
+
+#define RTOSCREATETASK(task, words, priority) \
+    xTaskCreateStatic(task, #task, words, NULL, priority, task##Stack, &task##Tcb)
+
+#define RTOSQUEUE(queue, length, itemSize) \
+    static uint8_t queue##Storage[(length) * (itemSize)]; \
+    static StaticQueue_t queue##Buffer
+
+#define RTOSCREATEQUEUE(queue, length, itemSize) \
+    xQueueCreateStatic(length, itemSize, queue##Storage, &queue##Buffer)
+
+#else
+
+//declarations only, so the uses read the same in both modes
+#define RTOSTASK(task, words) extern StackType_t task##Stack[]
+#define RTOSCREATETASK(task, words, priority) \
+    xTaskCreate(task, #task, words, NULL, priority, NULL)
+
+#define RTOSQUEUE(queue, length, itemSize) extern uint8_t queue##Storage[]
+#define RTOSCREATEQUEUE(queue, length, itemSize) \
+    xQueueCreate(length, itemSize)
+
+#endif
+
+#endif
@@ -0,0 +1,539 @@
+//Runtime configuration, see runtime_config.h
+//Every setting is a row in keys[]: where it lives in RuntimeConfig_t,
+//how it is written on the command line and the values it may take.
+//get, set, the range checks and loading from flash all work from the
+//table, so a new setting is one row.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "runtime_config.h"
+#include "telemetry.h"
+
+#ifndef RUNTIMECONFIGHOST
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+typedef enum {
+    KEYNUMBER,      //uint32_t or uint8_t between min and max
+    KEYCHOICE,      //uint8_t index into choices
+    KEYFILTER       //SampleFilterConfig_t
+} KeyKind_t;
+
+typedef struct {
+    const char *name;
+    KeyKind_t kind;
+    size_t offset;
+    uint8_t size;
+    uint32_t min;
+    uint32_t max;
+    const char *const *choices;
+} ConfigKey_t;
+
+static const char *const resolutionChoices[] = {"14", "11", "8", NULL};
+static const char *const outputChoices[] = {"text", "binary", NULL};
+static const char *const displayChoices[] = {"cycle", "temp", "hum", NULL};
+static const char *const unitChoices[] = {"c", "f", NULL};
+
+#define FIELD(member) offsetof(RuntimeConfig_t, member), sizeof(((RuntimeConfig_t *)0)->member)
+#define NUMBER(name, member, min, max) {name, KEYNUMBER, FIELD(member), min, max, NULL}
+#define CHOICE(name, member, count, choices) {name, KEYCHOICE, FIELD(member), 0, (count) - 1, choices}
+#define FILTER(name, member) {name, KEYFILTER, FIELD(member), 0, 0, NULL}
+
+static const ConfigKey_t keys[] = {
+    NUMBER("temp_min_ms", temperatureRate.minPeriodMs, 100, 3600000),
+    NUMBER("temp_max_ms", temperatureRate.maxPeriodMs, 100, 3600000),
+    NUMBER("temp_threshold", temperatureRate.thresholdPerMin, 1, 100000),
+    NUMBER("temp_deadband", temperatureRate.deadband, 0, 10000),
+    NUMBER("hum_min_ms", humidityRate.minPeriodMs, 100, 3600000),
+    NUMBER("hum_max_ms", humidityRate.maxPeriodMs, 100, 3600000),
+    NUMBER("hum_threshold", humidityRate.thresholdPerMin, 1, 100000),
+    NUMBER("hum_deadband", humidityRate.deadband, 0, 10000),
+    CHOICE("temp_res", temperatureResolution, 2, resolutionChoices),    //no 8 bit temperature
+    CHOICE("hum_res", humidityResolution, 3, resolutionChoices),
+    NUMBER("oversample", oversample, 1, 16),
+    FILTER("temp_filter", temperatureFilter),
+    FILTER("hum_filter", humidityFilter),
+    CHOICE("output", output, 2, outputChoices),
+    CHOICE("display", display, 3, displayChoices),
+    CHOICE("units", fahrenheit, 2, unitChoices),
+    NUMBER("dwell_ms", dwellMs, 500, 60000),
+};
+
+#define KEYCOUNT (sizeof(keys) / sizeof(keys[0]))
+
+static const char *const filterNames[] = {"none", "avg", "ema", "median"};
+
+//Published settings
+static struct {
+    volatile uint32_t seq;
+    RuntimeConfig_t config;
+} cell;
+
+//Settings as saved, in the first page of the sector
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    RuntimeConfig_t config;
+    uint16_t crc;               //over everything before it
+} StoredConfig_t;
+
+_Static_assert(sizeof(StoredConfig_t) <= FLASHLOGPAGESIZE, "saved settings fit one page");
+
+//The writer holds off the scheduler across the copy, so a reader on
+//core 0 cannot preempt it mid update and spin on an odd sequence
+static void publishBegin(void){
+#ifndef RUNTIMECONFIGHOST
+    vTaskSuspendAll();
+#endif
+}
+
+static void publishEnd(void){
+#ifndef RUNTIMECONFIGHOST
+    xTaskResumeAll();
+#endif
+}
+
+void runtimeConfigInit(const RuntimeConfig_t *config){
+
+    cell.seq = 0;
+    runtimeConfigPublish(config);
+}
+
+void runtimeConfigPublish(const RuntimeConfig_t *config){
+
+    uint32_t seq = cell.seq;
+
+    publishBegin();
+
+    __atomic_store_n(&cell.seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    cell.config = *config;
+
+    __atomic_store_n(&cell.seq, seq + 2, __ATOMIC_RELEASE);
+
+    publishEnd();
+}
+
+uint32_t runtimeConfigRead(RuntimeConfig_t *out){
+
+    uint32_t before;
+    uint32_t after;
+
+    do{
+        before = __atomic_load_n(&cell.seq, __ATOMIC_ACQUIRE);
+        *out = cell.config;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&cell.seq, __ATOMIC_RELAXED);
+    } while((before & 1) || before != after);
+
+    return before / 2;
+}
+
+uint32_t runtimeConfigGeneration(void){
+
+    return __atomic_load_n(&cell.seq, __ATOMIC_ACQUIRE) / 2;
+}
+
+//Field access by table row
+
+static uint32_t getNumber(const RuntimeConfig_t *config, const ConfigKey_t *key){
+
+    const uint8_t *field = (const uint8_t *)config + key->offset;
+    uint32_t value;
+
+    if(key->size == 1){
+        return *field;
+    }
+    memcpy(&value, field, sizeof(value));
+    return value;
+}
+
+static void setNumber(RuntimeConfig_t *config, const ConfigKey_t *key, uint32_t value){
+
+    uint8_t *field = (uint8_t *)config + key->offset;
+
+    if(key->size == 1){
+        *field = (uint8_t)value;
+    }
+    else{
+        memcpy(field, &value, sizeof(value));
+    }
+}
+
+static SampleFilterConfig_t *filterField(RuntimeConfig_t *config, const ConfigKey_t *key){
+
+    return (SampleFilterConfig_t *)((uint8_t *)config + key->offset);
+}
+
+static const ConfigKey_t *findKey(const char *name){
+
+    size_t i;
+
+    for(i = 0; i < KEYCOUNT; i++){
+        if(strcmp(keys[i].name, name) == 0){
+            return &keys[i];
+        }
+    }
+    return NULL;
+}
+
+//Value text to and from the table
+
+static void formatValue(const RuntimeConfig_t *config, const ConfigKey_t *key, char *buf, size_t len){
+
+    const SampleFilterConfig_t *filter;
+
+    switch(key->kind){
+    case KEYCHOICE :
+        snprintf(buf, len, "%s", key->choices[getNumber(config, key)]);
+        break;
+    case KEYFILTER :
+        filter = filterField((RuntimeConfig_t *)config, key);
+        if(filter->type == SAMPLEFILTERNONE){
+            snprintf(buf, len, "none");
+        }
+        else{
+            snprintf(buf, len, "%s%u", filterNames[filter->type],
+                     (unsigned)(filter->type == SAMPLEFILTEREMA ? filter->shift : filter->window));
+        }
+        break;
+    default :
+        snprintf(buf, len, "%lu", (unsigned long)getNumber(config, key));
+        break;
+    }
+}
+
+static bool parseNumber(const char *text, uint32_t *value){
+
+    char *end;
+    unsigned long parsed;
+
+    if(!isdigit((unsigned char)text[0])){
+        return false;
+    }
+    parsed = strtoul(text, &end, 10);
+    if(*end != '\0' || parsed > UINT32_MAX){
+        return false;
+    }
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+//none, avg<window>, ema<shift> or median<window>
+static bool parseFilter(const char *text, SampleFilterConfig_t *filter){
+
+    SampleFilter_t check;
+    uint32_t n;
+    size_t length;
+    int type;
+
+    if(strcmp(text, "none") == 0){
+        filter->type = SAMPLEFILTERNONE;
+        filter->window = 0;
+        filter->shift = 0;
+        return true;
+    }
+    for(type = SAMPLEFILTERAVERAGE; type <= SAMPLEFILTERMEDIAN; type++){
+        length = strlen(filterNames[type]);
+        if(strncmp(text, filterNames[type], length) == 0 && parseNumber(text + length, &n) && n <= 255){
+            filter->type = (SampleFilterType_t)type;
+            filter->window = type == SAMPLEFILTEREMA ? 0 : (uint8_t)n;
+            filter->shift = type == SAMPLEFILTEREMA ? (uint8_t)n : 0;
+            return sampleFilterInit(&check, filter);
+        }
+    }
+    return false;
+}
+
+static bool parseValue(RuntimeConfig_t *config, const ConfigKey_t *key, const char *text){
+
+    uint32_t value;
+
+    switch(key->kind){
+    case KEYCHOICE :
+        for(value = 0; value <= key->max; value++){
+            if(strcmp(text, key->choices[value]) == 0){
+                setNumber(config, key, value);
+                return true;
+            }
+        }
+        return false;
+    case KEYFILTER :
+        return parseFilter(text, filterField(config, key));
+    default :
+        if(!parseNumber(text, &value) || value < key->min || value > key->max){
+            return false;
+        }
+        setNumber(config, key, value);
+        return true;
+    }
+}
+
+const char *runtimeConfigCheck(const RuntimeConfig_t *config){
+
+    SampleFilter_t filter;
+    uint32_t value;
+    size_t i;
+
+    for(i = 0; i < KEYCOUNT; i++){
+        if(keys[i].kind == KEYFILTER){
+            if(!sampleFilterInit(&filter, filterField((RuntimeConfig_t *)config, &keys[i]))){
+                return keys[i].name;
+            }
+        }
+        else{
+            value = getNumber(config, &keys[i]);
+            if(value < keys[i].min || value > keys[i].max){
+                return keys[i].name;
+            }
+        }
+    }
+
+    if(config->temperatureRate.minPeriodMs > config->temperatureRate.maxPeriodMs){
+        return "temp_min_ms above temp_max_ms";
+    }
+    if(config->humidityRate.minPeriodMs > config->humidityRate.maxPeriodMs){
+        return "hum_min_ms above hum_max_ms";
+    }
+    return NULL;
+}
+
+//Commands
+
+void runtimeConfigParserInit(RuntimeConfigParser_t *parser, const RuntimeConfig_t *defaults,
+                             const FlashLogStorage_t *storage){
+
+    parser->defaults = *defaults;
+    parser->storage = storage;
+    parser->save = NULL;
+    parser->dirty = false;
+    runtimeConfigRead(&parser->staged);
+}
+
+//Split line in place into at most max words
+static int splitWords(char *line, char **words, int max){
+
+    int count = 0;
+
+    while(*line != '\0'){
+        while(isspace((unsigned char)*line)){
+            *line++ = '\0';
+        }
+        if(*line == '\0'){
+            break;
+        }
+        if(count == max){
+            return max + 1;
+        }
+        words[count++] = line;
+        while(*line != '\0' && !isspace((unsigned char)*line)){
+            *line = (char)tolower((unsigned char)*line);
+            line++;
+        }
+    }
+    return count;
+}
+
+//Every command, for telling a known one with the wrong number of words
+//from an unknown one
+static const char *const commandNames[] = {"get", "set", "apply", "discard", "defaults", "save", "load"};
+
+static void replyError(void (*reply)(const char *text), const char *what, const char *detail){
+
+    char text[RUNTIMECONFIGREPLYMAX];
+
+    snprintf(text, sizeof(text), "err %s%s%s", what, detail != NULL ? " " : "", detail != NULL ? detail : "");
+    reply(text);
+}
+
+bool runtimeConfigCommand(RuntimeConfigParser_t *parser, const char *line,
+                          void (*reply)(const char *text)){
+
+    char copy[RUNTIMECONFIGLINEMAX];
+    char text[RUNTIMECONFIGREPLYMAX];
+    char value[RUNTIMECONFIGREPLYMAX / 2];
+    char *words[3];
+    const ConfigKey_t *key;
+    RuntimeConfig_t config;
+    const char *problem;
+    int count;
+    size_t i;
+
+    if(strlen(line) >= sizeof(copy)){
+        replyError(reply, "line too long", NULL);
+        return false;
+    }
+    strcpy(copy, line);
+    count = splitWords(copy, words, 3);
+    if(count == 0){
+        return false;
+    }
+
+    //staged changes start from the settings in force
+    if(!parser->dirty){
+        runtimeConfigRead(&parser->staged);
+    }
+
+    if(strcmp(words[0], "get") == 0 && count <= 2){
+        runtimeConfigRead(&config);
+        if(count == 1){
+            for(i = 0; i < KEYCOUNT; i++){
+                formatValue(&config, &keys[i], value, sizeof(value));
+                snprintf(text, sizeof(text), "%s=%s", keys[i].name, value);
+                reply(text);
+            }
+            snprintf(text, sizeof(text), "ok generation %lu%s", (unsigned long)runtimeConfigGeneration(),
+                     parser->dirty ? ", changes staged" : "");
+            reply(text);
+            return false;
+        }
+        key = findKey(words[1]);
+        if(key == NULL){
+            replyError(reply, "unknown key", words[1]);
+            return false;
+        }
+        formatValue(&config, key, value, sizeof(value));
+        snprintf(text, sizeof(text), "ok %s=%s", key->name, value);
+        reply(text);
+        return false;
+    }
+
+    if(strcmp(words[0], "set") == 0 && count == 3){
+        key = findKey(words[1]);
+        if(key == NULL){
+            replyError(reply, "unknown key", words[1]);
+            return false;
+        }
+        config = parser->staged;
+        if(!parseValue(&config, key, words[2])){
+            replyError(reply, "bad value for", key->name);
+            return false;
+        }
+        parser->staged = config;
+        parser->dirty = true;
+        reply("ok staged");
+        return false;
+    }
+
+    if(strcmp(words[0], "set") == 0 && count < 3){
+        if(count == 1){
+            replyError(reply, "set needs a key and a value", NULL);
+        }
+        else if(findKey(words[1]) == NULL){
+            replyError(reply, "unknown key", words[1]);
+        }
+        else{
+            replyError(reply, "missing value for", words[1]);
+        }
+        return false;
+    }
+
+    if(strcmp(words[0], "apply") == 0 && count == 1){
+        problem = runtimeConfigCheck(&parser->staged);
+        if(problem != NULL){
+            replyError(reply, "not applied,", problem);
+            return false;
+        }
+        runtimeConfigPublish(&parser->staged);
+        parser->dirty = false;
+        snprintf(text, sizeof(text), "ok generation %lu", (unsigned long)runtimeConfigGeneration());
+        reply(text);
+        return true;
+    }
+
+    if(strcmp(words[0], "discard") == 0 && count == 1){
+        parser->dirty = false;
+        runtimeConfigRead(&parser->staged);
+        reply("ok");
+        return false;
+    }
+
+    if(strcmp(words[0], "defaults") == 0 && count == 1){
+        parser->staged = parser->defaults;
+        parser->dirty = true;
+        reply("ok staged");
+        return false;
+    }
+
+    if(strcmp(words[0], "save") == 0 && count == 1){
+        if(parser->save != NULL){
+            if(!parser->save()){
+                replyError(reply, "save busy", NULL);
+                return false;
+            }
+            reply("ok saving");
+            return false;
+        }
+        runtimeConfigRead(&config);
+        if(parser->storage == NULL || !runtimeConfigSave(parser->storage, &config)){
+            replyError(reply, "save failed", NULL);
+            return false;
+        }
+        reply("ok saved");
+        return false;
+    }
+
+    if(strcmp(words[0], "load") == 0 && count == 1){
+        if(parser->storage == NULL || !runtimeConfigLoad(parser->storage, &config)){
+            replyError(reply, "nothing saved", NULL);
+            return false;
+        }
+        parser->staged = config;
+        parser->dirty = true;
+        reply("ok staged");
+        return false;
+    }
+
+    for(i = 0; i < sizeof(commandNames) / sizeof(commandNames[0]); i++){
+        if(strcmp(words[0], commandNames[i]) == 0){
+            replyError(reply, "too many words for", words[0]);
+            return false;
+        }
+    }
+
+    replyError(reply, "unknown command", words[0]);
+    return false;
+}
+
+//Flash
+
+bool runtimeConfigSave(const FlashLogStorage_t *storage, const RuntimeConfig_t *config){
+
+    uint8_t page[FLASHLOGPAGESIZE];
+    StoredConfig_t stored;
+
+    memset(&stored, 0, sizeof(stored));
+    stored.magic = RUNTIMECONFIGMAGIC;
+    stored.version = RUNTIMECONFIGVERSION;
+    stored.size = sizeof(RuntimeConfig_t);
+    stored.config = *config;
+    stored.crc = telemetryCrc16((const uint8_t *)&stored, offsetof(StoredConfig_t, crc));
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &stored, sizeof(stored));
+
+    return storage->erase(storage->ctx, 0) && storage->program(storage->ctx, 0, page, sizeof(page));
+}
+
+bool runtimeConfigLoad(const FlashLogStorage_t *storage, RuntimeConfig_t *config){
+
+    StoredConfig_t stored;
+
+    if(!storage->read(storage->ctx, 0, &stored, sizeof(stored)) ||
+       stored.magic != RUNTIMECONFIGMAGIC ||
+       stored.version != RUNTIMECONFIGVERSION ||
+       stored.size != sizeof(RuntimeConfig_t) ||
+       stored.crc != telemetryCrc16((const uint8_t *)&stored, offsetof(StoredConfig_t, crc)) ||
+       runtimeConfigCheck(&stored.config) != NULL){
+        return false;
+    }
+
+    *config = stored.config;
+    return true;
+}
@@ -0,0 +1,109 @@
+//Runtime configuration
+//The settings that used to be compile time constants in Assign6.c,
+//changed over USB with a line based command set:
+//
+//  get [key]           applied value, or every key
+//  set <key> <value>   stage a change, checked against its range
+//  apply               publish every staged change at once
+//  discard             drop the staged changes
+//  save                write the applied settings to flash, replying
+//                      "ok saving" then "ok saved" when handed to a task
+//  load                stage the settings saved in flash
+//  defaults            stage the compiled in defaults
+//
+//Every reply ends with a line starting "ok" or "err"; a plain get
+//lists key=value lines first. Changes are staged in
+//the parser and only reach the tasks on apply, as one new generation
+//of the published settings, so a task never sees half of a change.
+//Publication is a sequence lock like the sample cell, safe to read
+//from either core. Nothing here allocates; the parser works in the
+//caller's line and reply buffers.
+//
+//Built with RUNTIMECONFIGHOST the module has no FreeRTOS or Pico SDK
+//dependency, so the host tool tools/config_script.c can drive it.
+
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "adaptive_rate.h"
+#include "sample_filter.h"
+#include "flash_log.h"
+
+#define RUNTIMECONFIGLINEMAX 64
+#define RUNTIMECONFIGREPLYMAX 64
+#define RUNTIMECONFIGMAGIC 0x47464348  //"HCFG"
+#define RUNTIMECONFIGVERSION 1
+
+typedef enum {
+    RUNTIMECONFIGOUTPUTTEXT,
+    RUNTIMECONFIGOUTPUTBINARY
+} RuntimeConfigOutput_t;
+
+typedef enum {
+    RUNTIMECONFIGDISPLAYCYCLE,          //humidity and temperature in turn
+    RUNTIMECONFIGDISPLAYTEMPERATURE,
+    RUNTIMECONFIGDISPLAYHUMIDITY
+} RuntimeConfigDisplay_t;
+
+typedef struct {
+    AdaptiveRateConfig_t temperatureRate;
+    AdaptiveRateConfig_t humidityRate;
+    SampleFilterConfig_t temperatureFilter;
+    SampleFilterConfig_t humidityFilter;
+    uint32_t dwellMs;
+    uint8_t temperatureResolution;      //HDC1080Resolution_t
+    uint8_t humidityResolution;
+    uint8_t oversample;
+    uint8_t output;                     //RuntimeConfigOutput_t
+    uint8_t display;                    //RuntimeConfigDisplay_t
+    uint8_t fahrenheit;                 //display units for temperature
+} RuntimeConfig_t;
+
+//Staged changes and the defaults, owned by the task reading commands
+typedef struct {
+    RuntimeConfig_t staged;
+    RuntimeConfig_t defaults;
+    const FlashLogStorage_t *storage;   //one sector, NULL for no save or load
+    //Hands save to another task, which saves the applied settings to
+    //storage and replies itself. NULL saves from the caller. Returns
+    //false if the save could not be handed over.
+    bool (*save)(void);
+    bool dirty;
+} RuntimeConfigParser_t;
+
+//Publish config as the first generation
+void runtimeConfigInit(const RuntimeConfig_t *config);
+
+//Publish a new generation, from one writer at a time
+void runtimeConfigPublish(const RuntimeConfig_t *config);
+
+//Copy the settings in force. Returns their generation.
+uint32_t runtimeConfigRead(RuntimeConfig_t *out);
+
+//Cheap check for a change since a generation returned by Read
+uint32_t runtimeConfigGeneration(void);
+
+//Range and cross field checks. NULL if config is usable, otherwise why not.
+const char *runtimeConfigCheck(const RuntimeConfig_t *config);
+
+void runtimeConfigParserInit(RuntimeConfigParser_t *parser, const RuntimeConfig_t *defaults,
+                             const FlashLogStorage_t *storage);
+
+//Run one command line. reply is called for each line of the answer.
+//Returns true when the command published a new generation.
+bool runtimeConfigCommand(RuntimeConfigParser_t *parser, const char *line,
+                          void (*reply)(const char *text));
+
+//Settings saved in flash. Load returns false if there are none or
+//they fail the CRC, version or range checks.
+bool runtimeConfigSave(const FlashLogStorage_t *storage, const RuntimeConfig_t *config);
+bool runtimeConfigLoad(const FlashLogStorage_t *storage, RuntimeConfig_t *config);
+
+//The settings sector, below the flash log (flash_log_rp2040.c)
+extern const FlashLogStorage_t runtimeConfigRp2040Storage;
+
+#endif
@@ -0,0 +1,165 @@
+//Runtime statistics
+
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+
+#include "runtime_stats.h"
+
+static volatile uint32_t switchCount;
+static volatile uint32_t taskSwitches[RUNTIMESTATSMAXTASKS];
+static volatile bool requested;
+
+//Counters at the previous snapshot, for the window deltas
+static uint32_t lastRunTime[RUNTIMESTATSMAXTASKS];
+static uint32_t lastTaskSwitches[RUNTIMESTATSMAXTASKS];
+static uint32_t lastTotalRunTime;
+static uint32_t lastSwitchCount;
+
+uint32_t runtimeStatsCounter(void){
+
+    return time_us_32();
+}
+
+//Runs on every context switch, so it is kept to two increments
+void runtimeStatsSwitchedIn(uint32_t taskNumber){
+
+    switchCount++;
+    if(taskNumber < RUNTIMESTATSMAXTASKS){
+        taskSwitches[taskNumber]++;
+    }
+}
+
+static char stateChar(eTaskState state){
+
+    switch(state){
+        case eRunning: return 'X';
+        case eReady: return 'R';
+        case eBlocked: return 'B';
+        case eSuspended: return 'S';
+        case eDeleted: return 'D';
+        default: return '?';
+    }
+}
+
+void runtimeStatsCollect(RuntimeStatsSnapshot_t *snapshot){
+
+    TaskStatus_t status[RUNTIMESTATSMAXTASKS];
+    struct mallinfo heap;
+    uint64_t startUs = time_us_64();
+    uint32_t totalRunTime;
+    uint32_t window;
+    uint32_t switches;
+    UBaseType_t count;
+    UBaseType_t i;
+
+    count = uxTaskGetSystemState(status, RUNTIMESTATSMAXTASKS, &totalRunTime);
+
+    window = totalRunTime - lastTotalRunTime;
+    lastTotalRunTime = totalRunTime;
+
+    switches = switchCount;
+    snapshot->switches = switches - lastSwitchCount;
+    lastSwitchCount = switches;
+
+    snapshot->uptimeUs = startUs;
+    snapshot->windowUs = window;
+    snapshot->sampleRingDropped = 0;
+    snapshot->flashLogDropped = 0;
+    snapshot->consoleDropped = 0;
+    snapshot->taskCount = 0;
+
+    for(i = 0; i < count; i++){
+        RuntimeTaskStats_t *task = &snapshot->tasks[snapshot->taskCount++];
+        uint32_t number = status[i].xTaskNumber;
+        uint32_t runTime = status[i].ulRunTimeCounter;
+
+        strncpy(task->name, status[i].pcTaskName, sizeof(task->name) - 1);
+        task->name[sizeof(task->name) - 1] = '\0';
+        task->number = number;
+        task->state = stateChar(status[i].eCurrentState);
+        task->priority = (uint8_t)status[i].uxCurrentPriority;
+        task->stackFreeWords = status[i].usStackHighWaterMark;
+        task->cpuPermille = 0;
+        task->switches = 0;
+
+        if(number < RUNTIMESTATSMAXTASKS){
+            uint32_t ran = runTime - lastRunTime[number];
+
+            if(window > 0){
+                task->cpuPermille = (uint16_t)(((uint64_t)ran * 1000 + window / 2) / window);
+            }
+            lastRunTime[number] = runTime;
+
+            switches = taskSwitches[number];
+            task->switches = switches - lastTaskSwitches[number];
+            lastTaskSwitches[number] = switches;
+        }
+    }
+
+    //heap_3 uses the C library allocator
+    heap = mallinfo();
+    snapshot->heapUsed = (uint32_t)heap.uordblks;
+    snapshot->heapTotal = (uint32_t)heap.arena;
+
+    snapshot->collectUs = (uint32_t)(time_us_64() - startUs);
+}
+
+size_t runtimeStatsFormat(const RuntimeStatsSnapshot_t *snapshot, int line, char *buf, size_t len){
+
+    int n;
+
+    if(line == 0){
+        n = snprintf(buf, len,
+                     "stats uptime_us=%llu window_us=%lu switches=%lu heap_used=%lu heap_total=%lu collect_us=%lu\n",
+                     (unsigned long long)snapshot->uptimeUs, (unsigned long)snapshot->windowUs,
+                     (unsigned long)snapshot->switches, (unsigned long)snapshot->heapUsed,
+                     (unsigned long)snapshot->heapTotal, (unsigned long)snapshot->collectUs);
+    }
+    else if(line <= snapshot->taskCount){
+        const RuntimeTaskStats_t *task = &snapshot->tasks[line - 1];
+
+        n = snprintf(buf, len,
+                     "task name=%s num=%lu state=%c prio=%u cpu_permille=%u stack_free_words=%lu switches=%lu\n",
+                     task->name, (unsigned long)task->number, task->state, task->priority,
+                     task->cpuPermille, (unsigned long)task->stackFreeWords, (unsigned long)task->switches);
+    }
+    else if(line == snapshot->taskCount + 1){
+        n = snprintf(buf, len, "drops sample_ring=%lu flash_log=%lu console=%lu\n",
+                     (unsigned long)snapshot->sampleRingDropped, (unsigned long)snapshot->flashLogDropped,
+                     (unsigned long)snapshot->consoleDropped);
+    }
+    else if(line == snapshot->taskCount + 2){
+        n = snprintf(buf, len, "stats end\n");
+    }
+    else{
+        return 0;
+    }
+
+    if(n < 0 || len == 0){
+        return 0;
+    }
+
+    return (size_t)n < len ? (size_t)n : len - 1;
+}
+
+void runtimeStatsRequest(void){
+
+    requested = true;
+}
+
+bool runtimeStatsTakeRequest(void){
+
+    if(!requested){
+        return false;
+    }
+
+    requested = false;
+
+    return true;
+}
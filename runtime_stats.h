@@ -0,0 +1,75 @@
+//Runtime statistics
+//FreeRTOS run time stats are clocked from the RP2040 1 MHz hardware
+//timer, and the trace hook in FreeRTOSConfig.h counts context
+//switches per task. A snapshot adds stack high water marks and heap
+//use, and is printed as one line per record:
+//
+//  stats uptime_us=<n> window_us=<n> switches=<n> heap_used=<n> heap_total=<n> collect_us=<n>
+//  task name=<s> num=<n> state=<c> prio=<n> cpu_permille=<n> stack_free_words=<n> switches=<n>
+//  drops sample_ring=<n> flash_log=<n> console=<n>
+//  stats end
+//
+//CPU share and switch counts are over the window since the previous
+//snapshot; drops are totals since boot. Only core 0 is covered; core
+//1 runs outside FreeRTOS.
+
+#ifndef RUNTIME_STATS_H
+#define RUNTIME_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <FreeRTOS.h>
+
+//Tasks tracked, by FreeRTOS task number
+#define RUNTIMESTATSMAXTASKS 16
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t number;
+    char state;                 //R ready, B blocked, S suspended, D deleted, X running
+    uint8_t priority;
+    uint16_t cpuPermille;
+    uint32_t stackFreeWords;
+    uint32_t switches;
+} RuntimeTaskStats_t;
+
+typedef struct {
+    uint64_t uptimeUs;
+    uint32_t windowUs;
+    uint32_t switches;
+    uint32_t heapUsed;
+    uint32_t heapTotal;
+    uint32_t collectUs;         //cost of taking this snapshot
+
+    //Samples lost on the way to core 1, to flash, and console lines
+    //lost. Filled in by the caller, which owns the queues; 0 otherwise.
+    uint32_t sampleRingDropped;
+    uint32_t flashLogDropped;
+    uint32_t consoleDropped;
+
+    int taskCount;
+    RuntimeTaskStats_t tasks[RUNTIMESTATSMAXTASKS];
+} RuntimeStatsSnapshot_t;
+
+//Called through portGET_RUN_TIME_COUNTER_VALUE and
+//traceTASK_SWITCHED_IN, see FreeRTOSConfig.h
+uint32_t runtimeStatsCounter(void);
+void runtimeStatsSwitchedIn(uint32_t taskNumber);
+
+//Take a snapshot from a task on core 0
+void runtimeStatsCollect(RuntimeStatsSnapshot_t *snapshot);
+
+//Format line of the report into buf. Line 0 is the header, then one
+//per task, the drops, then the end marker. Returns the length, or 0 once past
+//the last line. A line that does not fit is cut to len - 1 characters;
+//with len 0 nothing is written and 0 is returned.
+size_t runtimeStatsFormat(const RuntimeStatsSnapshot_t *snapshot, int line, char *buf, size_t len);
+
+//Ask for a report. Safe from core 1 or an interrupt; the stats task
+//picks it up.
+void runtimeStatsRequest(void);
+bool runtimeStatsTakeRequest(void);
+
+#endif
@@ -0,0 +1,95 @@
+//Latest sample cell
+//The writer bumps seq to odd, copies the record, then bumps seq to
+//even. A reader copies the record between two loads of seq and retries
+//if they differ or are odd. With one writer nothing ever blocks.
+
+#include <string.h>
+
+#include "sample_cell.h"
+
+void sampleCellInit(SampleCell_t *cell){
+
+    memset(cell, 0, sizeof(*cell));
+}
+
+bool sampleCellSubscribe(SampleCell_t *cell){
+
+    bool added = false;
+
+#ifndef SAMPLECELLHOST
+    taskENTER_CRITICAL();
+#endif
+    if(cell->readerCount < SAMPLECELLMAXREADERS){
+        cell->readers[cell->readerCount] = xTaskGetCurrentTaskHandle();
+        cell->readerCount++;
+        added = true;
+    }
+#ifndef SAMPLECELLHOST
+    taskEXIT_CRITICAL();
+#endif
+
+    return added;
+}
+
+void sampleCellPublish(SampleCell_t *cell, const HDC1080Sample_t *sample, const PsychroMetrics_t *derived,
+                       uint64_t timestampUs){
+
+    uint32_t seq = cell->seq;
+    int i;
+
+    //The update is kept in a critical section so a higher priority
+    //reader can never preempt the writer mid copy and spin forever on
+    //an odd sequence. It is a few dozen bytes, so interrupts are only
+    //held off briefly; readers still never block.
+#ifndef SAMPLECELLHOST
+    taskENTER_CRITICAL();
+#endif
+
+    __atomic_store_n(&cell->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    cell->record.sample = *sample;
+    cell->record.derived = *derived;
+    cell->record.timestampUs = timestampUs;
+    cell->record.sequence = (seq + 2) / 2;
+
+    __atomic_store_n(&cell->seq, seq + 2, __ATOMIC_RELEASE);
+
+#ifndef SAMPLECELLHOST
+    taskEXIT_CRITICAL();
+#endif
+
+    for(i = 0; i < cell->readerCount; i++){
+        xTaskNotifyGiveIndexed(cell->readers[i], SAMPLECELLNOTIFYINDEX);
+    }
+}
+
+bool sampleCellRead(SampleCell_t *cell, SampleRecord_t *out){
+
+    uint32_t before;
+    uint32_t after;
+
+    do{
+        before = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        *out = cell->record;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&cell->seq, __ATOMIC_RELAXED);
+    } while((before & 1) || before != after);
+
+    return before != 0;
+}
+
+bool sampleCellWait(SampleCell_t *cell, uint32_t lastSequence, SampleRecord_t *out, TickType_t timeout){
+
+    while(true){
+        if(sampleCellRead(cell, out) && out->sequence != lastSequence){
+            return true;
+        }
+
+        //a publish between the read and here leaves the notification
+        //pending, so the take returns straight away
+        if(ulTaskNotifyTakeIndexed(SAMPLECELLNOTIFYINDEX, pdTRUE, timeout) == 0){
+            return false;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+//Latest sample cell
+//Single writer, many reader publication of the most recent sample.
+//A sequence lock lets readers copy a consistent record without taking
+//a kernel lock; readers that want to sleep until the next sample
+//subscribe and are woken with a direct-to-task notification. The
+//reading task publishes every sample; the command task's "now" reads
+//it back and the report task waits on it for the watch command.
+//
+//Built with SAMPLECELLHOST the cell takes no critical sections, so
+//the host stress test tools/cell_stress.c can drive it from threads.
+
+#ifndef SAMPLE_CELL_H
+#define SAMPLE_CELL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "hdc1080.h"
+#include "psychro.h"
+
+//Notification slot used to wake subscribers. Slot 1 belongs to the
+//I2C transport.
+#define SAMPLECELLNOTIFYINDEX 2
+#define SAMPLECELLMAXREADERS 4
+
+typedef struct {
+    HDC1080Sample_t sample;
+    PsychroMetrics_t derived;   //PSYCHRONOVALUE without both channels
+    uint64_t timestampUs;
+    uint32_t sequence;      //1 for the first sample published
+} SampleRecord_t;
+
+typedef struct {
+    volatile uint32_t seq;  //odd while the writer is mid update
+    SampleRecord_t record;
+    TaskHandle_t readers[SAMPLECELLMAXREADERS];
+    volatile int readerCount;
+} SampleCell_t;
+
+void sampleCellInit(SampleCell_t *cell);
+
+//Register the calling task to be notified on every publish
+bool sampleCellSubscribe(SampleCell_t *cell);
+
+//Writer side. Stamps the sequence number into the stored record.
+void sampleCellPublish(SampleCell_t *cell, const HDC1080Sample_t *sample, const PsychroMetrics_t *derived,
+                       uint64_t timestampUs);
+
+//Copy the latest record. Returns false if nothing is published yet.
+bool sampleCellRead(SampleCell_t *cell, SampleRecord_t *out);
+
+//Copy the latest record once its sequence differs from lastSequence,
+//sleeping up to timeout ticks for a publish. The caller must have
+//subscribed. Returns false on timeout.
+bool sampleCellWait(SampleCell_t *cell, uint32_t lastSequence, SampleRecord_t *out, TickType_t timeout);
+
+#endif
@@ -0,0 +1,115 @@
+//Sample filters, see sample_filter.h
+
+#include <string.h>
+
+#include "sample_filter.h"
+
+bool sampleFilterInit(SampleFilter_t *filter, const SampleFilterConfig_t *config){
+
+    bool ok;
+
+    memset(filter, 0, sizeof(*filter));
+    filter->config = *config;
+
+    switch(config->type){
+    case SAMPLEFILTERAVERAGE :
+        ok = config->window >= 1 && config->window <= SAMPLEFILTERMAXWINDOW;
+        break;
+    case SAMPLEFILTEREMA :
+        ok = config->shift <= SAMPLEFILTERMAXSHIFT;
+        break;
+    case SAMPLEFILTERMEDIAN :
+        ok = config->window >= 1 && config->window <= SAMPLEFILTERMAXMEDIAN && (config->window & 1);
+        break;
+    default :
+        ok = config->type == SAMPLEFILTERNONE;
+        break;
+    }
+
+    if(!ok){
+        filter->config.type = SAMPLEFILTERNONE;
+    }
+    return ok;
+}
+
+static uint16_t averageAdd(SampleFilter_t *filter, uint16_t raw){
+
+    uint8_t window = filter->config.window;
+
+    if(filter->count == window){
+        filter->sum -= filter->ring[filter->head];
+    }
+    else{
+        filter->count++;
+    }
+    filter->sum += raw;
+    filter->ring[filter->head] = raw;
+    filter->head = (filter->head + 1) % window;
+
+    return (uint16_t)((filter->sum + filter->count / 2) / filter->count);
+}
+
+static uint16_t emaAdd(SampleFilter_t *filter, uint16_t raw){
+
+    int32_t x = (int32_t)raw << 8;
+
+    if(filter->count == 0){
+        //start from the first code rather than ramping up from 0
+        filter->ema = x;
+        filter->count = 1;
+    }
+    else{
+        //arithmetic shift, rounds toward minus infinity either way
+        filter->ema += (x - filter->ema) >> filter->config.shift;
+    }
+
+    return (uint16_t)((filter->ema + 128) >> 8);
+}
+
+//The sorted copy is updated in place: the code leaving the window is
+//found and the new one slides into order from there
+static uint16_t medianAdd(SampleFilter_t *filter, uint16_t raw){
+
+    uint8_t window = filter->config.window;
+    uint16_t *sorted = filter->sorted;
+    int i;
+
+    if(filter->count == window){
+        uint16_t oldest = filter->ring[filter->head];
+        for(i = 0; sorted[i] != oldest; i++){
+        }
+    }
+    else{
+        i = filter->count++;
+    }
+    filter->ring[filter->head] = raw;
+    filter->head = (filter->head + 1) % window;
+
+    //slot i is free, move it to where raw belongs
+    while(i > 0 && sorted[i - 1] > raw){
+        sorted[i] = sorted[i - 1];
+        i--;
+    }
+    while(i < filter->count - 1 && sorted[i + 1] < raw){
+        sorted[i] = sorted[i + 1];
+        i++;
+    }
+    sorted[i] = raw;
+
+    //an even count while filling takes the lower middle
+    return sorted[(filter->count - 1) / 2];
+}
+
+uint16_t sampleFilterAdd(SampleFilter_t *filter, uint16_t raw){
+
+    switch(filter->config.type){
+    case SAMPLEFILTERAVERAGE :
+        return averageAdd(filter, raw);
+    case SAMPLEFILTEREMA :
+        return emaAdd(filter, raw);
+    case SAMPLEFILTERMEDIAN :
+        return medianAdd(filter, raw);
+    default :
+        return raw;
+    }
+}
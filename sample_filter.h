@@ -0,0 +1,56 @@
+//Sample filters
+//Integer filters on HDC1080 raw codes, one per channel, run between
+//acquisition and publication. Filtering the 16 bit codes before
+//conversion keeps the fraction of an LSB that averaging recovers, so
+//the converted hundredths carry it through to the display, telemetry
+//and log.
+//
+//  moving average  mean of the last window codes, running sum
+//  EMA             y += (x - y) / 2^shift, state in Q8
+//  median          median of the last window codes, rejects spikes
+//
+//Cost per sample is fixed by the config: O(1) for the average and
+//EMA, at most SAMPLEFILTERMAXMEDIAN compares and moves for the median.
+
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SAMPLEFILTERMAXWINDOW 16
+#define SAMPLEFILTERMAXMEDIAN 9     //odd
+#define SAMPLEFILTERMAXSHIFT 8      //EMA, limited by the Q8 state
+
+typedef enum {
+    SAMPLEFILTERNONE,
+    SAMPLEFILTERAVERAGE,
+    SAMPLEFILTEREMA,
+    SAMPLEFILTERMEDIAN
+} SampleFilterType_t;
+
+typedef struct {
+    SampleFilterType_t type;
+    uint8_t window;             //average and median
+    uint8_t shift;              //EMA
+} SampleFilterConfig_t;
+
+typedef struct {
+    SampleFilterConfig_t config;
+    uint16_t ring[SAMPLEFILTERMAXWINDOW];   //last window codes, oldest at head once full
+    uint16_t sorted[SAMPLEFILTERMAXMEDIAN]; //median, the ring contents in order
+    uint8_t head;
+    uint8_t count;
+    uint32_t sum;               //average
+    int32_t ema;                //EMA, Q8
+} SampleFilter_t;
+
+//Returns false for a config out of range; the filter then passes
+//codes through unchanged
+bool sampleFilterInit(SampleFilter_t *filter, const SampleFilterConfig_t *config);
+
+//Add one code and return the filtered code. Until the window fills
+//the average and median use what they have.
+uint16_t sampleFilterAdd(SampleFilter_t *filter, uint16_t raw);
+
+#endif
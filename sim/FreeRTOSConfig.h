@@ -0,0 +1,27 @@
+#ifndef SIM_FREERTOS_CONFIG_H
+#define SIM_FREERTOS_CONFIG_H
+
+/* Host simulation build, FreeRTOS POSIX port. Everything comes from
+ * the firmware's ../FreeRTOSConfig.h so the two cannot drift apart;
+ * only the port specific values are replaced below. */
+#include "../FreeRTOSConfig.h"
+
+/* No Pico SDK ISR handlers or core clock under the POSIX port */
+#undef vPortSVCHandler
+#undef xPortPendSVHandler
+#undef xPortSysTickHandler
+#undef configCPU_CLOCK_HZ
+
+/* Each task is a pthread; a word is a StackType_t (8 bytes here) and
+ * the stack must be at least PTHREAD_STACK_MIN. */
+#undef configMINIMAL_STACK_SIZE
+#define configMINIMAL_STACK_SIZE                4096
+#undef configSTACK_DEPTH_TYPE
+#define configSTACK_DEPTH_TYPE                  uint32_t
+
+/* Define to trap errors during development. */
+#undef configASSERT
+#define configASSERT( x )                       if( !( x ) ) { vAssertCalled( __FILE__, __LINE__ ); }
+void vAssertCalled( const char * file, unsigned long line );
+
+#endif /* SIM_FREERTOS_CONFIG_H */
@@ -0,0 +1,26 @@
+//Host stand-in backend for the timed waits. There is no alarm
+//interrupt under the POSIX port, so whole ticks are blocked on the
+//notification and the part tick left is slept by the thread, which
+//leaves the host CPU free as the alarm leaves the RP2040's.
+
+#include "pico/stdlib.h"
+
+#include "alarm_wait.h"
+
+bool alarmWaitUntil(uint64_t dueUs, UBaseType_t index){
+
+    const uint64_t tickUs = portTICK_PERIOD_MS * 1000;
+    uint64_t nowUs;
+
+    while((nowUs = time_us_64()) + tickUs <= dueUs){
+        if(ulTaskNotifyTakeIndexed(index, pdTRUE, (TickType_t)((dueUs - nowUs) / tickUs)) != 0){
+            return false;
+        }
+    }
+
+    if(nowUs < dueUs){
+        sleep_us(dueUs - nowUs);
+    }
+
+    return true;
+}
@@ -0,0 +1,98 @@
+//Virtual 7 segment display for host builds
+//Stands in for display.c. The value is encoded into the same pin
+//words the PIO program would drive, decoded back to segments, and
+//drawn on stderr whenever the frame changes, so a wrong pin or
+//segment table shows up here exactly as it would on the board.
+//The MAX7219 chain goes to the capture backend in spi_display_sim.c
+//and is drawn as a line of text whenever what it shows changes.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "display.h"
+#include "spi_display_sim.h"
+#include "pico/stdlib.h"
+
+static DisplayFrame_t frame;
+
+void displayInit(void){
+
+    int digit;
+
+    for(digit = 0; digit < DISPLAYDIGITS; digit++){
+        frame.word[digit] = 0;
+    }
+}
+
+//Three rows of text per digit:
+//  _
+// |_|
+// |_|.
+static void drawFrame(void){
+
+    uint8_t segments[DISPLAYDIGITS];
+    int digit;
+
+    for(digit = 0; digit < DISPLAYDIGITS; digit++){
+        segments[digit] = displayDecodeSegments(frame.word[digit]);
+    }
+
+    fprintf(stderr, "[display %10.3f s]\n", time_us_64() / 1e6);
+
+    for(digit = 0; digit < DISPLAYDIGITS; digit++){
+        fprintf(stderr, " %c  ", (segments[digit] & SEGA) ? '_' : ' ');
+    }
+    fprintf(stderr, "\n");
+
+    for(digit = 0; digit < DISPLAYDIGITS; digit++){
+        fprintf(stderr, "%c%c%c ", (segments[digit] & SEGF) ? '|' : ' ',
+                (segments[digit] & SEGG) ? '_' : ' ', (segments[digit] & SEGB) ? '|' : ' ');
+    }
+    fprintf(stderr, "\n");
+
+    for(digit = 0; digit < DISPLAYDIGITS; digit++){
+        fprintf(stderr, "%c%c%c%c", (segments[digit] & SEGE) ? '|' : ' ', (segments[digit] & SEGD) ? '_' : ' ',
+                (segments[digit] & SEGC) ? '|' : ' ', (segments[digit] & SEGDP) ? '.' : ' ');
+    }
+    fprintf(stderr, "\n");
+}
+
+bool displayShow(int value){
+
+    if(!displayEncode(value, &frame)){
+        return false;
+    }
+
+    drawFrame();
+
+    return true;
+}
+
+static SpiDisplaySim_t chain;
+
+static void drawChain(SpiDisplaySim_t *sim){
+
+    static char shown[2 * SPIDISPLAYDIGITS + 1];
+    char text[2 * SPIDISPLAYDIGITS + 1];
+
+    spiDisplaySimText(sim, text, sizeof(text));
+    if(!spiDisplaySimLit(sim) || strcmp(text, shown) == 0){
+        return;
+    }
+    strcpy(shown, text);
+
+    fprintf(stderr, "[chain %10.3f s] [%s]\n", time_us_64() / 1e6, text);
+}
+
+void spiDisplayRp2040Init(SpiDisplay_t *display, struct spi_inst *spi, uint32_t sckPin, uint32_t mosiPin,
+                          uint32_t csPin, uint32_t baudrate){
+
+    (void)spi;
+    (void)sckPin;
+    (void)mosiPin;
+    (void)csPin;
+    (void)baudrate;
+
+    chain.updated = drawChain;
+    spiDisplaySimInit(display, &chain);
+}
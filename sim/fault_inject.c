@@ -0,0 +1,262 @@
+//Fault injection check for the sensor transport in hdc1080.c
+//Runs on the simulated bus under FreeRTOS like bench.c. Each fault is
+//injected FAULTRUNS times on both transports while a task reads both
+//channels back to back. Faults that bus recovery clears end by
+//themselves; the others are lifted after FAULTHOLDMS, as a target
+//that lets go or a reseated cable would. One line per fault and
+//transport:
+//
+//  fault <name> <transport> runs <n> worst_read <us> worst_recovery <us> failed <n> restored <n>/<n>
+//
+//  worst_read      longest single hdc1080ReadChannels call from the
+//                  fault on, the longest the read task is held up
+//  worst_recovery  from injection, or from the fault lifting, to the
+//                  next valid reading
+//  failed          reads that came back invalid, over all runs
+//  restored        runs that ended with the sensor's configuration
+//                  register as the driver had set it
+//
+//then the driver's bus counters for each transport. Exits 1 if a read
+//took longer than FAULTREADBOUNDUS, a run never read valid data again
+//or a configuration was lost.
+//
+//  ./build-sim/Assign6Faults
+
+//FreeRTOS headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+//C Headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Pico Headers
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+#include "hdc1080.h"
+#include "i2c_async.h"
+#include "i2c_bus_sim.h"
+#include "rtos_static.h"
+
+#define FAULTRUNS 5
+#define FAULTHOLDMS 50
+#define FAULTGIVEUPMS 2000
+#define FAULTSTACKWORDS (2 * configMINIMAL_STACK_SIZE)
+
+//A read may hold its task through a few good transfers, one conversion
+//and one transfer that fails every attempt (up to 65 ms, hdc1080.h)
+#define FAULTREADBOUNDUS 100000
+
+//Recovery pins are not simulated, any will do
+#define FAULTSDAPIN 4
+#define FAULTSCLPIN 5
+#define FAULTBAUDRATE (100 * 1000)
+
+typedef struct {
+    const char *name;
+    uint32_t nacks;
+    uint32_t stretchUs;
+    uint8_t sdaStuckClocks;
+    bool sclStuck;
+    bool sensorReset;       //the sensor comes back with its power on configuration
+    bool held;              //recovery cannot clear it, lifted after FAULTHOLDMS
+} Fault_t;
+
+static const Fault_t faults[] = {
+    {"nack_burst_2",   2, 0,     0, false, false, false},
+    {"nack_burst_8",   8, 0,     0, false, false, false},
+    {"stretch_1ms",    0, 1000,  0, false, false, true},
+    {"stretch_8ms",    0, 8000,  0, false, false, true},     //over the blocking bound only
+    {"stretch_25ms",   0, 25000, 0, false, false, true},
+    {"sda_stuck_3",    0, 0,     3, false, false, false},
+    {"sda_stuck_9",    0, 0,     9, false, false, false},
+    {"scl_stuck",      0, 0,     0, true,  false, true},
+    {"sensor_reset",   4, 0,     0, false, true,  false},
+};
+
+typedef struct {
+    const char *name;
+    i2c_inst_t *i2c;
+    bool async;
+    I2CAsyncBus_t asyncBus;
+    HDC1080Bus_t bus;
+    HDC1080_t dev;
+    uint16_t config;        //as set before the faults
+} Transport_t;
+
+static Transport_t transports[] = {
+    {.name = "blocking", .async = false},
+    {.name = "async", .async = true},
+};
+
+void faultTask();
+RTOSTASK(faultTask, FAULTSTACKWORDS);
+
+static bool failedCheck;
+
+//The sensor on the transport's simulated bus
+static HDC1080Sim_t *simSensor(Transport_t *transport){
+
+    return &i2cSimBus(transport->i2c)->devices[0].sensor;
+}
+
+static void inject(SimBus_t *sim, HDC1080Sim_t *sensor, const Fault_t *fault){
+
+    sim->faultNacks = fault->nacks;
+    sim->stretchUs = fault->stretchUs;
+    sim->sdaStuckClocks = fault->sdaStuckClocks;
+    sim->sclStuck = fault->sclStuck;
+
+    if(fault->sensorReset){
+        sensor->config = HDC1080SIMCONFIGDEFAULT;
+        sensor->converting = false;
+    }
+}
+
+static void lift(SimBus_t *sim){
+
+    sim->faultNacks = 0;
+    sim->stretchUs = 0;
+    sim->sdaStuckClocks = 0;
+    sim->sclStuck = false;
+}
+
+static void runFault(Transport_t *transport, const Fault_t *fault){
+
+    SimBus_t *sim = i2cSimBus(transport->i2c);
+    HDC1080Sim_t *sensor = simSensor(transport);
+    HDC1080Sample_t sample;
+    uint64_t worstRead = 0;
+    uint64_t worstRecovery = 0;
+    uint32_t failed = 0;
+    int restored = 0;
+    int run;
+
+    memset(&sample, 0, sizeof(sample));
+
+    for(run = 0; run < FAULTRUNS; run++){
+        uint64_t faultUs;
+        uint64_t liftUs;
+        bool lifted = !fault->held;
+        bool recovered = false;
+
+        //start each run from a working bus
+        hdc1080ReadChannels(&transport->dev, true, true, &sample);
+
+        inject(sim, sensor, fault);
+        faultUs = time_us_64();
+        liftUs = faultUs;
+
+        while(time_us_64() - faultUs < FAULTGIVEUPMS * 1000){
+            uint64_t startUs;
+            uint64_t readUs;
+            bool ok;
+
+            if(!lifted && time_us_64() - faultUs >= FAULTHOLDMS * 1000){
+                lift(sim);
+                lifted = true;
+                liftUs = time_us_64();
+            }
+
+            startUs = time_us_64();
+            ok = hdc1080ReadChannels(&transport->dev, true, true, &sample);
+            readUs = time_us_64() - startUs;
+
+            if(readUs > worstRead){
+                worstRead = readUs;
+            }
+            if(!ok){
+                failed++;
+            }
+            else if(lifted){
+                if(time_us_64() - liftUs > worstRecovery){
+                    worstRecovery = time_us_64() - liftUs;
+                }
+                recovered = true;
+                break;
+            }
+        }
+
+        lift(sim);
+        if(!recovered){
+            failedCheck = true;
+        }
+        if(sensor->config == transport->config){
+            restored++;
+        }
+    }
+
+    if(worstRead > FAULTREADBOUNDUS || restored != FAULTRUNS){
+        failedCheck = true;
+    }
+
+    printf("fault %-14s %-8s runs %d worst_read %6lu worst_recovery %6lu failed %3lu restored %d/%d\n",
+           fault->name, transport->name, FAULTRUNS, (unsigned long)worstRead, (unsigned long)worstRecovery,
+           (unsigned long)failed, restored, FAULTRUNS);
+}
+
+void faultTask(){
+
+    size_t t;
+    size_t f;
+
+    for(t = 0; t < sizeof(transports) / sizeof(transports[0]); t++){
+        Transport_t *transport = &transports[t];
+
+        //single channel reads at 11 bit, so a sensor that resets to
+        //its power on configuration is noticed
+        if(hdc1080Probe(&transport->bus, &transport->dev, 1) != 1 ||
+           !hdc1080SetAcquisitionMode(&transport->dev, false) ||
+           !hdc1080SetResolution(&transport->dev, HDC1080RES11BIT, HDC1080RES11BIT)){
+            printf("fault %s: no sensor\n", transport->name);
+            exit(1);
+        }
+        transport->config = transport->dev.config;
+
+        for(f = 0; f < sizeof(faults) / sizeof(faults[0]); f++){
+            runFault(transport, &faults[f]);
+        }
+    }
+
+    for(t = 0; t < sizeof(transports) / sizeof(transports[0]); t++){
+        const HDC1080BusStats_t *stats = &transports[t].bus.stats;
+
+        printf("bus %-8s nacks %lu timeouts %lu bus_errors %lu retries %lu recoveries %lu stuck %lu restores %lu\n",
+               transports[t].name, (unsigned long)stats->nacks, (unsigned long)stats->timeouts,
+               (unsigned long)stats->busErrors, (unsigned long)stats->retries, (unsigned long)stats->recoveries,
+               (unsigned long)stats->stuck, (unsigned long)stats->restores);
+    }
+
+    printf("faults %s\n", failedCheck ? "FAILED" : "ok");
+    fflush(stdout);
+    exit(failedCheck ? 1 : 0);
+}
+
+int main() {
+
+    size_t t;
+
+    stdio_init_all();
+
+    transports[0].i2c = i2c0;
+    transports[1].i2c = i2c1;
+
+    for(t = 0; t < sizeof(transports) / sizeof(transports[0]); t++){
+        Transport_t *transport = &transports[t];
+
+        i2c_init(transport->i2c, FAULTBAUDRATE);
+        if(transport->async){
+            i2cAsyncRp2040Init(&transport->asyncBus, transport->i2c);
+        }
+        hdc1080BusInit(&transport->bus, transport->i2c, transport->async ? &transport->asyncBus : NULL);
+        hdc1080BusSetRecovery(&transport->bus, FAULTSDAPIN, FAULTSCLPIN, FAULTBAUDRATE);
+    }
+
+    RTOSCREATETASK(faultTask, FAULTSTACKWORDS, 1);
+
+    vTaskStartScheduler();
+
+  while(1){};
+}
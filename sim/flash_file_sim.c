@@ -0,0 +1,106 @@
+//File backed storage for the flash log on Linux.
+
+#include <string.h>
+
+#include "flash_file_sim.h"
+
+#define FLASHFILESIMSIZE ((long)FLASHLOGSECTORS * FLASHLOGSECTORSIZE)
+
+static bool fileRead(void *ctx, uint32_t offset, void *dst, size_t len){
+
+    FlashFileSim_t *sim = (FlashFileSim_t *)ctx;
+
+    if(offset + len > FLASHFILESIMSIZE || fseek(sim->file, (long)offset, SEEK_SET) != 0){
+        return false;
+    }
+
+    sim->reads++;
+
+    return fread(dst, 1, len, sim->file) == len;
+}
+
+static bool fileProgram(void *ctx, uint32_t offset, const void *src, size_t len){
+
+    FlashFileSim_t *sim = (FlashFileSim_t *)ctx;
+    uint8_t page[FLASHLOGPAGESIZE];
+    const uint8_t *data = (const uint8_t *)src;
+    size_t i;
+
+    if(offset % FLASHLOGPAGESIZE != 0 || len != FLASHLOGPAGESIZE || !fileRead(ctx, offset, page, len)){
+        return false;
+    }
+
+    //NOR programming only clears bits
+    for(i = 0; i < len; i++){
+        page[i] &= data[i];
+    }
+
+    if(fseek(sim->file, (long)offset, SEEK_SET) != 0 || fwrite(page, 1, len, sim->file) != len){
+        return false;
+    }
+
+    sim->programs++;
+
+    return fflush(sim->file) == 0;
+}
+
+static bool fileErase(void *ctx, uint32_t offset){
+
+    FlashFileSim_t *sim = (FlashFileSim_t *)ctx;
+    uint8_t sector[FLASHLOGSECTORSIZE];
+
+    if(offset % FLASHLOGSECTORSIZE != 0 || offset >= FLASHFILESIMSIZE){
+        return false;
+    }
+
+    memset(sector, 0xFF, sizeof(sector));
+    if(fseek(sim->file, (long)offset, SEEK_SET) != 0 || fwrite(sector, 1, sizeof(sector), sim->file) != sizeof(sector)){
+        return false;
+    }
+
+    sim->erases++;
+    sim->eraseCounts[offset / FLASHLOGSECTORSIZE]++;
+
+    return fflush(sim->file) == 0;
+}
+
+bool flashFileSimOpen(FlashFileSim_t *sim, const char *path){
+
+    uint8_t sector[FLASHLOGSECTORSIZE];
+    int i;
+
+    memset(sim, 0, sizeof(*sim));
+
+    sim->file = fopen(path, "r+b");
+    if(sim->file == NULL){
+        //new image, blank like a fresh chip
+        sim->file = fopen(path, "w+b");
+        if(sim->file == NULL){
+            return false;
+        }
+        memset(sector, 0xFF, sizeof(sector));
+        for(i = 0; i < FLASHLOGSECTORS; i++){
+            if(fwrite(sector, 1, sizeof(sector), sim->file) != sizeof(sector)){
+                fclose(sim->file);
+                sim->file = NULL;
+                return false;
+            }
+        }
+        fflush(sim->file);
+    }
+
+    sim->storage.read = fileRead;
+    sim->storage.program = fileProgram;
+    sim->storage.erase = fileErase;
+    sim->storage.ctx = sim;
+
+    return true;
+}
+
+void flashFileSimClose(FlashFileSim_t *sim){
+
+    if(sim->file != NULL){
+        fclose(sim->file);
+        sim->file = NULL;
+    }
+}
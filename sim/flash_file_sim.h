@@ -0,0 +1,29 @@
+//File backed storage for the flash log on Linux.
+//The image behaves like NOR flash: erase sets a sector to 0xFF and
+//programming can only clear bits, so torn or repeated writes show up
+//the same way they would on the board.
+
+#ifndef FLASH_FILE_SIM_H
+#define FLASH_FILE_SIM_H
+
+#include <stdio.h>
+
+#include "flash_log.h"
+
+typedef struct {
+    FILE *file;
+    FlashLogStorage_t storage;
+
+    //Statistics
+    uint32_t reads;
+    uint32_t programs;
+    uint32_t erases;
+    uint32_t eraseCounts[FLASHLOGSECTORS];
+} FlashFileSim_t;
+
+//Open or create path as a FLASHLOGSECTORS sector image. A new image
+//starts fully erased. Returns false if the file cannot be opened.
+bool flashFileSimOpen(FlashFileSim_t *sim, const char *path);
+void flashFileSimClose(FlashFileSim_t *sim);
+
+#endif
@@ -0,0 +1,245 @@
+//Simulated HDC1080 register model
+//Timing follows the HDC1080 datasheet: 6.35/3.65 ms for 14/11 bit
+//temperature and 6.5/3.85/2.5 ms for 14/11/8 bit humidity.
+
+#include <string.h>
+
+#include "hdc1080_sim.h"
+
+#define SIMTEMPREG 0x00
+#define SIMHUMREG 0x01
+#define SIMCONFIGREG 0x02
+#define SIMSN1 0xFB
+#define SIMSN2 0xFC
+#define SIMSN3 0xFD
+#define SIMMFIDREG 0xFE
+#define SIMDEVICEIDREG 0xFF
+
+#define SIMCONFIGRST 0x8000
+#define SIMCONFIGMODE 0x1000
+#define SIMCONFIGTRES 0x0400
+#define SIMCONFIGHRES 0x0300
+#define SIMCONFIGWRITABLE 0xB700
+
+//Bus time for one transaction: start, address byte, data bytes, stop.
+//Each byte is 8 bits plus ACK.
+uint32_t hdc1080SimTransactionUs(uint32_t busHz, size_t len){
+
+    uint64_t bits = 2 + 9 * (len + 1);
+
+    return (uint32_t)((bits * 1000000 + busHz - 1) / busHz);
+}
+
+static void chargeBus(HDC1080Sim_t *sim, size_t len){
+
+    uint32_t us = hdc1080SimTransactionUs(sim->busHz, len);
+
+    sim->nowUs += us;
+    sim->busTimeUs += us;
+}
+
+//Quantize a raw 16 bit code to the configured resolution
+static uint16_t quantize(uint16_t raw, int bits){
+
+    return raw & (uint16_t)(0xFFFF << (16 - bits));
+}
+
+static uint16_t rawTemperature(const HDC1080Sim_t *sim){
+
+    double code = (sim->temperatureC + 40.0) / 165.0 * 65536.0;
+    int bits = (sim->config & SIMCONFIGTRES) ? 11 : 14;
+
+    if(code < 0){
+        code = 0;
+    }
+    if(code > 65535){
+        code = 65535;
+    }
+
+    return quantize((uint16_t)code, bits);
+}
+
+static uint16_t rawHumidity(const HDC1080Sim_t *sim){
+
+    double code = sim->humidityRH / 100.0 * 65536.0;
+    int bits;
+
+    switch((sim->config & SIMCONFIGHRES) >> 8){
+    case 1 :
+        bits = 11;
+        break;
+    case 2 :
+        bits = 8;
+        break;
+    default :
+        bits = 14;
+        break;
+    }
+
+    if(code < 0){
+        code = 0;
+    }
+    if(code > 65535){
+        code = 65535;
+    }
+
+    return quantize((uint16_t)code, bits);
+}
+
+static uint16_t registerValue(const HDC1080Sim_t *sim, uint8_t pointer){
+
+    switch(pointer){
+    case SIMCONFIGREG :
+        return sim->config;
+    case SIMSN1 :
+        return sim->serial[0];
+    case SIMSN2 :
+        return sim->serial[1];
+    case SIMSN3 :
+        return sim->serial[2];
+    case SIMMFIDREG :
+        return HDC1080SIMMANUFACTURERID;
+    case SIMDEVICEIDREG :
+        return HDC1080SIMDEVICEID;
+    default :
+        return 0;
+    }
+}
+
+uint32_t hdc1080SimConversionUs(const HDC1080Sim_t *sim, uint8_t pointer){
+
+    uint32_t tempUs = (sim->config & SIMCONFIGTRES) ? 3650 : 6350;
+    uint32_t humUs;
+
+    switch((sim->config & SIMCONFIGHRES) >> 8){
+    case 1 :
+        humUs = 3850;
+        break;
+    case 2 :
+        humUs = 2500;
+        break;
+    default :
+        humUs = 6500;
+        break;
+    }
+
+    if(pointer == SIMHUMREG){
+        return humUs;
+    }
+    if(sim->config & SIMCONFIGMODE){
+        return tempUs + humUs;
+    }
+    return tempUs;
+}
+
+void hdc1080SimInit(HDC1080Sim_t *sim, uint8_t address){
+
+    memset(sim, 0, sizeof(*sim));
+
+    sim->address = address;
+    sim->config = HDC1080SIMCONFIGDEFAULT;
+    sim->serial[0] = 0x0123;
+    sim->serial[1] = 0x4567;
+    sim->serial[2] = 0x8900;
+    sim->temperatureC = 22.0;
+    sim->humidityRH = 45.0;
+    sim->busHz = 100 * 1000;
+}
+
+void hdc1080SimResetStats(HDC1080Sim_t *sim){
+
+    sim->writes = 0;
+    sim->reads = 0;
+    sim->nacks = 0;
+    sim->conversions = 0;
+    sim->busTimeUs = 0;
+}
+
+void hdc1080SimAdvance(HDC1080Sim_t *sim, uint64_t us){
+
+    sim->nowUs += us;
+}
+
+int hdc1080SimWrite(HDC1080Sim_t *sim, const uint8_t *src, size_t len){
+
+    chargeBus(sim, len);
+    sim->writes++;
+
+    //the device does not acknowledge its address while converting
+    if(sim->converting && sim->nowUs < sim->readyAtUs){
+        sim->nacks++;
+        return HDC1080SIMNACK;
+    }
+    sim->converting = false;
+
+    if(len == 0){
+        return 0;
+    }
+
+    sim->pointer = src[0];
+
+    if(sim->pointer == SIMCONFIGREG && len >= 3){
+        uint16_t config = src[1] << 8 | src[2];
+
+        if(config & SIMCONFIGRST){
+            sim->config = HDC1080SIMCONFIGDEFAULT;
+        }
+        else{
+            sim->config = (sim->config & ~SIMCONFIGWRITABLE) | (config & SIMCONFIGWRITABLE);
+        }
+    }
+    else if(sim->pointer == SIMTEMPREG || sim->pointer == SIMHUMREG){
+        //a pointer write to a measurement register triggers a conversion
+        uint16_t temperature = rawTemperature(sim);
+        uint16_t humidity = rawHumidity(sim);
+
+        if(sim->pointer == SIMHUMREG){
+            sim->result[0] = humidity >> 8;
+            sim->result[1] = humidity & 0xFF;
+            sim->resultLen = 2;
+        }
+        else{
+            sim->result[0] = temperature >> 8;
+            sim->result[1] = temperature & 0xFF;
+            sim->result[2] = humidity >> 8;
+            sim->result[3] = humidity & 0xFF;
+            sim->resultLen = (sim->config & SIMCONFIGMODE) ? 4 : 2;
+        }
+
+        sim->converting = true;
+        sim->readyAtUs = sim->nowUs + hdc1080SimConversionUs(sim, sim->pointer);
+        sim->conversions++;
+    }
+
+    return (int)len;
+}
+
+int hdc1080SimRead(HDC1080Sim_t *sim, uint8_t *dst, size_t len){
+
+    size_t i;
+
+    chargeBus(sim, len);
+    sim->reads++;
+
+    //reading before the conversion has finished is NACKed
+    if(sim->converting && sim->nowUs < sim->readyAtUs){
+        sim->nacks++;
+        return HDC1080SIMNACK;
+    }
+
+    if(sim->pointer == SIMTEMPREG || sim->pointer == SIMHUMREG){
+        for(i = 0; i < len; i++){
+            dst[i] = i < sim->resultLen ? sim->result[i] : 0xFF;
+        }
+        sim->converting = false;
+    }
+    else{
+        uint16_t value = registerValue(sim, sim->pointer);
+
+        for(i = 0; i < len; i++){
+            dst[i] = (i & 1) ? value & 0xFF : value >> 8;
+        }
+    }
+
+    return (int)len;
+}
@@ -0,0 +1,69 @@
+//Simulated HDC1080 register model for host builds
+//Models the pointer register, configuration register, conversion
+//timing and the identity registers closely enough to count bus
+//transactions and measure read latency without hardware.
+
+#ifndef HDC1080_SIM_H
+#define HDC1080_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//Power on value of the configuration register (MODE set, 14 bit)
+#define HDC1080SIMCONFIGDEFAULT 0x1000
+#define HDC1080SIMMANUFACTURERID 0x5449
+#define HDC1080SIMDEVICEID 0x1050
+
+//Returned by the read and write functions when the device NACKs
+#define HDC1080SIMNACK -1
+
+typedef struct {
+    //Bus address the model answers on
+    uint8_t address;
+
+    //Register state
+    uint8_t pointer;
+    uint16_t config;
+    uint16_t serial[3];
+
+    //Environment presented to the sensor, set by the test
+    double temperatureC;
+    double humidityRH;
+
+    //Conversion in progress. Reads NACK until nowUs reaches readyAtUs.
+    bool converting;
+    uint64_t readyAtUs;
+    uint8_t result[4];
+    uint8_t resultLen;
+
+    //Simulated time and bus speed
+    uint64_t nowUs;
+    uint32_t busHz;
+
+    //Statistics
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t nacks;
+    uint32_t conversions;
+    uint64_t busTimeUs;
+} HDC1080Sim_t;
+
+void hdc1080SimInit(HDC1080Sim_t *sim, uint8_t address);
+void hdc1080SimResetStats(HDC1080Sim_t *sim);
+
+//One I2C write or read transaction addressed to this device.
+//Returns the number of bytes transferred or HDC1080SIMNACK.
+int hdc1080SimWrite(HDC1080Sim_t *sim, const uint8_t *src, size_t len);
+int hdc1080SimRead(HDC1080Sim_t *sim, uint8_t *dst, size_t len);
+
+//Let simulated time pass, e.g. while the driver waits on a conversion
+void hdc1080SimAdvance(HDC1080Sim_t *sim, uint64_t us);
+
+//Bus time in microseconds of one transaction carrying len data bytes
+uint32_t hdc1080SimTransactionUs(uint32_t busHz, size_t len);
+
+//Conversion time in microseconds for the current configuration
+uint32_t hdc1080SimConversionUs(const HDC1080Sim_t *sim, uint8_t pointer);
+
+#endif
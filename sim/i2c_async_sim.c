@@ -0,0 +1,56 @@
+//Host stand-in backend for the asynchronous I2C transport.
+//The transfer is carried out as soon as it is started and completion
+//is posted straight away; the notification latches, so the waiting
+//task sees the same start/complete sequence as on hardware. A transfer
+//that hangs on an injected fault, or would take longer than the wait
+//allows, is never completed, so the wait times out as on the board.
+
+#include "i2c_async_sim.h"
+
+static bool simStart(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer){
+
+    SimBus_t *sim = (SimBus_t *)bus->ctx;
+    int result = 0;
+
+    if(xfer->txLen + xfer->rxLen == 0){
+        return false;
+    }
+
+    xfer->startUs = sim->nowUs;
+
+    if(xfer->txLen > 0){
+        result = simBusWrite(sim, xfer->address, xfer->txBuf, xfer->txLen);
+    }
+    if(result >= 0 && xfer->rxLen > 0){
+        result = simBusRead(sim, xfer->address, xfer->rxBuf, xfer->rxLen);
+        if(result > 0){
+            xfer->rxIndex = (size_t)result;
+        }
+    }
+
+    if(result == SIMBUSHUNG || (xfer->timeoutUs != 0 && sim->nowUs - xfer->startUs > xfer->timeoutUs)){
+        if(xfer->timeoutUs != 0){
+            sim->nowUs = xfer->startUs + xfer->timeoutUs;
+        }
+        return true;
+    }
+
+    i2cAsyncComplete(bus, result < 0 ? I2CASYNCERROR : result, sim->nowUs);
+
+    return true;
+}
+
+static const I2CAsyncOps_t simOps = {
+    .start = simStart,
+    .abort = NULL,
+};
+
+void i2cAsyncSimInit(I2CAsyncBus_t *bus, SimBus_t *sim){
+
+    bus->ops = &simOps;
+    bus->ctx = sim;
+    bus->active = NULL;
+    bus->transfers = 0;
+    bus->errors = 0;
+    bus->busyUs = 0;
+}
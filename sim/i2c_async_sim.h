@@ -0,0 +1,13 @@
+//Host stand-in backend for the asynchronous I2C transport.
+//Transfers run against the simulated bus and complete in simulated
+//time, so the state machine and its latency can be checked on Linux.
+
+#ifndef I2C_ASYNC_SIM_H
+#define I2C_ASYNC_SIM_H
+
+#include "i2c_async.h"
+#include "i2c_bus_sim.h"
+
+void i2cAsyncSimInit(I2CAsyncBus_t *bus, SimBus_t *sim);
+
+#endif
@@ -0,0 +1,240 @@
+//Simulated I2C bus for host builds
+//Transactions are routed to the mux or sensor that would acknowledge
+//the address with the current mux channel selection. Every device
+//shares the bus clock, which advances with each transaction.
+
+#include <string.h>
+
+#include "i2c_bus_sim.h"
+
+void simBusInit(SimBus_t *bus, uint32_t busHz){
+
+    memset(bus, 0, sizeof(*bus));
+    bus->busHz = busHz;
+}
+
+void simBusResetStats(SimBus_t *bus){
+
+    int i;
+
+    bus->transactions = 0;
+    bus->nacks = 0;
+    bus->collisions = 0;
+    bus->recoveries = 0;
+    bus->busTimeUs = 0;
+
+    for(i = 0; i < bus->deviceCount; i++){
+        hdc1080SimResetStats(&bus->devices[i].sensor);
+    }
+}
+
+void simBusAdvance(SimBus_t *bus, uint64_t us){
+
+    bus->nowUs += us;
+}
+
+bool simBusAddMux(SimBus_t *bus, uint8_t address){
+
+    if(bus->muxCount == SIMBUSMAXMUXES){
+        return false;
+    }
+
+    bus->muxAddress[bus->muxCount] = address;
+    bus->muxMask[bus->muxCount] = 0;
+    bus->muxCount++;
+
+    return true;
+}
+
+HDC1080Sim_t *simBusAddSensor(SimBus_t *bus, uint8_t muxAddress, uint8_t muxChannel){
+
+    SimBusDevice_t *dev;
+
+    if(bus->deviceCount == SIMBUSMAXDEVICES){
+        return NULL;
+    }
+
+    dev = &bus->devices[bus->deviceCount++];
+    hdc1080SimInit(&dev->sensor, 0x40);
+    dev->sensor.busHz = bus->busHz;
+    dev->muxAddress = muxAddress;
+    dev->muxChannel = muxChannel;
+
+    return &dev->sensor;
+}
+
+static int findMux(const SimBus_t *bus, uint8_t addr){
+
+    int i;
+
+    for(i = 0; i < bus->muxCount; i++){
+        if(bus->muxAddress[i] == addr){
+            return i;
+        }
+    }
+    return -1;
+}
+
+//The device that acknowledges addr given the open mux channels
+static SimBusDevice_t *findDevice(SimBus_t *bus, uint8_t addr){
+
+    SimBusDevice_t *found = NULL;
+    int i;
+
+    for(i = 0; i < bus->deviceCount; i++){
+        SimBusDevice_t *dev = &bus->devices[i];
+        bool visible = true;
+
+        if(dev->sensor.address != addr){
+            continue;
+        }
+        if(dev->muxAddress != SIMBUSNOMUX){
+            int mux = findMux(bus, dev->muxAddress);
+            visible = mux >= 0 && (bus->muxMask[mux] & (1 << dev->muxChannel));
+        }
+        if(!visible){
+            continue;
+        }
+
+        if(found != NULL){
+            bus->collisions++;
+        }
+        else{
+            found = dev;
+        }
+    }
+
+    return found;
+}
+
+//Charge a transaction handled by the bus itself (mux or NACK)
+static void chargeBus(SimBus_t *bus, size_t len){
+
+    uint32_t us = hdc1080SimTransactionUs(bus->busHz, len);
+
+    bus->nowUs += us;
+    bus->busTimeUs += us;
+}
+
+//Injected faults that end a transaction before any target sees it.
+//Returns 0 if there are none.
+static int injectFault(SimBus_t *bus){
+
+    if(bus->sclStuck || bus->sdaStuckClocks > 0){
+        return SIMBUSHUNG;
+    }
+    if(bus->faultNacks > 0){
+        bus->faultNacks--;
+        chargeBus(bus, 0);
+        bus->nacks++;
+        return HDC1080SIMNACK;
+    }
+    return 0;
+}
+
+//A target stretching the clock makes every transaction longer
+static int stretch(SimBus_t *bus, int ret){
+
+    bus->nowUs += bus->stretchUs;
+    bus->busTimeUs += bus->stretchUs;
+
+    return ret;
+}
+
+bool simBusRecover(SimBus_t *bus){
+
+    uint32_t clocks = 0;
+
+    bus->recoveries++;
+
+    //each clock lets the target holding SDA shift out one more bit
+    while(!bus->sclStuck && bus->sdaStuckClocks > 0 && clocks < 9){
+        bus->sdaStuckClocks--;
+        clocks++;
+    }
+
+    //the clocks and the STOP, one bit time each
+    chargeBus(bus, 0);
+    bus->nowUs += (uint64_t)clocks * 1000000 / bus->busHz;
+    bus->busTimeUs += (uint64_t)clocks * 1000000 / bus->busHz;
+
+    return !bus->sclStuck && bus->sdaStuckClocks == 0;
+}
+
+int simBusWrite(SimBus_t *bus, uint8_t addr, const uint8_t *src, size_t len){
+
+    SimBusDevice_t *dev;
+    int mux = findMux(bus, addr);
+    int ret;
+
+    bus->transactions++;
+
+    ret = injectFault(bus);
+    if(ret != 0){
+        return ret;
+    }
+
+    if(mux >= 0){
+        chargeBus(bus, len);
+        if(len > 0){
+            bus->muxMask[mux] = src[len - 1];
+        }
+        return stretch(bus, (int)len);
+    }
+
+    dev = findDevice(bus, addr);
+    if(dev == NULL){
+        chargeBus(bus, 0);
+        bus->nacks++;
+        return HDC1080SIMNACK;
+    }
+
+    dev->sensor.nowUs = bus->nowUs;
+    ret = hdc1080SimWrite(&dev->sensor, src, len);
+    bus->busTimeUs += dev->sensor.nowUs - bus->nowUs;
+    bus->nowUs = dev->sensor.nowUs;
+    if(ret < 0){
+        bus->nacks++;
+        return ret;
+    }
+
+    return stretch(bus, ret);
+}
+
+int simBusRead(SimBus_t *bus, uint8_t addr, uint8_t *dst, size_t len){
+
+    SimBusDevice_t *dev;
+    int mux = findMux(bus, addr);
+    int ret;
+
+    bus->transactions++;
+
+    ret = injectFault(bus);
+    if(ret != 0){
+        return ret;
+    }
+
+    if(mux >= 0){
+        chargeBus(bus, len);
+        memset(dst, bus->muxMask[mux], len);
+        return stretch(bus, (int)len);
+    }
+
+    dev = findDevice(bus, addr);
+    if(dev == NULL){
+        chargeBus(bus, 0);
+        bus->nacks++;
+        return HDC1080SIMNACK;
+    }
+
+    dev->sensor.nowUs = bus->nowUs;
+    ret = hdc1080SimRead(&dev->sensor, dst, len);
+    bus->busTimeUs += dev->sensor.nowUs - bus->nowUs;
+    bus->nowUs = dev->sensor.nowUs;
+    if(ret < 0){
+        bus->nacks++;
+        return ret;
+    }
+
+    return stretch(bus, ret);
+}
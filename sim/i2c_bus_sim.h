@@ -0,0 +1,75 @@
+//Simulated I2C bus for host builds
+//Holds any number of simulated HDC1080s, directly on the bus or behind
+//TCA9548A style multiplexers, on one shared clock. Used to check the
+//multi sensor driver and to measure scan time as sensors are added.
+//Faults can be injected between transactions to check the driver's
+//timeouts and bus recovery (sim/fault_inject.c).
+
+#ifndef I2C_BUS_SIM_H
+#define I2C_BUS_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "hdc1080_sim.h"
+
+#define SIMBUSMAXDEVICES 64
+#define SIMBUSMAXMUXES 8
+#define SIMBUSNOMUX 0
+
+//A line is held low: the transaction never finishes
+#define SIMBUSHUNG -2
+
+typedef struct {
+    HDC1080Sim_t sensor;
+    uint8_t muxAddress;
+    uint8_t muxChannel;
+} SimBusDevice_t;
+
+typedef struct {
+    SimBusDevice_t devices[SIMBUSMAXDEVICES];
+    int deviceCount;
+
+    uint8_t muxAddress[SIMBUSMAXMUXES];
+    uint8_t muxMask[SIMBUSMAXMUXES];
+    int muxCount;
+
+    uint64_t nowUs;
+    uint32_t busHz;
+
+    //Faults, set by a test between transactions
+    uint32_t faultNacks;        //the next n transactions are not acknowledged
+    uint32_t stretchUs;         //a target holds SCL this long in every transaction
+    uint8_t sdaStuckClocks;     //a target holds SDA low until clocked this many times
+    bool sclStuck;              //SCL held low, recovery cannot free it
+
+    //Statistics
+    uint32_t transactions;
+    uint32_t nacks;
+    uint32_t collisions;
+    uint32_t recoveries;
+    uint64_t busTimeUs;
+} SimBus_t;
+
+void simBusInit(SimBus_t *bus, uint32_t busHz);
+bool simBusAddMux(SimBus_t *bus, uint8_t address);
+
+//Add a sensor at 0x40, behind muxAddress/muxChannel or SIMBUSNOMUX.
+//Returns the sensor model so the test can set its environment.
+HDC1080Sim_t *simBusAddSensor(SimBus_t *bus, uint8_t muxAddress, uint8_t muxChannel);
+
+//One transaction. Returns bytes transferred, HDC1080SIMNACK or
+//SIMBUSHUNG.
+int simBusWrite(SimBus_t *bus, uint8_t addr, const uint8_t *src, size_t len);
+int simBusRead(SimBus_t *bus, uint8_t addr, uint8_t *dst, size_t len);
+
+//The controller's bus recovery: up to 9 SCL clocks, then a STOP.
+//Frees a stuck SDA that needs 9 clocks or fewer. Returns false if a
+//line is still low.
+bool simBusRecover(SimBus_t *bus);
+
+void simBusAdvance(SimBus_t *bus, uint64_t us);
+void simBusResetStats(SimBus_t *bus);
+
+#endif
@@ -0,0 +1,505 @@
+//Host implementation of the mocked Pico SDK calls in sim/pico_mock.
+//
+//Time is CLOCK_MONOTONIC from the first call. Each simulated I2C bus
+//is brought up to that time before every transaction, so sensor
+//conversions finish in real time, and a blocking transfer spins for
+//the bus time the model charges for it. Timings seen by the firmware
+//match the board to within the host's scheduling noise.
+//
+//The environment seen by the default sensor can be set with
+//ASSIGN6SIMTEMPC and ASSIGN6SIMRH, and the flash image paths with
+//ASSIGN6SIMFLASH (log) and ASSIGN6SIMCONFIG (saved settings).
+//ASSIGN6SIMSENSORS puts 2 - 8 sensors behind a TCA9548A at 0x70 in
+//place of the one on the controller, each SIMSENSORSTEPC warmer than
+//the one on the channel before.
+
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+
+#include "i2c_async.h"
+#include "i2c_async_sim.h"
+#include "flash_log.h"
+#include "flash_file_sim.h"
+#include "runtime_config.h"
+
+#define SIMDEFAULTTEMPC 22.5
+#define SIMDEFAULTRH 45.0
+#define SIMMUXADDRESS 0x70
+#define SIMMAXSENSORS 8
+#define SIMSENSORSTEPC 0.5
+#define SIMDEFAULTFLASH "assign6_flash.img"
+#define SIMDEFAULTCONFIG "assign6_config.img"
+
+i2c_inst_t i2c0_inst = { NULL, 0 };
+i2c_inst_t i2c1_inst = { NULL, 1 };
+spi_inst_t spi0_inst = { 0 };
+spi_inst_t spi1_inst = { 1 };
+
+static SimBus_t simBuses[2];
+
+//FreeRTOS configASSERT in sim/FreeRTOSConfig.h
+void vAssertCalled(const char *file, unsigned long line){
+
+    fprintf(stderr, "assert failed: %s:%lu\n", file, line);
+    abort();
+}
+
+//Time
+
+static uint64_t monotonicUs(void){
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint64_t time_us_64(void){
+
+    static uint64_t startUs;
+
+    if(startUs == 0){
+        startUs = monotonicUs() - 1;
+    }
+
+    return monotonicUs() - startUs;
+}
+
+uint32_t time_us_32(void){
+
+    return (uint32_t)time_us_64();
+}
+
+void busy_wait_us_32(uint32_t us){
+
+    uint64_t end = time_us_64() + us;
+
+    while(time_us_64() < end){
+    }
+}
+
+void sleep_us(uint64_t us){
+
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+
+    nanosleep(&ts, NULL);
+}
+
+void sleep_ms(uint32_t ms){
+
+    sleep_us((uint64_t)ms * 1000);
+}
+
+absolute_time_t get_absolute_time(void){
+
+    return time_us_64();
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us){
+
+    return time_us_64() + us;
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms){
+
+    return make_timeout_time_us((uint64_t)ms * 1000);
+}
+
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us){
+
+    return t == at_the_end_of_time ? t : t + us;
+}
+
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms){
+
+    return delayed_by_us(t, (uint64_t)ms * 1000);
+}
+
+bool time_reached(absolute_time_t t){
+
+    return time_us_64() >= t;
+}
+
+//Events between the cores
+
+static pthread_mutex_t eventLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t eventCond = PTHREAD_COND_INITIALIZER;
+static bool eventPending;
+
+void __sev(void){
+
+    pthread_mutex_lock(&eventLock);
+    eventPending = true;
+    pthread_cond_broadcast(&eventCond);
+    pthread_mutex_unlock(&eventLock);
+}
+
+void __wfe(void){
+
+    best_effort_wfe_or_timeout(at_the_end_of_time);
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t t){
+
+    struct timespec deadline;
+    uint64_t wakeUs;
+    bool reached;
+
+    pthread_mutex_lock(&eventLock);
+    while(!eventPending && !time_reached(t)){
+        if(t == at_the_end_of_time){
+            pthread_cond_wait(&eventCond, &eventLock);
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        wakeUs = t - time_us_64();
+        deadline.tv_sec += (time_t)(wakeUs / 1000000);
+        deadline.tv_nsec += (long)(wakeUs % 1000000) * 1000;
+        if(deadline.tv_nsec >= 1000000000){
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&eventCond, &eventLock, &deadline);
+    }
+    eventPending = false;
+    reached = time_reached(t);
+    pthread_mutex_unlock(&eventLock);
+
+    return reached;
+}
+
+//Interrupts, nested blocks of every signal on the calling thread
+
+static __thread sigset_t savedSignals;
+static __thread uint32_t interruptDepth;
+
+uint32_t save_and_disable_interrupts(void){
+
+    sigset_t all;
+
+    if(interruptDepth++ == 0){
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &savedSignals);
+    }
+
+    return interruptDepth;
+}
+
+void restore_interrupts(uint32_t status){
+
+    (void)status;
+    if(--interruptDepth == 0){
+        pthread_sigmask(SIG_SETMASK, &savedSignals, NULL);
+    }
+}
+
+//Core 1
+
+static __thread unsigned int coreNum;
+
+unsigned int get_core_num(void){
+
+    return coreNum;
+}
+
+static void *core1Thread(void *entry){
+
+    coreNum = 1;
+    ((void (*)(void))entry)();
+
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)){
+
+    pthread_t thread;
+    sigset_t all;
+    sigset_t saved;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &saved);
+    pthread_create(&thread, NULL, core1Thread, (void *)entry);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+}
+
+void multicore_lockout_victim_init(void){
+}
+
+void multicore_lockout_start_blocking(void){
+}
+
+void multicore_lockout_end_blocking(void){
+}
+
+//stdio, stdout stands in for USB CDC
+
+bool stdio_init_all(void){
+
+    return true;
+}
+
+void stdio_flush(void){
+
+    fflush(stdout);
+}
+
+int putchar_raw(int c){
+
+    return putchar(c);
+}
+
+int getchar_timeout_us(uint32_t timeout_us){
+
+    struct pollfd in = { 0, POLLIN, 0 };
+    unsigned char c;
+
+    if(poll(&in, 1, (int)((timeout_us + 999) / 1000)) <= 0 || read(0, &c, 1) != 1){
+        return PICO_ERROR_TIMEOUT;
+    }
+
+    return c;
+}
+
+//I2C
+
+static double envOr(const char *name, double fallback){
+
+    const char *value = getenv(name);
+
+    return value != NULL ? atof(value) : fallback;
+}
+
+SimBus_t *i2cSimBus(i2c_inst_t *i2c){
+
+    HDC1080Sim_t *sensor;
+    int count;
+    int i;
+
+    if(i2c->sim == NULL){
+        i2c->sim = &simBuses[i2c->index];
+        simBusInit(i2c->sim, 100 * 1000);
+
+        count = (int)envOr("ASSIGN6SIMSENSORS", 1);
+        count = count < 1 ? 1 : count > SIMMAXSENSORS ? SIMMAXSENSORS : count;
+        if(count > 1){
+            simBusAddMux(i2c->sim, SIMMUXADDRESS);
+        }
+
+        for(i = 0; i < count; i++){
+            sensor = simBusAddSensor(i2c->sim, count > 1 ? SIMMUXADDRESS : SIMBUSNOMUX, (uint8_t)i);
+            sensor->temperatureC = envOr("ASSIGN6SIMTEMPC", SIMDEFAULTTEMPC) + i * SIMSENSORSTEPC;
+            sensor->humidityRH = envOr("ASSIGN6SIMRH", SIMDEFAULTRH);
+        }
+    }
+
+    return i2c->sim;
+}
+
+//Bring the bus model up to the host clock
+static SimBus_t *syncBus(SimBus_t *sim){
+
+    uint64_t now = time_us_64();
+
+    if(now > sim->nowUs){
+        simBusAdvance(sim, now - sim->nowUs);
+    }
+
+    return sim;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate){
+
+    SimBus_t *sim = i2cSimBus(i2c);
+    int i;
+
+    sim->busHz = baudrate;
+    for(i = 0; i < sim->deviceCount; i++){
+        sim->devices[i].sensor.busHz = baudrate;
+    }
+
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+
+    SimBus_t *sim = syncBus(i2cSimBus(i2c));
+    uint64_t startUs = sim->nowUs;
+    int ret;
+
+    (void)nostop;
+    ret = simBusWrite(sim, addr, src, len);
+    busy_wait_us_32((uint32_t)(sim->nowUs - startUs));
+
+    return ret;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+
+    SimBus_t *sim = syncBus(i2cSimBus(i2c));
+    uint64_t startUs = sim->nowUs;
+    int ret;
+
+    (void)nostop;
+    ret = simBusRead(sim, addr, dst, len);
+    busy_wait_us_32((uint32_t)(sim->nowUs - startUs));
+
+    return ret;
+}
+
+//A transfer that hangs, or runs past its deadline, gives up at the
+//deadline like the SDK's timeout calls, and the bus clock with it
+static int timedResult(SimBus_t *sim, uint64_t startUs, int ret, uint timeout_us){
+
+    uint64_t elapsed = sim->nowUs - startUs;
+
+    if(ret == SIMBUSHUNG || elapsed > timeout_us){
+        sim->nowUs = startUs + timeout_us;
+        busy_wait_us_32(timeout_us);
+        return PICO_ERROR_TIMEOUT;
+    }
+
+    busy_wait_us_32((uint32_t)elapsed);
+
+    return ret < 0 ? PICO_ERROR_GENERIC : ret;
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us){
+
+    SimBus_t *sim = syncBus(i2cSimBus(i2c));
+    uint64_t startUs = sim->nowUs;
+
+    (void)nostop;
+
+    return timedResult(sim, startUs, simBusWrite(sim, addr, src, len), timeout_us);
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us){
+
+    SimBus_t *sim = syncBus(i2cSimBus(i2c));
+    uint64_t startUs = sim->nowUs;
+
+    (void)nostop;
+
+    return timedResult(sim, startUs, simBusRead(sim, addr, dst, len), timeout_us);
+}
+
+//Bus recovery against the model; the pins are not simulated
+bool i2cRp2040Recover(struct i2c_inst *i2c, uint32_t sdaPin, uint32_t sclPin, uint32_t baudrate){
+
+    SimBus_t *sim = syncBus(i2cSimBus(i2c));
+    uint64_t startUs = sim->nowUs;
+    bool released;
+
+    (void)sdaPin;
+    (void)sclPin;
+    released = simBusRecover(sim);
+    i2c_init(i2c, baudrate);
+    busy_wait_us_32((uint32_t)(sim->nowUs - startUs));
+
+    return released;
+}
+
+//Asynchronous transport. The simulated backend completes transfers
+//straight away in bus time; the bus is synced to the host clock first
+//and a completed transfer then spins for its bus time, as the blocking
+//calls do.
+
+static const I2CAsyncOps_t *simAsyncOps;
+
+static bool halAsyncStart(I2CAsyncBus_t *bus, I2CAsyncXfer_t *xfer){
+
+    SimBus_t *sim = syncBus((SimBus_t *)bus->ctx);
+    uint64_t startUs = sim->nowUs;
+
+    if(!simAsyncOps->start(bus, xfer)){
+        return false;
+    }
+    if(bus->active == NULL){
+        busy_wait_us_32((uint32_t)(sim->nowUs - startUs));
+    }
+
+    return true;
+}
+
+static const I2CAsyncOps_t halAsyncOps = {
+    .start = halAsyncStart,
+    .abort = NULL,
+};
+
+void i2cAsyncRp2040Init(I2CAsyncBus_t *bus, struct i2c_inst *i2c){
+
+    i2cAsyncSimInit(bus, i2cSimBus(i2c));
+    simAsyncOps = bus->ops;
+    bus->ops = &halAsyncOps;
+}
+
+//Flash, file images in place of the QSPI flash, one for the log and
+//one for the saved settings
+
+typedef struct {
+    FlashFileSim_t image;
+    const char *env;
+    const char *fallback;
+} SimFlash_t;
+
+static SimFlash_t logFlash = { .env = "ASSIGN6SIMFLASH", .fallback = SIMDEFAULTFLASH };
+static SimFlash_t configFlash = { .env = "ASSIGN6SIMCONFIG", .fallback = SIMDEFAULTCONFIG };
+
+static bool openImage(SimFlash_t *flash){
+
+    const char *path = getenv(flash->env);
+
+    if(flash->image.file != NULL){
+        return true;
+    }
+
+    return flashFileSimOpen(&flash->image, path != NULL ? path : flash->fallback);
+}
+
+static bool imageRead(void *ctx, uint32_t offset, void *dst, size_t len){
+
+    SimFlash_t *flash = ctx;
+
+    return openImage(flash) && flash->image.storage.read(&flash->image, offset, dst, len);
+}
+
+static bool imageProgram(void *ctx, uint32_t offset, const void *src, size_t len){
+
+    SimFlash_t *flash = ctx;
+
+    return openImage(flash) && flash->image.storage.program(&flash->image, offset, src, len);
+}
+
+static bool imageErase(void *ctx, uint32_t offset){
+
+    SimFlash_t *flash = ctx;
+
+    return openImage(flash) && flash->image.storage.erase(&flash->image, offset);
+}
+
+const FlashLogStorage_t flashLogRp2040Storage = {
+    .read = imageRead,
+    .program = imageProgram,
+    .erase = imageErase,
+    .ctx = &logFlash,
+};
+
+const FlashLogStorage_t runtimeConfigRp2040Storage = {
+    .read = imageRead,
+    .program = imageProgram,
+    .erase = imageErase,
+    .ctx = &configFlash,
+};
@@ -0,0 +1,6 @@
+//Host stand-in for hardware/adc.h. Included by Assign6.c, not used.
+
+#ifndef HARDWARE_ADC_MOCK_H
+#define HARDWARE_ADC_MOCK_H
+
+#endif
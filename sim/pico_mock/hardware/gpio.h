@@ -0,0 +1,23 @@
+//Host stand-in for hardware/gpio.h. Pin setup has no effect.
+
+#ifndef HARDWARE_GPIO_MOCK_H
+#define HARDWARE_GPIO_MOCK_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_SIO = 5,
+};
+
+static inline void gpio_init(uint gpio){ (void)gpio; }
+static inline void gpio_set_function(uint gpio, enum gpio_function fn){ (void)gpio; (void)fn; }
+static inline void gpio_pull_up(uint gpio){ (void)gpio; }
+static inline void gpio_set_dir(uint gpio, bool out){ (void)gpio; (void)out; }
+static inline void gpio_put(uint gpio, bool value){ (void)gpio; (void)value; }
+
+#endif
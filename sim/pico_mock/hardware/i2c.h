@@ -0,0 +1,35 @@
+//Host stand-in for hardware/i2c.h. Each controller is routed to a
+//simulated bus from sim/i2c_bus_sim.c.
+
+#ifndef HARDWARE_I2C_MOCK_H
+#define HARDWARE_I2C_MOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "i2c_bus_sim.h"
+
+typedef struct i2c_inst {
+    SimBus_t *sim;
+    int index;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
+
+//The simulated bus behind i2c, created on first use with one HDC1080
+//at 0x40. Tests add sensors or set the environment through it.
+SimBus_t *i2cSimBus(i2c_inst_t *i2c);
+
+#endif
@@ -0,0 +1,18 @@
+//Host stand-in for hardware/spi.h. The controllers only exist to be
+//passed to spiDisplayRp2040Init, which the host replaces with the
+//capture backend in sim/spi_display_sim.c.
+
+#ifndef HARDWARE_SPI_MOCK_H
+#define HARDWARE_SPI_MOCK_H
+
+typedef struct spi_inst {
+    int index;
+} spi_inst_t;
+
+extern spi_inst_t spi0_inst;
+extern spi_inst_t spi1_inst;
+
+#define spi0 (&spi0_inst)
+#define spi1 (&spi1_inst)
+
+#endif
@@ -0,0 +1,19 @@
+//Host stand-in for hardware/sync.h. __sev wakes a thread waiting in
+//best_effort_wfe_or_timeout.
+
+#ifndef HARDWARE_SYNC_MOCK_H
+#define HARDWARE_SYNC_MOCK_H
+
+#include <stdint.h>
+
+void __sev(void);
+void __wfe(void);
+
+//Interrupts are the POSIX port's signals; they are blocked on the
+//calling thread until the matching restore
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+static inline void __dmb(void){ __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#endif
@@ -0,0 +1,6 @@
+//Host stand-in for hardware/uart.h. Included by Assign6.c, not used.
+
+#ifndef HARDWARE_UART_MOCK_H
+#define HARDWARE_UART_MOCK_H
+
+#endif
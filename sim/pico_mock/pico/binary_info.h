@@ -0,0 +1,9 @@
+//Host stand-in for pico/binary_info.h. There is no binary to tag.
+
+#ifndef PICO_BINARY_INFO_MOCK_H
+#define PICO_BINARY_INFO_MOCK_H
+
+#define bi_decl(x)
+#define bi_2pins_with_func(a, b, f)
+
+#endif
@@ -0,0 +1,15 @@
+//Host stand-in for pico/multicore.h. Core 1 is a pthread running
+//alongside the FreeRTOS POSIX port, with its signals blocked so the
+//port's tick never lands on it.
+
+#ifndef PICO_MULTICORE_MOCK_H
+#define PICO_MULTICORE_MOCK_H
+
+void multicore_launch_core1(void (*entry)(void));
+
+//Nothing runs from flash on the host, so lockout has nothing to do
+void multicore_lockout_victim_init(void);
+void multicore_lockout_start_blocking(void);
+void multicore_lockout_end_blocking(void);
+
+#endif
@@ -0,0 +1,49 @@
+//Host stand-in for the parts of pico/stdlib.h the firmware uses.
+//Time is the host monotonic clock from the start of the run; stdio
+//is the process stdout. See sim/pico_hal_sim.c.
+
+#ifndef PICO_STDLIB_MOCK_H
+#define PICO_STDLIB_MOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+
+#define PICO_DEFAULT_I2C_SDA_PIN 2
+#define PICO_DEFAULT_I2C_SCL_PIN 3
+
+typedef uint64_t absolute_time_t;
+
+#define at_the_end_of_time ((absolute_time_t)UINT64_MAX)
+
+bool stdio_init_all(void);
+void stdio_flush(void);
+int putchar_raw(int c);
+
+//Next byte from stdin, or PICO_ERROR_TIMEOUT if none arrives in time
+int getchar_timeout_us(uint32_t timeout_us);
+
+//0 for FreeRTOS threads, 1 for the core 1 thread
+unsigned int get_core_num(void);
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+void busy_wait_us_32(uint32_t us);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_us(uint64_t us);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us);
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms);
+bool time_reached(absolute_time_t t);
+
+//Waits for __sev from another thread or until t, whichever is first
+bool best_effort_wfe_or_timeout(absolute_time_t t);
+
+#endif
@@ -0,0 +1,138 @@
+//Host stand-in backend for the MAX7219 display chain, see
+//spi_display_sim.h. Frames are carried out as soon as they start.
+
+#include <string.h>
+
+#include "spi_display_sim.h"
+#include "display_frame.h"
+
+//A word reaches chip 0 first and moves one chip down the chain for
+//every word shifted in after it
+static void shiftFrame(SpiDisplaySim_t *sim, const uint8_t *frame, size_t len){
+
+    size_t i;
+    int chip;
+
+    if(len % 2 != 0){
+        sim->badFrames++;
+        return;
+    }
+
+    for(i = 0; i < len; i += 2){
+        for(chip = SPIDISPLAYCHIPS - 1; chip > 0; chip--){
+            sim->shift[chip] = sim->shift[chip - 1];
+        }
+        sim->shift[0] = (uint16_t)(frame[i] << 8 | frame[i + 1]);
+    }
+
+    //CS up, each chip takes the word it holds
+    for(chip = 0; chip < SPIDISPLAYCHIPS; chip++){
+        sim->registers[chip][(sim->shift[chip] >> 8) & 0x0F] = (uint8_t)sim->shift[chip];
+    }
+}
+
+static bool simStart(SpiDisplay_t *display, const uint8_t *frame, size_t len){
+
+    SpiDisplaySim_t *sim = (SpiDisplaySim_t *)display->ctx;
+
+    while(frame != NULL){
+        if(sim->captured + len <= SPIDISPLAYSIMCAPTURE){
+            memcpy(sim->capture + sim->captured, frame, len);
+        }
+        sim->captured += len;
+        sim->frames++;
+
+        shiftFrame(sim, frame, len);
+        frame = spiDisplayFrameDone(display);
+    }
+
+    if(sim->updated != NULL){
+        sim->updated(sim);
+    }
+
+    return true;
+}
+
+static const SpiDisplayOps_t simOps = {
+    .start = simStart,
+};
+
+void spiDisplaySimInit(SpiDisplay_t *display, SpiDisplaySim_t *sim){
+
+    void (*updated)(SpiDisplaySim_t *sim) = sim->updated;
+
+    //power on: registers cleared, in shutdown
+    memset(sim, 0, sizeof(*sim));
+    sim->updated = updated;
+
+    spiDisplayInit(display, &simOps, sim);
+}
+
+void spiDisplaySimClear(SpiDisplaySim_t *sim){
+
+    sim->captured = 0;
+    sim->frames = 0;
+}
+
+bool spiDisplaySimLit(const SpiDisplaySim_t *sim){
+
+    int chip;
+
+    for(chip = 0; chip < SPIDISPLAYCHIPS; chip++){
+        const uint8_t *registers = sim->registers[chip];
+
+        if(registers[MAX7219SHUTDOWN] != 0x01 || registers[MAX7219DISPLAYTEST] != 0x00 ||
+           registers[MAX7219SCANLIMIT] != 0x07 || registers[MAX7219DECODEMODE] != 0x00){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Back from the MAX7219 bit order to segment bits
+static char digitChar(uint8_t bits){
+
+    uint8_t segments = 0;
+    int i;
+
+    for(i = 0; i < 7; i++){
+        if(bits & (0x40 >> i)){
+            segments |= 1 << i;
+        }
+    }
+
+    if(segments == SEGBLANK){
+        return ' ';
+    }
+    if(segments == SEGDASH){
+        return '-';
+    }
+    for(i = 0; i < 10; i++){
+        if(segments == displayDigitSegments[i]){
+            return (char)('0' + i);
+        }
+    }
+
+    return '?';
+}
+
+size_t spiDisplaySimText(const SpiDisplaySim_t *sim, char *text, size_t len){
+
+    size_t n = 0;
+    int digit;
+
+    for(digit = 0; digit < SPIDISPLAYDIGITS && n + 1 < len; digit++){
+        uint8_t bits = sim->registers[digit / 8][MAX7219DIGIT0 + 7 - digit % 8];
+
+        text[n++] = digitChar(bits);
+        if((bits & 0x80) && n + 1 < len){
+            text[n++] = '.';
+        }
+    }
+    if(len > 0){
+        text[n] = '\0';
+    }
+
+    return n;
+}
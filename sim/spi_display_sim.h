@@ -0,0 +1,51 @@
+//Host stand-in backend for the MAX7219 display chain (spi_display.h)
+//Every frame is appended to a capture of the SPI byte stream and
+//shifted through a model of the chain: one 16 bit shift register per
+//chip, latched into its registers when CS goes up. The digits the
+//chain would light can then be read back as text, so a wrong register,
+//chip order or segment mapping shows up here as it would on the board.
+
+#ifndef SPI_DISPLAY_SIM_H
+#define SPI_DISPLAY_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "spi_display.h"
+
+#define SPIDISPLAYSIMCAPTURE 1024
+
+typedef struct SpiDisplaySim SpiDisplaySim_t;
+
+struct SpiDisplaySim {
+    //Byte stream since the last spiDisplaySimClear, and how many CS
+    //frames it was sent in. Bytes past the buffer are counted only.
+    uint8_t capture[SPIDISPLAYSIMCAPTURE];
+    size_t captured;
+    uint32_t frames;
+
+    //The chain: shift registers and latched registers per chip
+    uint16_t shift[SPIDISPLAYCHIPS];
+    uint8_t registers[SPIDISPLAYCHIPS][16];
+    uint32_t badFrames;         //not a whole number of 16 bit words
+
+    //Called after the last frame of each update, optional
+    void (*updated)(SpiDisplaySim_t *sim);
+};
+
+void spiDisplaySimInit(SpiDisplay_t *display, SpiDisplaySim_t *sim);
+
+//Forget the capture, the chain keeps its state
+void spiDisplaySimClear(SpiDisplaySim_t *sim);
+
+//True when every chip is out of shutdown and test mode, scanning all
+//eight digits without BCD decode
+bool spiDisplaySimLit(const SpiDisplaySim_t *sim);
+
+//The digits lit, leftmost first: 0 - 9, '-', ' ', '?' for any other
+//pattern, and '.' after a digit with its decimal point on. Returns
+//the length written.
+size_t spiDisplaySimText(const SpiDisplaySim_t *sim, char *text, size_t len);
+
+#endif
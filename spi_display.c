@@ -0,0 +1,190 @@
+//Multi digit display on a chain of MAX7219 drivers, see spi_display.h
+
+#include <string.h>
+
+#include "spi_display.h"
+#include "display_frame.h"
+
+//Control registers, in the order they are written: leave test mode,
+//scan all eight digits, raw segments, brightness, then light up
+static const uint8_t controlFrames[SPIDISPLAYCONTROLFRAMES][2] = {
+    {MAX7219DISPLAYTEST, 0x00},
+    {MAX7219SCANLIMIT, 0x07},
+    {MAX7219DECODEMODE, 0x00},
+    {MAX7219INTENSITY, SPIDISPLAYINTENSITY},
+    {MAX7219SHUTDOWN, 0x01},
+};
+
+void spiDisplayInit(SpiDisplay_t *display, const SpiDisplayOps_t *ops, void *ctx){
+
+    memset(display, 0, sizeof(*display));
+    display->ops = ops;
+    display->ctx = ctx;
+}
+
+bool spiDisplaySet(SpiDisplay_t *display, const uint8_t *segments){
+
+    if(memcmp(display->wanted, segments, SPIDISPLAYDIGITS) == 0){
+        return false;
+    }
+
+    memcpy(display->wanted, segments, SPIDISPLAYDIGITS);
+
+    return true;
+}
+
+uint8_t spiDisplayMax7219Segments(uint8_t segments){
+
+    uint8_t bits = segments & SEGDP;
+    int i;
+
+    //A on D6 down to G on D0
+    for(i = 0; i < 7; i++){
+        if(segments & (1 << i)){
+            bits |= 0x40 >> i;
+        }
+    }
+
+    return bits;
+}
+
+//Frame writing register reg on every chip, data for chip c from
+//data[c], or a no-op for chips with skip[c] set. Chip 0 is shifted
+//in last.
+static void buildFrame(uint8_t *frame, uint8_t reg, const uint8_t *data, const bool *skip){
+
+    int chip;
+
+    for(chip = 0; chip < SPIDISPLAYCHIPS; chip++){
+        uint8_t *word = frame + 2 * (SPIDISPLAYCHIPS - 1 - chip);
+
+        word[0] = skip != NULL && skip[chip] ? MAX7219NOOP : reg;
+        word[1] = skip != NULL && skip[chip] ? 0 : data[chip];
+    }
+}
+
+bool spiDisplayService(SpiDisplay_t *display){
+
+    uint8_t data[SPIDISPLAYCHIPS];
+    bool skip[SPIDISPLAYCHIPS];
+    bool changed;
+    int frame;
+    int row;
+    int chip;
+
+    if(display->busy){
+        return false;
+    }
+
+    frame = 0;
+    if(!display->configured){
+        for(row = 0; row < SPIDISPLAYCONTROLFRAMES; row++){
+            memset(data, controlFrames[row][1], sizeof(data));
+            buildFrame(display->stream[frame++], controlFrames[row][0], data, NULL);
+        }
+    }
+
+    //Digit register r of a chip holds its digit 8 - r from the left
+    for(row = 0; row < 8; row++){
+        changed = false;
+
+        for(chip = 0; chip < SPIDISPLAYCHIPS; chip++){
+            int digit = chip * 8 + 7 - row;
+
+            skip[chip] = display->configured && display->wanted[digit] == display->shown[digit];
+            data[chip] = spiDisplayMax7219Segments(display->wanted[digit]);
+            display->shown[digit] = display->wanted[digit];
+            changed |= !skip[chip];
+        }
+
+        if(changed){
+            buildFrame(display->stream[frame++], MAX7219DIGIT0 + row, data, skip);
+        }
+    }
+
+    if(frame == 0){
+        return false;
+    }
+
+    display->frames = frame;
+    display->next = 1;
+    display->busy = true;
+    display->configured = true;
+    display->updates++;
+
+    if(!display->ops->start(display, display->stream[0], SPIDISPLAYFRAMEBYTES)){
+        //send everything again next time
+        display->busy = false;
+        display->configured = false;
+        return false;
+    }
+
+    return true;
+}
+
+const uint8_t *spiDisplayFrameDone(SpiDisplay_t *display){
+
+    display->framesSent++;
+    display->bytesSent += SPIDISPLAYFRAMEBYTES;
+
+    if(display->next < display->frames){
+        return display->stream[display->next++];
+    }
+
+    display->busy = false;
+
+    return NULL;
+}
+
+void spiDisplayFormat(uint8_t *segments, int width, int32_t centi, int decimals){
+
+    static const int32_t scale[3] = {100, 10, 1};
+    uint32_t magnitude;
+    uint32_t rest;
+    bool negative;
+    int digits;
+    int i;
+
+    if(centi == SPIDISPLAYNOVALUE || decimals < 0 || decimals > 2){
+        memset(segments, SEGDASH, width);
+        return;
+    }
+
+    //round half away from zero to the places shown
+    negative = centi < 0;
+    magnitude = negative ? -(uint32_t)centi : (uint32_t)centi;
+    magnitude = (magnitude + scale[decimals] / 2) / scale[decimals];
+    if(magnitude == 0){
+        negative = false;
+    }
+
+    //digits needed, at least one ahead of the point
+    digits = 0;
+    rest = magnitude;
+    do{
+        digits++;
+        rest /= 10;
+    }while(rest != 0);
+    if(digits < decimals + 1){
+        digits = decimals + 1;
+    }
+
+    if(digits + (negative ? 1 : 0) > width){
+        memset(segments, SEGDASH, width);
+        return;
+    }
+
+    memset(segments, SEGBLANK, width);
+    for(i = 0; i < digits; i++){
+        uint8_t *digit = &segments[width - 1 - i];
+
+        *digit = displayDigitSegments[magnitude % 10];
+        if(decimals > 0 && i == decimals){
+            *digit |= SEGDP;
+        }
+        magnitude /= 10;
+    }
+    if(negative){
+        segments[width - 1 - digits] = SEGDASH;
+    }
+}
@@ -0,0 +1,124 @@
+//Multi digit display on a chain of MAX7219 drivers over SPI
+//Each MAX7219 holds eight digits in its own registers and refreshes
+//them itself, so the chain only has to be written when a digit
+//changes. The caller sets the digits wanted; the module compares them
+//with what the chain shows and sends one frame per digit row that
+//differs, every chip's register write for that row in one CS low
+//burst (a no-op for chips whose digit there is unchanged). Control
+//registers go out ahead of the first update.
+//
+//Digit 0 is the leftmost. Chip 0 is the one wired to the Pico and
+//shows digits 0 - 7, DIG7 of each chip is its leftmost digit.
+//
+//Backends send the frames: the RP2040 backend streams each one from
+//DMA to the SPI TX FIFO and raises CS from the DMA interrupt; the host
+//backend in sim/ captures the byte stream and decodes it the way the
+//chain would latch it. Pure logic apart from the backend, so it runs
+//unchanged on the host.
+
+#ifndef SPI_DISPLAY_H
+#define SPI_DISPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//Chips in the chain, eight digits each. 1 for the common 8 digit
+//module, 2 for 16 digits.
+#ifndef SPIDISPLAYCHIPS
+#define SPIDISPLAYCHIPS 1
+#endif
+#define SPIDISPLAYDIGITS (8 * SPIDISPLAYCHIPS)
+
+//One frame is a 16 bit register write per chip, farthest chip first
+#define SPIDISPLAYFRAMEBYTES (2 * SPIDISPLAYCHIPS)
+
+//Control frames and one per digit row
+#define SPIDISPLAYCONTROLFRAMES 5
+#define SPIDISPLAYMAXFRAMES (SPIDISPLAYCONTROLFRAMES + 8)
+
+//MAX7219 registers
+#define MAX7219NOOP 0x00
+#define MAX7219DIGIT0 0x01          //DIG0 - DIG7 are 0x01 - 0x08
+#define MAX7219DECODEMODE 0x09
+#define MAX7219INTENSITY 0x0A
+#define MAX7219SCANLIMIT 0x0B
+#define MAX7219SHUTDOWN 0x0C
+#define MAX7219DISPLAYTEST 0x0F
+
+//Brightness, 0 - 15 in 1/16 duty steps
+#define SPIDISPLAYINTENSITY 7
+
+//SPI1 pins, clear of the 7 segment display and I2C pins. CS is
+//driven as a GPIO so one CS low can span the whole chain.
+#define SPIDISPLAYSCKPIN 14
+#define SPIDISPLAYMOSIPIN 15
+#define SPIDISPLAYCSPIN 13
+#define SPIDISPLAYBAUDRATE (10 * 1000 * 1000)
+
+//Value shown as dashes across the field
+#define SPIDISPLAYNOVALUE INT32_MIN
+
+typedef struct SpiDisplay SpiDisplay_t;
+
+typedef struct {
+    //Send frame, len bytes under one CS low, and call
+    //spiDisplayFrameDone once CS is back up. Returns false if it could
+    //not be started.
+    bool (*start)(SpiDisplay_t *display, const uint8_t *frame, size_t len);
+} SpiDisplayOps_t;
+
+struct SpiDisplay {
+    const SpiDisplayOps_t *ops;
+    void *ctx;
+
+    uint8_t wanted[SPIDISPLAYDIGITS];   //segment bits, as set by the caller
+    uint8_t shown[SPIDISPLAYDIGITS];    //latched in the chain, or on the way
+    bool configured;                    //control registers sent
+
+    //Frames of the update in flight. The backend takes them one at a
+    //time from its completion interrupt.
+    uint8_t stream[SPIDISPLAYMAXFRAMES][SPIDISPLAYFRAMEBYTES];
+    uint8_t frames;
+    volatile uint8_t next;
+    volatile bool busy;
+
+    //Statistics
+    uint32_t updates;
+    uint32_t framesSent;
+    uint32_t bytesSent;
+};
+
+void spiDisplayInit(SpiDisplay_t *display, const SpiDisplayOps_t *ops, void *ctx);
+
+//Digits wanted, SPIDISPLAYDIGITS segment bytes (SEGA ... SEGDP) from
+//the left. Returns true if any differ from what was wanted before.
+bool spiDisplaySet(SpiDisplay_t *display, const uint8_t *segments);
+
+//Send what changed since the last update, if the chain is idle.
+//Call after Set and again once a transfer has finished; a Set made
+//while one is in flight goes out on the next call. Returns true if a
+//transfer was started.
+bool spiDisplayService(SpiDisplay_t *display);
+
+//For backends: the frame sent last is latched. Returns the next one,
+//or NULL when the update is complete.
+const uint8_t *spiDisplayFrameDone(SpiDisplay_t *display);
+
+//Write centi (hundredths) into width digits, right aligned with
+//decimals places (0 - 2) and a leading minus when negative, rounded
+//half away from zero. Too wide for the field, or SPIDISPLAYNOVALUE,
+//shows dashes.
+void spiDisplayFormat(uint8_t *segments, int width, int32_t centi, int decimals);
+
+//MAX7219 no decode mode bits for segment bits: DP on D7, A - G on D6 - D0
+uint8_t spiDisplayMax7219Segments(uint8_t segments);
+
+//RP2040 backend on spi0 or spi1 (spi_display_rp2040.c). Sets up the
+//pins, SPI and a DMA channel; the DMA interrupt is taken on the core
+//that calls it.
+struct spi_inst;
+void spiDisplayRp2040Init(SpiDisplay_t *display, struct spi_inst *spi, uint32_t sckPin, uint32_t mosiPin,
+                          uint32_t csPin, uint32_t baudrate);
+
+#endif
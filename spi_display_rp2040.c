@@ -0,0 +1,104 @@
+//Multi digit display on a chain of MAX7219 drivers, RP2040 backend
+//A DMA channel paced by the SPI TX DREQ feeds one frame to the FIFO.
+//Its completion interrupt waits out the last bits still shifting,
+//raises CS so every chip latches its word, and starts the next frame
+//of the update, so the CPU spends a few us per frame and nothing in
+//between.
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/gpio.h"
+
+#include "spi_display.h"
+
+//DMA_IRQ_0 is left for the SDK and other users
+#define SPIDISPLAYDMAIRQ DMA_IRQ_1
+
+static SpiDisplay_t *irqDisplay;
+static spi_inst_t *irqSpi;
+static uint32_t irqCsPin;
+static int dmaChan;
+
+static void sendFrame(const uint8_t *frame, size_t len){
+
+    gpio_put(irqCsPin, 0);
+    dma_channel_transfer_from_buffer_now(dmaChan, frame, len);
+}
+
+static void dmaIrq(void){
+
+    spi_hw_t *hw = spi_get_hw(irqSpi);
+    const uint8_t *frame;
+
+    if(!(dma_hw->ints1 & (1u << dmaChan))){
+        return;
+    }
+    dma_hw->ints1 = 1u << dmaChan;
+
+    //DMA is done once the last byte is in the FIFO, the chain only
+    //latches once it has been shifted out: at most one frame, 1.6 us
+    //per chip at 10 MHz
+    while(spi_is_busy(irqSpi)){
+        tight_loop_contents();
+    }
+
+    //nothing is read back, drop what came in and the overrun it caused
+    while(spi_is_readable(irqSpi)){
+        (void)hw->dr;
+    }
+    hw->icr = SPI_SSPICR_RORIC_BITS;
+
+    gpio_put(irqCsPin, 1);
+
+    frame = spiDisplayFrameDone(irqDisplay);
+    if(frame != NULL){
+        sendFrame(frame, SPIDISPLAYFRAMEBYTES);
+    }
+}
+
+static bool rp2040Start(SpiDisplay_t *display, const uint8_t *frame, size_t len){
+
+    (void)display;
+    sendFrame(frame, len);
+
+    return true;
+}
+
+static const SpiDisplayOps_t rp2040Ops = {
+    .start = rp2040Start,
+};
+
+void spiDisplayRp2040Init(SpiDisplay_t *display, struct spi_inst *spi, uint32_t sckPin, uint32_t mosiPin,
+                          uint32_t csPin, uint32_t baudrate){
+
+    dma_channel_config dc;
+
+    spiDisplayInit(display, &rp2040Ops, spi);
+    irqDisplay = display;
+    irqSpi = spi;
+    irqCsPin = csPin;
+
+    //MAX7219 takes data on the rising edge, MSB first
+    spi_init(spi, baudrate);
+    spi_set_format(spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    gpio_set_function(sckPin, GPIO_FUNC_SPI);
+    gpio_set_function(mosiPin, GPIO_FUNC_SPI);
+
+    gpio_init(csPin);
+    gpio_put(csPin, 1);
+    gpio_set_dir(csPin, GPIO_OUT);
+
+    dmaChan = dma_claim_unused_channel(true);
+    dc = dma_channel_get_default_config(dmaChan);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_8);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, spi_get_dreq(spi, true));
+    dma_channel_configure(dmaChan, &dc, &spi_get_hw(spi)->dr, NULL, 0, false);
+
+    dma_channel_set_irq1_enabled(dmaChan, true);
+    irq_set_exclusive_handler(SPIDISPLAYDMAIRQ, dmaIrq);
+    irq_set_enabled(SPIDISPLAYDMAIRQ, true);
+}
@@ -0,0 +1,56 @@
+//Single producer, single consumer ring
+//The producer copies the element in, then publishes it with a release
+//store of head; the consumer reads head with acquire before copying
+//out, then hands the slot back with a release store of tail. On the
+//RP2040 the fences are DMBs, which also order the stores as seen by
+//the other core.
+
+#include <string.h>
+
+#include "spsc_ring.h"
+
+void spscRingInit(SpscRing_t *ring, void *storage, size_t slotSize, uint32_t count){
+
+    ring->slots = (uint8_t *)storage;
+    ring->slotSize = slotSize;
+    ring->mask = count - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+}
+
+bool spscRingPush(SpscRing_t *ring, const void *element){
+
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if(head - tail > ring->mask){
+        ring->dropped++;
+        return false;
+    }
+
+    memcpy(&ring->slots[(head & ring->mask) * ring->slotSize], element, ring->slotSize);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool spscRingPop(SpscRing_t *ring, void *element){
+
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    if(head == tail){
+        return false;
+    }
+
+    memcpy(element, &ring->slots[(tail & ring->mask) * ring->slotSize], ring->slotSize);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+uint32_t spscRingCount(const SpscRing_t *ring){
+
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,39 @@
+//Single producer, single consumer ring
+//Lock free: the producer only writes head and the consumer only
+//writes tail, so one side can run on each core with no critical
+//section and neither ever waits for the other. Elements are copied
+//in and out by value. Plain C11 atomics, so the same code runs on
+//the host.
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    uint8_t *slots;
+    size_t slotSize;
+    uint32_t mask;              //slot count - 1, count is a power of 2
+
+    //Free running indices, each written by one side only. Kept apart
+    //so the two sides do not share a word.
+    volatile uint32_t head;     //producer
+    uint32_t dropped;           //producer, pushes refused while full
+    volatile uint32_t tail;     //consumer
+} SpscRing_t;
+
+//storage is count * slotSize bytes; count must be a power of 2
+void spscRingInit(SpscRing_t *ring, void *storage, size_t slotSize, uint32_t count);
+
+//Producer side. Returns false, and counts a drop, if the ring is full.
+bool spscRingPush(SpscRing_t *ring, const void *element);
+
+//Consumer side. Returns false if the ring is empty.
+bool spscRingPop(SpscRing_t *ring, void *element);
+
+//Either side; a snapshot that may be stale by the time it is used
+uint32_t spscRingCount(const SpscRing_t *ring);
+
+#endif
@@ -0,0 +1,201 @@
+//Binary sample telemetry
+
+#include <string.h>
+
+#include "telemetry.h"
+
+static void put16(uint8_t *p, uint16_t v){
+
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v){
+
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get16(const uint8_t *p){
+
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p){
+
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t telemetryCrc16(const uint8_t *data, size_t len){
+
+    uint16_t crc = 0xFFFF;
+    size_t i;
+    int bit;
+
+    for(i = 0; i < len; i++){
+        crc ^= (uint16_t)data[i] << 8;
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+void telemetryEncoderInit(TelemetryEncoder_t *enc, int batch){
+
+    if(batch < 1){
+        batch = 1;
+    }
+    if(batch > TELEMETRYMAXRECORDS){
+        batch = TELEMETRYMAXRECORDS;
+    }
+
+    enc->count = 0;
+    enc->batch = batch;
+    enc->frameSequence = 0;
+}
+
+size_t telemetryEncode(TelemetryEncoder_t *enc, const TelemetryRecord_t *record){
+
+    uint8_t *p = &enc->frame[TELEMETRYHEADERSIZE + enc->count * TELEMETRYRECORDSIZE];
+
+    put32(p, record->sequence);
+    put32(p + 4, record->timeMs);
+    put16(p + 8, record->rawTemperature);
+    put16(p + 10, record->rawHumidity);
+    enc->count++;
+
+    if(enc->count < enc->batch){
+        return 0;
+    }
+
+    return telemetryFlush(enc);
+}
+
+size_t telemetryFlush(TelemetryEncoder_t *enc){
+
+    size_t length;
+    uint8_t *frame = enc->frame;
+
+    if(enc->count == 0){
+        return 0;
+    }
+
+    frame[0] = TELEMETRYSYNC0;
+    frame[1] = TELEMETRYSYNC1;
+    frame[2] = TELEMETRYVERSION;
+    frame[3] = (uint8_t)enc->count;
+    put32(&frame[4], enc->frameSequence++);
+
+    length = TELEMETRYHEADERSIZE + enc->count * TELEMETRYRECORDSIZE;
+    put16(&frame[length], telemetryCrc16(&frame[2], length - 2));
+
+    enc->count = 0;
+
+    return length + TELEMETRYCRCSIZE;
+}
+
+void telemetryDecoderInit(TelemetryDecoder_t *dec){
+
+    memset(dec, 0, sizeof(*dec));
+}
+
+//Drop the first byte of a bad frame and look for sync in the rest
+static void resync(TelemetryDecoder_t *dec){
+
+    size_t i;
+
+    for(i = 1; i < dec->length; i++){
+        if(dec->frame[i] == TELEMETRYSYNC0 && (i + 1 == dec->length || dec->frame[i + 1] == TELEMETRYSYNC1)){
+            break;
+        }
+    }
+
+    dec->bytesSkipped += i;
+    memmove(dec->frame, &dec->frame[i], dec->length - i);
+    dec->length -= i;
+    dec->expected = 0;
+}
+
+static bool finishFrame(TelemetryDecoder_t *dec){
+
+    const uint8_t *frame = dec->frame;
+    size_t body = dec->expected - TELEMETRYCRCSIZE;
+    uint32_t sequence;
+    int i;
+
+    if(get16(&frame[body]) != telemetryCrc16(&frame[2], body - 2)){
+        dec->crcErrors++;
+        resync(dec);
+        return false;
+    }
+
+    sequence = get32(&frame[4]);
+    if(dec->synced && sequence != dec->frameSequence + 1){
+        dec->framesLost += sequence - dec->frameSequence - 1;
+    }
+    dec->synced = true;
+    dec->frameSequence = sequence;
+    dec->count = frame[3];
+
+    for(i = 0; i < dec->count; i++){
+        const uint8_t *p = &frame[TELEMETRYHEADERSIZE + i * TELEMETRYRECORDSIZE];
+
+        dec->records[i].sequence = get32(p);
+        dec->records[i].timeMs = get32(p + 4);
+        dec->records[i].rawTemperature = get16(p + 8);
+        dec->records[i].rawHumidity = get16(p + 10);
+    }
+
+    //keep anything after the frame, it can follow a resync
+    dec->frames++;
+    dec->length -= dec->expected;
+    memmove(dec->frame, &dec->frame[dec->expected], dec->length);
+    dec->expected = 0;
+
+    return true;
+}
+
+//Check what has arrived so far. Returns true on a good frame.
+static bool step(TelemetryDecoder_t *dec){
+
+    while(dec->length > 0){
+        if(dec->frame[0] != TELEMETRYSYNC0 || (dec->length > 1 && dec->frame[1] != TELEMETRYSYNC1)){
+            resync(dec);
+            continue;
+        }
+
+        if(dec->length < 4){
+            return false;
+        }
+
+        if(dec->expected == 0){
+            if(dec->frame[2] != TELEMETRYVERSION || dec->frame[3] == 0 || dec->frame[3] > TELEMETRYMAXRECORDS){
+                resync(dec);
+                continue;
+            }
+            dec->expected = TELEMETRYHEADERSIZE + dec->frame[3] * TELEMETRYRECORDSIZE + TELEMETRYCRCSIZE;
+        }
+
+        if(dec->length < dec->expected){
+            return false;
+        }
+
+        //a bad frame may leave a whole frame behind it, go round again
+        if(finishFrame(dec)){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool telemetryDecode(TelemetryDecoder_t *dec, uint8_t byte){
+
+    dec->frame[dec->length++] = byte;
+
+    return step(dec);
+}
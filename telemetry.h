@@ -0,0 +1,90 @@
+//Binary sample telemetry
+//Samples are packed into frames and sent in batches in place of the
+//printf text. The same file builds on the host, where the decoder is
+//used by tools/telemetry_decode.c.
+//
+//Frame, all fields little endian:
+//  sync      2  0xA5 0x5A
+//  version   1  TELEMETRYVERSION
+//  count     1  records in this frame, 1 - TELEMETRYMAXRECORDS
+//  sequence  4  frame sequence, increases by one per frame
+//  records   count * 12
+//  crc       2  CRC-16/CCITT over version..records
+//
+//Record:
+//  sequence  4  sample sequence from the sample cell
+//  timeMs    4  ms since boot
+//  rawTemp   2  HDC1080 temperature code
+//  rawHum    2  HDC1080 humidity code
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TELEMETRYSYNC0 0xA5
+#define TELEMETRYSYNC1 0x5A
+#define TELEMETRYVERSION 1
+
+#define TELEMETRYHEADERSIZE 8
+#define TELEMETRYRECORDSIZE 12
+#define TELEMETRYCRCSIZE 2
+#define TELEMETRYMAXRECORDS 16
+#define TELEMETRYMAXFRAME (TELEMETRYHEADERSIZE + TELEMETRYMAXRECORDS * TELEMETRYRECORDSIZE + TELEMETRYCRCSIZE)
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t timeMs;
+    uint16_t rawTemperature;
+    uint16_t rawHumidity;
+} TelemetryRecord_t;
+
+//Builds one frame at a time in place
+typedef struct {
+    uint8_t frame[TELEMETRYMAXFRAME];
+    int count;
+    int batch;                  //records per frame
+    uint32_t frameSequence;
+} TelemetryEncoder_t;
+
+//Byte at a time decoder, resynchronises on the sync bytes after a
+//bad length or CRC
+typedef struct {
+    uint8_t frame[TELEMETRYMAXFRAME];
+    size_t length;
+    size_t expected;
+
+    //Last good frame
+    uint32_t frameSequence;
+    int count;
+    TelemetryRecord_t records[TELEMETRYMAXRECORDS];
+
+    //Statistics
+    uint32_t frames;
+    uint32_t crcErrors;
+    uint32_t framesLost;        //gaps in the frame sequence
+    uint32_t bytesSkipped;
+    bool synced;
+} TelemetryDecoder_t;
+
+uint16_t telemetryCrc16(const uint8_t *data, size_t len);
+
+//batch is clamped to 1 - TELEMETRYMAXRECORDS
+void telemetryEncoderInit(TelemetryEncoder_t *enc, int batch);
+
+//Add a record. Returns the frame length when the batch is complete
+//and the frame is ready to send, otherwise 0.
+size_t telemetryEncode(TelemetryEncoder_t *enc, const TelemetryRecord_t *record);
+
+//Close a partial batch. Returns its length, 0 if it is empty.
+size_t telemetryFlush(TelemetryEncoder_t *enc);
+
+void telemetryDecoderInit(TelemetryDecoder_t *dec);
+
+//Feed one byte. Returns true when a whole, good frame has been decoded
+//into dec->records.
+bool telemetryDecode(TelemetryDecoder_t *dec, uint8_t byte);
+
+#endif
@@ -0,0 +1,384 @@
+//Replay of synthetic temperature/humidity curves through the adaptive
+//sample rate (adaptive_rate.h), against the old fixed 10 s schedule
+//and a fixed schedule at the adaptive floor period.
+//Each curve runs for REPLAYHOURS at REPLAYSTEPMS resolution with
+//sensor noise added. The samples taken are linearly interpolated back
+//onto the time grid and compared with the noiseless curve, up to the
+//last sample taken: past it there is nothing to interpolate towards.
+//
+//A transient that starts right on a reading is followed closely by
+//any schedule, so each curve is replayed REPLAYPHASES times, shifted
+//by a further REPLAYPHASES'th of the floor period each time, and the
+//worst error over the shifts is what counts. Reads are the mean over the shifts.
+//
+//  gcc -O2 -I.. -o adaptive_replay adaptive_replay.c ../adaptive_rate.c -lm
+//
+//  adaptive_replay             one line per curve and schedule, then
+//                              the reads against the error per floor
+//
+//Reads counts bus transactions, a coalesced read of both channels is
+//one. Errors are RMS and worst case in C and %RH. The floor table
+//reruns every curve with the adaptive settings at each slowest period
+//in floors[], so the reads saved can be weighed against the error
+//given up. Exits 1 if the adaptive schedule does not read the steady
+//curve less often than fixed10s, or if on any curve its worst case is
+//further from the curve than a fixed schedule at its floor period by
+//more than the sensor noise: following transients faster than that is
+//all the extra reads are for.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "adaptive_rate.h"
+
+#define REPLAYHOURS 4
+#define REPLAYSTEPMS 100
+#define REPLAYPOINTS (REPLAYHOURS * 3600 * (1000 / REPLAYSTEPMS))
+#define FIXEDPERIODMS 10000
+#define REPLAYPHASES 10
+#define CURVES (sizeof(curves) / sizeof(curves[0]))
+
+//Peak sensor noise in hundredths
+#define NOISETEMP 2
+#define NOISEHUM 5
+
+typedef struct {
+    const char *name;
+    void (*curve)(double minutes, double *c, double *rh);
+} Curve_t;
+
+typedef struct {
+    uint32_t ms[REPLAYPOINTS];
+    int32_t value[REPLAYPOINTS];
+    int count;
+} Samples_t;
+
+typedef struct {
+    int reads;
+    Samples_t temperature;
+    Samples_t humidity;
+} Run_t;
+
+//Worst over the shifts of a curve, reads summed
+typedef struct {
+    int reads;
+    int temperatureReads;
+    int humidityReads;
+    double rmsC;
+    double worstC;
+    double rmsRH;
+    double worstRH;
+} Result_t;
+
+static double truthC[REPLAYPOINTS];
+static double truthRH[REPLAYPOINTS];
+static int32_t measuredC[REPLAYPOINTS];
+static int32_t measuredRH[REPLAYPOINTS];
+static Run_t fixedRun;
+static Run_t adaptiveRun;
+static uint32_t noiseState;
+
+//Rising exponential settle, 0 before start
+static double settle(double minutes, double start, double tau){
+
+    if(minutes < start){
+        return 0;
+    }
+    return 1 - exp(-(minutes - start) / tau);
+}
+
+static void steadyCurve(double minutes, double *c, double *rh){
+
+    (void)minutes;
+    *c = 22.0;
+    *rh = 45.0;
+}
+
+//slow drift, 1 C and -2.5 %RH an hour
+static void driftCurve(double minutes, double *c, double *rh){
+
+    *c = 20.0 + minutes / 60;
+    *rh = 50.0 - minutes / 24;
+}
+
+//air conditioning switched on after 1 hour and off after 3
+static void stepCurve(double minutes, double *c, double *rh){
+
+    double on = settle(minutes, 60, 2) - settle(minutes, 180, 4);
+
+    *c = 24.0 - 3.0 * on;
+    *rh = 50.0 - 8.0 * on;
+}
+
+//a shower after 1 hour: 3 minutes of rise, then a slow decay
+static void showerCurve(double minutes, double *c, double *rh){
+
+    double level = 0;
+
+    if(minutes >= 60 && minutes < 63){
+        level = (minutes - 60) / 3;
+    }
+    else if(minutes >= 63){
+        level = exp(-(minutes - 63) / 15);
+    }
+    *c = 21.0 + 1.5 * level;
+    *rh = 45.0 + 35.0 * level;
+}
+
+//thermostat cycling every 20 minutes
+static void cycleCurve(double minutes, double *c, double *rh){
+
+    double phase = sin(2 * M_PI * minutes / 20);
+
+    *c = 22.0 + 1.5 * phase;
+    *rh = 45.0 - 4.0 * phase;
+}
+
+static const Curve_t curves[] = {
+    {"steady", steadyCurve},
+    {"drift", driftCurve},
+    {"step", stepCurve},
+    {"shower", showerCurve},
+    {"cycle", cycleCurve},
+};
+
+static int32_t noise(int32_t peak){
+
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return (int32_t)(noiseState % (2 * peak + 1)) - peak;
+}
+
+//The curve delayed by shiftMs
+static void generate(const Curve_t *curve, uint32_t shiftMs){
+
+    int i;
+
+    noiseState = 2463534242u;
+    for(i = 0; i < REPLAYPOINTS; i++){
+        curve->curve(((double)i * REPLAYSTEPMS - shiftMs) / 60000.0, &truthC[i], &truthRH[i]);
+        measuredC[i] = (int32_t)lround(truthC[i] * 100) + noise(NOISETEMP);
+        measuredRH[i] = (int32_t)lround(truthRH[i] * 100) + noise(NOISEHUM);
+    }
+}
+
+static void take(Samples_t *samples, uint32_t ms, int32_t value){
+
+    samples->ms[samples->count] = ms;
+    samples->value[samples->count] = value;
+    samples->count++;
+}
+
+static void runFixed(Run_t *run, uint32_t periodMs){
+
+    int i;
+
+    run->reads = 0;
+    run->temperature.count = 0;
+    run->humidity.count = 0;
+    for(i = 0; i < REPLAYPOINTS; i += periodMs / REPLAYSTEPMS){
+        run->reads++;
+        take(&run->temperature, i * REPLAYSTEPMS, measuredC[i]);
+        take(&run->humidity, i * REPLAYSTEPMS, measuredRH[i]);
+    }
+}
+
+//Same decisions as readHDC1080Task in Assign6.c, with both channels
+//settling at floorMs
+static void runAdaptive(Run_t *run, uint32_t floorMs){
+
+    AdaptiveRateConfig_t temperatureConfig = ADAPTIVERATETEMPERATURE;
+    AdaptiveRateConfig_t humidityConfig = ADAPTIVERATEHUMIDITY;
+    AdaptiveRate_t temperatureRate;
+    AdaptiveRate_t humidityRate;
+    uint32_t now;
+    uint64_t nowUs;
+    bool readTemperature;
+    bool readHumidity;
+    int i;
+
+    temperatureConfig.maxPeriodMs = floorMs;
+    humidityConfig.maxPeriodMs = floorMs;
+    run->reads = 0;
+    run->temperature.count = 0;
+    run->humidity.count = 0;
+    adaptiveRateInit(&temperatureRate, &temperatureConfig, 0);
+    adaptiveRateInit(&humidityRate, &humidityConfig, 0);
+
+    for(i = 0; i < REPLAYPOINTS; i++){
+        now = i * REPLAYSTEPMS;
+        nowUs = (uint64_t)now * 1000;
+        readTemperature = adaptiveRateDue(&temperatureRate, nowUs);
+        readHumidity = adaptiveRateDue(&humidityRate, nowUs);
+        if(!readTemperature && !readHumidity){
+            continue;
+        }
+        if(adaptiveRateWaitUs(&temperatureRate, nowUs) <= ADAPTIVERATECOALESCEMS * 1000 &&
+           adaptiveRateWaitUs(&humidityRate, nowUs) <= ADAPTIVERATECOALESCEMS * 1000){
+            readTemperature = true;
+            readHumidity = true;
+        }
+
+        run->reads++;
+        if(readTemperature){
+            take(&run->temperature, now, measuredC[i]);
+            adaptiveRateUpdate(&temperatureRate, measuredC[i], nowUs);
+        }
+        if(readHumidity){
+            take(&run->humidity, now, measuredRH[i]);
+            adaptiveRateUpdate(&humidityRate, measuredRH[i], nowUs);
+        }
+    }
+}
+
+//Interpolate the samples onto the grid and compare with truth, in
+//the units of truth, up to the last sample
+static void reconstructionError(const Samples_t *samples, const double *truth, double *rms, double *worst){
+
+    uint32_t lastMs = samples->ms[samples->count - 1];
+    double sum = 0;
+    double value;
+    double error;
+    uint32_t ms;
+    int next = 0;
+    int i;
+
+    *worst = 0;
+    for(i = 0; i < REPLAYPOINTS && (uint32_t)i * REPLAYSTEPMS <= lastMs; i++){
+        ms = i * REPLAYSTEPMS;
+        while(next < samples->count && samples->ms[next] <= ms){
+            next++;
+        }
+
+        if(next == 0){
+            value = samples->value[0];
+        }
+        else if(next == samples->count){
+            value = samples->value[next - 1];
+        }
+        else{
+            value = samples->value[next - 1] +
+                    (double)(samples->value[next] - samples->value[next - 1]) *
+                    (ms - samples->ms[next - 1]) / (samples->ms[next] - samples->ms[next - 1]);
+        }
+
+        error = fabs(value / 100 - truth[i]);
+        sum += error * error;
+        if(error > *worst){
+            *worst = error;
+        }
+    }
+    *rms = sqrt(sum / i);
+}
+
+static void accumulate(Result_t *result, const Run_t *run){
+
+    double rms;
+    double worst;
+
+    result->reads += run->reads;
+    result->temperatureReads += run->temperature.count;
+    result->humidityReads += run->humidity.count;
+
+    reconstructionError(&run->temperature, truthC, &rms, &worst);
+    result->rmsC = fmax(result->rmsC, rms);
+    result->worstC = fmax(result->worstC, worst);
+    reconstructionError(&run->humidity, truthRH, &rms, &worst);
+    result->rmsRH = fmax(result->rmsRH, rms);
+    result->worstRH = fmax(result->worstRH, worst);
+}
+
+static void report(const char *curve, const char *schedule, const Result_t *result){
+
+    printf("%-8s %-9s %6d %7d %7d %8.3f %8.3f %8.3f %8.3f\n", curve, schedule, result->reads / REPLAYPHASES,
+           result->temperatureReads / REPLAYPHASES, result->humidityReads / REPLAYPHASES, result->rmsC,
+           result->worstC, result->rmsRH, result->worstRH);
+}
+
+//Fixed 10 s, fixed at the adaptive floor and adaptive, on every shift
+//of curve
+static void replay(const Curve_t *curve, uint32_t floorMs, Result_t *fixed, Result_t *slow, Result_t *adaptive){
+
+    int phase;
+
+    memset(fixed, 0, sizeof(*fixed));
+    memset(slow, 0, sizeof(*slow));
+    memset(adaptive, 0, sizeof(*adaptive));
+    for(phase = 0; phase < REPLAYPHASES; phase++){
+        generate(curve, phase * (floorMs / REPLAYPHASES));
+        runFixed(&fixedRun, FIXEDPERIODMS);
+        accumulate(fixed, &fixedRun);
+        runFixed(&fixedRun, floorMs);
+        accumulate(slow, &fixedRun);
+        runAdaptive(&adaptiveRun, floorMs);
+        accumulate(adaptive, &adaptiveRun);
+    }
+}
+
+int main(void){
+
+    static const uint32_t floors[] = {10000, 20000, 30000, 60000};
+    const AdaptiveRateConfig_t config = ADAPTIVERATETEMPERATURE;
+    Result_t fixed;
+    Result_t slow;
+    Result_t adaptive;
+    char slowName[16];
+    int fixedReads;
+    int reads;
+    int steadyReads;
+    double worstC;
+    double worstRH;
+    int failures = 0;
+    size_t i;
+    size_t f;
+
+    snprintf(slowName, sizeof(slowName), "fixed%lus", (unsigned long)(config.maxPeriodMs / 1000));
+    printf("%-8s %-9s %6s %7s %7s %8s %8s %8s %8s\n", "curve", "schedule", "reads",
+           "temp", "hum", "rms_C", "max_C", "rms_RH", "max_RH");
+
+    for(i = 0; i < CURVES; i++){
+        replay(&curves[i], config.maxPeriodMs, &fixed, &slow, &adaptive);
+        report(curves[i].name, "fixed10s", &fixed);
+        report(curves[i].name, slowName, &slow);
+        report(curves[i].name, "adaptive", &adaptive);
+
+        if(adaptive.worstC > slow.worstC + NOISETEMP / 100.0 || adaptive.worstRH > slow.worstRH + NOISEHUM / 100.0){
+            printf("%s: adaptive worst case past %s\n", curves[i].name, slowName);
+            failures++;
+        }
+        if(i == 0 && adaptive.reads >= fixed.reads){
+            printf("%s: adaptive reads no fewer than fixed10s\n", curves[i].name);
+            failures++;
+        }
+    }
+
+    //reads over all the curves against the worst error on any of
+    //them, steady on its own for the settled rate
+    printf("\n%-8s %7s %7s %7s %8s %8s\n", "floor_s", "reads", "of_10s", "steady", "max_C", "max_RH");
+    for(f = 0; f < sizeof(floors) / sizeof(floors[0]); f++){
+        fixedReads = 0;
+        reads = 0;
+        steadyReads = 0;
+        worstC = 0;
+        worstRH = 0;
+        for(i = 0; i < CURVES; i++){
+            replay(&curves[i], floors[f], &fixed, &slow, &adaptive);
+            fixedReads += fixed.reads / REPLAYPHASES;
+            reads += adaptive.reads / REPLAYPHASES;
+            if(i == 0){
+                steadyReads = adaptive.reads / REPLAYPHASES;
+            }
+            worstC = fmax(worstC, adaptive.worstC);
+            worstRH = fmax(worstRH, adaptive.worstRH);
+        }
+        printf("%-8lu %7d %6.0f%% %7d %8.3f %8.3f\n", (unsigned long)(floors[f] / 1000), reads,
+               100.0 * reads / fixedReads, steadyReads, worstC, worstRH);
+    }
+
+    printf("adaptive replay %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,375 @@
+//Torn read stress test and cost of the latest sample cell
+//(sample_cell.h). A writer thread publishes records whose every field
+//is derived from the sample's sequence number while STRESSREADERS
+//reader threads read the cell back; a record mixing two publishes
+//shows up as fields that disagree with its sequence. Sequences must
+//also never go backwards for a reader.
+//
+//Every thread runs flat out, so on a single CPU the scheduler's own
+//preemptions land mid publish and mid read, the only way a copy can
+//tear there. One line for the stress run:
+//
+//  stress readers <n> publishes <n> reads <n> torn <n> backwards <n>
+//
+//then a subscriber sleeping in sampleCellWait while the writer
+//publishes every WAITGAPUS:
+//
+//  wait publishes <n> woken <n> stale <n> torn <n> timeouts <n> cpu_us <n>
+//
+//Every wake must bring a newer, whole record, the last publish must be
+//seen, and the subscriber must sleep rather than spin: its CPU time is
+//held under WAITCPUPERCENT of the run. Then the host cost of an
+//uncontended publish and read, as bench.c measures them on the board.
+//Exits 1 on any failure.
+//
+//Only the FreeRTOS headers are needed, for the types; with
+//SAMPLECELLHOST nothing from the kernel is linked and the task
+//notifications are stood in for here.
+//
+//  K=/path/to/FreeRTOS-Kernel
+//  gcc -O2 -pthread -DSAMPLECELLHOST -I.. -I../sim -I../sim/pico_mock -I$K/include -I$K/portable/ThirdParty/GCC/Posix -o cell_stress cell_stress.c ../sample_cell.c
+//
+//  cell_stress             STRESSMS of publishing
+//  cell_stress <ms>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "sample_cell.h"
+
+#define STRESSMS 2000
+#define STRESSREADERS 3
+#define COSTCALLS 10000000
+#define WAITPUBLISHES 500
+#define WAITGAPUS 2000
+#define WAITCPUPERCENT 10
+
+typedef struct {
+    uint64_t reads;
+    uint64_t torn;
+    uint64_t backwards;
+} Reader_t;
+
+//A subscriber's notification slots
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+} FakeTask_t;
+
+static SampleCell_t cell;
+static volatile bool writerDone;
+static volatile uint32_t sink;
+static FakeTask_t waiterTask = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, {0}};
+static __thread FakeTask_t *currentTask;
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void backOff(void){
+
+    struct timespec pause = {0, 1000};
+
+    nanosleep(&pause, NULL);
+}
+
+static uint64_t threadCpuNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+//Stand ins for the kernel's task notifications, with the kernel's
+//semantics: a give counts up, a take with clear set empties the count
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void){
+
+    return (TaskHandle_t)currentTask;
+}
+
+uint32_t ulTaskGenericNotifyTake(UBaseType_t index, BaseType_t clear, TickType_t ticks){
+
+    FakeTask_t *task = currentTask;
+    struct timespec until;
+    uint64_t untilNs;
+    uint32_t value;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    untilNs = (uint64_t)until.tv_sec * 1000000000u + (uint64_t)until.tv_nsec +
+              (uint64_t)ticks * portTICK_PERIOD_MS * 1000000;
+    until.tv_sec = (time_t)(untilNs / 1000000000u);
+    until.tv_nsec = (long)(untilNs % 1000000000u);
+
+    pthread_mutex_lock(&task->lock);
+    while(task->notify[index] == 0 && pthread_cond_timedwait(&task->cond, &task->lock, &until) == 0){
+    }
+    value = task->notify[index];
+    if(value > 0){
+        task->notify[index] = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+
+    return value;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t handle, UBaseType_t index, uint32_t value, eNotifyAction action,
+                              uint32_t *previous){
+
+    FakeTask_t *to = (FakeTask_t *)handle;
+
+    (void)value;
+    (void)action;
+    (void)previous;
+    pthread_mutex_lock(&to->lock);
+    to->notify[index]++;
+    pthread_cond_signal(&to->cond);
+    pthread_mutex_unlock(&to->lock);
+
+    return pdPASS;
+}
+
+//Every field of publish n, from n alone
+static void makeSample(uint32_t n, HDC1080Sample_t *sample, PsychroMetrics_t *derived){
+
+    sample->rawTemperature = (uint16_t)n;
+    sample->rawHumidity = (uint16_t)~n;
+    sample->centiC = (int32_t)n;
+    sample->centiF = (int32_t)(n * 3);
+    sample->centiRH = -(int32_t)n;
+    sample->temperatureInC = (int)(n * 5);
+    sample->temperatureInF = (int)(n * 7);
+    sample->humidity = (int)(n * 11);
+    sample->flags = (uint8_t)n;
+    derived->centiDewPointC = (int32_t)(n * 13);
+    derived->centiAbsHumidity = (int32_t)(n * 17);
+    derived->centiHeatIndexF = (int32_t)(n * 19);
+}
+
+static bool consistent(const SampleRecord_t *record){
+
+    HDC1080Sample_t sample;
+    PsychroMetrics_t derived;
+    uint32_t n = record->sequence;
+
+    memset(&sample, 0, sizeof(sample));
+    makeSample(n, &sample, &derived);
+
+    return record->sample.rawTemperature == sample.rawTemperature &&
+           record->sample.rawHumidity == sample.rawHumidity && record->sample.centiC == sample.centiC &&
+           record->sample.centiF == sample.centiF && record->sample.centiRH == sample.centiRH &&
+           record->sample.temperatureInC == sample.temperatureInC &&
+           record->sample.temperatureInF == sample.temperatureInF && record->sample.humidity == sample.humidity &&
+           record->sample.flags == sample.flags && record->derived.centiDewPointC == derived.centiDewPointC &&
+           record->derived.centiAbsHumidity == derived.centiAbsHumidity &&
+           record->derived.centiHeatIndexF == derived.centiHeatIndexF && record->timestampUs == (uint64_t)n * 1000 + 7;
+}
+
+static void *writer(void *arg){
+
+    uint64_t endNs = nowNs() + *(const uint64_t *)arg * 1000000;
+    HDC1080Sample_t sample;
+    PsychroMetrics_t derived;
+    uint32_t n = 0;
+
+    memset(&sample, 0, sizeof(sample));
+    while(nowNs() < endNs){
+        n++;
+        makeSample(n, &sample, &derived);
+        sampleCellPublish(&cell, &sample, &derived, (uint64_t)n * 1000 + 7);
+    }
+    __atomic_store_n(&writerDone, true, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void *reader(void *arg){
+
+    Reader_t *result = (Reader_t *)arg;
+    SampleRecord_t record;
+    uint32_t last = 0;
+
+    while(!__atomic_load_n(&writerDone, __ATOMIC_ACQUIRE)){
+        if(!sampleCellRead(&cell, &record)){
+            backOff();
+            continue;
+        }
+        result->reads++;
+        result->torn += !consistent(&record);
+        result->backwards += record.sequence < last;
+        last = record.sequence;
+    }
+
+    return NULL;
+}
+
+typedef struct {
+    uint64_t woken;
+    uint64_t stale;
+    uint64_t torn;
+    uint64_t timeouts;
+    uint32_t last;
+    uint64_t cpuNs;
+} Waiter_t;
+
+static volatile bool waiterReady;
+
+//A subscriber as the report task is: sleeps on the cell until a newer
+//record than the last it saw, until the writer is done and the last
+//publish has been seen
+static void *waiter(void *arg){
+
+    Waiter_t *result = (Waiter_t *)arg;
+    SampleRecord_t record;
+    uint64_t startNs;
+
+    currentTask = &waiterTask;
+    sampleCellSubscribe(&cell);
+    __atomic_store_n(&waiterReady, true, __ATOMIC_RELEASE);
+
+    startNs = threadCpuNs();
+    while(!__atomic_load_n(&writerDone, __ATOMIC_ACQUIRE) || result->last != WAITPUBLISHES){
+        if(!sampleCellWait(&cell, result->last, &record, 10)){
+            result->timeouts++;
+            continue;
+        }
+        result->woken++;
+        result->torn += !consistent(&record);
+        result->stale += record.sequence <= result->last;
+        result->last = record.sequence;
+    }
+    result->cpuNs = threadCpuNs() - startNs;
+
+    return NULL;
+}
+
+//The writer publishing every WAITGAPUS to one subscriber
+static bool waitCheck(void){
+
+    HDC1080Sample_t sample;
+    PsychroMetrics_t derived;
+    struct timespec gap = {0, WAITGAPUS * 1000};
+    Waiter_t result;
+    pthread_t thread;
+    uint64_t startNs;
+    uint64_t runNs;
+    uint32_t n;
+    bool ok;
+
+    sampleCellInit(&cell);
+    memset(&result, 0, sizeof(result));
+    memset(&sample, 0, sizeof(sample));
+    writerDone = false;
+    waiterReady = false;
+    pthread_create(&thread, NULL, waiter, &result);
+    while(!__atomic_load_n(&waiterReady, __ATOMIC_ACQUIRE)){
+        backOff();
+    }
+
+    startNs = nowNs();
+    for(n = 1; n <= WAITPUBLISHES; n++){
+        nanosleep(&gap, NULL);
+        makeSample(n, &sample, &derived);
+        sampleCellPublish(&cell, &sample, &derived, (uint64_t)n * 1000 + 7);
+    }
+    __atomic_store_n(&writerDone, true, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+    runNs = nowNs() - startNs;
+
+    printf("wait publishes %d woken %llu stale %llu torn %llu timeouts %llu cpu_us %llu of %llu\n", WAITPUBLISHES,
+           (unsigned long long)result.woken, (unsigned long long)result.stale, (unsigned long long)result.torn,
+           (unsigned long long)result.timeouts, (unsigned long long)(result.cpuNs / 1000),
+           (unsigned long long)(runNs / 1000));
+    ok = result.woken > 0 && result.stale == 0 && result.torn == 0 && result.last == WAITPUBLISHES &&
+         result.cpuNs * 100 < runNs * WAITCPUPERCENT;
+
+    return ok;
+}
+
+//Uncontended publish and read, host ns per call
+static void cost(void){
+
+    HDC1080Sample_t sample;
+    PsychroMetrics_t derived;
+    SampleRecord_t record;
+    uint64_t startNs;
+    double publishNs;
+    double readNs;
+    int i;
+
+    memset(&sample, 0, sizeof(sample));
+    makeSample(1, &sample, &derived);
+
+    startNs = nowNs();
+    for(i = 0; i < COSTCALLS; i++){
+        sample.centiC = i;
+        sampleCellPublish(&cell, &sample, &derived, (uint64_t)i);
+    }
+    publishNs = (double)(nowNs() - startNs) / COSTCALLS;
+
+    startNs = nowNs();
+    for(i = 0; i < COSTCALLS; i++){
+        sampleCellRead(&cell, &record);
+        sink += record.sequence;
+    }
+    readNs = (double)(nowNs() - startNs) / COSTCALLS;
+
+    printf("host ns per call: publish %.1f read %.1f record %zu bytes\n", publishNs, readNs, sizeof(SampleRecord_t));
+}
+
+int main(int argc, char **argv){
+
+    static Reader_t results[STRESSREADERS];
+    pthread_t readers[STRESSREADERS];
+    pthread_t writerThread;
+    uint64_t ms = STRESSMS;
+    uint64_t reads = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+    bool ok;
+    int i;
+
+    if(argc > 2){
+        fprintf(stderr, "usage: %s [ms]\n", argv[0]);
+        return 2;
+    }
+    if(argc == 2){
+        ms = strtoull(argv[1], NULL, 10);
+    }
+
+    sampleCellInit(&cell);
+    for(i = 0; i < STRESSREADERS; i++){
+        pthread_create(&readers[i], NULL, reader, &results[i]);
+    }
+    pthread_create(&writerThread, NULL, writer, &ms);
+    pthread_join(writerThread, NULL);
+    for(i = 0; i < STRESSREADERS; i++){
+        pthread_join(readers[i], NULL);
+        reads += results[i].reads;
+        torn += results[i].torn;
+        backwards += results[i].backwards;
+    }
+
+    printf("stress readers %d publishes %lu reads %llu torn %llu backwards %llu\n", STRESSREADERS,
+           (unsigned long)cell.record.sequence, (unsigned long long)reads, (unsigned long long)torn,
+           (unsigned long long)backwards);
+    ok = reads > 0 && torn == 0 && backwards == 0;
+
+    ok = waitCheck() && ok;
+
+    cost();
+
+    printf("cell_stress %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,373 @@
+//Host driver for the runtime config commands (runtime_config.h). Runs
+//a script of command lines through the parser the firmware uses, with
+//save and load going to a sector of RAM that behaves like NOR flash,
+//and a second thread standing in for a task that polls the published
+//settings. Each line prints its replies, then for a line that
+//published a new generation:
+//
+//  command_us   parse, checks and publish, in the calling thread
+//  visible_us   from the start of the line until the poller had
+//               read the new generation
+//
+//After the script a writer publishes two different settings in turn
+//while the poller reads them back and checks that every read is one
+//or the other whole, never a mix. A timer signal every SWAPTIMERUS
+//makes whichever thread it lands in yield, so the two interleave
+//mid publish and mid read SWAPINTERRUPTS times even on one CPU. The
+//same swaps then run through a plain unlocked copy as a control,
+//which must show torn reads, or the check could not have seen one.
+//Exits 1 on a torn read of the published settings or a control
+//without any.
+//
+//  gcc -O2 -I.. -DRUNTIMECONFIGHOST -o config_script config_script.c ../runtime_config.c ../sample_filter.c ../telemetry.c -lpthread
+//
+//  config_script               built in script covering every command
+//  config_script <file>        one command per line, # starts a comment
+//  config_script -             the same from stdin
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "runtime_config.h"
+
+#define SWAPTIMERUS 20
+#define SWAPINTERRUPTS 200000
+#define CONTROLINTERRUPTS 20000
+
+static const char *const builtinScript[] = {
+    "get",
+    "set display temp",
+    "set units c",
+    "get display",
+    "apply",
+    "get display",
+    "set oversample 0",
+    "set oversample 17",
+    "set temp_filter median4",
+    "set temp_filter ema3",
+    "set hum_filter avg16",
+    "set hum_res 8",
+    "set temp_res 8",
+    "apply",
+    "set temp_min_ms 40000",
+    "apply",
+    "discard",
+    "set nosuchkey 1",
+    "set dwell_ms",
+    "set",
+    "apply now",
+    "get display units",
+    "launch",
+    "load",
+    "save",
+    "defaults",
+    "apply",
+    "load",
+    "apply",
+    "get",
+    "set output binary extra words",
+    "set output 0123456789012345678901234567890123456789012345678901234567890123456789",
+    NULL
+};
+
+//One sector of NOR flash: erase sets every bit, programming only clears
+static uint8_t sector[FLASHLOGSECTORSIZE];
+
+static bool ramRead(void *ctx, uint32_t offset, void *dst, size_t len){
+
+    (void)ctx;
+    if(offset + len > sizeof(sector)){
+        return false;
+    }
+    memcpy(dst, sector + offset, len);
+    return true;
+}
+
+static bool ramProgram(void *ctx, uint32_t offset, const void *src, size_t len){
+
+    const uint8_t *bytes = src;
+    size_t i;
+
+    (void)ctx;
+    if(offset + len > sizeof(sector)){
+        return false;
+    }
+    for(i = 0; i < len; i++){
+        sector[offset + i] &= bytes[i];
+    }
+    return true;
+}
+
+static bool ramErase(void *ctx, uint32_t offset){
+
+    (void)ctx;
+    if(offset != 0){
+        return false;
+    }
+    memset(sector, 0xFF, sizeof(sector));
+    return true;
+}
+
+static const FlashLogStorage_t ramStorage = {ramRead, ramProgram, ramErase, NULL};
+
+//The poller's view, handed back to the main thread
+static volatile uint32_t seenGeneration;
+static volatile uint64_t seenNs;
+static volatile bool stopPoller;
+
+//Swap check, through the published settings and then through the
+//unlocked control copy
+typedef enum {
+    SWAPOFF,
+    SWAPPUBLISHED,
+    SWAPCONTROL,
+    SWAPPHASES
+} SwapPhase_t;
+
+static RuntimeConfig_t swapA;
+static RuntimeConfig_t swapB;
+static RuntimeConfig_t controlConfig;
+static volatile SwapPhase_t swapPhase;
+static volatile uint32_t interrupts;
+static uint64_t swapReads[SWAPPHASES];
+static uint64_t tornReads[SWAPPHASES];
+
+//Field by field, memcmp would take in padding the copy need not keep
+static bool sameConfig(const RuntimeConfig_t *a, const RuntimeConfig_t *b){
+
+    return memcmp(&a->temperatureRate, &b->temperatureRate, sizeof(a->temperatureRate)) == 0 &&
+           memcmp(&a->humidityRate, &b->humidityRate, sizeof(a->humidityRate)) == 0 &&
+           a->temperatureFilter.type == b->temperatureFilter.type &&
+           a->temperatureFilter.window == b->temperatureFilter.window &&
+           a->humidityFilter.type == b->humidityFilter.type &&
+           a->humidityFilter.window == b->humidityFilter.window &&
+           a->dwellMs == b->dwellMs &&
+           a->oversample == b->oversample &&
+           a->display == b->display &&
+           a->fahrenheit == b->fahrenheit;
+}
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void *poller(void *arg){
+
+    RuntimeConfig_t config;
+    uint32_t generation = 0;
+    SwapPhase_t phase;
+
+    (void)arg;
+    while(!stopPoller){
+        phase = swapPhase;
+
+        //while swapping every pass reads, so a read can start mid
+        //publish as well as be cut into by one
+        if(phase == SWAPPUBLISHED){
+            runtimeConfigRead(&config);
+        }
+        else if(phase == SWAPCONTROL){
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+            config = controlConfig;
+        }
+        else{
+            if(runtimeConfigGeneration() == generation){
+                continue;
+            }
+            generation = runtimeConfigRead(&config);
+            __atomic_store_n(&seenNs, nowNs(), __ATOMIC_RELAXED);
+            __atomic_store_n(&seenGeneration, generation, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        swapReads[phase]++;
+        if(!sameConfig(&config, &swapA) && !sameConfig(&config, &swapB)){
+            tornReads[phase]++;
+        }
+    }
+    return NULL;
+}
+
+//The timer signal: give the CPU up wherever this thread was
+static void interrupt(int sig){
+
+    (void)sig;
+    interrupts++;
+    sched_yield();
+}
+
+static void setTimer(uint32_t us){
+
+    struct itimerval timer;
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = us;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+//Publish swapA and swapB in turn until the timer has cut in count
+//times. Returns the publishes.
+static uint64_t swap(SwapPhase_t phase, uint32_t count){
+
+    uint64_t swaps;
+
+    interrupts = 0;
+    swapPhase = phase;
+    for(swaps = 0; interrupts < count; swaps++){
+        if(phase == SWAPPUBLISHED){
+            runtimeConfigPublish(swaps & 1 ? &swapB : &swapA);
+        }
+        else{
+            controlConfig = swaps & 1 ? swapB : swapA;
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        }
+    }
+    return swaps;
+}
+
+static void printReply(const char *text){
+
+    printf("  %s\n", text);
+}
+
+//Same defaults as configDefaults in Assign6.c
+static void defaultConfig(RuntimeConfig_t *config){
+
+    const AdaptiveRateConfig_t temperatureRate = ADAPTIVERATETEMPERATURE;
+    const AdaptiveRateConfig_t humidityRate = ADAPTIVERATEHUMIDITY;
+    const SampleFilterConfig_t filter = {SAMPLEFILTERMEDIAN, 3, 0};
+
+    memset(config, 0, sizeof(*config));
+    config->temperatureRate = temperatureRate;
+    config->humidityRate = humidityRate;
+    config->temperatureFilter = filter;
+    config->humidityFilter = filter;
+    config->dwellMs = 5000;
+    config->oversample = 4;
+    config->output = RUNTIMECONFIGOUTPUTTEXT;
+    config->display = RUNTIMECONFIGDISPLAYCYCLE;
+    config->fahrenheit = 1;
+}
+
+static void runLine(RuntimeConfigParser_t *parser, const char *line){
+
+    uint64_t start;
+    uint64_t done;
+    uint32_t generation;
+
+    printf("> %s\n", line);
+
+    start = nowNs();
+    if(!runtimeConfigCommand(parser, line, printReply)){
+        return;
+    }
+    done = nowNs();
+
+    generation = runtimeConfigGeneration();
+    while(__atomic_load_n(&seenGeneration, __ATOMIC_ACQUIRE) != generation){
+        sched_yield();      //on one CPU the poller needs it to run
+    }
+    printf("  command_us=%.1f visible_us=%.1f\n", (done - start) / 1e3,
+           (__atomic_load_n(&seenNs, __ATOMIC_RELAXED) - start) / 1e3);
+}
+
+int main(int argc, char **argv){
+
+    RuntimeConfigParser_t parser;
+    RuntimeConfig_t defaults;
+    pthread_t thread;
+    struct sigaction action;
+    FILE *script = NULL;
+    char line[256];
+    size_t length;
+    uint64_t swaps;
+    uint64_t controlSwaps;
+    bool ok;
+    int i;
+
+    if(argc > 2){
+        fprintf(stderr, "usage: %s [script|-]\n", argv[0]);
+        return 2;
+    }
+    if(argc == 2){
+        script = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+        if(script == NULL){
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    memset(sector, 0xFF, sizeof(sector));
+    defaultConfig(&defaults);
+    if(runtimeConfigCheck(&defaults) != NULL){
+        fprintf(stderr, "defaults fail the checks: %s\n", runtimeConfigCheck(&defaults));
+        return 1;
+    }
+    runtimeConfigInit(&defaults);
+    runtimeConfigParserInit(&parser, &defaults, &ramStorage);
+    seenGeneration = runtimeConfigGeneration();
+
+    pthread_create(&thread, NULL, poller, NULL);
+
+    if(script == NULL){
+        for(i = 0; builtinScript[i] != NULL; i++){
+            runLine(&parser, builtinScript[i]);
+        }
+    }
+    else{
+        while(fgets(line, sizeof(line), script) != NULL){
+            length = strcspn(line, "\r\n");
+            line[length] = '\0';
+            if(line[0] != '#' && length > 0){
+                runLine(&parser, line);
+            }
+        }
+    }
+
+    //two settings that differ from end to end, published in turn
+    defaultConfig(&swapA);
+    memset(&swapB, 0, sizeof(swapB));
+    swapB.display = RUNTIMECONFIGDISPLAYHUMIDITY;
+    swapB.temperatureRate.minPeriodMs = swapB.temperatureRate.maxPeriodMs = 100;
+    swapB.humidityRate.minPeriodMs = swapB.humidityRate.maxPeriodMs = 100;
+    swapB.temperatureRate.thresholdPerMin = swapB.humidityRate.thresholdPerMin = 1;
+    swapB.dwellMs = 60000;
+    swapB.oversample = 16;
+    controlConfig = swapA;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = interrupt;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &action, NULL);
+    setTimer(SWAPTIMERUS);
+
+    swaps = swap(SWAPPUBLISHED, SWAPINTERRUPTS);
+    controlSwaps = swap(SWAPCONTROL, CONTROLINTERRUPTS);
+
+    setTimer(0);
+    stopPoller = true;
+    pthread_join(thread, NULL);
+
+    ok = tornReads[SWAPPUBLISHED] == 0 && tornReads[SWAPCONTROL] > 0;
+    printf("swap: %llu publishes, %llu reads, %d interrupts, %llu torn\n", (unsigned long long)swaps,
+           (unsigned long long)swapReads[SWAPPUBLISHED], SWAPINTERRUPTS,
+           (unsigned long long)tornReads[SWAPPUBLISHED]);
+    printf("control: %llu unlocked copies, %llu reads, %d interrupts, %llu torn\n",
+           (unsigned long long)controlSwaps, (unsigned long long)swapReads[SWAPCONTROL], CONTROLINTERRUPTS,
+           (unsigned long long)tornReads[SWAPCONTROL]);
+    printf("config_script %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,557 @@
+//Host check of the non-blocking console (console.h): the ring between
+//the tasks on core 0 and the USB writer on core 1. consoleService's
+//output, stdout on the board's stdio, is captured in a temporary file
+//and read back.
+//
+//  stall       USB stops being serviced: the ring fills, every message
+//              past it is dropped and counted and the producer never
+//              waits; once serviced the queued messages come out whole
+//              and in order, then the drop report, then new messages
+//  limits      a line longer than a message is cut to fit, a binary
+//              frame of every byte value comes out as is, and one too
+//              long to send is dropped and counted
+//  threads     two producer threads against a consumer thread that
+//              stalls now and then: every message that arrives is
+//              whole, each producer's arrive in order, and arrived
+//              plus dropped is what was sent, with every drop reported
+//  jitter      a producer sending one line per JITTERPERIODUS on an
+//              absolute schedule, as the reading task does, first with
+//              the consumer servicing and then with it stalled for the
+//              whole run: with the ring full and every line dropped,
+//              no send takes more than SENDBOUNDUS at the 99th
+//              percentile. How late the slots start is printed for
+//              both; on the host it is the host scheduler's noise, so
+//              it is not held to a bound
+//
+//One line per check, then a summary. Exits 1 on any failure.
+//
+//Only the FreeRTOS headers are needed; the scheduler suspend console.c
+//serialises producers with, __sev and the event trace are stood in
+//for here.
+//
+//  K=/path/to/FreeRTOS-Kernel
+//  gcc -O2 -pthread -I.. -I../sim -I../sim/pico_mock -I$K/include -I$K/portable/ThirdParty/GCC/Posix -o console_check console_check.c ../console.c ../spsc_ring.c
+//
+//  console_check               THREADMESSAGES per producer
+//  console_check <count>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "console.h"
+
+#define THREADMESSAGES 100000
+#define THREADPRODUCERS 2
+#define PRODUCERPAUSE 8             //messages between pauses
+#define CONSUMERSTALLEVERY 500      //services between stalls
+#define CONSUMERSTALLUS 2000
+#define JITTERSAMPLES 2000
+#define JITTERPERIODUS 1000
+#define SENDBOUNDUS 100
+#define CAPTUREMAX (64 * 1024 * 1024)
+
+typedef struct {
+    int id;
+    uint32_t count;
+    uint32_t sent;
+    uint32_t dropped;
+} Producer_t;
+
+typedef struct {
+    bool stall;
+    uint32_t dropped;
+    uint64_t sendNs[JITTERSAMPLES];
+    uint64_t lateNs[JITTERSAMPLES];
+} Sampler_t;
+
+static pthread_mutex_t scheduler = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool producersDone;
+static volatile bool samplerDone;
+static char *captured;
+static size_t capturedLength;
+static int savedStdout;
+static FILE *capture;
+static int failures;
+
+//Stand ins for what console.c takes from the kernel and the SDK
+
+void vTaskSuspendAll(void){
+
+    pthread_mutex_lock(&scheduler);
+}
+
+BaseType_t xTaskResumeAll(void){
+
+    pthread_mutex_unlock(&scheduler);
+    return pdFALSE;
+}
+
+void __sev(void){
+}
+
+void stdio_flush(void){
+
+    fflush(stdout);
+}
+
+int putchar_raw(int c){
+
+    return putchar(c);
+}
+
+void eventTraceRecord(uint8_t type, uint8_t arg8, uint16_t arg16){
+
+    (void)type;
+    (void)arg8;
+    (void)arg16;
+}
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-8s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+//Send stdout to a temporary file until captureEnd, which reads it
+//back into captured
+static void captureStart(void){
+
+    fflush(stdout);
+    capture = tmpfile();
+    savedStdout = dup(STDOUT_FILENO);
+    dup2(fileno(capture), STDOUT_FILENO);
+}
+
+static void captureEnd(void){
+
+    long length;
+
+    fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+
+    fseek(capture, 0, SEEK_END);
+    length = ftell(capture);
+    if(length > CAPTUREMAX){
+        length = CAPTUREMAX;
+    }
+    rewind(capture);
+    free(captured);
+    captured = malloc((size_t)length + 1);
+    capturedLength = fread(captured, 1, (size_t)length, capture);
+    captured[capturedLength] = '\0';
+    fclose(capture);
+}
+
+static void pauseUs(long us){
+
+    struct timespec pause = {0, us * 1000};
+
+    nanosleep(&pause, NULL);
+}
+
+//Message n of producer id: its sequence, then filler whose length and
+//bytes follow from both, then a check over the filler
+static int formatMessage(char *line, size_t size, int id, uint32_t n){
+
+    char filler[160];
+    uint32_t check = 2166136261u;
+    int length = (int)((n * 37 + (uint32_t)id * 11) % (sizeof(filler) - 1));
+    int i;
+
+    for(i = 0; i < length; i++){
+        filler[i] = (char)('a' + (n + (uint32_t)i * 7 + (uint32_t)id) % 26);
+        check = (check ^ (uint8_t)filler[i]) * 16777619u;
+    }
+    filler[length] = '\0';
+
+    return snprintf(line, size, "m %d %lu %s %08lx\n", id, (unsigned long)n, filler, (unsigned long)check);
+}
+
+//Parse one captured line. Returns 1 for a whole message, 2 for a drop
+//report, 0 for anything else.
+static int parseLine(const char *line, size_t length, int *id, uint32_t *n, uint32_t *dropped){
+
+    char expected[CONSOLEMESSAGEMAX];
+    unsigned long value;
+    int expectedLength;
+
+    if(sscanf(line, "console: %lu messages dropped", &value) == 1){
+        *dropped = (uint32_t)value;
+        return 2;
+    }
+    if(sscanf(line, "m %d %lu", id, &value) != 2 || *id < 0 || *id >= THREADPRODUCERS){
+        return 0;
+    }
+    *n = (uint32_t)value;
+    expectedLength = formatMessage(expected, sizeof(expected), *id, *n);
+
+    return (size_t)expectedLength == length + 1 && memcmp(expected, line, length) == 0 ? 1 : 0;
+}
+
+static void checkStall(void){
+
+    char line[CONSOLEMESSAGEMAX];
+    char detail[128];
+    uint32_t accepted = 0;
+    uint32_t refused = 0;
+    uint32_t dropped = 0;
+    uint32_t order = 0;
+    uint32_t n;
+    int lines = 0;
+    int bad = 0;
+    int serviced;
+    int freeAtFull;
+    int kind;
+    int id;
+    char *at;
+    char *end;
+
+    consoleInit();
+
+    //nothing services the ring: it fills, then every send is refused
+    for(n = 0; n < 3 * CONSOLESLOTS; n++){
+        formatMessage(line, sizeof(line), 0, n);
+        if(consolePrintf("%s", line)){
+            accepted++;
+        }
+        else{
+            refused++;
+        }
+    }
+    freeAtFull = consoleFree();
+
+    captureStart();
+    serviced = consoleService();
+    formatMessage(line, sizeof(line), 0, 3 * CONSOLESLOTS);
+    consolePrintf("%s", line);
+    serviced += consoleService();
+    captureEnd();
+
+    //the queued messages in order, the report after the first of them,
+    //then the one sent once there was room
+    for(at = captured; *at != '\0'; at = end + 1){
+        end = strchr(at, '\n');
+        if(end == NULL){
+            bad++;
+            break;
+        }
+        *end = '\0';           //or sscanf reads to the end of the capture
+        lines++;
+        kind = parseLine(at, (size_t)(end - at), &id, &n, &dropped);
+        if(kind == 1){
+            bad += n != (order < CONSOLESLOTS ? order : 3 * CONSOLESLOTS);
+            order++;
+        }
+        else if(kind == 2){
+            bad += lines != 2;
+        }
+        else{
+            bad++;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "accepted %lu refused %lu dropped %lu reported %lu, %d lines %d bad",
+             (unsigned long)accepted, (unsigned long)refused, (unsigned long)consoleDropped(),
+             (unsigned long)dropped, lines, bad);
+    result("stall", accepted == CONSOLESLOTS && refused == 2 * CONSOLESLOTS && freeAtFull == 0 &&
+           consoleDropped() == 2 * CONSOLESLOTS && dropped == 2 * CONSOLESLOTS && serviced == CONSOLESLOTS + 1 &&
+           order == CONSOLESLOTS + 1 && lines == CONSOLESLOTS + 2 && bad == 0, detail);
+}
+
+static void checkLimits(void){
+
+    char longLine[2 * CONSOLEMESSAGEMAX];
+    uint8_t frame[CONSOLEMESSAGEMAX + 1];
+    char detail[128];
+    bool cut;
+    bool whole;
+    bool refused;
+    int i;
+
+    consoleInit();
+    for(i = 0; i < (int)sizeof(frame); i++){
+        frame[i] = (uint8_t)i;
+    }
+    memset(longLine, 'x', sizeof(longLine) - 1);
+    longLine[sizeof(longLine) - 1] = '\0';
+
+    captureStart();
+    consolePrintf("%s", longLine);
+    consoleService();
+    captureEnd();
+    cut = capturedLength == CONSOLEMESSAGEMAX - 1 && strspn(captured, "x") == CONSOLEMESSAGEMAX - 1;
+
+    captureStart();
+    consoleWrite(frame, CONSOLEMESSAGEMAX);
+    consoleService();
+    captureEnd();
+    whole = capturedLength == CONSOLEMESSAGEMAX && memcmp(captured, frame, CONSOLEMESSAGEMAX) == 0;
+
+    refused = !consoleWrite(frame, CONSOLEMESSAGEMAX + 1) && consoleDropped() == 1;
+
+    snprintf(detail, sizeof(detail), "line cut to %d, frame of %d bytes %s, frame of %d %s", CONSOLEMESSAGEMAX - 1,
+             CONSOLEMESSAGEMAX, whole ? "whole" : "changed", CONSOLEMESSAGEMAX + 1,
+             refused ? "dropped" : "not dropped");
+    result("limits", cut && whole && refused, detail);
+}
+
+static void *producer(void *arg){
+
+    Producer_t *self = (Producer_t *)arg;
+    char line[CONSOLEMESSAGEMAX];
+    uint32_t n;
+
+    for(n = 0; n < self->count; n++){
+        formatMessage(line, sizeof(line), self->id, n);
+        if(consolePrintf("%s", line)){
+            self->sent++;
+        }
+        else{
+            self->dropped++;
+        }
+
+        //as a task would between lines, and so the consumer runs
+        //on a single CPU
+        if(n % PRODUCERPAUSE == 0){
+            pauseUs(1);
+        }
+    }
+
+    return NULL;
+}
+
+static void *consumer(void *arg){
+
+    uint32_t services = 0;
+
+    (void)arg;
+    while(!__atomic_load_n(&producersDone, __ATOMIC_ACQUIRE)){
+        if(consoleService() == 0){
+            pauseUs(1);
+        }
+        else if(++services % CONSUMERSTALLEVERY == 0){
+            pauseUs(CONSUMERSTALLUS);
+        }
+    }
+    consoleService();
+
+    return NULL;
+}
+
+static void checkThreads(uint32_t count){
+
+    Producer_t producers[THREADPRODUCERS];
+    pthread_t producerThreads[THREADPRODUCERS];
+    pthread_t consumerThread;
+    uint32_t next[THREADPRODUCERS] = {0};
+    uint32_t arrived = 0;
+    uint32_t reported = 0;
+    uint32_t sent = 0;
+    uint32_t dropped = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t bad = 0;
+    uint32_t value = 0;
+    uint32_t n;
+    char detail[160];
+    char *at;
+    char *end;
+    int kind;
+    int id;
+    int i;
+
+    consoleInit();
+    producersDone = false;
+
+    captureStart();
+    pthread_create(&consumerThread, NULL, consumer, NULL);
+    for(i = 0; i < THREADPRODUCERS; i++){
+        producers[i] = (Producer_t){i, count, 0, 0};
+        pthread_create(&producerThreads[i], NULL, producer, &producers[i]);
+    }
+    for(i = 0; i < THREADPRODUCERS; i++){
+        pthread_join(producerThreads[i], NULL);
+    }
+    __atomic_store_n(&producersDone, true, __ATOMIC_RELEASE);
+    pthread_join(consumerThread, NULL);
+
+    //drops are reported with the next message written
+    consolePrintf("end\n");
+    consoleService();
+    captureEnd();
+
+    for(at = captured; *at != '\0'; at = end + 1){
+        end = strchr(at, '\n');
+        if(end == NULL){
+            bad++;
+            break;
+        }
+        *end = '\0';           //or sscanf reads to the end of the capture
+        kind = parseLine(at, (size_t)(end - at), &id, &n, &value);
+        if(kind == 1){
+            outOfOrder += n < next[id];
+            next[id] = n + 1;
+            arrived++;
+        }
+        else if(kind == 2){
+            reported += value;
+        }
+        else if(strncmp(at, "end", 3) != 0){
+            bad++;
+        }
+    }
+
+    for(i = 0; i < THREADPRODUCERS; i++){
+        sent += producers[i].sent;
+        dropped += producers[i].dropped;
+    }
+
+    snprintf(detail, sizeof(detail), "sent %lu arrived %lu dropped %lu reported %lu out_of_order %lu bad %lu",
+             (unsigned long)(sent + dropped), (unsigned long)arrived, (unsigned long)consoleDropped(),
+             (unsigned long)reported, (unsigned long)outOfOrder, (unsigned long)bad);
+    result("threads", sent + dropped == THREADPRODUCERS * count && arrived == sent && consoleDropped() == dropped &&
+           reported == dropped && outOfOrder == 0 && bad == 0, detail);
+}
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int compareNs(const void *a, const void *b){
+
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t p99(uint64_t *ns, int count){
+
+    qsort(ns, (size_t)count, sizeof(ns[0]), compareNs);
+    return ns[count * 99 / 100];
+}
+
+//The reading task: a line per slot on an absolute grid, timing how
+//late each slot starts and how long each send holds the sampler
+static void *sampler(void *arg){
+
+    Sampler_t *self = (Sampler_t *)arg;
+    struct timespec slot;
+    uint64_t slotNs;
+    uint64_t startNs;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &slot);
+    slotNs = (uint64_t)slot.tv_sec * 1000000000u + (uint64_t)slot.tv_nsec;
+    for(i = 0; i < JITTERSAMPLES; i++){
+        slotNs += JITTERPERIODUS * 1000u;
+        slot.tv_sec = (time_t)(slotNs / 1000000000u);
+        slot.tv_nsec = (long)(slotNs % 1000000000u);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &slot, NULL);
+
+        startNs = nowNs();
+        self->lateNs[i] = startNs - slotNs;
+        if(!consolePrintf("Temperature in C: %d.%02d sample %d\n", 22, i % 100, i)){
+            self->dropped++;
+        }
+        self->sendNs[i] = nowNs() - startNs;
+    }
+
+    return NULL;
+}
+
+//USB writer that keeps up, or one stalled for the whole run
+static void *jitterConsumer(void *arg){
+
+    Sampler_t *sampling = (Sampler_t *)arg;
+
+    while(!__atomic_load_n(&samplerDone, __ATOMIC_ACQUIRE)){
+        if(sampling->stall || consoleService() == 0){
+            pauseUs(100);
+        }
+    }
+
+    return NULL;
+}
+
+static void runSampler(Sampler_t *sampling){
+
+    pthread_t samplerThread;
+    pthread_t consumerThread;
+
+    consoleInit();
+    samplerDone = false;
+    sampling->dropped = 0;
+
+    captureStart();
+    pthread_create(&consumerThread, NULL, jitterConsumer, sampling);
+    pthread_create(&samplerThread, NULL, sampler, sampling);
+    pthread_join(samplerThread, NULL);
+    __atomic_store_n(&samplerDone, true, __ATOMIC_RELEASE);
+    pthread_join(consumerThread, NULL);
+    consoleService();
+    captureEnd();
+}
+
+static void checkJitter(void){
+
+    static Sampler_t serviced = {false, 0, {0}, {0}};
+    static Sampler_t stalled = {true, 0, {0}, {0}};
+    uint64_t servicedSend;
+    uint64_t servicedLate;
+    uint64_t stalledSend;
+    uint64_t stalledLate;
+    char detail[192];
+
+    runSampler(&serviced);
+    runSampler(&stalled);
+
+    servicedSend = p99(serviced.sendNs, JITTERSAMPLES);
+    servicedLate = p99(serviced.lateNs, JITTERSAMPLES);
+    stalledSend = p99(stalled.sendNs, JITTERSAMPLES);
+    stalledLate = p99(stalled.lateNs, JITTERSAMPLES);
+
+    snprintf(detail, sizeof(detail),
+             "p99 serviced send_us %.1f late_us %.1f, stalled send_us %.1f late_us %.1f, %lu of %d dropped",
+             servicedSend / 1e3, servicedLate / 1e3, stalledSend / 1e3, stalledLate / 1e3,
+             (unsigned long)stalled.dropped, JITTERSAMPLES);
+    result("jitter", serviced.dropped == 0 && stalled.dropped == JITTERSAMPLES - CONSOLESLOTS &&
+           stalledSend <= SENDBOUNDUS * 1000u, detail);
+}
+
+int main(int argc, char **argv){
+
+    uint32_t count = THREADMESSAGES;
+
+    if(argc > 2){
+        fprintf(stderr, "usage: %s [count]\n", argv[0]);
+        return 2;
+    }
+    if(argc == 2){
+        count = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    checkStall();
+    checkLimits();
+    checkThreads(count);
+    checkJitter();
+
+    free(captured);
+    printf("console_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
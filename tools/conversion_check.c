@@ -0,0 +1,152 @@
+//Host check of the fixed point raw code conversions (conversion.h)
+//against the datasheet formulas in double precision, for every one of
+//the 65536 raw codes. One line per conversion:
+//
+//  conv <name> codes <n> mismatches <n> max_err <x> worst_raw <n>
+//
+//  mismatches  results that differ from round() of the exact value
+//  max_err     largest distance from the exact, unrounded value, in
+//              the result's units: half a unit at most when rounding
+//              is right
+//  worst_raw   the code it was seen at
+//
+//then the host time per call over all the codes. bench.c times them,
+//and in cycles, on the board. Exits 1 on any mismatch.
+//
+//  gcc -O2 -I.. -o conversion_check conversion_check.c ../conversion.c -lm
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "conversion.h"
+
+#define TIMINGLAPS 1000
+
+typedef struct {
+    const char *name;
+    int32_t (*convert)(uint16_t raw);
+    double scale;                       //raw * scale / 2^16 - offset
+    double offset;
+    double units;                       //result units per degree / percent
+} Conversion_t;
+
+static int32_t centiC(uint16_t raw){
+
+    return convRawToCentiC(raw);
+}
+
+static int32_t centiF(uint16_t raw){
+
+    return convRawToCentiF(raw);
+}
+
+static int32_t centiRH(uint16_t raw){
+
+    return convRawToCentiRH(raw);
+}
+
+static int32_t wholeC(uint16_t raw){
+
+    return convRawToC(raw);
+}
+
+static int32_t wholeF(uint16_t raw){
+
+    return convRawToF(raw);
+}
+
+static int32_t wholeRH(uint16_t raw){
+
+    return convRawToRH(raw);
+}
+
+static const Conversion_t conversions[] = {
+    {"centi_c", centiC, CONVTEMPCSCALE, CONVTEMPOFFSET, 100},
+    {"centi_f", centiF, CONVTEMPFSCALE, CONVTEMPOFFSET, 100},
+    {"centi_rh", centiRH, CONVHUMSCALE, 0, 100},
+    {"c", wholeC, CONVTEMPCSCALE, CONVTEMPOFFSET, 1},
+    {"f", wholeF, CONVTEMPFSCALE, CONVTEMPOFFSET, 1},
+    {"rh", wholeRH, CONVHUMSCALE, 0, 1},
+};
+
+static volatile int32_t sink;
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+//Every code against the formula. raw * scale * units fits the 53 bit
+//mantissa and the division is by a power of two, so the double value
+//is exact and round() of it is the right answer.
+static bool check(const Conversion_t *conversion){
+
+    uint32_t mismatches = 0;
+    uint32_t worstRaw = 0;
+    double maxErr = 0;
+    double exact;
+    double err;
+    int32_t got;
+    uint32_t raw;
+
+    for(raw = 0; raw <= UINT16_MAX; raw++){
+        exact = (raw * conversion->scale / 65536 - conversion->offset) * conversion->units;
+        got = conversion->convert((uint16_t)raw);
+
+        mismatches += got != (int32_t)round(exact);
+        err = fabs(got - exact);
+        if(err > maxErr){
+            maxErr = err;
+            worstRaw = raw;
+        }
+    }
+
+    printf("conv %-8s codes %u mismatches %lu max_err %.4f worst_raw %lu\n", conversion->name, UINT16_MAX + 1,
+           (unsigned long)mismatches, maxErr, (unsigned long)worstRaw);
+    return mismatches == 0;
+}
+
+static void timing(void){
+
+    uint64_t startNs;
+    uint32_t sum = 0;
+    size_t i;
+    uint32_t raw;
+    int lap;
+
+    printf("host ns per call:");
+    for(i = 0; i < sizeof(conversions) / sizeof(conversions[0]); i++){
+        startNs = nowNs();
+        for(lap = 0; lap < TIMINGLAPS; lap++){
+            for(raw = 0; raw <= UINT16_MAX; raw++){
+                sum += (uint32_t)conversions[i].convert((uint16_t)raw);
+            }
+        }
+        printf(" %s %.2f", conversions[i].name,
+               (double)(nowNs() - startNs) / ((double)TIMINGLAPS * (UINT16_MAX + 1)));
+    }
+    printf("\n");
+    sink = (int32_t)sum;
+}
+
+int main(void){
+
+    bool ok = true;
+    size_t i;
+
+    for(i = 0; i < sizeof(conversions) / sizeof(conversions[0]); i++){
+        ok &= check(&conversions[i]);
+    }
+
+    timing();
+
+    printf("conversion_check %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+//Host check of the 7 segment frame encoding (display_frame.h), the
+//words the PIO shifts out to the multiplexed digits.
+//
+//  table       the digit table against the usual 7 segment patterns,
+//              no decimal point lit
+//  decode      displayDecodeSegments recovers every one of the 256
+//              segment sets from its pin image
+//  digits      0 - 99 show both digits, leading zero included, each
+//              word selecting its own digit and no pin outside the
+//              display's
+//  negative    -9 to -1 show a dash then the digit
+//  dash        DISPLAYNOVALUE and anything out of range show "--"
+//  blank       a cleared frame, what the PIO drives before the first
+//              value, lights no segment and selects no digit
+//  changed     displayEncode reports a change only when a word changed
+//
+//One line per check, then a summary. Exits 1 on any failure.
+//
+//  gcc -O2 -I.. -o display_frame_check display_frame_check.c ../display_frame.c
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+
+#include "display_frame.h"
+
+//gfedcba, the common 7 segment font
+static const uint8_t font[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+//Digit select pins, in multiplex order
+static const uint32_t selectPins[DISPLAYDIGITS] = {1u << SevenSegCC2, 1u << SevenSegCC1};
+
+static const int outOfRange[] = {DISPLAYNOVALUE, 100, 1000, -10, -99, INT_MAX, INT_MIN};
+
+static int failures;
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-10s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+//Word i of frame shows segments on its own digit, with no stray pins
+static bool shows(const DisplayFrame_t *frame, int i, uint8_t segments){
+
+    uint32_t pins = frame->word[i] << DISPLAYPINBASE;
+
+    return displayDecodeSegments(frame->word[i]) == segments && (pins & selectPins[i]) != 0 &&
+           (pins & selectPins[1 - i]) == 0 && (pins & ~DISPLAYPINMASK) == 0;
+}
+
+static void checkTable(void){
+
+    char detail[64] = "";
+    bool ok = true;
+    int d;
+
+    for(d = 0; d < 10; d++){
+        if(displayDigitSegments[d] != font[d]){
+            snprintf(detail, sizeof(detail), "digit %d is 0x%02X, not 0x%02X", d, displayDigitSegments[d], font[d]);
+            ok = false;
+            break;
+        }
+    }
+    result("table", ok, detail);
+}
+
+static void checkDecode(void){
+
+    char detail[64] = "";
+    bool ok = true;
+    int s;
+
+    for(s = 0; s < 256; s++){
+        if(displayDecodeSegments(SEGPINS(s) >> DISPLAYPINBASE) != s){
+            snprintf(detail, sizeof(detail), "segments 0x%02X decode as 0x%02X", s,
+                     displayDecodeSegments(SEGPINS(s) >> DISPLAYPINBASE));
+            ok = false;
+            break;
+        }
+    }
+    result("decode", ok, detail);
+}
+
+static void checkDigits(void){
+
+    DisplayFrame_t frame;
+    char detail[64] = "";
+    bool ok = true;
+    int value;
+
+    memset(&frame, 0, sizeof(frame));
+    for(value = 0; value <= 99; value++){
+        displayEncode(value, &frame);
+        if(!shows(&frame, 0, font[value / 10]) || !shows(&frame, 1, font[value % 10])){
+            snprintf(detail, sizeof(detail), "%d shows 0x%02X 0x%02X", value, displayDecodeSegments(frame.word[0]),
+                     displayDecodeSegments(frame.word[1]));
+            ok = false;
+            break;
+        }
+    }
+    result("digits", ok, detail);
+}
+
+static void checkNegative(void){
+
+    DisplayFrame_t frame;
+    char detail[64] = "";
+    bool ok = true;
+    int value;
+
+    memset(&frame, 0, sizeof(frame));
+    for(value = -9; value < 0; value++){
+        displayEncode(value, &frame);
+        if(!shows(&frame, 0, SEGDASH) || !shows(&frame, 1, font[-value])){
+            snprintf(detail, sizeof(detail), "%d shows 0x%02X 0x%02X", value, displayDecodeSegments(frame.word[0]),
+                     displayDecodeSegments(frame.word[1]));
+            ok = false;
+            break;
+        }
+    }
+    result("negative", ok, detail);
+}
+
+static void checkDash(void){
+
+    DisplayFrame_t frame;
+    char detail[64] = "";
+    bool ok = true;
+    size_t i;
+
+    for(i = 0; i < sizeof(outOfRange) / sizeof(outOfRange[0]); i++){
+        memset(&frame, 0, sizeof(frame));
+        displayEncode(outOfRange[i], &frame);
+        if(!shows(&frame, 0, SEGDASH) || !shows(&frame, 1, SEGDASH)){
+            snprintf(detail, sizeof(detail), "%d shows 0x%02X 0x%02X", outOfRange[i],
+                     displayDecodeSegments(frame.word[0]), displayDecodeSegments(frame.word[1]));
+            ok = false;
+            break;
+        }
+    }
+    result("dash", ok, detail);
+}
+
+static void checkBlank(void){
+
+    DisplayFrame_t frame;
+    bool ok;
+
+    memset(&frame, 0, sizeof(frame));
+    ok = displayDecodeSegments(frame.word[0]) == SEGBLANK && displayDecodeSegments(frame.word[1]) == SEGBLANK &&
+         ((frame.word[0] | frame.word[1]) << DISPLAYPINBASE & (selectPins[0] | selectPins[1])) == 0;
+    result("blank", ok, "");
+}
+
+static void checkChanged(void){
+
+    DisplayFrame_t frame;
+    bool ok;
+
+    memset(&frame, 0, sizeof(frame));
+    ok = displayEncode(42, &frame);
+    ok = !displayEncode(42, &frame) && ok;
+    ok = displayEncode(43, &frame) && ok;       //right digit only
+    ok = displayEncode(DISPLAYNOVALUE, &frame) && ok;
+    ok = !displayEncode(-10, &frame) && ok;     //dashes again
+    result("changed", ok, "");
+}
+
+int main(void){
+
+    checkTable();
+    checkDecode();
+    checkDigits();
+    checkNegative();
+    checkDash();
+    checkBlank();
+    checkChanged();
+
+    printf("display_frame_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+//Host check of the sample filters (sample_filter.h) on noisy
+//synthetic raw codes. The input is a steady level, a step and a ramp
+//with Gaussian-ish sensor noise, 14 bit quantisation and the odd spike.
+//For every filter config, with and without oversampling, it prints:
+//
+//  rms_lsb   error against the noiseless input over the steady part,
+//            in 16 bit codes (1 code = 2.5 mC)
+//  gain      noise reduction against the unfiltered codes
+//  lag90     readings until a step is 90% through
+//  ns        host time per sampleFilterAdd call
+//
+//Each config has a floor on its gain and a ceiling on its lag90, a
+//little outside what it gives on this fixed input: a filter that
+//stops smoothing, or smooths by no longer following a step, fails.
+//Exits 1 if any config is outside either.
+//
+//  gcc -O2 -I.. -o filter_check filter_check.c ../sample_filter.c -lm
+//
+//  filter_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "sample_filter.h"
+
+#define CHECKREADINGS 20000
+#define STEADYEND 8000
+#define STEPAT 10000
+#define RAMPAT 15000
+#define LEVEL 25000
+#define STEPSIZE 400
+#define NOISESIGMA 8.0
+#define SPIKEEVERY 500
+#define SPIKESIZE 400
+#define TIMINGCALLS 10000000
+
+typedef struct {
+    const char *name;
+    SampleFilterConfig_t config;
+    int oversample;
+    double minGain;
+    int maxLag;
+} Check_t;
+
+static const Check_t checks[] = {
+    {"none", {SAMPLEFILTERNONE, 0, 0}, 1, 0.95, 1},
+    {"average4", {SAMPLEFILTERAVERAGE, 4, 0}, 1, 1.8, 4},
+    {"average16", {SAMPLEFILTERAVERAGE, 16, 0}, 1, 3.4, 16},
+    {"ema2", {SAMPLEFILTEREMA, 0, 2}, 1, 2.3, 10},
+    {"ema4", {SAMPLEFILTEREMA, 0, 4}, 1, 4.5, 40},
+    {"median3", {SAMPLEFILTERMEDIAN, 3, 0}, 1, 2.7, 2},
+    {"median9", {SAMPLEFILTERMEDIAN, 9, 0}, 1, 4.2, 5},
+    {"x4 none", {SAMPLEFILTERNONE, 0, 0}, 4, 1.6, 1},
+    {"x4 median3", {SAMPLEFILTERMEDIAN, 3, 0}, 4, 4.5, 2},
+    {"x4 ema2", {SAMPLEFILTEREMA, 0, 2}, 4, 4.0, 10},
+};
+
+static uint32_t noiseState;
+static volatile uint16_t sink;
+
+static double uniform(void){
+
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return noiseState / 4294967296.0;
+}
+
+static double truth(int reading){
+
+    if(reading >= RAMPAT){
+        return LEVEL + STEPSIZE + (reading - RAMPAT) * 0.1;
+    }
+    if(reading >= STEPAT){
+        return LEVEL + STEPSIZE;
+    }
+    return LEVEL;
+}
+
+//One conversion: noise from the sum of 12 uniforms, a spike now and
+//then, and the two low bits the 14 bit ADC does not fill
+static uint16_t convert(int reading){
+
+    double value = truth(reading);
+    double sum = 0;
+    int i;
+
+    for(i = 0; i < 12; i++){
+        sum += uniform();
+    }
+    value += (sum - 6) * NOISESIGMA;
+    if(uniform() * SPIKEEVERY < 1){
+        value += uniform() < 0.5 ? -SPIKESIZE : SPIKESIZE;
+    }
+    return (uint16_t)lround(value) & 0xFFFC;
+}
+
+static bool run(const Check_t *check, double baseline){
+
+    SampleFilter_t filter;
+    uint16_t out;
+    uint32_t sum;
+    double error;
+    double squares = 0;
+    int lag = -1;
+    int reading;
+    int i;
+    struct timespec start;
+    struct timespec end;
+    double ns;
+    bool ok;
+
+    noiseState = 2463534242u;
+    sampleFilterInit(&filter, &check->config);
+
+    for(reading = 0; reading < CHECKREADINGS; reading++){
+        sum = 0;
+        for(i = 0; i < check->oversample; i++){
+            sum += convert(reading);
+        }
+        out = sampleFilterAdd(&filter, (uint16_t)((sum + check->oversample / 2) / check->oversample));
+
+        if(reading >= 100 && reading < STEADYEND){
+            error = out - truth(reading);
+            squares += error * error;
+        }
+        if(reading >= STEPAT && lag < 0 && out >= LEVEL + STEPSIZE * 0.9){
+            lag = reading - STEPAT + 1;
+        }
+    }
+
+    //cost of the filter alone
+    sampleFilterInit(&filter, &check->config);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < TIMINGCALLS; i++){
+        sink = sampleFilterAdd(&filter, (uint16_t)(LEVEL + (i & 63)));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / TIMINGCALLS;
+
+    error = sqrt(squares / (STEADYEND - 100));
+    ok = baseline / error >= check->minGain && lag > 0 && lag <= check->maxLag;
+    printf("%-11s %8.2f %6.1f %6d %6.1f %s\n", check->name, error, baseline / error, lag, ns,
+           ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(void){
+
+    double squares = 0;
+    double error;
+    double baseline;
+    bool ok = true;
+    int reading;
+    size_t i;
+
+    //unfiltered noise for the gain column
+    noiseState = 2463534242u;
+    for(reading = 0; reading < STEADYEND; reading++){
+        error = convert(reading) - truth(reading);
+        if(reading >= 100){
+            squares += error * error;
+        }
+    }
+    baseline = sqrt(squares / (STEADYEND - 100));
+
+    printf("%-11s %8s %6s %6s %6s\n", "filter", "rms_lsb", "gain", "lag90", "ns");
+    for(i = 0; i < sizeof(checks) / sizeof(checks[0]); i++){
+        ok &= run(&checks[i], baseline);
+    }
+
+    printf("filter_check %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
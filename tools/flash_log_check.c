@@ -0,0 +1,431 @@
+//Host check of the flash log (flash_log.h) on a RAM image that behaves
+//like NOR flash: erase sets a sector to 0xFF and programming only
+//clears bits. Writes can be made to fail on demand, leaving the page
+//or sector as it was.
+//
+//  program_fail  a page program fails mid log: its records are dropped
+//                and counted, the stage stays within its page, and the
+//                log carries on with every later record readable
+//  wear          three laps of the region, rebooting each time the
+//                spare has been erased ahead of use: every header's
+//                erase count matches the erases the image saw
+//  rollover      a reboot with the head just moved to a new sector:
+//                the record sequence carries on from the last sector
+//  throughput    THROUGHPUTLAPS laps of the region, serviced as the log
+//                task does: one page program per FLASHLOGRECORDSPERPAGE
+//                records plus one header and one erase per sector, no
+//                more. Prints records/s through the code on the host
+//                and the rate the programs and erases would allow on
+//                the board at the W25Q64JV's typical timings
+//  recovery      a mount at head positions across a lap and after a
+//                wrap: the head and sequence are found in at most
+//                RECOVERYREADSMAX reads (every header, a word per page
+//                of the head and the spare, and the newest record),
+//                not by reading the region. Prints the reads, bytes
+//                read and mount time on the host
+//
+//One line per check, then a summary. Exits 1 on any failure.
+//
+//  gcc -O2 -I.. -o flash_log_check flash_log_check.c ../flash_log.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "flash_log.h"
+
+#define IMAGESIZE (FLASHLOGSECTORS * FLASHLOGSECTORSIZE)
+#define RECORDSPERSECTOR ((FLASHLOGPAGESPERSECTOR - 1) * FLASHLOGRECORDSPERPAGE)
+#define THROUGHPUTLAPS 4
+#define RECOVERYMOUNTS 101
+#define RECOVERYREADSMAX (FLASHLOGSECTORS + 2 * FLASHLOGPAGESPERSECTOR + 1)
+
+//W25Q64JV typical page program and 4 KB sector erase
+#define BOARDPAGEPROGRAMUS 400
+#define BOARDSECTORERASEUS 45000
+
+typedef struct {
+    uint8_t image[IMAGESIZE];
+    uint32_t eraseCounts[FLASHLOGSECTORS];
+    int passPrograms;           //then the next failPrograms fail
+    int failPrograms;
+    int failErases;
+    uint32_t reads;
+    uint32_t readBytes;
+    uint32_t programs;
+    uint32_t erases;
+} RamFlash_t;
+
+static RamFlash_t flash;
+static int failures;
+
+static bool ramRead(void *ctx, uint32_t offset, void *dst, size_t len){
+
+    RamFlash_t *ram = (RamFlash_t *)ctx;
+
+    if(offset + len > IMAGESIZE){
+        return false;
+    }
+    memcpy(dst, ram->image + offset, len);
+    ram->reads++;
+    ram->readBytes += len;
+
+    return true;
+}
+
+static bool ramProgram(void *ctx, uint32_t offset, const void *src, size_t len){
+
+    RamFlash_t *ram = (RamFlash_t *)ctx;
+    const uint8_t *data = (const uint8_t *)src;
+    size_t i;
+
+    if(offset % FLASHLOGPAGESIZE != 0 || len != FLASHLOGPAGESIZE || offset + len > IMAGESIZE){
+        return false;
+    }
+    if(ram->passPrograms > 0){
+        ram->passPrograms--;
+    }
+    else if(ram->failPrograms > 0){
+        ram->failPrograms--;
+        return false;
+    }
+
+    for(i = 0; i < len; i++){
+        ram->image[offset + i] &= data[i];
+    }
+    ram->programs++;
+
+    return true;
+}
+
+static bool ramErase(void *ctx, uint32_t offset){
+
+    RamFlash_t *ram = (RamFlash_t *)ctx;
+
+    if(offset % FLASHLOGSECTORSIZE != 0 || offset >= IMAGESIZE){
+        return false;
+    }
+    if(ram->failErases > 0){
+        ram->failErases--;
+        return false;
+    }
+
+    memset(ram->image + offset, 0xFF, FLASHLOGSECTORSIZE);
+    ram->eraseCounts[offset / FLASHLOGSECTORSIZE]++;
+    ram->erases++;
+
+    return true;
+}
+
+static const FlashLogStorage_t ramStorage = {
+    .read = ramRead,
+    .program = ramProgram,
+    .erase = ramErase,
+    .ctx = &flash,
+};
+
+static void blankFlash(void){
+
+    memset(&flash, 0, sizeof(flash));
+    memset(flash.image, 0xFF, sizeof(flash.image));
+}
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-14s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+//The newest count records are timeSec first - count + 1 to first in
+//order, newest first
+static bool recentAre(FlashLog_t *log, uint32_t first, int count){
+
+    FlashLogRecord_t records[2 * FLASHLOGRECORDSPERPAGE];
+    int i;
+
+    if(count > (int)(sizeof(records) / sizeof(records[0])) || flashLogReadRecent(log, records, count) != count){
+        return false;
+    }
+    for(i = 0; i < count; i++){
+        if(records[i].timeSec != first - (uint32_t)i){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void checkProgramFail(void){
+
+    FlashLog_t log;
+    uint32_t t = 0;
+    bool bounded = true;
+    bool failedOnce = false;
+    char detail[128];
+    int i;
+
+    blankFlash();
+    flashLogInit(&log, &ramStorage);
+
+    //two good pages, one that fails, then three more pages
+    for(i = 0; i < 6 * FLASHLOGRECORDSPERPAGE; i++){
+        if(i == 2 * FLASHLOGRECORDSPERPAGE){
+            flash.failPrograms = 1;
+        }
+        if(!flashLogAppend(&log, ++t, 2000 + i, 4000)){
+            failedOnce = true;
+        }
+        bounded &= log.staged >= 0 && log.staged < FLASHLOGRECORDSPERPAGE;
+    }
+
+    snprintf(detail, sizeof(detail), "dropped %lu errors %lu pages %lu", (unsigned long)log.dropped,
+             (unsigned long)log.errors, (unsigned long)log.pagesProgrammed);
+    result("program_fail", failedOnce && bounded && log.dropped == FLASHLOGRECORDSPERPAGE && log.errors == 1 &&
+           log.pagesProgrammed == 5 && recentAre(&log, t, 2 * FLASHLOGRECORDSPERPAGE), detail);
+
+    //and a failure that keeps on: the stage never overruns
+    bounded = true;
+    flash.failPrograms = 1000;
+    for(i = 0; i < 40 * FLASHLOGRECORDSPERPAGE; i++){
+        flashLogAppend(&log, ++t, 2000, 4000);
+        bounded &= log.staged >= 0 && log.staged < FLASHLOGRECORDSPERPAGE;
+    }
+    flash.failPrograms = 0;
+    for(i = 0; i < FLASHLOGRECORDSPERPAGE; i++){
+        flashLogAppend(&log, ++t, 2000, 4000);
+    }
+
+    snprintf(detail, sizeof(detail), "stuck for 40 pages, dropped %lu", (unsigned long)log.dropped);
+    result("program_stuck", bounded && log.dropped == 41 * FLASHLOGRECORDSPERPAGE &&
+           recentAre(&log, t, FLASHLOGRECORDSPERPAGE), detail);
+}
+
+static void checkWear(void){
+
+    FlashLog_t log;
+    FlashLogHeader_t header;
+    uint32_t t = 0;
+    int reboots = 0;
+    int headers = 0;
+    int wrong = 0;
+    char detail[128];
+    int sector;
+    int i;
+
+    blankFlash();
+    flashLogInit(&log, &ramStorage);
+
+    for(i = 0; i < 3 * FLASHLOGSECTORS * (FLASHLOGPAGESPERSECTOR - 1) * FLASHLOGRECORDSPERPAGE; i++){
+        flashLogAppend(&log, ++t, 2000, 4000);
+
+        //as the log task does once the queue is empty, then a reset
+        //before the spare is used
+        if(log.staged == 0 && flashLogService(&log)){
+            flashLogInit(&log, &ramStorage);
+            reboots++;
+        }
+    }
+
+    for(sector = 0; sector < FLASHLOGSECTORS; sector++){
+        memcpy(&header, flash.image + sector * FLASHLOGSECTORSIZE, sizeof(header));
+        if(header.magic != FLASHLOGMAGIC){
+            continue;
+        }
+        headers++;
+        if(header.eraseCount != flash.eraseCounts[sector]){
+            if(wrong == 0){
+                printf("sector %d header erase count %lu, erased %lu times\n", sector,
+                       (unsigned long)header.eraseCount, (unsigned long)flash.eraseCounts[sector]);
+            }
+            wrong++;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "%d reboots, %d headers, %d wrong", reboots, headers, wrong);
+    //the spare erased last has no header until it is opened
+    result("wear", reboots >= 3 * FLASHLOGSECTORS - 1 && headers >= FLASHLOGSECTORS - 1 && wrong == 0, detail);
+}
+
+static void checkRollover(void){
+
+    FlashLog_t log;
+    FlashLogRecord_t newest;
+    uint32_t t = 0;
+    uint32_t recovered;
+    char detail[128];
+    int i;
+
+    blankFlash();
+    flashLogInit(&log, &ramStorage);
+
+    //fill the first sector, then the next page opens sector 1 and
+    //fails, leaving it with only its header
+    for(i = 0; i < (FLASHLOGPAGESPERSECTOR - 1) * FLASHLOGRECORDSPERPAGE; i++){
+        flashLogAppend(&log, ++t, 2000, 4000);
+    }
+    flash.passPrograms = 1;
+    flash.failPrograms = 1;
+    for(i = 0; i < FLASHLOGRECORDSPERPAGE; i++){
+        flashLogAppend(&log, ++t, 2000, 4000);
+    }
+
+    flashLogInit(&log, &ramStorage);
+    recovered = log.recordSequence;
+    for(i = 0; i < FLASHLOGRECORDSPERPAGE; i++){
+        flashLogAppend(&log, ++t, 2000, 4000);
+    }
+
+    //the page that failed was dropped, the one after follows on from
+    //the first sector's last record
+    flashLogReadRecent(&log, &newest, 1);
+    snprintf(detail, sizeof(detail), "head sector %d, sequence %lu after reboot, newest %lu", log.sector,
+             (unsigned long)recovered, (unsigned long)newest.sequence);
+    result("rollover", log.sector == 1 && recovered == (FLASHLOGPAGESPERSECTOR - 1) * FLASHLOGRECORDSPERPAGE &&
+           newest.sequence == recovered + FLASHLOGRECORDSPERPAGE && recentAre(&log, t, FLASHLOGRECORDSPERPAGE),
+           detail);
+}
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int compareNs(const void *a, const void *b){
+
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void checkThroughput(void){
+
+    FlashLog_t log;
+    const uint32_t records = THROUGHPUTLAPS * FLASHLOGSECTORS * RECORDSPERSECTOR;
+    uint32_t programs;
+    uint32_t erases;
+    uint32_t sectors;
+    uint64_t startNs;
+    uint64_t hostNs;
+    uint64_t boardUs;
+    uint32_t i;
+    char detail[160];
+
+    blankFlash();
+    flashLogInit(&log, &ramStorage);
+    programs = flash.programs;
+    erases = flash.erases;
+
+    startNs = nowNs();
+    for(i = 0; i < records; i++){
+        flashLogAppend(&log, i, 2000, 4000);
+        if(log.staged == 0){
+            flashLogService(&log);
+        }
+    }
+    hostNs = nowNs() - startNs;
+
+    programs = flash.programs - programs;
+    erases = flash.erases - erases;
+    sectors = records / RECORDSPERSECTOR;
+    boardUs = (uint64_t)programs * BOARDPAGEPROGRAMUS + (uint64_t)erases * BOARDSECTORERASEUS;
+
+    snprintf(detail, sizeof(detail), "%lu records, %lu programs %lu erases, host %.0f records/s, board %.0f records/s",
+             (unsigned long)records, (unsigned long)programs, (unsigned long)erases, records * 1e9 / hostNs,
+             records * 1e6 / boardUs);
+    //the last sector's spare is erased ahead, one more than were filled
+    result("throughput", log.dropped == 0 && log.errors == 0 &&
+           programs == records / FLASHLOGRECORDSPERPAGE + sectors - 1 && erases == sectors, detail);
+}
+
+//Mount the image RECOVERYMOUNTS times. Returns the median mount time
+//in ns; reads and bytes are for one mount.
+static uint64_t mount(FlashLog_t *log, uint32_t *reads, uint32_t *readBytes){
+
+    static uint64_t mountNs[RECOVERYMOUNTS];
+    uint64_t startNs;
+    int i;
+
+    for(i = 0; i < RECOVERYMOUNTS; i++){
+        flash.reads = 0;
+        flash.readBytes = 0;
+        startNs = nowNs();
+        flashLogInit(log, &ramStorage);
+        mountNs[i] = nowNs() - startNs;
+    }
+    *reads = flash.reads;
+    *readBytes = flash.readBytes;
+
+    qsort(mountNs, RECOVERYMOUNTS, sizeof(mountNs[0]), compareNs);
+    return mountNs[RECOVERYMOUNTS / 2];
+}
+
+static void checkRecovery(void){
+
+    FlashLog_t log;
+    uint32_t appended = 0;
+    uint32_t target;
+    uint32_t worstReads = 0;
+    uint32_t worstBytes = 0;
+    uint32_t reads;
+    uint32_t readBytes;
+    uint64_t worstNs = 0;
+    uint64_t medianNs;
+    bool found = true;
+    char detail[160];
+    int step;
+
+    blankFlash();
+    flashLogInit(&log, &ramStorage);
+
+    //a mount every eighth of a lap, through the wrap into the second
+    for(step = 1; step <= 12; step++){
+        target = (uint32_t)step * FLASHLOGSECTORS * RECORDSPERSECTOR / 8 - 3;
+        while(appended < target){
+            flashLogAppend(&log, ++appended, 2000, 4000);
+            if(log.staged == 0){
+                flashLogService(&log);
+            }
+        }
+
+        medianNs = mount(&log, &reads, &readBytes);
+        found &= log.recordSequence == appended / FLASHLOGRECORDSPERPAGE * FLASHLOGRECORDSPERPAGE &&
+                 log.recoveryReads <= RECOVERYREADSMAX;
+        if(log.recoveryReads > worstReads){
+            worstReads = log.recoveryReads;
+        }
+        if(readBytes > worstBytes){
+            worstBytes = readBytes;
+        }
+        if(medianNs > worstNs){
+            worstNs = medianNs;
+        }
+
+        //the staged records were lost with the reboot
+        appended = log.recordSequence;
+    }
+
+    snprintf(detail, sizeof(detail), "worst of 12 mounts: %lu recovery reads (max %d), %lu bytes of %d, %.1f us on the host",
+             (unsigned long)worstReads, RECOVERYREADSMAX, (unsigned long)worstBytes, IMAGESIZE, worstNs / 1e3);
+    result("recovery", found, detail);
+}
+
+int main(void){
+
+    checkProgramFail();
+    checkWear();
+    checkRollover();
+    checkThroughput();
+    checkRecovery();
+
+    printf("flash_log_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
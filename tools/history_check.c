@@ -0,0 +1,214 @@
+//Host check of the sample history (history.h), then its insert and
+//query cost.
+//
+//  wide_count    an hour of samples 10 ms apart in one bucket: count
+//                and mean past what 16 bits held
+//  mean_round    bucket means round half away from zero
+//  gap           a gap in the samples leaves empty buckets, and a gap
+//                longer than the ring clears it
+//  last_day      26 hours at 1 s: the newest 24 hour buckets oldest
+//                first, and each found again by historyBucketAt
+//
+//One line per check, then host ns per historyAdd and per query of the
+//last 24 hours and of every minute bucket. bench.c times the same on
+//the board. Exits 1 on any failure.
+//
+//  gcc -O2 -I.. -o history_check history_check.c ../history.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "history.h"
+
+#define TIMINGADDS 10000000
+#define TIMINGQUERIES 1000000
+
+static History_t history;
+static HistoryBucket_t buckets[HISTORYHOURS];
+static int failures;
+static volatile int32_t sink;
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-12s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+static uint64_t seconds(uint32_t s){
+
+    return (uint64_t)s * 1000000;
+}
+
+static void checkWideCount(void){
+
+    int32_t meanC = 0;
+    int32_t meanRH = 0;
+    char detail[128];
+    uint32_t i;
+    bool ok;
+
+    historyInit(&history);
+    for(i = 0; i < 360000; i++){
+        historyAdd(&history, (uint64_t)i * 10000, 12500, 10000);
+    }
+
+    ok = historyQuery(&history, HISTORYHOUR, buckets, 1) == 1 && historyMean(&buckets[0], &meanC, &meanRH);
+    snprintf(detail, sizeof(detail), "count %lu mean %ld C %ld RH", (unsigned long)buckets[0].count, (long)meanC,
+             (long)meanRH);
+    result("wide_count", ok && buckets[0].count == 360000 && meanC == 12500 && meanRH == 10000, detail);
+}
+
+static int32_t meanOf(const int32_t *values, int count){
+
+    int32_t meanC = 0;
+    int32_t meanRH = 0;
+    int i;
+
+    historyInit(&history);
+    for(i = 0; i < count; i++){
+        historyAdd(&history, seconds((uint32_t)i), values[i], 5000);
+    }
+    historyQuery(&history, HISTORYMINUTE, buckets, 1);
+    historyMean(&buckets[0], &meanC, &meanRH);
+
+    return meanC;
+}
+
+static void checkMeanRound(void){
+
+    const int32_t up[] = {1, 2};
+    const int32_t down[] = {-1, -2};
+    const int32_t third[] = {1, 1, 2};
+    const int32_t negThird[] = {-1, -1, -2};
+    int32_t got[4];
+    char detail[128];
+
+    got[0] = meanOf(up, 2);
+    got[1] = meanOf(down, 2);
+    got[2] = meanOf(third, 3);
+    got[3] = meanOf(negThird, 3);
+
+    snprintf(detail, sizeof(detail), "1.5 -> %ld, -1.5 -> %ld, 1.33 -> %ld, -1.33 -> %ld", (long)got[0],
+             (long)got[1], (long)got[2], (long)got[3]);
+    result("mean_round", got[0] == 2 && got[1] == -2 && got[2] == 1 && got[3] == -1, detail);
+}
+
+static void checkGap(void){
+
+    HistoryBucket_t bucket;
+    char detail[128];
+    int copied;
+    bool ok;
+
+    //samples in hours 0 and 3: hours 1 and 2 are empty
+    historyInit(&history);
+    historyAdd(&history, seconds(10), 2000, 4000);
+    historyAdd(&history, seconds(3 * 3600 + 10), 2100, 4100);
+
+    copied = historyQuery(&history, HISTORYHOUR, buckets, HISTORYHOURS);
+    ok = copied == 4 && buckets[0].count == 1 && buckets[1].count == 0 && buckets[2].count == 0 &&
+         buckets[3].count == 1 && buckets[2].startSec == 2 * 3600;
+    ok &= historyBucketAt(&history, HISTORYHOUR, 3600, &bucket) && bucket.count == 0;
+    ok &= !historyBucketAt(&history, HISTORYHOUR, 4 * 3600, &bucket);
+    ok &= !historyBucketAt(&history, HISTORYHOUR, 1800, &bucket);
+
+    //then a gap longer than the minute ring: only empty minutes are
+    //left behind the new one
+    historyAdd(&history, seconds(3 * 3600 + 10 + HISTORYMINUTES * 60 * 2), 2200, 4200);
+    copied = historyQuery(&history, HISTORYMINUTE, buckets, HISTORYMINUTES);
+    ok &= copied == HISTORYMINUTES && buckets[0].count == 0 && buckets[HISTORYMINUTES - 1].count == 1 &&
+          buckets[HISTORYMINUTES - 1].startSec - buckets[0].startSec == (HISTORYMINUTES - 1) * 60;
+    ok &= !historyBucketAt(&history, HISTORYMINUTE, 3 * 3600, &bucket);
+
+    snprintf(detail, sizeof(detail), "%d minute buckets after a %d minute gap", copied, HISTORYMINUTES * 2);
+    result("gap", ok, detail);
+}
+
+static void checkLastDay(void){
+
+    HistoryBucket_t bucket;
+    int32_t meanC;
+    int32_t meanRH;
+    char detail[128];
+    uint32_t s;
+    int copied;
+    int wrong = 0;
+    int i;
+
+    //temperature is the hour number, humidity counts up within it
+    historyInit(&history);
+    for(s = 0; s < 26 * 3600; s++){
+        historyAdd(&history, seconds(s), (int32_t)(s / 3600) * 100, (int32_t)(s % 3600));
+    }
+
+    copied = historyQuery(&history, HISTORYHOUR, buckets, 24);
+    for(i = 0; i < copied; i++){
+        if(!historyMean(&buckets[i], &meanC, &meanRH) || meanC != (i + 2) * 100 || meanRH != 1800 ||
+           buckets[i].count != 3600 || buckets[i].minRH != 0 || buckets[i].maxRH != 3599 ||
+           !historyBucketAt(&history, HISTORYHOUR, buckets[i].startSec, &bucket) ||
+           bucket.startSec != buckets[i].startSec || bucket.count != buckets[i].count){
+            wrong++;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "%d hours, %d wrong, first starts %lu s", copied, wrong,
+             (unsigned long)buckets[0].startSec);
+    result("last_day", copied == 24 && wrong == 0 && buckets[0].startSec == 2 * 3600, detail);
+}
+
+static void timing(void){
+
+    uint64_t startNs;
+    double addNs;
+    double dayNs;
+    double minutesNs;
+    int i;
+
+    historyInit(&history);
+    startNs = nowNs();
+    for(i = 0; i < TIMINGADDS; i++){
+        historyAdd(&history, (uint64_t)i * 100000, 2000 + i % 100, 4000 + i % 300);
+    }
+    addNs = (double)(nowNs() - startNs) / TIMINGADDS;
+
+    startNs = nowNs();
+    for(i = 0; i < TIMINGQUERIES; i++){
+        sink += historyQuery(&history, HISTORYHOUR, buckets, 24);
+    }
+    dayNs = (double)(nowNs() - startNs) / TIMINGQUERIES;
+
+    startNs = nowNs();
+    for(i = 0; i < TIMINGQUERIES; i++){
+        sink += historyQuery(&history, HISTORYMINUTE, buckets, HISTORYMINUTES);
+    }
+    minutesNs = (double)(nowNs() - startNs) / TIMINGQUERIES;
+
+    printf("host ns: add %.1f query 24 hours %.1f query %d minutes %.1f, History_t %zu bytes\n", addNs, dayNs,
+           HISTORYMINUTES, minutesNs, sizeof(History_t));
+}
+
+int main(void){
+
+    checkWideCount();
+    checkMeanRound();
+    checkGap();
+    checkLastDay();
+
+    timing();
+
+    printf("history_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,576 @@
+//Host check of the asynchronous I2C transport's state machine
+//(i2c_async.h), then the CPU it leaves free against a blocking read.
+//
+//A scripted backend stands in for the RP2040 one: a hardware thread
+//finishes each transfer after its bus time by calling
+//i2cAsyncCompleteFromISR, as the interrupt handler does, or never
+//does, as a hung bus would.
+//
+//  complete      the transfer completes from the interrupt: the waiter
+//                gets its byte count and the bus is free
+//  isr_abort     the interrupt ends it with a bus error: the waiter
+//                gets the error and it is counted
+//  timeout       it never completes: the wait gives up after its ticks,
+//                aborts the backend and frees the bus
+//  late          a completion that comes after the wait gave up is
+//                dropped, and a stale notification left by one does not
+//                end the next transfer's wait early
+//  busy          a second transfer is refused while one is in flight,
+//                as is one the backend cannot start
+//  sim_backend   the host backend in sim/ against the simulated
+//                HDC1080: an ID read, a NACK and a stuck bus
+//
+//One line per check, then the CPU time the calling thread spends per
+//HDC1080 result read, bus time from the simulated bus at 100 kHz:
+//waiting on the notification against polling as the SDK's blocking
+//calls do. Exits 1 on any failure, or if the asynchronous read does
+//not use less than half the CPU of the blocking one.
+//
+//Only the FreeRTOS headers are needed; the task notifications the
+//transport blocks on are stood in for here.
+//
+//  K=/path/to/FreeRTOS-Kernel
+//  gcc -O2 -pthread -I.. -I../sim -I../sim/pico_mock -I$K/include -I$K/portable/ThirdParty/GCC/Posix -o i2c_async_check i2c_async_check.c ../i2c_async.c ../sim/i2c_async_sim.c ../sim/i2c_bus_sim.c ../sim/hdc1080_sim.c
+//
+//  i2c_async_check             CPUREADS reads each way
+//  i2c_async_check <reads>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "i2c_async.h"
+#include "i2c_async_sim.h"
+
+#define CPUREADS 500
+#define XFERMS 2                    //bus time of the scripted transfers
+#define WAITTICKS 3
+#define HDC1080ADDRESS 0x40
+#define HDC1080MFIDPOINTER 0xFE
+
+typedef enum {
+    SCRIPTCOMPLETE,                 //complete with the byte count
+    SCRIPTBUSERROR,                 //complete with a bus error
+    SCRIPTHANG,                     //never complete
+    SCRIPTREFUSE,                   //fail to start
+} ScriptMode_t;
+
+//The backend's hardware: finishes the armed transfer at dueNs
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    ScriptMode_t mode;
+    uint32_t busUs;
+    bool armed;
+    bool quit;
+    uint64_t dueNs;
+    int result;
+    volatile bool done;             //for the polling read
+    int starts;
+    int aborts;
+    int interrupts;
+    BaseType_t woken;
+} Hardware_t;
+
+//The one task the checks run as
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+} FakeTask_t;
+
+static FakeTask_t task = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, {0}};
+static Hardware_t hardware = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+static I2CAsyncBus_t bus;
+static int failures;
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t threadCpuNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+//Stand ins for the kernel's task notifications, with the kernel's
+//semantics for one task
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void){
+
+    return (TaskHandle_t)&task;
+}
+
+uint32_t ulTaskGenericNotifyTake(UBaseType_t index, BaseType_t clear, TickType_t ticks){
+
+    uint64_t endNs = nowNs() + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000;
+    struct timespec until;
+    uint32_t value;
+
+    pthread_mutex_lock(&task.lock);
+    while(task.notify[index] == 0 && ticks > 0){
+        if(ticks == portMAX_DELAY){
+            pthread_cond_wait(&task.cond, &task.lock);
+            continue;
+        }
+        if(nowNs() >= endNs){
+            break;
+        }
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += 1000000;
+        if(until.tv_nsec >= 1000000000){
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&task.cond, &task.lock, &until);
+    }
+    value = task.notify[index];
+    if(value > 0){
+        task.notify[index] = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task.lock);
+
+    return value;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t handle, UBaseType_t index, uint32_t value, eNotifyAction action,
+                              uint32_t *previous){
+
+    FakeTask_t *to = (FakeTask_t *)handle;
+
+    (void)value;
+    (void)action;
+    (void)previous;
+    pthread_mutex_lock(&to->lock);
+    to->notify[index]++;
+    pthread_cond_signal(&to->cond);
+    pthread_mutex_unlock(&to->lock);
+
+    return pdPASS;
+}
+
+void vTaskGenericNotifyGiveFromISR(TaskHandle_t handle, UBaseType_t index, BaseType_t *woken){
+
+    xTaskGenericNotify(handle, index, 0, eIncrement, NULL);
+    *woken = pdTRUE;
+}
+
+BaseType_t xTaskGenericNotifyStateClear(TaskHandle_t handle, UBaseType_t index){
+
+    (void)handle;
+    (void)index;
+
+    return pdFALSE;
+}
+
+//The scripted backend
+
+static void *hardwareThread(void *arg){
+
+    struct timespec due;
+    uint64_t dueNs;
+    int result;
+
+    (void)arg;
+    pthread_mutex_lock(&hardware.lock);
+    while(!hardware.quit){
+        if(!hardware.armed){
+            pthread_cond_wait(&hardware.cond, &hardware.lock);
+            continue;
+        }
+
+        dueNs = hardware.dueNs;
+        pthread_mutex_unlock(&hardware.lock);
+        due.tv_sec = (time_t)(dueNs / 1000000000u);
+        due.tv_nsec = (long)(dueNs % 1000000000u);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+        pthread_mutex_lock(&hardware.lock);
+
+        //aborted while the bytes were moving
+        if(!hardware.armed || hardware.dueNs != dueNs){
+            continue;
+        }
+        hardware.armed = false;
+        result = hardware.result;
+        hardware.interrupts++;
+        pthread_mutex_unlock(&hardware.lock);
+
+        i2cAsyncCompleteFromISR(&bus, result, nowNs() / 1000, &hardware.woken);
+        __atomic_store_n(&hardware.done, true, __ATOMIC_RELEASE);
+
+        pthread_mutex_lock(&hardware.lock);
+    }
+    pthread_mutex_unlock(&hardware.lock);
+
+    return NULL;
+}
+
+//Arm the hardware to finish after busUs
+static void arm(int result){
+
+    pthread_mutex_lock(&hardware.lock);
+    hardware.done = false;
+    hardware.result = result;
+    hardware.dueNs = nowNs() + (uint64_t)hardware.busUs * 1000;
+    hardware.armed = true;
+    pthread_cond_signal(&hardware.cond);
+    pthread_mutex_unlock(&hardware.lock);
+}
+
+static bool scriptStart(I2CAsyncBus_t *on, I2CAsyncXfer_t *xfer){
+
+    (void)on;
+    hardware.starts++;
+    xfer->startUs = nowNs() / 1000;
+
+    switch(hardware.mode){
+        case SCRIPTCOMPLETE:
+            arm((int)(xfer->rxLen > 0 ? xfer->rxLen : xfer->txLen));
+            return true;
+        case SCRIPTBUSERROR:
+            arm(I2CASYNCBUSERROR);
+            return true;
+        case SCRIPTHANG:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void scriptAbort(I2CAsyncBus_t *on){
+
+    (void)on;
+    pthread_mutex_lock(&hardware.lock);
+    hardware.aborts++;
+    hardware.armed = false;
+    pthread_mutex_unlock(&hardware.lock);
+}
+
+static const I2CAsyncOps_t scriptOps = {
+    .start = scriptStart,
+    .abort = scriptAbort,
+};
+
+//The same without an abort, so a hung transfer's interrupt can still
+//come in after the wait has given up
+static const I2CAsyncOps_t lateOps = {
+    .start = scriptStart,
+    .abort = NULL,
+};
+
+static void useScript(const I2CAsyncOps_t *ops, ScriptMode_t mode, uint32_t busUs){
+
+    memset(&bus, 0, sizeof(bus));
+    bus.ops = ops;
+    pthread_mutex_lock(&hardware.lock);
+    hardware.mode = mode;
+    hardware.busUs = busUs;
+    hardware.armed = false;
+    hardware.starts = 0;
+    hardware.aborts = 0;
+    hardware.interrupts = 0;
+    hardware.woken = pdFALSE;
+    pthread_mutex_unlock(&hardware.lock);
+    task.notify[I2CASYNCNOTIFYINDEX] = 0;
+}
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-12s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+static void readXfer(I2CAsyncXfer_t *xfer, const uint8_t *pointer, uint8_t *rx, size_t rxLen){
+
+    memset(xfer, 0, sizeof(*xfer));
+    xfer->address = HDC1080ADDRESS;
+    xfer->txBuf = pointer;
+    xfer->txLen = 1;
+    xfer->rxBuf = rx;
+    xfer->rxLen = rxLen;
+}
+
+static void checkComplete(void){
+
+    static const uint8_t pointer = 0;
+    I2CAsyncXfer_t xfer;
+    uint8_t rx[4];
+    char detail[128];
+    uint64_t startNs;
+    uint64_t waitedUs;
+    int ret;
+
+    useScript(&scriptOps, SCRIPTCOMPLETE, XFERMS * 1000);
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    startNs = nowNs();
+    ret = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+    waitedUs = (nowNs() - startNs) / 1000;
+
+    snprintf(detail, sizeof(detail), "returned %d after %lu us, busy %lu us, %lu transfers %lu errors", ret,
+             (unsigned long)waitedUs, (unsigned long)bus.busyUs, (unsigned long)bus.transfers,
+             (unsigned long)bus.errors);
+    result("complete", ret == (int)sizeof(rx) && xfer.result == ret && bus.active == NULL && bus.transfers == 1 &&
+           bus.errors == 0 && bus.busyUs >= XFERMS * 1000 && waitedUs >= XFERMS * 1000 && hardware.woken == pdTRUE &&
+           xfer.endUs >= xfer.startUs + XFERMS * 1000, detail);
+}
+
+static void checkIsrAbort(void){
+
+    static const uint8_t pointer = 0;
+    I2CAsyncXfer_t xfer;
+    uint8_t rx[4];
+    char detail[96];
+    int ret;
+
+    useScript(&scriptOps, SCRIPTBUSERROR, XFERMS * 1000);
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    ret = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+
+    snprintf(detail, sizeof(detail), "returned %d, %lu errors, %d aborts", ret, (unsigned long)bus.errors,
+             hardware.aborts);
+    result("isr_abort", ret == I2CASYNCBUSERROR && bus.active == NULL && bus.errors == 1 && hardware.aborts == 0,
+           detail);
+}
+
+static void checkTimeout(void){
+
+    static const uint8_t pointer = 0;
+    I2CAsyncXfer_t xfer;
+    uint8_t rx[4];
+    char detail[128];
+    uint64_t startNs;
+    uint64_t waitedUs;
+    int ret;
+
+    useScript(&scriptOps, SCRIPTHANG, 0);
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    startNs = nowNs();
+    ret = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+    waitedUs = (nowNs() - startNs) / 1000;
+
+    snprintf(detail, sizeof(detail), "returned %d after %lu us for %d ticks, %d aborts, %lu errors", ret,
+             (unsigned long)waitedUs, WAITTICKS, hardware.aborts, (unsigned long)bus.errors);
+    result("timeout", ret == I2CASYNCTIMEOUT && waitedUs >= WAITTICKS * portTICK_PERIOD_MS * 1000 &&
+           hardware.aborts == 1 && bus.active == NULL && bus.errors == 1 && xfer.timeoutUs == WAITTICKS *
+           portTICK_PERIOD_MS * 1000, detail);
+}
+
+static void checkLate(void){
+
+    static const uint8_t pointer = 0;
+    I2CAsyncXfer_t xfer;
+    uint8_t rx[4];
+    char detail[160];
+    uint64_t startNs;
+    uint64_t waitedUs;
+    int first;
+    int second;
+    int third;
+
+    //the interrupt comes a tick after the wait has given up
+    useScript(&lateOps, SCRIPTCOMPLETE, (WAITTICKS + 1) * portTICK_PERIOD_MS * 1000);
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    first = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+    while(!__atomic_load_n(&hardware.done, __ATOMIC_ACQUIRE)){
+        sched_yield();
+    }
+
+    //nothing was left behind for the next transfer
+    hardware.busUs = XFERMS * 1000;
+    readXfer(&xfer, &pointer, rx, 2);
+    second = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+
+    //a notification given after a wait has timed out, as an interrupt
+    //racing the timeout would leave, must not end the next wait early
+    xTaskNotifyGiveIndexed((TaskHandle_t)&task, I2CASYNCNOTIFYINDEX);
+    hardware.mode = SCRIPTHANG;
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    startNs = nowNs();
+    third = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+    waitedUs = (nowNs() - startNs) / 1000;
+
+    snprintf(detail, sizeof(detail), "timed out %d, late interrupts %d, next returned %d, after a stale "
+             "notification %d in %lu us", first, hardware.interrupts, second, third, (unsigned long)waitedUs);
+    result("late", first == I2CASYNCTIMEOUT && hardware.interrupts == 2 && second == 2 &&
+           third == I2CASYNCTIMEOUT && waitedUs >= WAITTICKS * portTICK_PERIOD_MS * 1000 && bus.active == NULL,
+           detail);
+}
+
+static void checkBusy(void){
+
+    static const uint8_t pointer = 0;
+    I2CAsyncXfer_t first;
+    I2CAsyncXfer_t second;
+    uint8_t rx[4];
+    char detail[128];
+    bool started;
+    bool refused;
+    bool kept;
+    int ret;
+
+    useScript(&scriptOps, SCRIPTHANG, 0);
+    readXfer(&first, &pointer, rx, sizeof(rx));
+    readXfer(&second, &pointer, rx, sizeof(rx));
+    started = i2cAsyncStart(&bus, &first);
+    refused = !i2cAsyncStart(&bus, &second);
+    kept = bus.active == &first && hardware.starts == 1;
+    i2cAsyncWait(&bus, &first, 1);
+
+    //and a backend that cannot start
+    hardware.mode = SCRIPTREFUSE;
+    ret = i2cAsyncTransfer(&bus, &second, WAITTICKS);
+
+    snprintf(detail, sizeof(detail), "second start %s, first %s; refused by the backend %d, bus %s",
+             refused ? "refused" : "taken", kept ? "kept" : "lost", ret, bus.active == NULL ? "free" : "held");
+    result("busy", started && refused && kept && ret == I2CASYNCERROR && bus.active == NULL, detail);
+}
+
+static void checkSimBackend(void){
+
+    static const uint8_t pointer = HDC1080MFIDPOINTER;
+    SimBus_t sim;
+    I2CAsyncXfer_t xfer;
+    uint8_t rx[2] = {0, 0};
+    char detail[160];
+    uint64_t stuckAtUs;
+    int id;
+    int nack;
+    int stuck;
+
+    simBusInit(&sim, 100000);
+    simBusAddSensor(&sim, SIMBUSNOMUX, 0);
+    i2cAsyncSimInit(&bus, &sim);
+    task.notify[I2CASYNCNOTIFYINDEX] = 0;
+
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    id = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+
+    sim.faultNacks = 1;
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    nack = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+
+    sim.sdaStuckClocks = 3;
+    stuckAtUs = sim.nowUs;
+    readXfer(&xfer, &pointer, rx, sizeof(rx));
+    stuck = i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+
+    snprintf(detail, sizeof(detail), "id read %d (0x%04X), nack %d, stuck bus %d after %lu us simulated",
+             id, (rx[0] << 8) | rx[1], nack, stuck, (unsigned long)(sim.nowUs - stuckAtUs));
+    result("sim_backend", id == 2 && ((rx[0] << 8) | rx[1]) == HDC1080SIMMANUFACTURERID && nack == I2CASYNCERROR &&
+           stuck == I2CASYNCTIMEOUT && sim.nowUs - stuckAtUs == WAITTICKS * portTICK_PERIOD_MS * 1000 &&
+           bus.active == NULL && bus.errors == 2, detail);
+}
+
+//Bus time of the HDC1080's 4 byte result read once it has converted,
+//from the simulated bus
+static uint32_t resultReadBusUs(void){
+
+    static const uint8_t pointer = 0;
+    SimBus_t sim;
+    uint8_t rx[4];
+    uint64_t startUs;
+
+    simBusInit(&sim, 100000);
+    simBusAddSensor(&sim, SIMBUSNOMUX, 0);
+    simBusWrite(&sim, HDC1080ADDRESS, &pointer, 1);
+    simBusAdvance(&sim, 20000);
+
+    startUs = sim.nowUs;
+    simBusRead(&sim, HDC1080ADDRESS, rx, sizeof(rx));
+
+    return (uint32_t)(sim.nowUs - startUs);
+}
+
+static void cpuTime(uint32_t reads){
+
+    static const uint8_t pointer = 0;
+    I2CAsyncXfer_t xfer;
+    uint8_t rx[4];
+    uint32_t busUs = resultReadBusUs();
+    uint64_t startCpuNs;
+    uint64_t startNs;
+    double asyncCpuUs;
+    double asyncWallUs;
+    double blockingCpuUs;
+    double blockingWallUs;
+    uint32_t i;
+    bool ok;
+
+    useScript(&scriptOps, SCRIPTCOMPLETE, busUs);
+    startNs = nowNs();
+    startCpuNs = threadCpuNs();
+    for(i = 0; i < reads; i++){
+        readXfer(&xfer, &pointer, rx, sizeof(rx));
+        i2cAsyncTransfer(&bus, &xfer, WAITTICKS);
+    }
+    asyncCpuUs = (double)(threadCpuNs() - startCpuNs) / 1000 / reads;
+    asyncWallUs = (double)(nowNs() - startNs) / 1000 / reads;
+
+    //the blocking read polls the controller until the bytes are in
+    startNs = nowNs();
+    startCpuNs = threadCpuNs();
+    for(i = 0; i < reads; i++){
+        arm((int)sizeof(rx));
+        while(!__atomic_load_n(&hardware.done, __ATOMIC_ACQUIRE)){
+        }
+    }
+    blockingCpuUs = (double)(threadCpuNs() - startCpuNs) / 1000 / reads;
+    blockingWallUs = (double)(nowNs() - startNs) / 1000 / reads;
+
+    ok = asyncCpuUs * 2 < blockingCpuUs;
+    printf("cpu          %s %lu reads of %lu us bus time: async %.1f us cpu %.1f us wall, blocking %.1f us cpu "
+           "%.1f us wall\n", ok ? "ok" : "FAILED", (unsigned long)reads, (unsigned long)busUs, asyncCpuUs,
+           asyncWallUs, blockingCpuUs, blockingWallUs);
+    if(!ok){
+        failures++;
+    }
+}
+
+int main(int argc, char **argv){
+
+    uint32_t reads = CPUREADS;
+
+    if(argc > 2){
+        fprintf(stderr, "usage: %s [reads]\n", argv[0]);
+        return 2;
+    }
+    if(argc == 2){
+        reads = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    pthread_create(&hardware.thread, NULL, hardwareThread, NULL);
+
+    checkComplete();
+    checkIsrAbort();
+    checkTimeout();
+    checkLate();
+    checkBusy();
+    checkSimBackend();
+    cpuTime(reads);
+
+    pthread_mutex_lock(&hardware.lock);
+    hardware.quit = true;
+    pthread_cond_signal(&hardware.cond);
+    pthread_mutex_unlock(&hardware.lock);
+    pthread_join(hardware.thread, NULL);
+
+    printf("i2c_async_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
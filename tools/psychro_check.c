@@ -0,0 +1,195 @@
+//Host check of the fixed point psychrometric metrics (psychro.h)
+//against the same formulas in double precision, over the sensor's
+//whole range: every CHECKSTEP hundredths from -40 to 125 C and from 0
+//to 100 %RH, and the readings the raw codes at either end give. One
+//line per metric:
+//
+//  metric <name> cases <n> max_err <x> rms_err <x> worst_c <x> worst_rh <x>
+//
+//  max_err     largest difference from the double result, in the
+//              metric's units, after both are rounded to hundredths
+//  worst       the input it was seen at
+//
+//then the host time per psychroCompute call against the same metrics
+//from libm in double. The host has an FPU, so double wins here; the
+//board has none, see psychroCompute in bench.c. Exits 1 if a metric is
+//off by more than its bound in psychro.h.
+//
+//  gcc -O2 -I.. -o psychro_check psychro_check.c ../psychro.c ../conversion.c -lm
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "psychro.h"
+#include "conversion.h"
+
+#define CHECKSTEP 5
+#define TIMINGCALLS 2000000
+
+typedef struct {
+    const char *name;
+    int32_t bound;
+    uint64_t cases;
+    int32_t maxErr;
+    double sumSquares;
+    int32_t worstC;
+    int32_t worstRH;
+} Metric_t;
+
+static Metric_t metrics[] = {
+    {"dew_point_c", PSYCHRODEWPOINTBOUND, 0, 0, 0, 0, 0},
+    {"abs_humidity_gm3", PSYCHROABSHUMIDITYBOUND, 0, 0, 0, 0, 0},
+    {"heat_index_f", PSYCHROHEATINDEXBOUND, 0, 0, 0, 0, 0},
+};
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+//The formulas in psychro.h in double, hundredths rounded half away
+//from zero as psychro.c rounds them
+static void reference(int32_t centiC, int32_t centiRH, PsychroMetrics_t *out){
+
+    const double b = 17.62;
+    const double c = 243.12;
+    double t = centiC / 100.0;
+    double rh = centiRH / 100.0;
+    double magnus = b * t / (c + t);
+    double gamma;
+    double f;
+    double hi;
+
+    if(centiRH == 0){
+        out->centiDewPointC = PSYCHRONOVALUE;
+    }
+    else{
+        gamma = log(rh / 100) + magnus;
+        out->centiDewPointC = (int32_t)round(100 * c * gamma / (b - gamma));
+    }
+
+    out->centiAbsHumidity = (int32_t)round(100 * 216.7 * rh / 100 * 6.112 * exp(magnus) / (t + 273.15));
+
+    //the firmware takes F in hundredths
+    f = round(centiC * 1.8) / 100 + 32;
+    hi = 0.5 * (f + 61 + (f - 68) * 1.2 + rh * 0.094);
+    if((hi + f) / 2 >= 80){
+        hi = -42.379 + 2.04901523 * f + 10.14333127 * rh - 0.22475541 * f * rh - 0.00683783 * f * f -
+             0.05481717 * rh * rh + 0.00122874 * f * f * rh + 0.00085282 * f * rh * rh -
+             0.00000199 * f * f * rh * rh;
+        if(rh < 13 && f > 80 && f < 112){
+            hi -= (13 - rh) / 4 * sqrt((17 - fabs(f - 95)) / 17);
+        }
+        if(rh > 85 && f > 80 && f < 87){
+            hi += (rh - 85) / 10 * ((87 - f) / 5);
+        }
+    }
+    out->centiHeatIndexF = (int32_t)round(100 * hi);
+}
+
+static void compare(Metric_t *metric, int32_t got, int32_t want, int32_t centiC, int32_t centiRH){
+
+    int32_t err;
+
+    if(got == PSYCHRONOVALUE || want == PSYCHRONOVALUE){
+        err = got == want ? 0 : INT32_MAX;
+    }
+    else{
+        err = got > want ? got - want : want - got;
+    }
+
+    metric->cases++;
+    metric->sumSquares += (double)err * err;
+    if(err > metric->maxErr){
+        metric->maxErr = err;
+        metric->worstC = centiC;
+        metric->worstRH = centiRH;
+    }
+}
+
+static void check(int32_t centiC, int32_t centiRH){
+
+    PsychroMetrics_t got;
+    PsychroMetrics_t want;
+
+    psychroCompute(centiC, centiRH, &got);
+    reference(centiC, centiRH, &want);
+
+    compare(&metrics[0], got.centiDewPointC, want.centiDewPointC, centiC, centiRH);
+    compare(&metrics[1], got.centiAbsHumidity, want.centiAbsHumidity, centiC, centiRH);
+    compare(&metrics[2], got.centiHeatIndexF, want.centiHeatIndexF, centiC, centiRH);
+}
+
+//Time per call of fixed point and libm, on inputs walked across the range
+static void timing(void){
+
+    PsychroMetrics_t out;
+    volatile uint32_t sink = 0;
+    uint64_t startNs;
+    double fixedNs;
+    double doubleNs;
+    int32_t centiC = -4000;
+    int32_t centiRH = 0;
+    int i;
+
+    startNs = nowNs();
+    for(i = 0; i < TIMINGCALLS; i++){
+        psychroCompute(centiC, centiRH, &out);
+        sink += (uint32_t)out.centiDewPointC + (uint32_t)out.centiAbsHumidity + (uint32_t)out.centiHeatIndexF;
+        centiC = centiC >= 12500 ? -4000 : centiC + 7;
+        centiRH = centiRH >= 10000 ? 1 : centiRH + 13;
+    }
+    fixedNs = (double)(nowNs() - startNs) / TIMINGCALLS;
+
+    startNs = nowNs();
+    for(i = 0; i < TIMINGCALLS; i++){
+        reference(centiC, centiRH, &out);
+        sink += (uint32_t)out.centiDewPointC + (uint32_t)out.centiAbsHumidity + (uint32_t)out.centiHeatIndexF;
+        centiC = centiC >= 12500 ? -4000 : centiC + 7;
+        centiRH = centiRH >= 10000 ? 1 : centiRH + 13;
+    }
+    doubleNs = (double)(nowNs() - startNs) / TIMINGCALLS;
+
+    printf("host ns per sample: fixed %.1f double %.1f\n", fixedNs, doubleNs);
+}
+
+int main(void){
+
+    int32_t centiC;
+    int32_t centiRH;
+    bool failed = false;
+    size_t i;
+
+    for(centiC = -4000; centiC <= 12500; centiC += CHECKSTEP){
+        for(centiRH = 0; centiRH <= 10000; centiRH += CHECKSTEP){
+            check(centiC, centiRH);
+        }
+    }
+
+    //what the sensor reports at the ends of its codes
+    check(convRawToCentiC(0), convRawToCentiRH(1));
+    check(convRawToCentiC(0xFFFF), convRawToCentiRH(0xFFFF));
+    check(convRawToCentiC(0xFFFF), convRawToCentiRH(1));
+    check(convRawToCentiC(0), convRawToCentiRH(0xFFFF));
+
+    for(i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++){
+        Metric_t *metric = &metrics[i];
+
+        printf("metric %-16s cases %llu max_err %.2f rms_err %.4f worst_c %.2f worst_rh %.2f\n", metric->name,
+               (unsigned long long)metric->cases, metric->maxErr / 100.0,
+               sqrt(metric->sumSquares / metric->cases) / 100, metric->worstC / 100.0, metric->worstRH / 100.0);
+        failed |= metric->maxErr > metric->bound;
+    }
+
+    timing();
+
+    printf("psychro_check %s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+#RAM budget report for the Assign6 firmware
+#Reads the GNU ld map written next to the ELF and breaks the statically
+#allocated RAM down per task, per buffer and per subsystem. Exits 1
+#when a subsystem or the total is over its budget in BUDGETS, which
+#fails the build; CMakeLists.txt runs it after every link.
+#
+#  python3 tools/ram_budget.py build/Assign6.elf.map
+#
+#Heap (newlib printf, TinyUSB) is whatever RAM is left, so the total
+#budget keeps HEAPRESERVE bytes of the 264 KB free for it.
+#
+#The budgets only mean something for a static build (ASSIGN6STATIC
+#ON), where the task stacks are in the map; a map without the kernel's
+#idle task storage from rtos_static.c is refused rather than passed.
+
+import os
+import re
+import sys
+
+RAMBYTES = 264 * 1024
+HEAPRESERVE = 32 * 1024
+
+#Budgets in bytes. Raise one deliberately, in the same commit as the
+#change that needs it.
+BUDGETS = {
+    "tasks":        12 * 1024,      #stacks and TCBs, incl. idle and timer
+    "queues":       1 * 1024,
+    "history":      16 * 1024,      #HISTORYMAXBYTES
+    "flash log":    1 * 1024,
+    "samples":      1 * 1024,       #sample cell and the ring to core 1
+    "console":      2 * 1024,
+    "event trace":  9 * 1024,
+    "runtime stats": 768,          #incl. the schedule jitter histogram
+    "config":       256,            #published settings, not the parser
+    "sensor":       512,
+    "display":      512,
+    "kernel":       1 * 1024,
+    "usb":          6 * 1024,
+    "sdk":          16 * 1024,      #pico SDK, newlib, core 0/1 stacks
+    "total":        RAMBYTES - HEAPRESERVE,
+}
+
+#Output sections that take RAM. .heap is the remainder, not counted.
+RAMSECTIONS = {".data", ".bss", ".uninitialized_data", ".ram_vector_table",
+               ".scratch_x", ".scratch_y", ".stack_dummy", ".stack1_dummy"}
+
+#Objects named by rtos_static.h, and application globals that live in
+#Assign6.c but belong to a subsystem
+SYMBOLRULES = [
+    (re.compile(r"^(\w+?)(Stack|Tcb)$"), "tasks"),
+    (re.compile(r"^\w+(Storage|Buffer)$"), "queues"),
+    (re.compile(r"^sampleHistory$"), "history"),
+    (re.compile(r"^(sampleLog|flashLog)"), "flash log"),
+    (re.compile(r"^(latestSample|sampleRing)"), "samples"),
+    (re.compile(r"^(hdc1080Bus|sensorBus|sensor)$"), "sensor"),
+    (re.compile(r"^(configAppliedUs|readTaskHandle)$"), "config"),
+    (re.compile(r"^scheduleJitter$"), "runtime stats"),
+    (re.compile(r"^chainDisplay$"), "display"),
+]
+
+#Everything else by the object it came from
+FILERULES = [
+    (re.compile(r"^console\."), "console"),
+    (re.compile(r"^event_trace\."), "event trace"),
+    (re.compile(r"^(runtime_stats|jitter_histogram)\."), "runtime stats"),
+    (re.compile(r"^runtime_config\."), "config"),
+    (re.compile(r"^(display|spi_display)"), "display"),
+    (re.compile(r"^(hdc1080|i2c_async)"), "sensor"),
+    (re.compile(r"^flash_log"), "flash log"),
+    (re.compile(r"^history\."), "history"),
+    (re.compile(r"^(tasks|queue|list|timers|event_groups|stream_buffer|port|heap_\d)\.c"), "kernel"),
+    (re.compile(r"^(tusb|usbd|usbd_control|cdc_device|dcd_rp2040|rp2040_usb|stdio_usb|reset_interface)\.c"), "usb"),
+]
+
+#Buffers at least this big are listed on their own
+BUFFERMIN = 256
+
+
+def objectName(path):
+    #libfreertos.a(tasks.c.obj) -> tasks.c.obj
+    member = re.search(r"\(([^)]+)\)$", path)
+    if member:
+        return member.group(1)
+    return os.path.basename(path)
+
+
+def symbolName(section):
+    #.bss.readHDC1080TaskStack -> readHDC1080TaskStack, and drop the
+    #.N gcc adds to function statics
+    parts = section.split(".")
+    if len(parts) < 3:
+        return ""
+    name = ".".join(parts[2:])
+    return re.sub(r"\.\d+$", "", name)
+
+
+def subsystem(symbol, obj):
+    for pattern, name in SYMBOLRULES:
+        if pattern.search(symbol):
+            return name
+    for pattern, name in FILERULES:
+        if pattern.search(obj):
+            return name
+    return "sdk"
+
+
+def readMap(path):
+    #Yields (output section, input section, size, object) for every
+    #input section placed in a RAM output section
+    output = None
+    pending = None
+    inMemoryMap = False
+
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+
+            if line.startswith("Linker script and memory map"):
+                inMemoryMap = True
+                continue
+            if not inMemoryMap:
+                continue
+
+            #output section, starts in column 0
+            match = re.match(r"^(\.[\w.]+)", line)
+            if match:
+                output = match.group(1)
+                pending = None
+                continue
+            if output not in RAMSECTIONS:
+                continue
+
+            #input section with address, size and object on one line,
+            #or a long name with them on the next
+            match = re.match(r"^ (\S+)\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(.+)$", line)
+            if match:
+                if match.group(1) != "*fill*":
+                    yield output, match.group(1), int(match.group(2), 16), match.group(3)
+                pending = None
+                continue
+            match = re.match(r"^ (\S+)$", line)
+            if match:
+                pending = match.group(1)
+                continue
+            match = re.match(r"^\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(.+)$", line)
+            if match and pending is not None:
+                yield output, pending, int(match.group(1), 16), match.group(2)
+                pending = None
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: ram_budget.py <firmware.elf.map>", file=sys.stderr)
+        return 2
+
+    tasks = {}
+    buffers = []
+    subsystems = {}
+    total = 0
+
+    for output, section, size, path in readMap(sys.argv[1]):
+        if size == 0:
+            continue
+        obj = objectName(path)
+        symbol = symbolName(section)
+        group = subsystem(symbol, obj)
+
+        subsystems[group] = subsystems.get(group, 0) + size
+        total += size
+
+        match = SYMBOLRULES[0][0].match(symbol)
+        if match:
+            tasks[match.group(1)] = tasks.get(match.group(1), 0) + size
+        if size >= BUFFERMIN:
+            buffers.append((size, symbol or section, obj))
+
+    if "idleTask" not in tasks:
+        print("ram_budget: no idleTaskStack in %s, not a static build (ASSIGN6STATIC OFF?)"
+              % os.path.basename(sys.argv[1]), file=sys.stderr)
+        return 1
+
+    over = False
+
+    print("RAM budget: %s" % os.path.basename(sys.argv[1]))
+    print("  per task (stack + TCB)")
+    for name in sorted(tasks, key=tasks.get, reverse=True):
+        print("    %-24s %7d" % (name, tasks[name]))
+
+    print("  buffers >= %d bytes" % BUFFERMIN)
+    for size, name, obj in sorted(buffers, reverse=True):
+        print("    %-32s %7d  %s" % (name, size, obj))
+
+    print("  per subsystem            used  budget")
+    for name in sorted(set(subsystems) | set(BUDGETS) - {"total"}):
+        used = subsystems.get(name, 0)
+        budget = BUDGETS.get(name)
+        flag = ""
+        if budget is not None and used > budget:
+            flag = "  OVER"
+            over = True
+        print("    %-20s %7d %7s%s" % (name, used, budget if budget is not None else "-", flag))
+
+    flag = ""
+    if total > BUDGETS["total"]:
+        flag = "  OVER"
+        over = True
+    print("    %-20s %7d %7d%s" % ("total", total, BUDGETS["total"], flag))
+    print("  heap and free            %7d" % (RAMBYTES - total))
+
+    if over:
+        print("ram_budget: over budget", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
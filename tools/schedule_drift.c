@@ -0,0 +1,256 @@
+//Long run check of the reading task's schedule (adaptive_rate.h and
+//sleepUntil in Assign6.c) against the old relative one, on a model of
+//the 10 ms FreeRTOS tick. Both sample one channel at a fixed
+//DRIFTPERIODMS for the hours given, with each read taking
+//READMINUS - READMAXUS, each wake, from the tick or an alarm, delayed
+//by up to WAKELATENCYUS and each read started up to RUNLATENCYUS
+//after the task is back, for interrupts taken on the way.
+//One read in STALLEVERY stalls for STALLUS, as a hung bus recovering
+//would, so the absolute schedule has to drop slots. The clock starts
+//an hour before a 32 bit millisecond count of it wraps, 49.7 days
+//after boot, so every run goes through the wrap.
+//
+//  relative    next reading due a period after the last one was read,
+//              in 32 bit ms, slept as pdMS_TO_TICKS(wait) + 1 ticks
+//  absolute    next reading due a period after its slot in 64 bit us,
+//              slept until a one shot alarm at the slot
+//
+//One line per schedule:
+//
+//  schedule <name> readings <n> missed <n> drift_us <n> late_p50_us <n> late_p99_us <n> late_max_us <n>
+//
+//  drift_us    where the last reading started against the slot it
+//              would have on an exact grid from the first
+//  late        start of each reading after the time it was due
+//
+//then the jitter report of the absolute schedule as the firmware
+//prints it. Exits 1 if the absolute schedule drifted, or a reading
+//started more than JITTERBOUNDUS after its slot.
+//
+//  gcc -O2 -I.. -o schedule_drift schedule_drift.c ../adaptive_rate.c ../jitter_histogram.c
+//
+//  schedule_drift              DRIFTHOURS simulated hours
+//  schedule_drift <hours> [seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "adaptive_rate.h"
+#include "jitter_histogram.h"
+
+#define DRIFTHOURS 72
+#define DRIFTPERIODMS 1000
+#define TICKUS 10000
+#define READMINUS 50000             //4 x oversampled, both channels at 14 bit
+#define READMAXUS 60000
+#define WAKELATENCYUS 200
+#define RUNLATENCYUS 20
+#define STALLEVERY 10000
+#define STALLUS 2500000
+#define JITTERBOUNDUS 1000
+
+//An hour before (uint32_t)(time_us_64() / 1000) wraps
+#define DRIFTSTARTUS ((((uint64_t)1 << 32) - 3600000) * 1000)
+
+typedef struct {
+    const char *name;
+    int64_t *late;
+    uint32_t readings;
+    uint32_t missed;
+    int64_t driftUs;
+} Schedule_t;
+
+static uint64_t tickPhaseUs;
+static uint32_t randomState;
+
+static uint32_t randomNext(void){
+
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static uint64_t randomRange(uint64_t low, uint64_t high){
+
+    return low + randomNext() % (high - low + 1);
+}
+
+//How long one read holds the task
+static uint64_t readUs(void){
+
+    if(randomNext() % STALLEVERY == 0){
+        return STALLUS;
+    }
+    return randomRange(READMINUS, READMAXUS);
+}
+
+//ulTaskNotifyTake for ticks from nowUs with nothing to notify: the
+//first tick interrupt after nowUs counts as one, then the task runs
+//once the scheduler gets to it
+static uint64_t sleepTicks(uint64_t nowUs, uint64_t ticks){
+
+    uint64_t nextTickUs = (nowUs - tickPhaseUs) / TICKUS * TICKUS + TICKUS + tickPhaseUs;
+
+    return nextTickUs + (ticks - 1) * TICKUS + randomRange(0, WAKELATENCYUS);
+}
+
+//sleepUntil in Assign6.c: a slot already past returns at once,
+//otherwise the alarm wakes the task at the slot
+static uint64_t sleepUntil(uint64_t nowUs, uint64_t dueUs){
+
+    if(nowUs < dueUs){
+        nowUs = dueUs + randomRange(0, WAKELATENCYUS);
+    }
+    return nowUs + randomRange(0, RUNLATENCYUS);
+}
+
+static int compareLate(const void *a, const void *b){
+
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void printSchedule(Schedule_t *schedule){
+
+    qsort(schedule->late, schedule->readings, sizeof(schedule->late[0]), compareLate);
+    printf("schedule %-8s readings %lu missed %lu drift_us %lld late_p50_us %lld late_p99_us %lld late_max_us %lld\n",
+           schedule->name, (unsigned long)schedule->readings, (unsigned long)schedule->missed,
+           (long long)schedule->driftUs, (long long)schedule->late[schedule->readings / 2],
+           (long long)schedule->late[(uint64_t)schedule->readings * 99 / 100],
+           (long long)schedule->late[schedule->readings - 1]);
+}
+
+//The reading task before: due a period after the read started, in ms
+static void runRelative(Schedule_t *schedule, uint64_t endUs){
+
+    uint64_t nowUs = DRIFTSTARTUS;
+    uint64_t firstUs = 0;
+    uint64_t startUs = 0;
+    uint32_t dueMs = (uint32_t)(DRIFTSTARTUS / 1000);
+    uint32_t nowMs;
+    uint32_t waitMs;
+
+    while(nowUs < endUs){
+        nowMs = (uint32_t)(nowUs / 1000);
+        if((int32_t)(nowMs - dueMs) >= 0){
+            startUs = nowUs;
+            if(schedule->readings == 0){
+                firstUs = startUs;
+            }
+            schedule->late[schedule->readings++] = (int64_t)(int32_t)(nowMs - dueMs) * 1000 + (int64_t)(startUs % 1000);
+            dueMs = nowMs + DRIFTPERIODMS;
+            nowUs += readUs();
+        }
+
+        nowMs = (uint32_t)(nowUs / 1000);
+        waitMs = (int32_t)(dueMs - nowMs) > 0 ? dueMs - nowMs : 0;
+        nowUs = sleepTicks(nowUs, waitMs * 1000 / TICKUS + 1);
+    }
+
+    schedule->driftUs = (int64_t)(startUs - firstUs) - (int64_t)(schedule->readings - 1) * DRIFTPERIODMS * 1000;
+}
+
+//The reading task now, on adaptive_rate.c and the jitter histogram
+static void runAbsolute(Schedule_t *schedule, JitterHistogram_t *histogram, uint64_t endUs){
+
+    const AdaptiveRateConfig_t config = {DRIFTPERIODMS, DRIFTPERIODMS, 50, 5};
+    AdaptiveRate_t rate;
+    uint64_t nowUs = DRIFTSTARTUS;
+    uint64_t firstUs = 0;
+    uint64_t startUs = 0;
+    uint64_t dueUs = 0;
+    bool scheduled = false;
+    uint32_t missed;
+
+    adaptiveRateInit(&rate, &config, nowUs);
+
+    while(nowUs < endUs){
+        if(adaptiveRateDue(&rate, nowUs)){
+            startUs = nowUs;
+            if(schedule->readings == 0){
+                firstUs = startUs;
+            }
+            if(scheduled){
+                jitterHistogramRecord(histogram, dueUs, startUs);
+            }
+            schedule->late[schedule->readings++] = (int64_t)(startUs - rate.dueUs);
+            nowUs += readUs();
+
+            //scheduled from the end of the read, as the reading task does
+            missed = adaptiveRateUpdate(&rate, 0, nowUs);
+            schedule->missed += missed;
+            jitterHistogramMissed(histogram, missed);
+        }
+
+        dueUs = rate.dueUs;
+        nowUs = sleepUntil(nowUs, dueUs);
+        scheduled = true;
+    }
+
+    //missed slots are still slots on the grid
+    schedule->driftUs = (int64_t)(startUs - firstUs) -
+                        (int64_t)(schedule->readings - 1 + schedule->missed) * DRIFTPERIODMS * 1000;
+}
+
+int main(int argc, char **argv){
+
+    static JitterHistogram_t histogram;
+    uint64_t hours = DRIFTHOURS;
+    uint64_t endUs;
+    size_t slots;
+    Schedule_t relative = {"relative", NULL, 0, 0, 0};
+    Schedule_t absolute = {"absolute", NULL, 0, 0, 0};
+    char line[256];
+    bool failed;
+    int i;
+
+    if(argc > 3){
+        fprintf(stderr, "usage: %s [hours [seed]]\n", argv[0]);
+        return 2;
+    }
+    if(argc >= 2){
+        hours = strtoull(argv[1], NULL, 10);
+    }
+    randomState = argc == 3 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x2545F491;
+    if(hours == 0 || randomState == 0){
+        fprintf(stderr, "hours and seed must not be 0\n");
+        return 2;
+    }
+
+    endUs = DRIFTSTARTUS + hours * 3600 * 1000000;
+    slots = (size_t)((endUs - DRIFTSTARTUS) / (DRIFTPERIODMS * 1000)) + 1;
+    relative.late = malloc(slots * sizeof(int64_t));
+    absolute.late = malloc(slots * sizeof(int64_t));
+    if(relative.late == NULL || absolute.late == NULL){
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    tickPhaseUs = randomRange(0, TICKUS - 1);
+    jitterHistogramInit(&histogram);
+
+    runRelative(&relative, endUs);
+    runAbsolute(&absolute, &histogram, endUs);
+
+    printf("%llu hours, %d ms period, tick phase %llu us\n", (unsigned long long)hours, DRIFTPERIODMS,
+           (unsigned long long)tickPhaseUs);
+    printSchedule(&relative);
+    printSchedule(&absolute);
+
+    for(i = 0; jitterHistogramFormat(&histogram, i, line, sizeof(line)) > 0; i++){
+        printf("%s", line);
+    }
+
+    failed = absolute.driftUs < 0 || absolute.driftUs > JITTERBOUNDUS ||
+             absolute.late[absolute.readings - 1] > JITTERBOUNDUS;
+
+    printf("schedule drift %s\n", failed ? "FAILED" : "ok");
+    free(relative.late);
+    free(absolute.late);
+    return failed ? 1 : 0;
+}
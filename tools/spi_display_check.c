@@ -0,0 +1,206 @@
+//Host check of the MAX7219 chain driver (spi_display.h) against the
+//capture backend in sim/spi_display_sim.c, which shifts every frame
+//through a model of the chain and reads back what it would light.
+//
+//  format      fixed point fields: sign, decimal point, rounding,
+//              overflow and no value, as the chain shows them
+//  diff        the first update sends the control registers and every
+//              digit; later ones only the digit rows that changed, as
+//              no-ops for the chips that did not
+//  replay      a day of readings at one every REPLAYSTEPS s, the
+//              frames and bytes each update sent against rewriting
+//              every digit, the SPI time at SPIDISPLAYBAUDRATE and the
+//              host CPU time of format, set and service
+//
+//Exits 1 on any mismatch.
+//
+//  gcc -O2 -I.. -I../sim -o spi_display_check spi_display_check.c ../spi_display.c ../display_frame.c ../sim/spi_display_sim.c -lm
+//  gcc -O2 -I.. -I../sim -DSPIDISPLAYCHIPS=2 -o spi_display_check16 spi_display_check.c ../spi_display.c ../display_frame.c ../sim/spi_display_sim.c -lm
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "spi_display.h"
+#include "spi_display_sim.h"
+#include "display_frame.h"
+
+#define FIELDDIGITS 4
+#define REPLAYSTEPS 2
+#define REPLAYUPDATES (24 * 3600 / REPLAYSTEPS)
+
+typedef struct {
+    int32_t centi;
+    int decimals;
+    const char *text;       //as the chain shows the FIELDDIGITS field
+} FormatCase_t;
+
+static const FormatCase_t formatCases[] = {
+    {7250,    1, " 72.5"},
+    {-1234,   1, "-12.3"},
+    {-1255,   1, "-12.6"},      //half away from zero
+    {1245,    1, " 12.5"},
+    {-4,      1, "  0.0"},      //no minus on a value that rounds to 0
+    {-5,      1, " -0.1"},
+    {10000,   1, "100.0"},
+    {99994,   1, "999.9"},
+    {99995,   1, "----"},       //rounds to 1000.0, one digit too many
+    {-9994,   1, "-99.9"},
+    {-10000,  1, "----"},
+    {SPIDISPLAYNOVALUE, 1, "----"},
+    {4500,    2, "45.00"},
+    {-500,    2, "-5.00"},
+    {4550,    0, "  46"},
+    {0,       0, "   0"},
+};
+
+static SpiDisplay_t display;
+static SpiDisplaySim_t sim;
+static int failures;
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+//Set segments and send the update
+static void update(const uint8_t *segments){
+
+    spiDisplaySet(&display, segments);
+    spiDisplayService(&display);
+}
+
+static void checkFormat(void){
+
+    uint8_t segments[SPIDISPLAYDIGITS];
+    char expected[2 * SPIDISPLAYDIGITS + 1];
+    char text[2 * SPIDISPLAYDIGITS + 1];
+    size_t i;
+    int failed = 0;
+
+    for(i = 0; i < sizeof(formatCases) / sizeof(formatCases[0]); i++){
+        const FormatCase_t *test = &formatCases[i];
+
+        //the field in the rightmost digits, blanks ahead of it
+        memset(segments, SEGBLANK, sizeof(segments));
+        spiDisplayFormat(segments + SPIDISPLAYDIGITS - FIELDDIGITS, FIELDDIGITS, test->centi, test->decimals);
+        update(segments);
+
+        snprintf(expected, sizeof(expected), "%*s%s", SPIDISPLAYDIGITS - FIELDDIGITS, "", test->text);
+        spiDisplaySimText(&sim, text, sizeof(text));
+        if(strcmp(text, expected) != 0 || !spiDisplaySimLit(&sim)){
+            printf("format %ld decimals %d: shows [%s], expected [%s]\n", (long)test->centi, test->decimals,
+                   text, expected);
+            failed++;
+        }
+    }
+
+    printf("format cases %d failed %d\n", (int)i, failed);
+    failures += failed;
+}
+
+static void checkDiff(void){
+
+    uint8_t segments[SPIDISPLAYDIGITS];
+    uint32_t firstFrames;
+    uint32_t unchangedFrames;
+    uint32_t oneFrames;
+    size_t oneBytes;
+    bool noops = true;
+    int chip;
+
+    //from power on
+    spiDisplaySimInit(&display, &sim);
+    spiDisplayFormat(segments, SPIDISPLAYDIGITS, 2250, 1);
+    update(segments);
+    firstFrames = sim.frames;
+
+    spiDisplaySimClear(&sim);
+    update(segments);
+    unchangedFrames = sim.frames;
+
+    //the rightmost digit only, in the last chip
+    spiDisplaySimClear(&sim);
+    spiDisplayFormat(segments, SPIDISPLAYDIGITS, 2260, 1);
+    update(segments);
+    oneFrames = sim.frames;
+    oneBytes = sim.captured;
+
+    //every chip but the last is sent a no-op, and the last one's word
+    //is shifted in first
+    for(chip = 0; chip < SPIDISPLAYCHIPS - 1 && oneBytes == SPIDISPLAYFRAMEBYTES; chip++){
+        const uint8_t *word = sim.capture + 2 * (SPIDISPLAYCHIPS - 1 - chip);
+
+        noops &= word[0] == MAX7219NOOP && word[1] == 0;
+    }
+
+    printf("diff first %lu frames, unchanged %lu, one digit %lu frame of %lu bytes\n", (unsigned long)firstFrames,
+           (unsigned long)unchangedFrames, (unsigned long)oneFrames, (unsigned long)oneBytes);
+
+    if(firstFrames != SPIDISPLAYMAXFRAMES || unchangedFrames != 0 || oneFrames != 1 ||
+       oneBytes != SPIDISPLAYFRAMEBYTES || !noops || sim.badFrames != 0){
+        printf("diff FAILED\n");
+        failures++;
+    }
+}
+
+static void replay(void){
+
+    uint8_t segments[SPIDISPLAYDIGITS];
+    uint64_t bytes = 0;
+    uint64_t frames = 0;
+    uint64_t updates = 0;
+    uint64_t cpuNs = 0;
+    uint64_t startNs;
+    double minutes;
+    int32_t centiC;
+    int32_t centiRH;
+    int i;
+
+    srand(1);
+    for(i = 0; i < REPLAYUPDATES; i++){
+        //a day's swing and a bit of sensor noise
+        minutes = i * REPLAYSTEPS / 60.0;
+        centiC = (int32_t)lround(2200 + 400 * sin(minutes / 1440 * 2 * M_PI) + rand() % 5 - 2);
+        centiRH = (int32_t)lround(4500 - 1000 * sin(minutes / 1440 * 2 * M_PI) + rand() % 11 - 5);
+
+        spiDisplaySimClear(&sim);
+        startNs = nowNs();
+        spiDisplayFormat(segments, SPIDISPLAYDIGITS / 2, centiC, 1);
+        spiDisplayFormat(segments + SPIDISPLAYDIGITS / 2, SPIDISPLAYDIGITS / 2, centiRH, 1);
+        if(spiDisplaySet(&display, segments)){
+            updates++;
+        }
+        spiDisplayService(&display);
+        cpuNs += nowNs() - startNs;
+
+        frames += sim.frames;
+        bytes += sim.captured;
+    }
+
+    printf("replay %d readings, %lu changed the display\n", REPLAYUPDATES, (unsigned long)updates);
+    printf("replay per update: frames %.2f bytes %.1f spi_us %.2f, every digit: frames 8 bytes %d spi_us %.2f\n",
+           (double)frames / updates, (double)bytes / updates, bytes * 8.0 * 1e6 / SPIDISPLAYBAUDRATE / updates,
+           8 * SPIDISPLAYFRAMEBYTES, 8 * SPIDISPLAYFRAMEBYTES * 8.0 * 1e6 / SPIDISPLAYBAUDRATE);
+    printf("replay host cpu per reading: %.0f ns\n", (double)cpuNs / REPLAYUPDATES);
+}
+
+int main(void){
+
+    printf("%d digits, %d chip(s)\n", SPIDISPLAYDIGITS, SPIDISPLAYCHIPS);
+
+    spiDisplaySimInit(&display, &sim);
+    checkFormat();
+    checkDiff();
+    replay();
+
+    printf("spi_display_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+//Stress test of the single producer, single consumer ring (spsc_ring.h)
+//with a producer and a consumer thread, as core 0 and core 1 use it.
+//Each element carries its sequence number and a payload derived from
+//it, so a slot read before it was written, or while it was being
+//overwritten, shows up as a bad payload.
+//
+//  lossless    the producer retries a full ring until the push goes
+//              in: the consumer must see every sequence once, in order
+//  dropping    the producer drops on a full ring, as readHDC1080Task
+//              does: what arrives is in order with no duplicates, and
+//              arrived + dropped is what was pushed
+//
+//Both sides pause now and then, the producer every PRODUCERPAUSE
+//pushes and the consumer every CONSUMERPAUSE pops, so the ring runs
+//full as well as empty and the threads interleave even on a single
+//CPU. One line per run, with the elements received per second of
+//wall time, pauses included.
+//
+//  throughput  one thread filling the ring and draining it again,
+//              THROUGHPUTCOUNT elements, with no other thread to wait
+//              on: the cost of the ring itself, in ns per push and per
+//              pop and elements through per second. The clock is read
+//              around each burst of STRESSSLOTS, a few ns of each
+//
+//then a summary. Exits 1 on any failure.
+//
+//  gcc -O2 -pthread -I.. -o spsc_stress spsc_stress.c ../spsc_ring.c
+//
+//  spsc_stress             STRESSCOUNT elements per run
+//  spsc_stress <count>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "spsc_ring.h"
+
+#define STRESSCOUNT 1000000
+#define STRESSSLOTS 8               //SAMPLERINGLEN
+#define PAYLOADWORDS 14             //a SampleRecord_t and a bit
+#define PRODUCERPAUSE 11
+#define CONSUMERPAUSE 29
+#define THROUGHPUTCOUNT 10000000
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t payload[PAYLOADWORDS];
+    uint32_t check;
+} Element_t;
+
+typedef struct {
+    const char *name;
+    bool retry;
+    uint32_t count;
+    uint32_t pushed;
+    uint32_t received;
+    uint32_t outOfOrder;
+    uint32_t corrupt;
+    uint32_t lastSequence;
+    double seconds;
+} Run_t;
+
+static Element_t slots[STRESSSLOTS];
+static SpscRing_t ring;
+static volatile bool producerDone;
+
+//Give the CPU up for a moment; sched_yield alone often does not
+static void backOff(void){
+
+    struct timespec pause = {0, 1000};
+
+    nanosleep(&pause, NULL);
+}
+
+static uint64_t nowNs(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static uint32_t payloadWord(uint32_t sequence, int i){
+
+    return sequence * 2654435761u + (uint32_t)i * 40503u;
+}
+
+static void *producer(void *arg){
+
+    Run_t *run = (Run_t *)arg;
+    Element_t element;
+    uint32_t sequence;
+    int i;
+
+    for(sequence = 1; sequence <= run->count; sequence++){
+        element.sequence = sequence;
+        for(i = 0; i < PAYLOADWORDS; i++){
+            element.payload[i] = payloadWord(sequence, i);
+        }
+        element.check = ~sequence;
+
+        while(!spscRingPush(&ring, &element) && run->retry){
+            backOff();
+        }
+        run->pushed++;
+
+        if(sequence % PRODUCERPAUSE == 0){
+            backOff();
+        }
+    }
+    __atomic_store_n(&producerDone, true, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void *consumer(void *arg){
+
+    Run_t *run = (Run_t *)arg;
+    Element_t element;
+    bool bad;
+    int i;
+
+    while(true){
+        if(!spscRingPop(&ring, &element)){
+            //done only once the producer has finished and its last
+            //push is seen
+            if(__atomic_load_n(&producerDone, __ATOMIC_ACQUIRE) && spscRingCount(&ring) == 0){
+                break;
+            }
+            backOff();
+            continue;
+        }
+
+        bad = element.check != ~element.sequence;
+        for(i = 0; i < PAYLOADWORDS; i++){
+            bad |= element.payload[i] != payloadWord(element.sequence, i);
+        }
+        run->corrupt += bad;
+        run->outOfOrder += element.sequence <= run->lastSequence;
+        run->lastSequence = element.sequence;
+        run->received++;
+
+        if(run->received % CONSUMERPAUSE == 0){
+            backOff();
+        }
+    }
+
+    return NULL;
+}
+
+static bool runOne(Run_t *run){
+
+    pthread_t producerThread;
+    pthread_t consumerThread;
+    uint64_t startNs;
+    bool ok;
+
+    spscRingInit(&ring, slots, sizeof(Element_t), STRESSSLOTS);
+    producerDone = false;
+
+    startNs = nowNs();
+    pthread_create(&consumerThread, NULL, consumer, run);
+    pthread_create(&producerThread, NULL, producer, run);
+    pthread_join(producerThread, NULL);
+    pthread_join(consumerThread, NULL);
+    run->seconds = (nowNs() - startNs) / 1e9;
+
+    if(run->retry){
+        ok = run->received == run->count && run->lastSequence == run->count;
+    }
+    else{
+        ok = run->received + ring.dropped == run->count;
+    }
+    ok &= run->pushed == run->count && run->outOfOrder == 0 && run->corrupt == 0;
+
+    printf("%-10s %s elements %lu received %lu dropped %lu out_of_order %lu corrupt %lu per_s %.0f\n", run->name,
+           ok ? "ok" : "FAILED", (unsigned long)run->count, (unsigned long)run->received,
+           (unsigned long)ring.dropped, (unsigned long)run->outOfOrder, (unsigned long)run->corrupt,
+           run->received / run->seconds);
+    return ok;
+}
+
+//Fill and drain in one thread. Sequences are checked on the way out
+//so the work cannot be dropped.
+static bool throughput(uint32_t count){
+
+    Element_t element = {0, {0}, 0};
+    uint64_t pushNs = 0;
+    uint64_t popNs = 0;
+    uint64_t startNs;
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    uint32_t wrong = 0;
+    bool ok;
+    int i;
+
+    spscRingInit(&ring, slots, sizeof(Element_t), STRESSSLOTS);
+
+    while(popped < count){
+        startNs = nowNs();
+        for(i = 0; i < STRESSSLOTS && pushed < count; i++){
+            element.sequence = ++pushed;
+            spscRingPush(&ring, &element);
+        }
+        pushNs += nowNs() - startNs;
+
+        startNs = nowNs();
+        while(spscRingPop(&ring, &element)){
+            wrong += element.sequence != ++popped;
+        }
+        popNs += nowNs() - startNs;
+    }
+
+    ok = popped == count && wrong == 0 && ring.dropped == 0;
+    printf("%-10s %s elements %lu push_ns %.1f pop_ns %.1f per_s %.0f\n", "throughput", ok ? "ok" : "FAILED",
+           (unsigned long)count, (double)pushNs / count, (double)popNs / count, count * 1e9 / (pushNs + popNs));
+    return ok;
+}
+
+int main(int argc, char **argv){
+
+    Run_t lossless = {"lossless", true, STRESSCOUNT, 0, 0, 0, 0, 0, 0};
+    Run_t dropping = {"dropping", false, STRESSCOUNT, 0, 0, 0, 0, 0, 0};
+    bool ok = true;
+
+    if(argc > 2){
+        fprintf(stderr, "usage: %s [count]\n", argv[0]);
+        return 2;
+    }
+    if(argc == 2){
+        lossless.count = dropping.count = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    ok &= runOne(&lossless);
+    ok &= runOne(&dropping);
+    ok &= throughput(THROUGHPUTCOUNT);
+
+    printf("spsc_stress %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
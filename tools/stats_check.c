@@ -0,0 +1,258 @@
+//Host check of the runtime stats (runtime_stats.h): snapshots taken
+//from a stand-in task list whose counters are set by the check, and
+//the report lines formatted from them.
+//
+//  lines       a snapshot formats to its header, a line per task, the
+//              drops and the end marker, each ending in a newline,
+//              then 0
+//  widest      every field at its largest still fits a console message
+//  truncate    every line formatted into every buffer length from 0 up
+//              to one past it: the length returned is what fits, the
+//              text is the start of the whole line, NUL terminated, and
+//              nothing past the buffer is touched
+//  wrap        the 32 bit run time counter wrapping inside a window,
+//              and a task's counter wrapping inside it: the window and
+//              CPU shares come out as if it had not
+//
+//One line per check, then a summary. Exits 1 on any failure.
+//
+//Only the FreeRTOS headers are needed; the task list and the clock are
+//stood in for here.
+//
+//  K=/path/to/FreeRTOS-Kernel
+//  gcc -O2 -I.. -I../sim -I../sim/pico_mock -I$K/include -I$K/portable/ThirdParty/GCC/Posix -o stats_check stats_check.c ../runtime_stats.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+
+#include "runtime_stats.h"
+#include "console.h"
+
+#define LINEMAX 256
+#define GUARD 0x5A
+
+typedef struct {
+    const char *name;
+    uint32_t number;
+    eTaskState state;
+    uint32_t priority;
+    uint32_t runTime;
+    uint32_t stackFree;
+} FakeTask_t;
+
+static FakeTask_t fakeTasks[RUNTIMESTATSMAXTASKS];
+static int fakeTaskCount;
+static uint32_t fakeTotalRunTime;
+static uint64_t fakeNowUs;
+static int failures;
+
+//Stand ins for the kernel's task list and the SDK clock
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, uint32_t *totalRunTime){
+
+    int i;
+
+    for(i = 0; i < fakeTaskCount && i < (int)size; i++){
+        memset(&status[i], 0, sizeof(status[i]));
+        status[i].pcTaskName = fakeTasks[i].name;
+        status[i].xTaskNumber = fakeTasks[i].number;
+        status[i].eCurrentState = fakeTasks[i].state;
+        status[i].uxCurrentPriority = fakeTasks[i].priority;
+        status[i].ulRunTimeCounter = fakeTasks[i].runTime;
+        status[i].usStackHighWaterMark = (configSTACK_DEPTH_TYPE)fakeTasks[i].stackFree;
+    }
+    *totalRunTime = fakeTotalRunTime;
+
+    return (UBaseType_t)i;
+}
+
+uint64_t time_us_64(void){
+
+    return fakeNowUs;
+}
+
+uint32_t time_us_32(void){
+
+    return (uint32_t)fakeNowUs;
+}
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-9s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+static void setTasks(void){
+
+    static const FakeTask_t tasks[] = {
+        {"read", 1, eBlocked, 3, 0, 120},
+        {"flashLog", 2, eBlocked, 1, 0, 200},
+        {"report", 3, eRunning, 1, 0, 400},
+        {"IDLE", 4, eReady, 0, 0, 90},
+    };
+
+    memcpy(fakeTasks, tasks, sizeof(tasks));
+    fakeTaskCount = (int)(sizeof(tasks) / sizeof(tasks[0]));
+}
+
+//A snapshot with every field at its widest
+static void widestSnapshot(RuntimeStatsSnapshot_t *snapshot){
+
+    int i;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->uptimeUs = UINT64_MAX;
+    snapshot->windowUs = UINT32_MAX;
+    snapshot->switches = UINT32_MAX;
+    snapshot->heapUsed = UINT32_MAX;
+    snapshot->heapTotal = UINT32_MAX;
+    snapshot->collectUs = UINT32_MAX;
+    snapshot->sampleRingDropped = UINT32_MAX;
+    snapshot->flashLogDropped = UINT32_MAX;
+    snapshot->consoleDropped = UINT32_MAX;
+    snapshot->taskCount = RUNTIMESTATSMAXTASKS;
+    for(i = 0; i < RUNTIMESTATSMAXTASKS; i++){
+        memset(snapshot->tasks[i].name, 'w', sizeof(snapshot->tasks[i].name) - 1);
+        snapshot->tasks[i].number = UINT32_MAX;
+        snapshot->tasks[i].state = 'X';
+        snapshot->tasks[i].priority = UINT8_MAX;
+        snapshot->tasks[i].cpuPermille = UINT16_MAX;
+        snapshot->tasks[i].stackFreeWords = UINT32_MAX;
+        snapshot->tasks[i].switches = UINT32_MAX;
+    }
+}
+
+static void checkLines(void){
+
+    RuntimeStatsSnapshot_t snapshot;
+    char line[LINEMAX];
+    char detail[96];
+    const char *starts[] = {"stats ", "task ", "drops ", "stats end\n"};
+    size_t length;
+    int lines = 0;
+    int bad = 0;
+    int kind;
+
+    setTasks();
+    fakeNowUs = 5000000;
+    fakeTotalRunTime = 5000000;
+    runtimeStatsCollect(&snapshot);
+
+    while((length = runtimeStatsFormat(&snapshot, lines, line, sizeof(line))) > 0){
+        kind = lines == 0 ? 0 : lines <= snapshot.taskCount ? 1 : lines == snapshot.taskCount + 1 ? 2 : 3;
+        bad += strncmp(line, starts[kind], strlen(starts[kind])) != 0 || line[length - 1] != '\n' ||
+               strlen(line) != length;
+        lines++;
+    }
+
+    snprintf(detail, sizeof(detail), "%d tasks, %d lines, %d bad", snapshot.taskCount, lines, bad);
+    result("lines", snapshot.taskCount == fakeTaskCount && lines == fakeTaskCount + 3 && bad == 0, detail);
+}
+
+static void checkWidest(void){
+
+    RuntimeStatsSnapshot_t snapshot;
+    char line[LINEMAX];
+    char detail[96];
+    size_t longest = 0;
+    size_t length;
+    int i;
+
+    widestSnapshot(&snapshot);
+    for(i = 0; (length = runtimeStatsFormat(&snapshot, i, line, sizeof(line))) > 0; i++){
+        if(length > longest){
+            longest = length;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "longest line %zu, console message %d", longest, CONSOLEMESSAGEMAX);
+    result("widest", longest < CONSOLEMESSAGEMAX - 1, detail);
+}
+
+static void checkTruncate(void){
+
+    RuntimeStatsSnapshot_t snapshot;
+    char whole[LINEMAX];
+    char buf[LINEMAX + 1];
+    char detail[96];
+    size_t wholeLength;
+    size_t length;
+    size_t want;
+    size_t len;
+    int cases = 0;
+    int bad = 0;
+    int i;
+
+    widestSnapshot(&snapshot);
+    for(i = 0; (wholeLength = runtimeStatsFormat(&snapshot, i, whole, sizeof(whole))) > 0; i++){
+        for(len = 0; len <= wholeLength + 1; len++){
+            memset(buf, GUARD, sizeof(buf));
+            length = runtimeStatsFormat(&snapshot, i, buf, len);
+            want = len == 0 ? 0 : len - 1 < wholeLength ? len - 1 : wholeLength;
+
+            bad += length != want || buf[len] != (char)GUARD || (len > 0 && buf[want] != '\0') ||
+                   memcmp(buf, whole, want) != 0;
+            cases++;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "%d lines into buffers of 0 - their length + 1, %d cases %d bad", i, cases,
+             bad);
+    result("truncate", bad == 0, detail);
+}
+
+static void checkWrap(void){
+
+    RuntimeStatsSnapshot_t snapshot;
+    char detail[160];
+    bool ok;
+
+    //the first snapshot 0.5 s before the run time counter wraps, the
+    //second 1 s later; read's own counter wraps in between
+    setTasks();
+    fakeNowUs = UINT32_MAX - 499999;
+    fakeTotalRunTime = UINT32_MAX - 499999;
+    fakeTasks[0].runTime = UINT32_MAX - 99999;
+    fakeTasks[1].runTime = 1000;
+    fakeTasks[2].runTime = 2000;
+    fakeTasks[3].runTime = UINT32_MAX - 700000;
+    runtimeStatsCollect(&snapshot);
+
+    fakeNowUs += 1000000;
+    fakeTotalRunTime += 1000000;
+    fakeTasks[0].runTime += 250000;
+    fakeTasks[1].runTime += 50000;
+    fakeTasks[2].runTime += 1000;
+    fakeTasks[3].runTime += 699000;
+    runtimeStatsCollect(&snapshot);
+
+    ok = snapshot.windowUs == 1000000 && snapshot.tasks[0].cpuPermille == 250 &&
+         snapshot.tasks[1].cpuPermille == 50 && snapshot.tasks[2].cpuPermille == 1 &&
+         snapshot.tasks[3].cpuPermille == 699 && snapshot.uptimeUs == (uint64_t)UINT32_MAX + 500001;
+
+    snprintf(detail, sizeof(detail), "window_us %lu, cpu_permille read %u flashLog %u report %u IDLE %u",
+             (unsigned long)snapshot.windowUs, snapshot.tasks[0].cpuPermille, snapshot.tasks[1].cpuPermille,
+             snapshot.tasks[2].cpuPermille, snapshot.tasks[3].cpuPermille);
+    result("wrap", ok, detail);
+}
+
+int main(void){
+
+    checkLines();
+    checkWidest();
+    checkTruncate();
+    checkWrap();
+
+    printf("stats_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,379 @@
+//Host check of the binary telemetry (telemetry.h): frames from the
+//firmware's encoder through the decoder the host tools use.
+//
+//  crc           the CRC is CRC-16/CCITT-FALSE, check value 0x29B1
+//  round_trip    every batch size, with a partial batch flushed at the
+//                end: each record comes back as it went in
+//  sequence_wrap frame sequences running through 2^32: a frame lost at
+//                the wrap counts as one lost, and none are counted
+//                where none were lost
+//  truncated     a frame cut off after every possible length, then
+//                good frames: the cut frame is never delivered, the
+//                next one is, and the lost frame is counted
+//  corrupt       every single bit of a frame flipped in turn: the frame
+//                is never delivered and the frames after it are
+//  garbage       noise between frames, sync bytes included: every frame
+//                still comes through
+//
+//One line per check, then a summary. Exits 1 on any failure.
+//telemetry_decode -l runs a long loopback of the same, -b its speed.
+//
+//  gcc -O2 -I.. -o telemetry_check telemetry_check.c ../telemetry.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "telemetry.h"
+
+#define STREAMMAX (64 * TELEMETRYMAXFRAME)
+#define ROUNDTRIPRECORDS 1000
+#define GARBAGEFRAMES 200
+
+typedef struct {
+    uint8_t bytes[STREAMMAX];
+    size_t length;
+} Stream_t;
+
+//What came out of the decoder
+typedef struct {
+    uint32_t frames;
+    uint32_t records;
+    uint32_t wrong;             //records that are not the next one expected
+    uint32_t nextRecord;
+    uint32_t lastFrame;
+} Received_t;
+
+static Stream_t stream;
+static int failures;
+static uint32_t noiseState = 2463534242u;
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-13s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+static TelemetryRecord_t makeRecord(uint32_t n){
+
+    TelemetryRecord_t record;
+
+    record.sequence = n;
+    record.timeMs = n * 1000 + 7;
+    record.rawTemperature = (uint16_t)(n * 2654435761u >> 16);
+    record.rawHumidity = (uint16_t)(n * 40503u);
+
+    return record;
+}
+
+static uint8_t noise(void){
+
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return (uint8_t)noiseState;
+}
+
+static void append(Stream_t *to, const uint8_t *bytes, size_t length){
+
+    memcpy(&to->bytes[to->length], bytes, length);
+    to->length += length;
+}
+
+//One frame of batch records starting at record n, into frame. Returns
+//its length.
+static size_t encodeFrame(TelemetryEncoder_t *enc, uint32_t n, int batch, uint8_t *frame){
+
+    TelemetryRecord_t record;
+    size_t length = 0;
+    int i;
+
+    for(i = 0; i < batch && length == 0; i++){
+        record = makeRecord(n + (uint32_t)i);
+        length = telemetryEncode(enc, &record);
+    }
+    memcpy(frame, enc->frame, length);
+
+    return length;
+}
+
+static void receivedInit(Received_t *received, uint32_t firstRecord){
+
+    memset(received, 0, sizeof(*received));
+    received->nextRecord = firstRecord;
+}
+
+//Feed bytes to the decoder, checking each record delivered against the
+//one expected. A record further on is taken as a gap, one before it as
+//wrong.
+static void feed(TelemetryDecoder_t *dec, const uint8_t *bytes, size_t length, Received_t *received){
+
+    TelemetryRecord_t want;
+    size_t i;
+    int j;
+
+    for(i = 0; i < length; i++){
+        if(!telemetryDecode(dec, bytes[i])){
+            continue;
+        }
+        received->frames++;
+        received->lastFrame = dec->frameSequence;
+        for(j = 0; j < dec->count; j++){
+            if(dec->records[j].sequence < received->nextRecord){
+                received->wrong++;
+                continue;
+            }
+            want = makeRecord(dec->records[j].sequence);
+            received->wrong += memcmp(&want, &dec->records[j], sizeof(want)) != 0;
+            received->nextRecord = dec->records[j].sequence + 1;
+            received->records++;
+        }
+    }
+}
+
+static void checkCrc(void){
+
+    const char *check = "123456789";
+    uint16_t crc = telemetryCrc16((const uint8_t *)check, strlen(check));
+    char detail[64];
+
+    snprintf(detail, sizeof(detail), "crc(\"123456789\") 0x%04X", crc);
+    result("crc", crc == 0x29B1, detail);
+}
+
+static void checkRoundTrip(void){
+
+    TelemetryEncoder_t enc;
+    TelemetryDecoder_t dec;
+    TelemetryRecord_t record;
+    Received_t received;
+    uint8_t frame[TELEMETRYMAXFRAME];
+    size_t length;
+    int badBatches = 0;
+    char detail[96];
+    uint32_t n;
+    int batch;
+
+    for(batch = 1; batch <= TELEMETRYMAXRECORDS; batch++){
+        telemetryEncoderInit(&enc, batch);
+        telemetryDecoderInit(&dec);
+        receivedInit(&received, 0);
+
+        for(n = 0; n <= ROUNDTRIPRECORDS; n++){
+            if(n < ROUNDTRIPRECORDS){
+                record = makeRecord(n);
+                length = telemetryEncode(&enc, &record);
+            }
+            else{
+                length = telemetryFlush(&enc);
+            }
+            if(length == 0){
+                continue;
+            }
+
+            memcpy(frame, enc.frame, length);
+            feed(&dec, frame, length, &received);
+        }
+
+        if(received.records != ROUNDTRIPRECORDS || received.wrong != 0 ||
+           received.frames != (ROUNDTRIPRECORDS + (uint32_t)batch - 1) / (uint32_t)batch || dec.crcErrors != 0 ||
+           dec.framesLost != 0 || dec.bytesSkipped != 0){
+            badBatches++;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "batches 1 - %d of %d records, %d wrong", TELEMETRYMAXRECORDS,
+             ROUNDTRIPRECORDS, badBatches);
+    result("round_trip", badBatches == 0, detail);
+}
+
+static void checkSequenceWrap(void){
+
+    TelemetryEncoder_t enc;
+    TelemetryDecoder_t dec;
+    TelemetryDecoder_t lossy;
+    Received_t received;
+    Received_t lossyReceived;
+    uint8_t frame[TELEMETRYMAXFRAME];
+    size_t length;
+    uint32_t sequence;
+    char detail[128];
+    int i;
+
+    telemetryEncoderInit(&enc, 4);
+    enc.frameSequence = UINT32_MAX - 5;
+    telemetryDecoderInit(&dec);
+    telemetryDecoderInit(&lossy);
+    receivedInit(&received, 0);
+    receivedInit(&lossyReceived, 0);
+
+    //the lossy stream is missing the frame numbered UINT32_MAX
+    for(i = 0; i < 12; i++){
+        sequence = enc.frameSequence;
+        length = encodeFrame(&enc, (uint32_t)i * 4, 4, frame);
+        feed(&dec, frame, length, &received);
+        if(sequence != UINT32_MAX){
+            feed(&lossy, frame, length, &lossyReceived);
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "frames %lu lost %lu, with one lost at the wrap %lu lost, last frame %lu",
+             (unsigned long)received.frames, (unsigned long)dec.framesLost, (unsigned long)lossy.framesLost,
+             (unsigned long)lossyReceived.lastFrame);
+    result("sequence_wrap", received.frames == 12 && dec.framesLost == 0 && received.wrong == 0 &&
+           lossyReceived.frames == 11 && lossy.framesLost == 1 && lossyReceived.wrong == 0 &&
+           lossyReceived.lastFrame == 5, detail);
+}
+
+//A good frame, then the one after it damaged by damage(), then three
+//good frames. Returns true if the damaged frame is not delivered and
+//all the good ones are, with the damaged one counted lost.
+static bool damagedBetween(void (*damage)(uint8_t *frame, size_t *length, int variant), int variant){
+
+    TelemetryEncoder_t enc;
+    TelemetryDecoder_t dec;
+    Received_t received;
+    uint8_t frame[TELEMETRYMAXFRAME];
+    size_t length;
+    int i;
+
+    telemetryEncoderInit(&enc, 5);
+    telemetryDecoderInit(&dec);
+    receivedInit(&received, 0);
+    stream.length = 0;
+
+    for(i = 0; i < 5; i++){
+        length = encodeFrame(&enc, (uint32_t)i * 5, 5, frame);
+        if(i == 1){
+            damage(frame, &length, variant);
+        }
+        append(&stream, frame, length);
+    }
+    feed(&dec, stream.bytes, stream.length, &received);
+
+    //frame 1 is records 5 - 9
+    return received.frames == 4 && received.records == 20 && received.wrong == 0 && dec.framesLost == 1 &&
+           received.lastFrame == 4;
+}
+
+static void cut(uint8_t *frame, size_t *length, int variant){
+
+    (void)frame;
+    *length = (size_t)variant;
+}
+
+static void flipBit(uint8_t *frame, size_t *length, int variant){
+
+    (void)length;
+    frame[variant / 8] ^= (uint8_t)(1 << (variant % 8));
+}
+
+static void checkTruncated(void){
+
+    TelemetryEncoder_t enc;
+    TelemetryDecoder_t dec;
+    Received_t received;
+    uint8_t frame[TELEMETRYMAXFRAME];
+    size_t frameLength;
+    size_t length;
+    int bad = 0;
+    char detail[96];
+
+    telemetryEncoderInit(&enc, 5);
+    frameLength = encodeFrame(&enc, 0, 5, frame);
+
+    for(length = 1; length < frameLength; length++){
+        if(!damagedBetween(cut, (int)length)){
+            bad++;
+        }
+    }
+
+    //and cut off at the end of the stream: nothing is delivered
+    telemetryDecoderInit(&dec);
+    receivedInit(&received, 0);
+    feed(&dec, frame, frameLength - 1, &received);
+    bad += received.frames != 0;
+
+    snprintf(detail, sizeof(detail), "cut after 1 - %zu of %zu bytes, %d wrong", frameLength - 1, frameLength,
+             bad);
+    result("truncated", bad == 0, detail);
+}
+
+static void checkCorrupt(void){
+
+    TelemetryEncoder_t enc;
+    uint8_t frame[TELEMETRYMAXFRAME];
+    size_t frameLength;
+    int bad = 0;
+    char detail[96];
+    int bit;
+
+    telemetryEncoderInit(&enc, 5);
+    frameLength = encodeFrame(&enc, 0, 5, frame);
+
+    for(bit = 0; bit < (int)frameLength * 8; bit++){
+        if(!damagedBetween(flipBit, bit)){
+            bad++;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "%zu bits flipped one at a time, %d wrong", frameLength * 8, bad);
+    result("corrupt", bad == 0, detail);
+}
+
+static void checkGarbage(void){
+
+    TelemetryEncoder_t enc;
+    TelemetryDecoder_t dec;
+    Received_t received;
+    uint8_t frame[TELEMETRYMAXFRAME];
+    uint8_t junk[24];
+    size_t length;
+    size_t junkLength;
+    uint32_t lost = 0;
+    char detail[128];
+    size_t j;
+    int i;
+
+    telemetryEncoderInit(&enc, 3);
+    telemetryDecoderInit(&dec);
+    receivedInit(&received, 0);
+
+    for(i = 0; i < GARBAGEFRAMES; i++){
+        junkLength = noise() % sizeof(junk);
+        for(j = 0; j < junkLength; j++){
+            junk[j] = noise();
+        }
+        //a sync pair in the noise every so often
+        if(junkLength >= 2 && i % 3 == 0){
+            junk[junkLength - 2] = TELEMETRYSYNC0;
+            junk[junkLength - 1] = TELEMETRYSYNC1;
+        }
+        feed(&dec, junk, junkLength, &received);
+
+        length = encodeFrame(&enc, (uint32_t)i * 3, 3, frame);
+        feed(&dec, frame, length, &received);
+        lost = dec.framesLost;
+    }
+
+    snprintf(detail, sizeof(detail), "%d frames in noise: %lu delivered, %lu lost, %lu bytes skipped",
+             GARBAGEFRAMES, (unsigned long)received.frames, (unsigned long)lost, (unsigned long)dec.bytesSkipped);
+    result("garbage", received.frames == GARBAGEFRAMES && received.wrong == 0 && lost == 0, detail);
+}
+
+int main(void){
+
+    checkCrc();
+    checkRoundTrip();
+    checkSequenceWrap();
+    checkTruncated();
+    checkCorrupt();
+    checkGarbage();
+
+    printf("telemetry_check %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+//Host decoder for the binary telemetry stream
+//Reads frames from a file or serial device (stdin by default) and
+//prints one CSV line per sample.
+//
+//  gcc -O2 -I.. -o telemetry_decode telemetry_decode.c ../telemetry.c ../conversion.c
+//
+//  telemetry_decode [file]     decode to CSV
+//  telemetry_decode -l         loopback: encode, corrupt, decode, check
+//  telemetry_decode -b         decoder throughput
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "telemetry.h"
+#include "conversion.h"
+
+#define LOOPBACKSAMPLES 100000
+#define BENCHSAMPLES 2000000
+
+static void printFrame(const TelemetryDecoder_t *dec){
+
+    int i;
+
+    for(i = 0; i < dec->count; i++){
+        const TelemetryRecord_t *r = &dec->records[i];
+        int32_t centiC = convRawToCentiC(r->rawTemperature);
+        int32_t centiRH = convRawToCentiRH(r->rawHumidity);
+
+        printf("%u,%u,%u,%s%d.%02d,%d.%02d\n", dec->frameSequence, r->sequence, r->timeMs,
+               centiC < 0 ? "-" : "", abs(centiC) / 100, abs(centiC) % 100,
+               centiRH / 100, centiRH % 100);
+    }
+}
+
+static int decodeStream(FILE *in){
+
+    TelemetryDecoder_t dec;
+    int c;
+
+    telemetryDecoderInit(&dec);
+    printf("frame,sequence,timeMs,tempC,humidityRH\n");
+
+    while((c = fgetc(in)) != EOF){
+        if(telemetryDecode(&dec, (uint8_t)c)){
+            printFrame(&dec);
+            fflush(stdout);
+        }
+    }
+
+    fprintf(stderr, "%u frames, %u lost, %u crc errors, %u bytes skipped\n",
+            dec.frames, dec.framesLost, dec.crcErrors, dec.bytesSkipped);
+
+    return 0;
+}
+
+static TelemetryRecord_t makeRecord(uint32_t i){
+
+    TelemetryRecord_t r;
+
+    r.sequence = i + 1;
+    r.timeMs = i * 10000;
+    r.rawTemperature = (uint16_t)(i * 2654435761u >> 16);
+    r.rawHumidity = (uint16_t)(i * 40503u);
+
+    return r;
+}
+
+//Encode a known sequence into a buffer, damaging every 97th frame
+static uint8_t *encodeAll(uint32_t samples, int batch, bool corrupt, size_t *size, uint32_t *damaged){
+
+    TelemetryEncoder_t enc;
+    TelemetryRecord_t r;
+    uint8_t *buf = malloc((size_t)samples * TELEMETRYMAXFRAME);
+    size_t len;
+    uint32_t i;
+
+    *size = 0;
+    *damaged = 0;
+    telemetryEncoderInit(&enc, batch);
+
+    for(i = 0; i <= samples; i++){
+        if(i < samples){
+            r = makeRecord(i);
+            len = telemetryEncode(&enc, &r);
+        }
+        else{
+            len = telemetryFlush(&enc);
+        }
+
+        if(len == 0){
+            continue;
+        }
+
+        memcpy(&buf[*size], enc.frame, len);
+        if(corrupt && enc.frameSequence % 97 == 0){
+            buf[*size + len / 2] ^= 0x10;
+            (*damaged)++;
+        }
+        *size += len;
+    }
+
+    return buf;
+}
+
+static int loopback(void){
+
+    TelemetryDecoder_t dec;
+    uint32_t damaged;
+    uint32_t next = 1;
+    uint32_t received = 0;
+    size_t size;
+    size_t i;
+    int j;
+    uint8_t *buf = encodeAll(LOOPBACKSAMPLES, 7, true, &size, &damaged);
+
+    telemetryDecoderInit(&dec);
+
+    for(i = 0; i < size; i++){
+        if(!telemetryDecode(&dec, buf[i])){
+            continue;
+        }
+        for(j = 0; j < dec.count; j++){
+            TelemetryRecord_t want;
+
+            //records in damaged frames are skipped, not invented
+            if(dec.records[j].sequence < next){
+                printf("FAIL: sequence went back at %u\n", dec.records[j].sequence);
+                return 1;
+            }
+            next = dec.records[j].sequence;
+            want = makeRecord(next - 1);
+            if(memcmp(&want, &dec.records[j], sizeof(want)) != 0){
+                printf("FAIL: record %u differs\n", next);
+                return 1;
+            }
+            next++;
+            received++;
+        }
+    }
+
+    free(buf);
+
+    printf("%u samples, %u frames damaged, %u frames lost, %u crc errors, %u received\n",
+           LOOPBACKSAMPLES, damaged, dec.framesLost, dec.crcErrors, received);
+
+    if(dec.framesLost != damaged){
+        printf("FAIL\n");
+        return 1;
+    }
+
+    printf("PASS\n");
+
+    return 0;
+}
+
+static int bench(void){
+
+    TelemetryDecoder_t dec;
+    struct timespec start, end;
+    uint32_t damaged;
+    size_t size;
+    size_t i;
+    double seconds;
+    int batch;
+
+    for(batch = 1; batch <= TELEMETRYMAXRECORDS; batch *= 4){
+        uint8_t *buf = encodeAll(BENCHSAMPLES, batch, false, &size, &damaged);
+
+        telemetryDecoderInit(&dec);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(i = 0; i < size; i++){
+            telemetryDecode(&dec, buf[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        free(buf);
+
+        seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("batch %2d: %.2f bytes/sample, %.1f MB/s, %.1f M samples/s\n", batch,
+               (double)size / BENCHSAMPLES, size / seconds / 1e6, BENCHSAMPLES / seconds / 1e6);
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv){
+
+    FILE *in = stdin;
+    int ret;
+
+    if(argc > 1 && strcmp(argv[1], "-l") == 0){
+        return loopback();
+    }
+    if(argc > 1 && strcmp(argv[1], "-b") == 0){
+        return bench();
+    }
+
+    if(argc > 1){
+        in = fopen(argv[1], "rb");
+        if(in == NULL){
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    ret = decodeStream(in);
+
+    if(in != stdin){
+        fclose(in);
+    }
+
+    return ret;
+}
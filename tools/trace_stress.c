@@ -0,0 +1,211 @@
+//Stress test of the event trace dump (event_trace.h) with one thread
+//recording into core 1's ring, as core 1 does, while another dumps it,
+//as the report task does on core 0. Each event carries its index in
+//its time and arguments, so a slot copied while it was being written
+//or overwritten shows up as a bad event.
+//
+//  idle        with nothing recording, a dump is the newest
+//              EVENTTRACELEN events, in order, none lost
+//  recording   DUMPS dumps while the recorder runs flat out: every
+//              event in a chunk is whole and in order, every index up
+//              to where the dump began is either sent or counted lost,
+//              and recording carries on through the dump
+//
+//The recorder pauses every RECORDERPAUSE events so the threads
+//interleave on a single CPU too. One line per check, then a summary.
+//Exits 1 on any failure.
+//
+//  gcc -O2 -pthread -I.. -I../sim/pico_mock -o trace_stress trace_stress.c ../event_trace.c ../telemetry.c
+//
+//  trace_stress            DUMPS dumps
+//  trace_stress <dumps>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "event_trace.h"
+#include "telemetry.h"
+
+#define DUMPS 20000
+#define RECORDERPAUSE 97
+#define CHUNKMAX (EVENTTRACECHUNKHEADER + EVENTTRACECHUNKEVENTS * 8 + 2)
+
+typedef struct {
+    uint32_t dumps;
+    uint32_t events;
+    uint32_t lost;
+    uint32_t bad;               //torn, out of order or a bad chunk
+    uint32_t missing;           //neither sent nor counted lost
+    uint32_t recordedDuring;    //dumps the recorder added to
+} Result_t;
+
+static __thread unsigned int threadCore;
+static __thread uint32_t threadClock;
+static volatile bool stopRecorder;
+static volatile uint32_t recorded;
+static int failures;
+
+//Stand ins for the SDK: the core is the thread's, interrupts are
+//per core so there is nothing to hold off, and the clock is the
+//thread's own event count so each event's time is its index
+
+unsigned int get_core_num(void){
+
+    return threadCore;
+}
+
+uint32_t save_and_disable_interrupts(void){
+
+    return 0;
+}
+
+void restore_interrupts(uint32_t status){
+
+    (void)status;
+}
+
+uint32_t time_us_32(void){
+
+    return threadClock++;
+}
+
+static void backOff(void){
+
+    struct timespec pause = {0, 1000};
+
+    nanosleep(&pause, NULL);
+}
+
+static void record(uint32_t index){
+
+    eventTraceRecord(EVENTTRACETASKSWITCH, (uint8_t)(index >> 16), (uint16_t)index);
+}
+
+static void *recorder(void *arg){
+
+    uint32_t index;
+
+    (void)arg;
+    threadCore = 1;
+    for(index = 0; !stopRecorder; index++){
+        record(index);
+        __atomic_store_n(&recorded, index + 1, __ATOMIC_RELEASE);
+        if(index % RECORDERPAUSE == 0){
+            backOff();
+        }
+    }
+    return NULL;
+}
+
+static void result(const char *name, bool ok, const char *detail){
+
+    printf("%-10s %s %s\n", name, ok ? "ok" : "FAILED", detail);
+    if(!ok){
+        failures++;
+    }
+}
+
+//One dump of core's ring, every chunk checked event by event
+static void dumpAndCheck(int core, Result_t *result){
+
+    EventTraceDump_t dump;
+    EventTrace_t event;
+    uint8_t chunk[CHUNKMAX];
+    uint32_t start;
+    uint32_t next;
+    uint32_t first;
+    uint32_t index;
+    uint32_t before = __atomic_load_n(&recorded, __ATOMIC_ACQUIRE);
+    uint32_t sent = 0;
+    uint16_t crc;
+    int length;
+    int i;
+
+    eventTraceDumpBegin(&dump);
+    start = dump.next[core];
+    next = start;
+
+    while((length = eventTraceDumpChunk(&dump, core, chunk, sizeof(chunk))) > 0){
+        crc = (uint16_t)(chunk[length - 2] | (chunk[length - 1] << 8));
+        memcpy(&first, &chunk[4], 4);
+        if(chunk[0] != EVENTTRACESYNC0 || chunk[1] != EVENTTRACESYNC1 || chunk[2] != core || chunk[3] == 0 ||
+           crc != telemetryCrc16(&chunk[2], length - 4) || first < next){
+            result->bad++;
+            continue;
+        }
+
+        for(i = 0; i < chunk[3]; i++){
+            index = first + (uint32_t)i;
+            memcpy(&event, &chunk[EVENTTRACECHUNKHEADER + i * sizeof(event)], sizeof(event));
+            result->bad += event.timeUs != index || event.arg16 != (uint16_t)index ||
+                           event.arg8 != (uint8_t)(index >> 16) || event.type != EVENTTRACETASKSWITCH ||
+                           index >= dump.end[core];
+        }
+        sent += chunk[3];
+        next = first + chunk[3];
+    }
+
+    result->dumps++;
+    result->lost += dump.lost;
+    result->events += sent;
+    result->missing += sent + dump.lost != dump.end[core] - start;
+    result->recordedDuring += __atomic_load_n(&recorded, __ATOMIC_ACQUIRE) > before;
+}
+
+int main(int argc, char **argv){
+
+    pthread_t thread;
+    Result_t idle;
+    Result_t busy;
+    uint32_t dumps = DUMPS;
+    char detail[160];
+    uint32_t i;
+
+    if(argc > 2){
+        fprintf(stderr, "usage: %s [dumps]\n", argv[0]);
+        return 2;
+    }
+    if(argc == 2){
+        dumps = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    //a ring and a bit recorded on core 0, then dumped
+    memset(&idle, 0, sizeof(idle));
+    threadCore = 0;
+    for(i = 0; i < EVENTTRACELEN + 5; i++){
+        record(i);
+    }
+    dumpAndCheck(0, &idle);
+    snprintf(detail, sizeof(detail), "%lu events recorded, %lu sent, %lu lost, %lu bad",
+             (unsigned long)(EVENTTRACELEN + 5), (unsigned long)idle.events, (unsigned long)idle.lost,
+             (unsigned long)idle.bad);
+    result("idle", idle.events == EVENTTRACELEN && idle.lost == 0 && idle.bad == 0 && idle.missing == 0, detail);
+
+    memset(&busy, 0, sizeof(busy));
+    pthread_create(&thread, NULL, recorder, NULL);
+    while(__atomic_load_n(&recorded, __ATOMIC_ACQUIRE) < 2 * EVENTTRACELEN){
+        backOff();
+    }
+    for(i = 0; i < dumps; i++){
+        dumpAndCheck(1, &busy);
+    }
+    stopRecorder = true;
+    pthread_join(thread, NULL);
+
+    snprintf(detail, sizeof(detail), "%lu dumps of %lu recorded: %lu events sent, %lu lost, %lu bad, %lu missing, "
+             "%lu recorded into", (unsigned long)busy.dumps, (unsigned long)recorded, (unsigned long)busy.events,
+             (unsigned long)busy.lost, (unsigned long)busy.bad, (unsigned long)busy.missing,
+             (unsigned long)busy.recordedDuring);
+    result("recording", busy.bad == 0 && busy.missing == 0 && busy.recordedDuring > 0, detail);
+
+    printf("trace_stress %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
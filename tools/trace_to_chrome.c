@@ -0,0 +1,248 @@
+//Host converter from the event trace dump to Chrome trace JSON
+//Reads a USB capture that contains the dump chunks (see
+//event_trace.h), skipping anything else on the stream, and writes a
+//trace that chrome://tracing or ui.perfetto.dev can open.
+//
+//  gcc -O2 -I.. -o trace_to_chrome trace_to_chrome.c ../telemetry.c
+//
+//  trace_to_chrome capture.bin > trace.json
+//
+//Core 0 tasks are drawn as slices between context switches, I2C
+//transfers as slices from start to end, everything else as instant
+//events on the core that recorded it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_trace.h"
+#include "telemetry.h"
+
+#define MAXEVENTS (1 << 20)
+
+typedef struct {
+    uint64_t timeUs;
+    uint32_t index;
+    int core;
+    EventTrace_t event;
+} HostEvent_t;
+
+//Chrome trace thread ids
+#define TIDTASKS 0
+#define TIDCORE1 1
+#define TIDI2C 2
+#define TIDEVENTS 3
+
+static HostEvent_t events[MAXEVENTS];
+static int eventCount;
+static uint32_t badChunks;
+
+static const char *eventName(uint8_t type){
+
+    switch(type){
+        case EVENTTRACEQUEUESEND: return "queue send";
+        case EVENTTRACEQUEUERECEIVE: return "queue receive";
+        case EVENTTRACEQUEUEPEEK: return "queue peek";
+        case EVENTTRACESAMPLEPUBLISH: return "sample publish";
+        case EVENTTRACESAMPLEREAD: return "sample read";
+        case EVENTTRACERINGPUSH: return "ring push";
+        case EVENTTRACERINGPOP: return "ring pop";
+        case EVENTTRACECONSOLE: return "console";
+        case EVENTTRACEI2CRECOVER: return "i2c recover";
+        default: return "event";
+    }
+}
+
+//Find every good chunk in the capture
+static void parse(const uint8_t *data, size_t size){
+
+    size_t pos = 0;
+
+    while(pos + EVENTTRACECHUNKHEADER + 2 <= size){
+        const uint8_t *chunk = &data[pos];
+        size_t length;
+        uint32_t first;
+        uint16_t crc;
+        int i;
+
+        if(chunk[0] != EVENTTRACESYNC0 || chunk[1] != EVENTTRACESYNC1 || chunk[2] > 1 ||
+           chunk[3] == 0 || chunk[3] > EVENTTRACECHUNKEVENTS){
+            pos++;
+            continue;
+        }
+
+        length = EVENTTRACECHUNKHEADER + chunk[3] * sizeof(EventTrace_t) + 2;
+        if(pos + length > size){
+            break;
+        }
+
+        crc = (uint16_t)(chunk[length - 2] | (chunk[length - 1] << 8));
+        if(crc != telemetryCrc16(&chunk[2], length - 4)){
+            badChunks++;
+            pos++;
+            continue;
+        }
+
+        memcpy(&first, &chunk[4], 4);
+        for(i = 0; i < chunk[3] && eventCount < MAXEVENTS; i++){
+            HostEvent_t *e = &events[eventCount++];
+
+            e->core = chunk[2];
+            e->index = first + i;
+            memcpy(&e->event, &chunk[EVENTTRACECHUNKHEADER + i * sizeof(EventTrace_t)], sizeof(EventTrace_t));
+        }
+
+        pos += length;
+    }
+}
+
+static int compareIndex(const void *a, const void *b){
+
+    const HostEvent_t *x = a;
+    const HostEvent_t *y = b;
+
+    if(x->core != y->core){
+        return x->core - y->core;
+    }
+
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static int compareTime(const void *a, const void *b){
+
+    const HostEvent_t *x = a;
+    const HostEvent_t *y = b;
+
+    return (x->timeUs > y->timeUs) - (x->timeUs < y->timeUs);
+}
+
+//The timer is 32 bits of us; extend it in recording order per core
+static void unwrap(void){
+
+    uint64_t base = 0;
+    uint32_t last = 0;
+    int core = -1;
+    int i;
+
+    qsort(events, eventCount, sizeof(events[0]), compareIndex);
+
+    for(i = 0; i < eventCount; i++){
+        uint32_t t = events[i].event.timeUs;
+
+        if(events[i].core != core){
+            core = events[i].core;
+            base = 0;
+        }
+        else if(t < last && last - t > 0x80000000u){
+            base += 0x100000000ull;
+        }
+        last = t;
+        events[i].timeUs = base + t;
+    }
+
+    qsort(events, eventCount, sizeof(events[0]), compareTime);
+}
+
+static void emit(const char *json, bool *firstLine){
+
+    printf("%s  %s", *firstLine ? "" : ",\n", json);
+    *firstLine = false;
+}
+
+int main(int argc, char **argv){
+
+    FILE *in;
+    uint8_t *data;
+    size_t size;
+    char json[256];
+    bool firstLine = true;
+    uint64_t taskStart = 0;
+    int task = -1;
+    uint64_t i2cStart = 0;
+    uint16_t i2cLength = 0;
+    bool i2cOpen = false;
+    int i;
+
+    if(argc < 2){
+        fprintf(stderr, "usage: %s capture.bin > trace.json\n", argv[0]);
+        return 1;
+    }
+
+    in = fopen(argv[1], "rb");
+    if(in == NULL){
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(in, 0, SEEK_END);
+    size = (size_t)ftell(in);
+    fseek(in, 0, SEEK_SET);
+    data = malloc(size);
+    if(data == NULL || fread(data, 1, size, in) != size){
+        fprintf(stderr, "%s: read failed\n", argv[1]);
+        return 1;
+    }
+    fclose(in);
+
+    parse(data, size);
+    free(data);
+    unwrap();
+
+    printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    emit("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 0, \"tid\": 0, \"args\": {\"name\": \"core 0 tasks\"}}", &firstLine);
+    emit("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 0, \"tid\": 1, \"args\": {\"name\": \"core 1\"}}", &firstLine);
+    emit("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 0, \"tid\": 2, \"args\": {\"name\": \"i2c\"}}", &firstLine);
+    emit("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 0, \"tid\": 3, \"args\": {\"name\": \"core 0 events\"}}", &firstLine);
+
+    for(i = 0; i < eventCount; i++){
+        const HostEvent_t *e = &events[i];
+        const EventTrace_t *ev = &e->event;
+
+        switch(ev->type){
+            case EVENTTRACETASKSWITCH:
+                if(task >= 0){
+                    snprintf(json, sizeof(json),
+                             "{\"ph\": \"X\", \"name\": \"task %d\", \"pid\": 0, \"tid\": %d, \"ts\": %llu, \"dur\": %llu}",
+                             task, TIDTASKS, (unsigned long long)taskStart, (unsigned long long)(e->timeUs - taskStart));
+                    emit(json, &firstLine);
+                }
+                task = ev->arg16;
+                taskStart = e->timeUs;
+                break;
+
+            case EVENTTRACEI2CSTART:
+                i2cStart = e->timeUs;
+                i2cLength = ev->arg16;
+                i2cOpen = true;
+                break;
+
+            case EVENTTRACEI2CEND:
+                if(i2cOpen){
+                    snprintf(json, sizeof(json),
+                             "{\"ph\": \"X\", \"name\": \"i2c %s 0x%02x\", \"pid\": 0, \"tid\": %d, \"ts\": %llu, \"dur\": %llu, "
+                             "\"args\": {\"len\": %u, \"result\": %d}}",
+                             (i2cLength & 0x8000) ? "read" : "write", ev->arg8, TIDI2C,
+                             (unsigned long long)i2cStart, (unsigned long long)(e->timeUs - i2cStart),
+                             i2cLength & 0x7FFF, (int16_t)ev->arg16);
+                    emit(json, &firstLine);
+                    i2cOpen = false;
+                }
+                break;
+
+            default:
+                snprintf(json, sizeof(json),
+                         "{\"ph\": \"i\", \"s\": \"t\", \"name\": \"%s\", \"pid\": 0, \"tid\": %d, \"ts\": %llu, "
+                         "\"args\": {\"arg8\": %u, \"arg16\": %u}}",
+                         eventName(ev->type), e->core ? TIDCORE1 : TIDEVENTS, (unsigned long long)e->timeUs,
+                         ev->arg8, ev->arg16);
+                emit(json, &firstLine);
+                break;
+        }
+    }
+
+    printf("\n]}\n");
+
+    fprintf(stderr, "%d events, %u bad chunks\n", eventCount, badChunks);
+
+    return 0;
+}